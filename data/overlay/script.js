@@ -8,14 +8,22 @@ function mmss(ms) {
   return `${String(m).padStart(2, "0")}:${String(s).padStart(2, "0")}`;
 }
 
+const urlParams = new URLSearchParams(window.location.search);
+const boardId = (urlParams.get("board") || "").trim().toLowerCase();
+const isDefaultBoard = !boardId || boardId === "main";
+const stateTopics = (urlParams.get("topics") || "").split(",").map((t) => t.trim()).filter(Boolean);
+const leaderCount = Math.max(1, parseInt(urlParams.get("leaders") || "5", 10) || 5);
+
 async function fetchState() {
-  const res = await fetch("plugin.json", { cache: "no-store" });
+  const statePath = isDefaultBoard ? "plugin.json" : "boards/" + encodeURIComponent(boardId) + "/plugin.json";
+  const res = await fetch(statePath, { cache: "no-store" });
   if (!res.ok) throw new Error("fetch failed");
   return await res.json();
 }
 
 function normalizeIncomingState(payload) {
   if (!payload) return null;
+  if (payload.board && payload.board !== (isDefaultBoard ? "main" : boardId)) return null;
   if (payload.type === "state" && payload.state) return payload.state;
   if (payload.home || payload.away || payload.custom_fields) return payload;
   return null;
@@ -361,7 +369,7 @@ function applyTemplateBindings(data) {
     if (b.kind === "text") {
       b.targetNode.nodeValue = str;
     } else if (b.kind === "attr") {
-      b.targetNode.setAttribute(b.attrName, str);
+      b.targetNode.setAttribute(b.attrName, bustAssetUrl(str));
     }
   }
 }
@@ -390,6 +398,55 @@ let currentJsonState = null;
 let socket = null;
 let socketRetryTimer = null;
 let lastSocketStateAt = 0;
+let pendingRenderedRev = 0;
+let lastView = null;
+
+// Expands the plugin's column-wise roster into per-team player rows, plus the
+// top players of every stat (players.leaders.home.points[0].name).
+function buildPlayers(roster) {
+  const players = { home: [], away: [], leaders: { home: {}, away: {}, all: {} } };
+  if (!roster || !Array.isArray(roster.number)) return players;
+
+  const stats = Array.isArray(roster.stats) ? roster.stats : [];
+  const values = Array.isArray(roster.values) ? roster.values : [];
+  const all = roster.number.map((number, row) => {
+    const p = {
+      number,
+      name: (roster.name || [])[row] || "",
+      team: (roster.team || [])[row] ? "away" : "home",
+    };
+    stats.forEach((stat, k) => {
+      p[stat] = Number((values[k] || [])[row] ?? 0);
+    });
+    return p;
+  });
+
+  for (const p of all) players[p.team].push(p);
+  // Stable sort: ties keep the (team, number) order the plugin stores.
+  const top = (list, stat) => list.slice().sort((a, b) => b[stat] - a[stat]).slice(0, leaderCount);
+  for (const stat of stats) {
+    players.leaders.home[stat] = top(players.home, stat);
+    players.leaders.away[stat] = top(players.away, stat);
+    players.leaders.all[stat] = top(all, stat);
+  }
+  return players;
+}
+
+// Applies [row, stat, value] cells; asks for a full state if they don't fit.
+function applyRosterDelta(msg) {
+  if (msg.board && msg.board !== (isDefaultBoard ? "main" : boardId)) return;
+  const values = currentJsonState && currentJsonState.roster && currentJsonState.roster.values;
+  const cells = Array.isArray(msg.cells) ? msg.cells : [];
+  for (const [row, stat, value] of cells) {
+    if (!values || !Array.isArray(values[stat]) || row >= values[stat].length) {
+      if (socket && socket.readyState === WebSocket.OPEN) socket.send(JSON.stringify({ type: "get_state" }));
+      return;
+    }
+    values[stat][row] = value;
+  }
+  lastSocketStateAt = Date.now();
+  if (msg.rev) pendingRenderedRev = msg.rev;
+}
 
 function renderFrame() {
   if (!currentJsonState) return;
@@ -440,16 +497,210 @@ function renderFrame() {
 
   const view = {
     ...st,
+    players: buildPlayers(st.roster),
     team_x,
     team_y,
     fields_xy,
+    // Computed by the plugin (see "derived" in plugin.json).
+    derived_values: st.derived_values || {},
   };
 
+  lastView = view;
+
   // First apply fs-if (visibility), then template bindings (text/attrs)
   applyIfBindings(view);
   applyTemplateBindings(view);
 }
 
+// -----------------------------------------------------------------------------
+// Template hot swap (same runtime, new markup/styles)
+// -----------------------------------------------------------------------------
+let templateSwapSeq = 0;
+const assetVersions = new Map();
+
+function templateBaseHref(basePath) {
+  let p = String(basePath || "").replace(/\\/g, "/");
+  if (!p) return "";
+  if (!p.endsWith("/")) p += "/";
+  if (window.location.protocol === "file:") {
+    return "file://" + (p.startsWith("/") ? "" : "/") + encodeURI(p);
+  }
+  return window.location.origin + "/" + encodeURI(p.replace(/^\/+/, ""));
+}
+
+function preloadStylesheet(href) {
+  return new Promise((resolve) => {
+    const link = document.createElement("link");
+    link.rel = "stylesheet";
+    link.media = "print";
+    link.href = href;
+    link.setAttribute("data-fs-template", "");
+    link.onload = () => resolve(link);
+    link.onerror = () => resolve(link);
+    document.head.appendChild(link);
+  });
+}
+
+function preloadImage(src) {
+  return new Promise((resolve) => {
+    const img = new Image();
+    img.onload = resolve;
+    img.onerror = resolve;
+    img.src = src;
+  });
+}
+
+function resolveTemplateString(value, data) {
+  if (!value || !value.includes("{{")) return value;
+  const binding = createBinding(null, "attr", null, value);
+  if (!binding || !data) return "";
+  let str = "";
+  for (const part of binding.parts) {
+    if (part.type === "literal") {
+      str += part.value;
+    } else {
+      const v = evaluateExpression(part.value, data);
+      str += v == null ? "" : String(v);
+    }
+  }
+  return str;
+}
+
+function assetKey(url, base) {
+  try {
+    return decodeURI(new URL(url, base || document.baseURI).pathname);
+  } catch (e) {
+    return "";
+  }
+}
+
+function bustAssetUrl(url) {
+  if (!assetVersions.size || !url || url.startsWith("data:")) return url;
+  const key = assetKey(url);
+  const rev = assetVersions.get(key);
+  if (!rev) return url;
+  try {
+    const u = new URL(url, document.baseURI);
+    u.searchParams.set("fsv", rev);
+    return u.href;
+  } catch (e) {
+    return url;
+  }
+}
+
+function swapStylesheet(link) {
+  const next = link.cloneNode();
+  next.href = bustAssetUrl(link.href);
+  next.onload = () => link.remove();
+  next.onerror = () => next.remove();
+  link.after(next);
+}
+
+function applyAssetUpdate(msg) {
+  const baseHref = templateBaseHref(msg.base_path) || document.baseURI;
+  const rev = String(msg.rev || Date.now());
+  const styleKeys = (msg.styles || []).map((f) => assetKey(f, baseHref));
+  const imageKeys = (msg.images || []).map((f) => assetKey(f, baseHref));
+
+  styleKeys.concat(imageKeys).forEach((key) => key && assetVersions.set(key, rev));
+
+  const links = Array.from(document.head.querySelectorAll('link[rel="stylesheet"]'));
+  let stylesMatched = false;
+  links.forEach((link) => {
+    if (styleKeys.includes(assetKey(link.href))) {
+      swapStylesheet(link);
+      stylesMatched = true;
+    }
+  });
+
+  let imagesMatched = false;
+  document.querySelectorAll("img[src]").forEach((img) => {
+    if (imageKeys.includes(assetKey(img.src))) {
+      img.src = bustAssetUrl(img.src);
+      imagesMatched = true;
+    }
+  });
+
+  // @import-ed sheets and CSS background images: refresh every stylesheet.
+  if ((styleKeys.length && !stylesMatched) || (imageKeys.length && !imagesMatched)) {
+    links.forEach((link) => {
+      if (!styleKeys.includes(assetKey(link.href))) {
+        assetVersions.set(assetKey(link.href), rev);
+        swapStylesheet(link);
+      }
+    });
+  }
+}
+
+async function hotSwapTemplate(msg) {
+  const seq = ++templateSwapSeq;
+  const doc = new DOMParser().parseFromString(String(msg.html || ""), "text/html");
+  const baseHref = templateBaseHref(msg.base_path);
+  const resolve = (url) => {
+    try {
+      return new URL(url, baseHref || document.baseURI).href;
+    } catch (e) {
+      return url;
+    }
+  };
+
+  doc.querySelectorAll("script").forEach((el) => el.remove());
+
+  const sheets = Array.from(doc.head.querySelectorAll('link[rel="stylesheet"]'));
+  const styles = Array.from(doc.head.querySelectorAll("style"));
+  const images = Array.from(doc.body.querySelectorAll("img[src]"))
+    .map((img) => resolveTemplateString(img.getAttribute("src"), lastView))
+    .filter((src) => src)
+    .map(resolve);
+
+  const loaded = await Promise.all([
+    Promise.all(sheets.map((el) => preloadStylesheet(resolve(el.getAttribute("href"))))),
+    Promise.all(images.map(preloadImage)),
+  ]);
+  const newLinks = loaded[0];
+
+  if (seq !== templateSwapSeq) {
+    newLinks.forEach((el) => el.remove());
+    return;
+  }
+
+  requestAnimationFrame(() => {
+    if (seq !== templateSwapSeq) {
+      newLinks.forEach((el) => el.remove());
+      return;
+    }
+
+    let base = document.head.querySelector("base");
+    if (baseHref) {
+      if (!base) {
+        base = document.createElement("base");
+        document.head.insertBefore(base, document.head.firstChild);
+      }
+      base.href = baseHref;
+    }
+
+    document.head
+      .querySelectorAll('link[rel="stylesheet"], style')
+      .forEach((el) => {
+        if (!newLinks.includes(el)) el.remove();
+      });
+    newLinks.forEach((el) => {
+      el.media = "all";
+      el.removeAttribute("data-fs-template");
+    });
+    styles.forEach((el) => document.head.appendChild(document.importNode(el, true)));
+
+    if (doc.title) document.title = doc.title;
+    document.body.className = doc.body.className;
+    document.body.innerHTML = doc.body.innerHTML;
+
+    templateBindings.length = 0;
+    ifBindings.length = 0;
+    collectTemplateBindings();
+    renderFrame();
+  });
+}
+
 // -----------------------------------------------------------------------------
 // Poll loop
 // -----------------------------------------------------------------------------
@@ -471,8 +722,15 @@ function connectSocket() {
     return;
   }
 
-  const params = new URLSearchParams(window.location.search);
-  const wsUrl = params.get("ws") || "ws://127.0.0.1:4457";
+  // Served by the plugin or a relay under /overlay/ or /board/<id>/overlay/: the WebSocket
+  // is on the same port. Any other web server only hosts the files, so fall back to the plugin's default.
+  const servedByPlugin =
+    window.location.protocol === "http:" && /^\/(board\/[^/]+\/)?overlay\//.test(window.location.pathname);
+  const sameOrigin = servedByPlugin ? "ws://" + window.location.host : "";
+  const wsBase = urlParams.get("ws") || sameOrigin || "ws://127.0.0.1:4457";
+  const wsUrl = isDefaultBoard || urlParams.get("ws")
+    ? wsBase
+    : wsBase.replace(/\/+$/, "") + "/board/" + encodeURIComponent(boardId);
 
   try {
     socket = new WebSocket(wsUrl);
@@ -482,16 +740,36 @@ function connectSocket() {
   }
 
   socket.addEventListener("open", () => {
+    socket.send(JSON.stringify({
+      type: "hello",
+      board: isDefaultBoard ? "main" : boardId,
+      capabilities: ["template_swap", "asset_reload", "roster_delta"],
+      obs: !!window.obsstudio,
+      ...(stateTopics.length ? { topics: stateTopics } : {}),
+    }));
     socket.send(JSON.stringify({ type: "get_state" }));
   });
 
   socket.addEventListener("message", (event) => {
     try {
       const payload = JSON.parse(event.data);
+      if (payload && payload.type === "template") {
+        hotSwapTemplate(payload);
+        return;
+      }
+      if (payload && payload.type === "asset_update") {
+        applyAssetUpdate(payload);
+        return;
+      }
+      if (payload && payload.type === "roster_delta") {
+        applyRosterDelta(payload);
+        return;
+      }
       const st = normalizeIncomingState(payload);
       if (st) {
-        currentJsonState = st;
+        currentJsonState = payload.partial ? { ...(currentJsonState || {}), ...st } : st;
         lastSocketStateAt = Date.now();
+        if (payload.rev) pendingRenderedRev = payload.rev;
       }
     } catch (e) {
       // ignore malformed remote messages
@@ -516,8 +794,19 @@ function scheduleSocketReconnect() {
   }, 1000);
 }
 
+function reportRendered() {
+  if (!pendingRenderedRev || !socket || socket.readyState !== WebSocket.OPEN) return;
+  socket.send(JSON.stringify({
+    type: "rendered",
+    board: isDefaultBoard ? "main" : boardId,
+    rev: pendingRenderedRev,
+  }));
+  pendingRenderedRev = 0;
+}
+
 function animationLoop() {
   renderFrame();
+  reportRendered();
   requestAnimationFrame(animationLoop);
 }
 
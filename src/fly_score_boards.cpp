@@ -0,0 +1,106 @@
+#include "fly_score_boards.hpp"
+
+#include "fly_score_paths.hpp"
+#include "fly_score_settings.hpp"
+
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSet>
+
+static inline QString key_boards()
+{
+	return QStringLiteral("boards/list");
+}
+static inline QString key_active_board()
+{
+	return QStringLiteral("boards/active");
+}
+
+QString fly_default_board_id()
+{
+	return QStringLiteral("main");
+}
+
+QString fly_board_normalize_id(const QString &raw)
+{
+	QString id;
+	for (const QChar c : raw.trimmed().toLower()) {
+		if ((c >= QLatin1Char('a') && c <= QLatin1Char('z')) || (c >= QLatin1Char('0') && c <= QLatin1Char('9')) ||
+		    c == QLatin1Char('-') || c == QLatin1Char('_'))
+			id += c;
+		else if (c.isSpace() && !id.endsWith(QLatin1Char('-')))
+			id += QLatin1Char('-');
+		if (id.size() >= 32)
+			break;
+	}
+	return id.isEmpty() ? fly_default_board_id() : id;
+}
+
+bool fly_board_is_default(const QString &id)
+{
+	return id.isEmpty() || id == fly_default_board_id();
+}
+
+QVector<FlyBoard> fly_boards_load()
+{
+	QVector<FlyBoard> boards;
+
+	FlyBoard main;
+	main.id = fly_default_board_id();
+	main.templatePath = fly_get_data_root_no_ui();
+	boards.push_back(main);
+
+	const QJsonArray arr = QJsonDocument::fromJson(fly_settings().value(key_boards()).toByteArray()).array();
+
+	QSet<QString> seen{main.id};
+	for (const QJsonValue v : arr) {
+		const QJsonObject o = v.toObject();
+		FlyBoard b;
+		b.id = fly_board_normalize_id(o.value(QStringLiteral("id")).toString());
+		b.name = o.value(QStringLiteral("name")).toString().trimmed();
+		b.templatePath = o.value(QStringLiteral("template")).toString();
+		if (seen.contains(b.id))
+			continue;
+		if (b.templatePath.isEmpty())
+			b.templatePath = main.templatePath;
+		seen.insert(b.id);
+		boards.push_back(b);
+	}
+
+	return boards;
+}
+
+void fly_boards_save(const QVector<FlyBoard> &boards)
+{
+	QJsonArray arr;
+	for (const FlyBoard &b : boards) {
+		if (fly_board_is_default(b.id))
+			continue;
+		QJsonObject o;
+		o.insert(QStringLiteral("id"), b.id);
+		o.insert(QStringLiteral("name"), b.name);
+		o.insert(QStringLiteral("template"), b.templatePath);
+		arr.push_back(o);
+	}
+
+	fly_settings().setValue(key_boards(), QJsonDocument(arr).toJson(QJsonDocument::Compact));
+}
+
+QString fly_load_active_board_id()
+{
+	return fly_board_normalize_id(fly_settings().string(key_active_board()));
+}
+
+void fly_save_active_board_id(const QString &id)
+{
+	fly_settings().setValue(key_active_board(), fly_board_normalize_id(id));
+}
+
+QString fly_board_state_dir(const FlyBoard &board)
+{
+	if (fly_board_is_default(board.id))
+		return board.templatePath;
+	return QDir(board.templatePath).filePath(QStringLiteral("boards/") + board.id);
+}
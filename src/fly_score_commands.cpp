@@ -0,0 +1,422 @@
+#include "fly_score_commands.hpp"
+
+#include "fly_score_derived.hpp"
+#include "fly_score_trace.hpp"
+
+#include <QJsonArray>
+#include <QJsonValue>
+#include <QSet>
+#include <QStringList>
+
+#include <algorithm>
+
+QString fly_command_action(const QJsonObject &command)
+{
+	const QString action = fly_command_string(command, QStringLiteral("action"));
+	return action.isEmpty() ? fly_command_string(command, QStringLiteral("type")) : action;
+}
+
+int fly_command_int(const QJsonObject &command, const QString &key, int fallback)
+{
+	const QJsonValue v = command.value(key);
+	if (v.isDouble())
+		return v.toInt(fallback);
+	if (v.isString()) {
+		bool ok = false;
+		const int n = v.toString().toInt(&ok);
+		return ok ? n : fallback;
+	}
+	return fallback;
+}
+
+qint64 fly_command_int64(const QJsonObject &command, const QString &key, qint64 fallback)
+{
+	const QJsonValue v = command.value(key);
+	if (v.isDouble())
+		return static_cast<qint64>(v.toDouble(fallback));
+	if (v.isString()) {
+		bool ok = false;
+		const qint64 n = v.toString().toLongLong(&ok);
+		return ok ? n : fallback;
+	}
+	return fallback;
+}
+
+bool fly_command_bool(const QJsonObject &command, const QString &key, bool fallback)
+{
+	const QJsonValue v = command.value(key);
+	if (v.isBool())
+		return v.toBool(fallback);
+	if (v.isDouble())
+		return v.toInt() != 0;
+	if (v.isString()) {
+		const QString s = v.toString().trimmed().toLower();
+		if (s == QLatin1String("true") || s == QLatin1String("1") || s == QLatin1String("yes"))
+			return true;
+		if (s == QLatin1String("false") || s == QLatin1String("0") || s == QLatin1String("no"))
+			return false;
+	}
+	return fallback;
+}
+
+QString fly_command_string(const QJsonObject &command, const QString &key)
+{
+	return command.value(key).toString().trimmed();
+}
+
+uint32_t fly_command_color(const QJsonObject &command, const QString &key, uint32_t fallback)
+{
+	const QJsonValue v = command.value(key);
+	if (v.isDouble())
+		return static_cast<uint32_t>(v.toInt(static_cast<int>(fallback)));
+	if (v.isString()) {
+		QString s = v.toString().trimmed();
+		if (s.startsWith(QLatin1Char('#')))
+			s.remove(0, 1);
+		bool ok = false;
+		const uint n = s.startsWith(QStringLiteral("0x"), Qt::CaseInsensitive) ? s.mid(2).toUInt(&ok, 16)
+											: s.toUInt(&ok, 16);
+		if (ok)
+			return static_cast<uint32_t>(n);
+		const uint dec = s.toUInt(&ok, 10);
+		if (ok)
+			return static_cast<uint32_t>(dec);
+	}
+	return fallback;
+}
+
+bool fly_command_side_is_away(const QString &side, bool swapSides)
+{
+	return side == QLatin1String("away") || side == QLatin1String("guest") || side == QLatin1String("guests") ||
+	       (side == QLatin1String("y") && !swapSides) || (side == QLatin1String("x") && swapSides);
+}
+
+static void setTimerStoppedAtInitial(FlyTimer &timer)
+{
+	timer.running = false;
+	timer.last_tick_ms = 0;
+	if (timer.initial_ms < 0)
+		timer.initial_ms = 0;
+	timer.remaining_ms = timer.initial_ms;
+}
+
+void fly_timer_toggle(FlyTimer &tm, qint64 now)
+{
+	if (!tm.running) {
+		if (tm.remaining_ms < 0) {
+			if (tm.mode == QStringLiteral("countdown"))
+				tm.remaining_ms = (tm.initial_ms > 0) ? tm.initial_ms : 0;
+			else
+				tm.remaining_ms = 0;
+		}
+		tm.last_tick_ms = now;
+		tm.running = true;
+		return;
+	}
+
+	if (tm.last_tick_ms > 0) {
+		qint64 elapsed = now - tm.last_tick_ms;
+		if (elapsed < 0)
+			elapsed = 0;
+
+		if (tm.mode == QStringLiteral("countup"))
+			tm.remaining_ms += elapsed;
+		else {
+			tm.remaining_ms -= elapsed;
+			if (tm.remaining_ms < 0)
+				tm.remaining_ms = 0;
+		}
+	}
+	tm.running = false;
+}
+
+bool fly_command_is_state_action(const QString &action)
+{
+	static const QSet<QString> actions = {
+		QStringLiteral("set_state"), QStringLiteral("swap"), QStringLiteral("show_scoreboard"),
+		QStringLiteral("toggle_scoreboard"), QStringLiteral("set_team"), QStringLiteral("set_derived"),
+		QStringLiteral("remove_derived"), QStringLiteral("add_score"), QStringLiteral("add_field"),
+		QStringLiteral("remove_score"), QStringLiteral("remove_field"), QStringLiteral("set_field"),
+		QStringLiteral("set_score_field"), QStringLiteral("toggle_field"), QStringLiteral("score_visibility"),
+		QStringLiteral("bump_score"), QStringLiteral("set_score"), QStringLiteral("bump_single"),
+		QStringLiteral("toggle_single"), QStringLiteral("add_single"), QStringLiteral("remove_single"),
+		QStringLiteral("set_single"), QStringLiteral("add_timer"), QStringLiteral("remove_timer"),
+		QStringLiteral("set_timer"), QStringLiteral("timer_toggle"), QStringLiteral("timer_visibility"),
+		QStringLiteral("timer_start"), QStringLiteral("timer_pause"), QStringLiteral("timer_reset"),
+		QStringLiteral("set_roster_stats"), QStringLiteral("reset_roster"), QStringLiteral("add_player"),
+		QStringLiteral("remove_player"), QStringLiteral("player_stat"), QStringLiteral("set_player_stat"),
+	};
+	return actions.contains(action);
+}
+
+int fly_apply_state_command(FlyState &st, const QString &action, const QJsonObject &command, qint64 nowMs)
+{
+	FLY_TRACE_SCOPE("fly_apply_state_command");
+	if (action == QLatin1String("set_state") && command.value(QStringLiteral("state")).isObject()) {
+		FlyState next;
+		if (!fly_state_from_json_object(command.value(QStringLiteral("state")).toObject(), next))
+			return FlyCommandIgnored;
+		st = next;
+		return FlyCommandValues | FlyCommandStructure;
+	}
+
+	if (action == QLatin1String("swap")) {
+		st.swap_sides = !st.swap_sides;
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("show_scoreboard")) {
+		st.show_scoreboard = command.value(QStringLiteral("value")).toBool(st.show_scoreboard);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("toggle_scoreboard")) {
+		st.show_scoreboard = !st.show_scoreboard;
+		return FlyCommandValues;
+	}
+
+	if (action == QLatin1String("set_team")) {
+		const QString side = fly_command_string(command, QStringLiteral("side"));
+		const bool away = side == QLatin1String("away") || side == QLatin1String("guest") ||
+				  side == QLatin1String("guests");
+		FlyTeam &team = away ? st.away : st.home;
+
+		if (command.contains(QStringLiteral("title")))
+			team.title = fly_command_string(command, QStringLiteral("title"));
+		if (command.contains(QStringLiteral("subtitle")))
+			team.subtitle = fly_command_string(command, QStringLiteral("subtitle"));
+		if (command.contains(QStringLiteral("logo")))
+			team.logo = fly_command_string(command, QStringLiteral("logo"));
+		if (command.contains(QStringLiteral("color")))
+			team.color = fly_command_color(command, QStringLiteral("color"), team.color);
+		return FlyCommandValues;
+	}
+
+	if (action == QLatin1String("set_derived") || action == QLatin1String("remove_derived")) {
+		const QString id = fly_command_string(command, QStringLiteral("id")).trimmed();
+		if (id.isEmpty())
+			return FlyCommandIgnored;
+
+		auto it = std::find_if(st.derived.begin(), st.derived.end(),
+				       [&id](const FlyDerivedField &d) { return d.id == id; });
+		if (action == QLatin1String("remove_derived")) {
+			if (it == st.derived.end())
+				return FlyCommandIgnored;
+			st.derived.erase(it);
+			return FlyCommandValues;
+		}
+
+		const QString expr = fly_command_string(command, QStringLiteral("expr"));
+		if (!fly_derived_expr_error(expr).isEmpty())
+			return FlyCommandIgnored;
+		if (it != st.derived.end())
+			it->expr = expr;
+		else
+			st.derived.push_back({id, expr});
+		return FlyCommandValues;
+	}
+
+	const int index = fly_command_int(command, QStringLiteral("index"));
+	if (action == QLatin1String("add_score") || action == QLatin1String("add_field")) {
+		FlyCustomField cf;
+		cf.label = fly_command_string(command, QStringLiteral("label"));
+		if (cf.label.isEmpty())
+			cf.label = QStringLiteral("Score");
+		cf.home = std::max(0, fly_command_int(command, QStringLiteral("home")));
+		cf.away = std::max(0, fly_command_int(command, QStringLiteral("away")));
+		cf.visible = fly_command_bool(command, QStringLiteral("visible"), true);
+		st.custom_fields.push_back(cf);
+		return FlyCommandValues | FlyCommandStructure;
+	}
+	if ((action == QLatin1String("remove_score") || action == QLatin1String("remove_field")) && index >= 0 &&
+	    index < st.custom_fields.size()) {
+		if (st.custom_fields.size() <= 1)
+			return FlyCommandIgnored;
+		st.custom_fields.removeAt(index);
+		return FlyCommandValues | FlyCommandStructure;
+	}
+	if ((action == QLatin1String("set_field") || action == QLatin1String("set_score_field")) && index >= 0 &&
+	    index < st.custom_fields.size()) {
+		FlyCustomField &cf = st.custom_fields[index];
+		if (command.contains(QStringLiteral("label")))
+			cf.label = fly_command_string(command, QStringLiteral("label"));
+		if (command.contains(QStringLiteral("home")))
+			cf.home = std::max(0, fly_command_int(command, QStringLiteral("home")));
+		if (command.contains(QStringLiteral("away")))
+			cf.away = std::max(0, fly_command_int(command, QStringLiteral("away")));
+		if (command.contains(QStringLiteral("visible")))
+			cf.visible = fly_command_bool(command, QStringLiteral("visible"), cf.visible);
+		return FlyCommandValues;
+	}
+	if ((action == QLatin1String("toggle_field") || action == QLatin1String("score_visibility")) && index >= 0 &&
+	    index < st.custom_fields.size()) {
+		st.custom_fields[index].visible = !st.custom_fields[index].visible;
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("bump_score") && index >= 0 && index < st.custom_fields.size()) {
+		const QString side = fly_command_string(command, QStringLiteral("side"));
+		const int delta = fly_command_int(command, QStringLiteral("delta"), 1);
+		FlyCustomField &cf = st.custom_fields[index];
+		int &value = fly_command_side_is_away(side, st.swap_sides) ? cf.away : cf.home;
+		value = std::max(0, value + delta);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("set_score") && index >= 0 && index < st.custom_fields.size()) {
+		const QString side = fly_command_string(command, QStringLiteral("side"));
+		const int value = std::max(0, fly_command_int(command, QStringLiteral("value")));
+		FlyCustomField &cf = st.custom_fields[index];
+		(fly_command_side_is_away(side, st.swap_sides) ? cf.away : cf.home) = value;
+		return FlyCommandValues;
+	}
+
+	if (action == QLatin1String("bump_single") && index >= 0 && index < st.single_stats.size()) {
+		st.single_stats[index].value += fly_command_int(command, QStringLiteral("delta"), 1);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("toggle_single") && index >= 0 && index < st.single_stats.size()) {
+		st.single_stats[index].visible = !st.single_stats[index].visible;
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("add_single")) {
+		FlySingleStat ss;
+		ss.label = fly_command_string(command, QStringLiteral("label"));
+		if (ss.label.isEmpty())
+			ss.label = QStringLiteral("STAT");
+		ss.value = fly_command_int(command, QStringLiteral("value"));
+		ss.visible = fly_command_bool(command, QStringLiteral("visible"), true);
+		st.single_stats.push_back(ss);
+		return FlyCommandValues | FlyCommandStructure;
+	}
+	if (action == QLatin1String("remove_single") && index >= 0 && index < st.single_stats.size()) {
+		if (st.single_stats.size() <= 1)
+			return FlyCommandIgnored;
+		st.single_stats.removeAt(index);
+		return FlyCommandValues | FlyCommandStructure;
+	}
+	if (action == QLatin1String("set_single") && index >= 0 && index < st.single_stats.size()) {
+		FlySingleStat &ss = st.single_stats[index];
+		if (command.contains(QStringLiteral("label")))
+			ss.label = fly_command_string(command, QStringLiteral("label"));
+		if (command.contains(QStringLiteral("value")))
+			ss.value = fly_command_int(command, QStringLiteral("value"));
+		if (command.contains(QStringLiteral("visible")))
+			ss.visible = fly_command_bool(command, QStringLiteral("visible"), ss.visible);
+		return FlyCommandValues;
+	}
+
+	if (action == QLatin1String("add_timer")) {
+		FlyTimer timer;
+		timer.label = fly_command_string(command, QStringLiteral("label"));
+		if (timer.label.isEmpty())
+			timer.label = QStringLiteral("Timer");
+		timer.mode = fly_command_string(command, QStringLiteral("mode"));
+		if (timer.mode != QLatin1String("countup"))
+			timer.mode = QStringLiteral("countdown");
+		timer.initial_ms = std::max<qint64>(0, fly_command_int64(command, QStringLiteral("initial_ms")));
+		timer.visible = fly_command_bool(command, QStringLiteral("visible"), true);
+		setTimerStoppedAtInitial(timer);
+		st.timers.push_back(timer);
+		return FlyCommandValues | FlyCommandStructure;
+	}
+	if (action == QLatin1String("remove_timer") && index >= 0 && index < st.timers.size()) {
+		if (st.timers.size() <= 1)
+			return FlyCommandIgnored;
+		st.timers.removeAt(index);
+		return FlyCommandValues | FlyCommandStructure;
+	}
+	if (action == QLatin1String("set_timer") && index >= 0 && index < st.timers.size()) {
+		FlyTimer &timer = st.timers[index];
+		const bool wasRunning = timer.running;
+		if (timer.running)
+			fly_timer_toggle(timer, nowMs);
+
+		if (command.contains(QStringLiteral("label")))
+			timer.label = fly_command_string(command, QStringLiteral("label"));
+		if (command.contains(QStringLiteral("mode"))) {
+			const QString mode = fly_command_string(command, QStringLiteral("mode"));
+			timer.mode = mode == QLatin1String("countup") ? QStringLiteral("countup") : QStringLiteral("countdown");
+		}
+		if (command.contains(QStringLiteral("initial_ms")))
+			timer.initial_ms = std::max<qint64>(0, fly_command_int64(command, QStringLiteral("initial_ms")));
+		if (command.contains(QStringLiteral("remaining_ms")))
+			timer.remaining_ms = std::max<qint64>(0, fly_command_int64(command, QStringLiteral("remaining_ms")));
+		else if (command.contains(QStringLiteral("initial_ms")))
+			timer.remaining_ms = timer.initial_ms;
+		if (command.contains(QStringLiteral("visible")))
+			timer.visible = fly_command_bool(command, QStringLiteral("visible"), timer.visible);
+
+		timer.running = false;
+		timer.last_tick_ms = 0;
+		// Consoles resend the clock while it runs; they must not stop it.
+		if (wasRunning && fly_command_bool(command, QStringLiteral("keep_running")))
+			fly_timer_toggle(timer, nowMs);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("timer_toggle") && index >= 0 && index < st.timers.size()) {
+		fly_timer_toggle(st.timers[index], nowMs);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("timer_visibility") && index >= 0 && index < st.timers.size()) {
+		st.timers[index].visible = !st.timers[index].visible;
+		return FlyCommandValues;
+	}
+	if ((action == QLatin1String("timer_start") || action == QLatin1String("timer_pause")) && index >= 0 &&
+	    index < st.timers.size()) {
+		const bool shouldRun = action == QLatin1String("timer_start");
+		if (st.timers[index].running == shouldRun)
+			return FlyCommandIgnored;
+		fly_timer_toggle(st.timers[index], nowMs);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("timer_reset") && index >= 0 && index < st.timers.size()) {
+		FlyTimer &t = st.timers[index];
+		t.remaining_ms = std::max<qint64>(0, t.initial_ms);
+		t.running = false;
+		t.last_tick_ms = 0;
+		return FlyCommandValues;
+	}
+
+	if (action == QLatin1String("set_roster_stats")) {
+		QStringList stats;
+		for (const QJsonValue v : command.value(QStringLiteral("stats")).toArray()) {
+			const QString stat = v.toString().trimmed();
+			if (!stat.isEmpty() && !stats.contains(stat))
+				stats << stat;
+		}
+		st.roster.setStats(stats);
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("reset_roster")) {
+		st.roster.resetValues();
+		return FlyCommandValues;
+	}
+	if (action == QLatin1String("add_player") || action == QLatin1String("remove_player") ||
+	    action == QLatin1String("player_stat") || action == QLatin1String("set_player_stat")) {
+		// Teams are absolute here: a player stays on their team when sides swap.
+		const QString side = fly_command_string(command, QStringLiteral("team"));
+		const int team = fly_command_side_is_away(side, false) ? 1 : 0;
+		const int number = fly_command_int(command, QStringLiteral("number"), -1);
+		if (number < 0)
+			return FlyCommandIgnored;
+
+		if (action == QLatin1String("add_player")) {
+			st.roster.addPlayer(team, number, fly_command_string(command, QStringLiteral("name")));
+			return FlyCommandValues;
+		}
+		if (action == QLatin1String("remove_player"))
+			return st.roster.removePlayer(team, number) ? FlyCommandValues : FlyCommandIgnored;
+
+		const QJsonValue statArg = command.value(QStringLiteral("stat"));
+		const int stat = st.roster.statIndex(statArg.isDouble() ? QString::number(statArg.toInt())
+									: statArg.toString().trimmed());
+		const int row = st.roster.find(team, number);
+		if (stat < 0 || row < 0)
+			return FlyCommandIgnored;
+
+		int &cell = st.roster.values[stat][row];
+		cell = action == QLatin1String("player_stat")
+			       ? std::max(0, cell + fly_command_int(command, QStringLiteral("delta"), 1))
+			       : std::max(0, fly_command_int(command, QStringLiteral("value")));
+		return FlyCommandValues;
+	}
+
+	return FlyCommandIgnored;
+}
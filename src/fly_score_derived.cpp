@@ -0,0 +1,673 @@
+#include "fly_score_derived.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][derived]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_trace.hpp"
+
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonValue>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// Bounds on what a client may declare, so neither the recursive-descent parser
+// nor eval() can run the stack out.
+static constexpr int kMaxExprLength = 4096;
+static constexpr int kMaxExprDepth = 64;
+
+static double fly_json_number(const QJsonValue &v)
+{
+	if (v.isDouble())
+		return v.toDouble();
+	if (v.isBool())
+		return v.toBool() ? 1.0 : 0.0;
+	if (v.isString())
+		return v.toString().toDouble();
+	return 0.0;
+}
+
+static QJsonValue fly_json_from_number(double v)
+{
+	if (std::trunc(v) == v && std::fabs(v) < 9007199254740992.0)
+		return static_cast<qint64>(v);
+	return v;
+}
+
+static bool fly_is_identifier(const QString &s)
+{
+	if (s.isEmpty() || !(s[0].isLetter() || s[0] == QLatin1Char('_')))
+		return false;
+	for (const QChar c : s) {
+		if (!(c.isLetterOrNumber() || c == QLatin1Char('_')))
+			return false;
+	}
+	return true;
+}
+
+// Recursive-descent parser emitting into the engine's expression pool.
+class FlyDerivedParser {
+public:
+	using Engine = FlyDerivedEngine;
+
+	FlyDerivedParser(Engine &engine, const QString &src, QHash<QString, int> &inputKeys)
+		: e_(engine), src_(src), inputKeys_(inputKeys)
+	{
+	}
+
+	// Returns the root expression, or -1 with error() set.
+	int parse()
+	{
+		if (src_.size() > kMaxExprLength)
+			return fail(QStringLiteral("expression longer than %1 characters").arg(kMaxExprLength));
+		next();
+		const int root = parseTernary();
+		if (root >= 0 && tok_ != Tok::End)
+			return fail(QStringLiteral("unexpected '%1'").arg(text_));
+		return root;
+	}
+
+	const QString &error() const { return error_; }
+	// (expression index, name) for references to other derived ids.
+	const std::vector<std::pair<int, QString>> &nodeRefs() const { return nodeRefs_; }
+	const std::vector<int> &inputsUsed() const { return inputsUsed_; }
+
+private:
+	enum class Tok { End, Num, Ident, Str, Sym };
+
+	// Counts parseTernary/parseUnary frames on the stack.
+	struct Nesting {
+		explicit Nesting(int &depth) : depth_(depth) { ++depth_; }
+		~Nesting() { --depth_; }
+		int &depth_;
+	};
+
+	int fail(const QString &msg)
+	{
+		if (error_.isEmpty())
+			error_ = msg;
+		return -1;
+	}
+
+	void next()
+	{
+		while (pos_ < src_.size() && src_[pos_].isSpace())
+			++pos_;
+		text_.clear();
+		if (pos_ >= src_.size()) {
+			tok_ = Tok::End;
+			return;
+		}
+
+		const QChar c = src_[pos_];
+		if (c.isDigit() || (c == QLatin1Char('.') && pos_ + 1 < src_.size() && src_[pos_ + 1].isDigit())) {
+			const int start = pos_;
+			while (pos_ < src_.size() && (src_[pos_].isDigit() || src_[pos_] == QLatin1Char('.')))
+				++pos_;
+			text_ = src_.mid(start, pos_ - start);
+			bool ok = false;
+			num_ = text_.toDouble(&ok);
+			tok_ = ok ? Tok::Num : Tok::Sym;
+			return;
+		}
+		if (c.isLetter() || c == QLatin1Char('_')) {
+			const int start = pos_;
+			while (pos_ < src_.size() && (src_[pos_].isLetterOrNumber() || src_[pos_] == QLatin1Char('_')))
+				++pos_;
+			text_ = src_.mid(start, pos_ - start);
+			tok_ = Tok::Ident;
+			return;
+		}
+		if (c == QLatin1Char('"') || c == QLatin1Char('\'')) {
+			const int end = src_.indexOf(c, pos_ + 1);
+			if (end < 0) {
+				text_ = src_.mid(pos_);
+				pos_ = src_.size();
+				tok_ = Tok::Sym;
+				return;
+			}
+			text_ = src_.mid(pos_ + 1, end - pos_ - 1);
+			pos_ = end + 1;
+			tok_ = Tok::Str;
+			return;
+		}
+
+		static const char *const twoChar[] = {"<=", ">=", "==", "!=", "&&", "||"};
+		for (const char *op : twoChar) {
+			if (src_.mid(pos_, 2) == QLatin1String(op)) {
+				text_ = QLatin1String(op);
+				pos_ += 2;
+				tok_ = Tok::Sym;
+				return;
+			}
+		}
+		text_ = c;
+		++pos_;
+		tok_ = Tok::Sym;
+	}
+
+	bool accept(const char *sym)
+	{
+		if (tok_ == Tok::Sym && text_ == QLatin1String(sym)) {
+			next();
+			return true;
+		}
+		return false;
+	}
+
+	bool expect(const char *sym)
+	{
+		if (accept(sym))
+			return true;
+		fail(QStringLiteral("expected '%1'").arg(QLatin1String(sym)));
+		return false;
+	}
+
+	int emit(Engine::Op op, std::vector<int> args = {}, double num = 0, int ref = -1)
+	{
+		int depth = 1;
+		for (int a : args) {
+			if (a < 0)
+				return -1;
+			depth = std::max(depth, e_.exprs_[size_t(a)].depth + 1);
+		}
+		if (depth > kMaxExprDepth)
+			return fail(QStringLiteral("expression nested deeper than %1").arg(kMaxExprDepth));
+		Engine::Expr x;
+		x.op = op;
+		x.depth = depth;
+		x.num = num;
+		x.ref = ref;
+		x.args = std::move(args);
+		e_.exprs_.push_back(std::move(x));
+		return int(e_.exprs_.size()) - 1;
+	}
+
+	int emitInput(Engine::Input in)
+	{
+		const QString key = QStringLiteral("%1|%2|%3|%4|%5")
+					    .arg(QString::number(int(in.kind)), in.collection, QString::number(in.index),
+						 in.label, in.prop);
+		int idx = inputKeys_.value(key, -1);
+		if (idx < 0) {
+			idx = e_.addInput(std::move(in));
+			inputKeys_.insert(key, idx);
+		}
+		if (std::find(inputsUsed_.begin(), inputsUsed_.end(), idx) == inputsUsed_.end())
+			inputsUsed_.push_back(idx);
+		return emit(Engine::Op::Input, {}, 0, idx);
+	}
+
+	int parseTernary()
+	{
+		const Nesting nest(nesting_);
+		if (nesting_ > kMaxExprDepth)
+			return fail(QStringLiteral("expression nested deeper than %1").arg(kMaxExprDepth));
+		const int cond = parseBinary(0);
+		if (!accept("?"))
+			return cond;
+		const int a = parseTernary();
+		if (!expect(":"))
+			return -1;
+		const int b = parseTernary();
+		return emit(Engine::Op::Cond, {cond, a, b});
+	}
+
+	// Precedence climbing: || < && < equality < relational < additive < multiplicative.
+	int parseBinary(int level)
+	{
+		struct Level {
+			const char *syms[4];
+			Engine::Op ops[4];
+		};
+		static const Level levels[] = {
+			{{"||"}, {Engine::Op::Or}},
+			{{"&&"}, {Engine::Op::And}},
+			{{"==", "!="}, {Engine::Op::Eq, Engine::Op::Ne}},
+			{{"<", "<=", ">", ">="}, {Engine::Op::Lt, Engine::Op::Le, Engine::Op::Gt, Engine::Op::Ge}},
+			{{"+", "-"}, {Engine::Op::Add, Engine::Op::Sub}},
+			{{"*", "/", "%"}, {Engine::Op::Mul, Engine::Op::Div, Engine::Op::Mod}},
+		};
+		constexpr int kLevels = int(sizeof(levels) / sizeof(levels[0]));
+		if (level >= kLevels)
+			return parseUnary();
+
+		int lhs = parseBinary(level + 1);
+		for (;;) {
+			int matched = -1;
+			for (int i = 0; i < 4 && levels[level].syms[i]; ++i) {
+				if (tok_ == Tok::Sym && text_ == QLatin1String(levels[level].syms[i])) {
+					matched = i;
+					break;
+				}
+			}
+			if (matched < 0 || lhs < 0)
+				return lhs;
+			next();
+			const int rhs = parseBinary(level + 1);
+			lhs = emit(levels[level].ops[matched], {lhs, rhs});
+		}
+	}
+
+	int parseUnary()
+	{
+		const Nesting nest(nesting_);
+		if (nesting_ > kMaxExprDepth)
+			return fail(QStringLiteral("expression nested deeper than %1").arg(kMaxExprDepth));
+		if (accept("-"))
+			return emit(Engine::Op::Neg, {parseUnary()});
+		if (accept("+"))
+			return parseUnary();
+		if (accept("!"))
+			return emit(Engine::Op::Not, {parseUnary()});
+		return parsePrimary();
+	}
+
+	int parsePrimary()
+	{
+		if (tok_ == Tok::Num) {
+			const double v = num_;
+			next();
+			return emit(Engine::Op::Num, {}, v);
+		}
+		if (accept("(")) {
+			const int inner = parseTernary();
+			return expect(")") ? inner : -1;
+		}
+		if (tok_ == Tok::End)
+			return fail(QStringLiteral("unexpected end"));
+		if (tok_ != Tok::Ident)
+			return fail(QStringLiteral("unexpected '%1'").arg(text_));
+
+		const QString name = text_;
+		next();
+		if (tok_ == Tok::Sym && text_ == QLatin1String("("))
+			return parseCall(name);
+		if (tok_ == Tok::Sym && text_ == QLatin1String("["))
+			return parseItem(name);
+
+		if (name == QLatin1String("true") || name == QLatin1String("false"))
+			return emit(Engine::Op::Num, {}, name == QLatin1String("true") ? 1.0 : 0.0);
+		if (name == QLatin1String("swap_sides") || name == QLatin1String("show_scoreboard")) {
+			Engine::Input in;
+			in.kind = Engine::InputKind::Scalar;
+			in.prop = name;
+			return emitInput(std::move(in));
+		}
+
+		const int ref = emit(Engine::Op::Node);
+		nodeRefs_.emplace_back(ref, name);
+		return ref;
+	}
+
+	int parseCall(const QString &name)
+	{
+		next();
+		std::vector<int> args;
+		if (!accept(")")) {
+			do {
+				const int a = parseTernary();
+				if (a < 0)
+					return -1;
+				args.push_back(a);
+			} while (accept(","));
+			if (!expect(")"))
+				return -1;
+		}
+
+		struct Fn {
+			const char *name;
+			Engine::Op op;
+			int minArgs;
+			int maxArgs;
+		};
+		static const Fn fns[] = {
+			{"min", Engine::Op::Min, 1, 64},     {"max", Engine::Op::Max, 1, 64},
+			{"abs", Engine::Op::Abs, 1, 1},      {"round", Engine::Op::Round, 1, 1},
+			{"floor", Engine::Op::Floor, 1, 1},  {"ceil", Engine::Op::Ceil, 1, 1},
+			{"clamp", Engine::Op::Clamp, 3, 3},  {"pct", Engine::Op::Pct, 2, 2},
+		};
+		for (const Fn &fn : fns) {
+			if (name != QLatin1String(fn.name))
+				continue;
+			if (int(args.size()) < fn.minArgs || int(args.size()) > fn.maxArgs)
+				return fail(QStringLiteral("wrong argument count for %1()").arg(name));
+			return emit(fn.op, std::move(args));
+		}
+
+		Engine::Input in;
+		if (name == QLatin1String("sum_home"))
+			in.kind = Engine::InputKind::SumHome;
+		else if (name == QLatin1String("sum_away"))
+			in.kind = Engine::InputKind::SumAway;
+		else if (name == QLatin1String("count_fields"))
+			in.kind = Engine::InputKind::Count;
+		else
+			return fail(QStringLiteral("unknown function %1()").arg(name));
+		if (!args.empty())
+			return fail(QStringLiteral("%1() takes no arguments").arg(name));
+		in.collection = QStringLiteral("custom_fields");
+		return emitInput(std::move(in));
+	}
+
+	int parseItem(const QString &name)
+	{
+		Engine::Input in;
+		in.kind = Engine::InputKind::Item;
+		QStringList props;
+		if (name == QLatin1String("field") || name == QLatin1String("fields")) {
+			in.collection = QStringLiteral("custom_fields");
+			props = {QStringLiteral("home"), QStringLiteral("away"), QStringLiteral("visible")};
+		} else if (name == QLatin1String("single") || name == QLatin1String("singles")) {
+			in.collection = QStringLiteral("single_stats");
+			props = {QStringLiteral("value"), QStringLiteral("visible")};
+		} else if (name == QLatin1String("timer") || name == QLatin1String("timers")) {
+			in.collection = QStringLiteral("timers");
+			props = {QStringLiteral("remaining_ms"), QStringLiteral("initial_ms"), QStringLiteral("running"),
+				 QStringLiteral("visible")};
+		} else {
+			return fail(QStringLiteral("'%1' cannot be indexed").arg(name));
+		}
+
+		next();
+		if (tok_ == Tok::Num && num_ >= 0 && std::trunc(num_) == num_) {
+			in.index = int(num_);
+		} else if (tok_ == Tok::Str) {
+			in.label = text_;
+		} else {
+			return fail(QStringLiteral("expected an index or a \"label\" after %1[").arg(name));
+		}
+		next();
+		if (!expect("]"))
+			return -1;
+
+		if (accept(".")) {
+			if (tok_ != Tok::Ident || !props.contains(text_))
+				return fail(QStringLiteral("%1[] has no property '%2'").arg(name, text_));
+			in.prop = text_;
+			next();
+		} else if (in.collection == QLatin1String("custom_fields")) {
+			return fail(QStringLiteral("field[] needs .home, .away or .visible"));
+		} else {
+			in.prop = props.first();
+		}
+		return emitInput(std::move(in));
+	}
+
+	Engine &e_;
+	const QString &src_;
+	QHash<QString, int> &inputKeys_;
+	int pos_ = 0;
+	int nesting_ = 0;
+	Tok tok_ = Tok::End;
+	QString text_;
+	double num_ = 0;
+	QString error_;
+	std::vector<std::pair<int, QString>> nodeRefs_;
+	std::vector<int> inputsUsed_;
+};
+
+QString fly_derived_expr_error(const QString &expr)
+{
+	FlyDerivedEngine scratch;
+	QHash<QString, int> inputKeys;
+	FlyDerivedParser parser(scratch, expr, inputKeys);
+	return parser.parse() < 0 ? parser.error() : QString();
+}
+
+int FlyDerivedEngine::addInput(Input in)
+{
+	inputs_.push_back(std::move(in));
+	return int(inputs_.size()) - 1;
+}
+
+QStringList FlyDerivedEngine::setDefinitions(const QVector<FlyDerivedField> &defs)
+{
+	bool same = defs.size() == defs_.size();
+	for (int i = 0; same && i < defs.size(); ++i)
+		same = defs[i].id == defs_[i].id && defs[i].expr == defs_[i].expr;
+	if (same)
+		return errors_;
+
+	FLY_TRACE_SCOPE("derived_compile");
+	defs_ = defs;
+	exprs_.clear();
+	inputs_.clear();
+	nodes_.clear();
+	order_.clear();
+	values_ = QJsonObject();
+	errors_.clear();
+	primed_ = false;
+
+	auto reject = [this](Node &n, const QString &msg) {
+		if (n.ok)
+			errors_ << QStringLiteral("%1: %2").arg(n.id, msg);
+		n.ok = false;
+	};
+
+	QHash<QString, int> ids;
+	QHash<QString, int> inputKeys;
+	std::vector<std::vector<std::pair<int, QString>>> refs(size_t(defs.size()));
+
+	for (int i = 0; i < defs.size(); ++i) {
+		Node n;
+		n.id = defs[i].id;
+		if (!fly_is_identifier(n.id))
+			reject(n, QStringLiteral("invalid id"));
+		else if (ids.contains(n.id))
+			reject(n, QStringLiteral("duplicate id"));
+		else
+			ids.insert(n.id, i);
+
+		FlyDerivedParser parser(*this, defs[i].expr, inputKeys);
+		n.root = parser.parse();
+		if (n.root < 0)
+			reject(n, parser.error());
+		refs[size_t(i)] = parser.nodeRefs();
+		nodes_.push_back(std::move(n));
+		for (int in : parser.inputsUsed())
+			inputs_[size_t(in)].dependents.push_back(i);
+	}
+
+	for (int i = 0; i < int(nodes_.size()); ++i) {
+		Node &n = nodes_[size_t(i)];
+		for (const auto &[expr, name] : refs[size_t(i)]) {
+			const int dep = ids.value(name, -1);
+			if (dep < 0) {
+				reject(n, QStringLiteral("unknown name '%1'").arg(name));
+				continue;
+			}
+			exprs_[size_t(expr)].ref = dep;
+			if (std::find(n.nodeDeps.begin(), n.nodeDeps.end(), dep) == n.nodeDeps.end()) {
+				n.nodeDeps.push_back(dep);
+				nodes_[size_t(dep)].dependents.push_back(i);
+			}
+		}
+	}
+
+	// Kahn's algorithm; whatever is left over sits on a cycle.
+	std::vector<int> indegree(nodes_.size(), 0);
+	std::vector<int> ready;
+	for (int i = 0; i < int(nodes_.size()); ++i) {
+		indegree[size_t(i)] = int(nodes_[size_t(i)].nodeDeps.size());
+		if (indegree[size_t(i)] == 0)
+			ready.push_back(i);
+	}
+	std::vector<int> topo;
+	while (!ready.empty()) {
+		const int i = ready.back();
+		ready.pop_back();
+		topo.push_back(i);
+		for (int d : nodes_[size_t(i)].dependents) {
+			if (--indegree[size_t(d)] == 0)
+				ready.push_back(d);
+		}
+	}
+	for (int i = 0; i < int(nodes_.size()); ++i) {
+		if (indegree[size_t(i)] > 0)
+			reject(nodes_[size_t(i)], QStringLiteral("circular reference"));
+	}
+
+	for (int i : topo) {
+		Node &n = nodes_[size_t(i)];
+		for (int dep : n.nodeDeps) {
+			if (!nodes_[size_t(dep)].ok)
+				reject(n, QStringLiteral("depends on invalid '%1'").arg(nodes_[size_t(dep)].id));
+		}
+		if (n.ok)
+			order_.push_back(i);
+	}
+
+	for (const QString &err : errors_)
+		LOGW("Derived field rejected: %s", err.toUtf8().constData());
+	return errors_;
+}
+
+double FlyDerivedEngine::readInput(const Input &in, const QJsonObject &state) const
+{
+	switch (in.kind) {
+	case InputKind::Scalar:
+		return fly_json_number(state.value(in.prop));
+	case InputKind::Count:
+		return state.value(in.collection).toArray().size();
+	case InputKind::SumHome:
+	case InputKind::SumAway: {
+		const QString key = in.kind == InputKind::SumHome ? QStringLiteral("home") : QStringLiteral("away");
+		double sum = 0;
+		for (const QJsonValue v : state.value(in.collection).toArray())
+			sum += fly_json_number(v.toObject().value(key));
+		return sum;
+	}
+	case InputKind::Item:
+		break;
+	}
+
+	const QJsonArray arr = state.value(in.collection).toArray();
+	if (in.index >= 0)
+		return in.index < arr.size() ? fly_json_number(arr.at(in.index).toObject().value(in.prop)) : 0.0;
+	for (const QJsonValue v : arr) {
+		const QJsonObject o = v.toObject();
+		if (o.value(QStringLiteral("label")).toString() == in.label)
+			return fly_json_number(o.value(in.prop));
+	}
+	return 0.0;
+}
+
+double FlyDerivedEngine::eval(int idx) const
+{
+	const Expr &x = exprs_[size_t(idx)];
+	auto arg = [&](size_t i) { return eval(x.args[i]); };
+
+	switch (x.op) {
+	case Op::Num:
+		return x.num;
+	case Op::Input:
+		return inputs_[size_t(x.ref)].value;
+	case Op::Node:
+		return nodes_[size_t(x.ref)].value;
+	case Op::Neg:
+		return -arg(0);
+	case Op::Not:
+		return arg(0) == 0.0 ? 1.0 : 0.0;
+	case Op::Add:
+		return arg(0) + arg(1);
+	case Op::Sub:
+		return arg(0) - arg(1);
+	case Op::Mul:
+		return arg(0) * arg(1);
+	case Op::Div: {
+		const double d = arg(1);
+		return d == 0.0 ? 0.0 : arg(0) / d;
+	}
+	case Op::Mod: {
+		const double d = arg(1);
+		return d == 0.0 ? 0.0 : std::fmod(arg(0), d);
+	}
+	case Op::Lt:
+		return arg(0) < arg(1) ? 1.0 : 0.0;
+	case Op::Le:
+		return arg(0) <= arg(1) ? 1.0 : 0.0;
+	case Op::Gt:
+		return arg(0) > arg(1) ? 1.0 : 0.0;
+	case Op::Ge:
+		return arg(0) >= arg(1) ? 1.0 : 0.0;
+	case Op::Eq:
+		return arg(0) == arg(1) ? 1.0 : 0.0;
+	case Op::Ne:
+		return arg(0) != arg(1) ? 1.0 : 0.0;
+	case Op::And:
+		return arg(0) != 0.0 && arg(1) != 0.0 ? 1.0 : 0.0;
+	case Op::Or:
+		return arg(0) != 0.0 || arg(1) != 0.0 ? 1.0 : 0.0;
+	case Op::Cond:
+		return arg(0) != 0.0 ? arg(1) : arg(2);
+	case Op::Min:
+	case Op::Max: {
+		double v = arg(0);
+		for (size_t i = 1; i < x.args.size(); ++i)
+			v = x.op == Op::Min ? std::min(v, arg(i)) : std::max(v, arg(i));
+		return v;
+	}
+	case Op::Abs:
+		return std::fabs(arg(0));
+	case Op::Round:
+		return std::round(arg(0));
+	case Op::Floor:
+		return std::floor(arg(0));
+	case Op::Ceil:
+		return std::ceil(arg(0));
+	case Op::Clamp: {
+		const double lo = arg(1);
+		const double hi = arg(2);
+		return lo <= hi ? std::clamp(arg(0), lo, hi) : lo;
+	}
+	case Op::Pct: {
+		const double total = arg(1);
+		return total == 0.0 ? 0.0 : 100.0 * arg(0) / total;
+	}
+	}
+	return 0.0;
+}
+
+QJsonObject FlyDerivedEngine::update(const QJsonObject &state)
+{
+	lastRecomputed_ = 0;
+	if (order_.empty())
+		return values_;
+
+	FLY_TRACE_SCOPE("derived_update");
+	std::vector<char> dirty(nodes_.size(), primed_ ? 0 : 1);
+	for (Input &in : inputs_) {
+		double v = readInput(in, state);
+		if (!std::isfinite(v))
+			v = 0.0;
+		if (in.read && v == in.value)
+			continue;
+		in.value = v;
+		in.read = true;
+		for (int d : in.dependents)
+			dirty[size_t(d)] = 1;
+	}
+
+	for (int i : order_) {
+		if (!dirty[size_t(i)])
+			continue;
+		Node &n = nodes_[size_t(i)];
+		double v = eval(n.root);
+		if (!std::isfinite(v))
+			v = 0.0;
+		++lastRecomputed_;
+		if (primed_ && v == n.value)
+			continue;
+		n.value = v;
+		values_.insert(n.id, fly_json_from_number(v));
+		for (int d : n.dependents)
+			dirty[size_t(d)] = 1;
+	}
+
+	primed_ = true;
+	return values_;
+}
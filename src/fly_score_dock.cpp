@@ -14,13 +14,23 @@
 #include "fly_score_logo_helpers.hpp"
 #include "fly_score_teams_dialog.hpp"
 #include "fly_score_fields_dialog.hpp"
+#include "fly_score_field_rows.hpp"
 #include "fly_score_timers_dialog.hpp"
+#include "fly_score_hotkeys.hpp"
 #include "fly_score_hotkeys_dialog.hpp"
+#include "fly_score_obs_hotkeys.hpp"
 #include "fly_score_websocket_server.hpp"
-
-#ifdef ENABLE_EMBEDDED_DEFAULTS
-#include "embedded_assets.hpp"
-#endif
+#include "fly_score_theme_index.hpp"
+#include "fly_score_template_swap.hpp"
+#include "fly_score_template_watcher.hpp"
+#include "fly_score_commands.hpp"
+#include "fly_score_ingest.hpp"
+#include "fly_score_presets.hpp"
+#include "fly_score_boards.hpp"
+#include "fly_score_metrics.hpp"
+#include "fly_score_trace.hpp"
+#include "fly_score_settings.hpp"
+#include "fly_score_embedded.hpp"
 
 #include <obs.h>
 #ifdef ENABLE_FRONTEND_API
@@ -31,39 +41,41 @@
 #include <QBoxLayout>
 #include <QCheckBox>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QFileDialog>
 #include <QFileInfo>
-#include <QSettings>
 #include <QGridLayout>
 #include <QGroupBox>
 #include <QHash>
+#include <QInputDialog>
 #include <QJsonObject>
 #include <QLabel>
 #include <QLineEdit>
+#include <QMenu>
 #include <QMessageBox>
 #include <QPushButton>
 #include <QComboBox>
 #include <QMetaObject>
+#include <QSet>
 #include <QShortcut>
 #include <QSignalBlocker>
 #include <QSizePolicy>
 #include <QSpinBox>
 #include <QTabWidget>
-#include <QTextStream>
+#include <QTimer>
 #include <QSpacerItem>
 #include <algorithm>
 #include <limits>
+#include <utility>
 #include <QToolButton>
 
-static inline QString fly_settings_org_name()
-{
-	return QStringLiteral("MMLTech");
-}
-static inline QString fly_settings_app_name()
-{
-	return QStringLiteral("fly-scoreboard");
-}
+static constexpr int kMetricsLogIntervalMs = 60000;
+static constexpr int kIngestStatusIntervalMs = 1000;
+static constexpr qint64 kIngestStaleMs = 3000;
+static constexpr int kDefaultRateBurst = 40;
+static constexpr int kDefaultRatePerSec = 20;
+
 static inline QString fly_settings_key_browser_source()
 {
 	return QStringLiteral("dock/browser_source_name");
@@ -76,47 +88,128 @@ static inline QString fly_settings_key_websocket_port()
 {
 	return QStringLiteral("websocket/port");
 }
+static inline QString fly_settings_key_rate_burst()
+{
+	return QStringLiteral("websocket/rate_burst");
+}
+static inline QString fly_settings_key_rate_per_sec()
+{
+	return QStringLiteral("websocket/rate_per_sec");
+}
+static inline QString fly_settings_key_local_socket()
+{
+	return QStringLiteral("ipc/local_name");
+}
+static inline QString fly_settings_key_shm_name()
+{
+	return QStringLiteral("ipc/shm_name");
+}
+static inline QString fly_settings_key_ingest_sources()
+{
+	return QStringLiteral("ingest/sources");
+}
 
 static QString fly_load_saved_browser_source_name()
 {
-	QSettings s(fly_settings_org_name(), fly_settings_app_name());
-	return s.value(fly_settings_key_browser_source()).toString().trimmed();
+	return fly_settings().string(fly_settings_key_browser_source()).trimmed();
 }
 
 static void fly_save_browser_source_name(const QString &name)
 {
-	QSettings s(fly_settings_org_name(), fly_settings_app_name());
-	if (name.trimmed().isEmpty()) {
-		s.remove(fly_settings_key_browser_source());
-	} else {
-		s.setValue(fly_settings_key_browser_source(), name.trimmed());
-	}
-	s.sync();
+	if (name.trimmed().isEmpty())
+		fly_settings().remove(fly_settings_key_browser_source());
+	else
+		fly_settings().setValue(fly_settings_key_browser_source(), name.trimmed());
 }
 
 static QString fly_load_templates_root()
 {
-	QSettings s(fly_settings_org_name(), fly_settings_app_name());
-	return s.value(fly_settings_key_templates_root()).toString().trimmed();
+	return fly_settings().string(fly_settings_key_templates_root()).trimmed();
 }
 
 static void fly_save_templates_root(const QString &path)
 {
-	QSettings s(fly_settings_org_name(), fly_settings_app_name());
 	if (path.trimmed().isEmpty())
-		s.remove(fly_settings_key_templates_root());
+		fly_settings().remove(fly_settings_key_templates_root());
 	else
-		s.setValue(fly_settings_key_templates_root(), QDir(path).absolutePath());
-	s.sync();
+		fly_settings().setValue(fly_settings_key_templates_root(), QDir(path).absolutePath());
 }
 
 static quint16 fly_load_websocket_port()
 {
-	QSettings s(fly_settings_org_name(), fly_settings_app_name());
-	const int p = s.value(fly_settings_key_websocket_port(), 4457).toInt();
+	const int p = fly_settings().integer(fly_settings_key_websocket_port(), 4457);
 	return static_cast<quint16>((p > 0 && p <= 65535) ? p : 4457);
 }
 
+// Per-client command limit; a rate of 0 turns it off.
+static void fly_apply_rate_limit(FlyScoreWebSocketServer *server)
+{
+	const int burst = fly_settings().integer(fly_settings_key_rate_burst(), kDefaultRateBurst);
+	const int rate = fly_settings().integer(fly_settings_key_rate_per_sec(), kDefaultRatePerSec);
+	server->setRateLimit(burst > 0 ? burst : kDefaultRateBurst, qMax(0, rate));
+}
+
+// Empty disables the local control channel.
+static QString fly_load_local_socket_name()
+{
+	return fly_settings().string(fly_settings_key_local_socket(), QStringLiteral("fly-scoreboard")).trimmed();
+}
+
+// Empty (the default) leaves shared-memory publishing off.
+static QString fly_load_shm_name()
+{
+	return fly_settings().string(fly_settings_key_shm_name()).trimmed();
+}
+
+static QVector<FlyIngestSourceConfig> fly_load_ingest_sources()
+{
+	QVector<FlyIngestSourceConfig> sources;
+	for (const QVariantMap &row : fly_settings().array(fly_settings_key_ingest_sources())) {
+		FlyIngestSourceConfig config;
+		const int port = row.value(QStringLiteral("port")).toInt();
+		config.port = static_cast<quint16>((port > 0 && port <= 65535) ? port : 0);
+		config.adapter = row.value(QStringLiteral("adapter")).toString();
+		config.board = fly_board_normalize_id(row.value(QStringLiteral("board")).toString());
+		config.address = row.value(QStringLiteral("address"), config.address).toString().trimmed();
+		if (config.port)
+			sources.push_back(config);
+	}
+	return sources;
+}
+
+static void fly_save_ingest_sources(const QVector<FlyIngestSourceConfig> &sources)
+{
+	QList<QVariantMap> rows;
+	rows.reserve(sources.size());
+	for (const FlyIngestSourceConfig &config : sources) {
+		rows.push_back({{QStringLiteral("address"), config.address},
+				{QStringLiteral("port"), config.port},
+				{QStringLiteral("adapter"), config.adapter},
+				{QStringLiteral("board"), config.board}});
+	}
+	fly_settings().setArray(fly_settings_key_ingest_sources(), rows);
+}
+
+static QString fly_ingest_source_title(const FlyIngestSourceConfig &config)
+{
+	return fly_i18n("Dock.IngestSource").arg(config.address).arg(config.port).arg(config.adapter, config.board);
+}
+
+static QString fly_ingest_health_text(const FlyIngestHealth &h, qint64 nowMs)
+{
+	if (!h.error.isEmpty())
+		return fly_i18n("Dock.IngestError").arg(h.error);
+	if (h.lastPacketMs <= 0)
+		return fly_i18n("Dock.IngestWaiting");
+
+	const qint64 ageMs = std::max<qint64>(0, nowMs - h.lastPacketMs);
+	return fly_i18n(ageMs < kIngestStaleMs ? "Dock.IngestLive" : "Dock.IngestStale")
+		.arg(h.packets)
+		.arg(h.malformed)
+		.arg(ageMs / 1000)
+		.arg(h.lastSender);
+}
+
 static void updateWidgetCarouselToggleUi(QPushButton *btn, QWidget *carousel, QStyle *st)
 {
 	if (!btn || !carousel || !st)
@@ -158,158 +251,168 @@ FlyScoreDock::FlyScoreDock(QWidget *parent) : QWidget(parent)
 	setSizePolicy(sp);
 }
 
-QList<FlyHotkeyBinding> FlyScoreDock::buildDefaultHotkeyBindings() const
+QList<FlyHotkeyBinding> FlyScoreDock::buildMergedHotkeyBindings() const
 {
-	QList<FlyHotkeyBinding> v;
-
-	v.push_back({"swap_sides", fly_i18n("Hotkey.SwapSides"), QKeySequence()});
-	v.push_back({"toggle_scoreboard", fly_i18n("Hotkey.ToggleScoreboard"), QKeySequence()});
-
-	for (int i = 0; i < st_.custom_fields.size(); ++i) {
-		const auto &cf = st_.custom_fields[i];
-		const QString label = cf.label.isEmpty() ? fly_i18n("Hotkey.CustomFieldN").arg(i + 1) : cf.label;
-		const QString baseId = QStringLiteral("field_%1").arg(i);
-
-		v.push_back({baseId + "_toggle", fly_i18n("Hotkey.CustomToggle").arg(label), QKeySequence()});
-		v.push_back({baseId + "_home_inc", fly_i18n("Hotkey.CustomHomeInc").arg(label), QKeySequence()});
-		v.push_back({baseId + "_home_dec", fly_i18n("Hotkey.CustomHomeDec").arg(label), QKeySequence()});
-		v.push_back({baseId + "_away_inc", fly_i18n("Hotkey.CustomGuestsInc").arg(label), QKeySequence()});
-		v.push_back({baseId + "_away_dec", fly_i18n("Hotkey.CustomGuestsDec").arg(label), QKeySequence()});
-	}
-
-	for (int i = 0; i < st_.single_stats.size(); ++i) {
-		const auto &ss = st_.single_stats[i];
-		const QString label = ss.label.isEmpty() ? fly_i18n("Hotkey.SingleStatN").arg(i + 1) : ss.label;
-		const QString baseId = QStringLiteral("single_%1").arg(i);
-
-		v.push_back({baseId + "_toggle", fly_i18n("Hotkey.SingleToggle").arg(label), QKeySequence()});
-		v.push_back({baseId + "_inc", fly_i18n("Hotkey.SingleInc").arg(label), QKeySequence()});
-		v.push_back({baseId + "_dec", fly_i18n("Hotkey.SingleDec").arg(label), QKeySequence()});
-	}
-
-	for (int i = 0; i < st_.timers.size(); ++i) {
-		const auto &tm = st_.timers[i];
-		const QString label = tm.label.isEmpty() ? fly_i18n("Hotkey.TimerN").arg(i + 1) : tm.label;
-		const QString baseId = QStringLiteral("timer_%1").arg(i);
+	const QVector<FlyPreset> presets = boardPresets_.value(activeBoardId_);
+	return fly_hotkeys_merge(fly_hotkeys_default_bindings(st_, presets), hotkeyBindings_);
+}
 
-		v.push_back({baseId + "_toggle", fly_i18n("Hotkey.TimerToggle").arg(label), QKeySequence()});
+void FlyScoreDock::clearAllHotkeys()
+{
+	for (const FlyHotkeyRegistration &reg : std::as_const(hotkeyRegs_)) {
+		fly_obs_hotkey_unregister(reg.obsId);
+		if (reg.shortcut)
+			reg.shortcut->deleteLater();
 	}
-
-	return v;
+	hotkeyRegs_.clear();
 }
 
-QList<FlyHotkeyBinding> FlyScoreDock::buildMergedHotkeyBindings() const
+void FlyScoreDock::runHotkeyAction(const FlyHotkeyAction &action, uint64_t pressedUs)
 {
-	QList<FlyHotkeyBinding> merged = buildDefaultHotkeyBindings();
-
-	if (hotkeyBindings_.isEmpty())
-		return merged;
-
-	QHash<QString, QKeySequence> existing;
-	existing.reserve(hotkeyBindings_.size());
-	for (const auto &b : hotkeyBindings_)
-		existing.insert(b.actionId, b.sequence);
+	// Stamped first so the broadcast the action causes gets an input time.
+	if (webSocketServer_)
+		webSocketServer_->markInput(pressedUs);
 
-	for (auto &b : merged) {
-		if (existing.contains(b.actionId))
-			b.sequence = existing.value(b.actionId);
+	switch (action.kind) {
+	case FlyHotkeyKind::SwapSides:
+		toggleSwap();
+		break;
+	case FlyHotkeyKind::ToggleScoreboard:
+		toggleScoreboardVisible();
+		break;
+	case FlyHotkeyKind::FieldToggle:
+		toggleCustomFieldVisible(action.index);
+		break;
+	case FlyHotkeyKind::FieldHome:
+		bumpCustomFieldHome(action.index, action.delta);
+		break;
+	case FlyHotkeyKind::FieldAway:
+		bumpCustomFieldAway(action.index, action.delta);
+		break;
+	case FlyHotkeyKind::SingleToggle:
+		toggleSingleStatVisible(action.index);
+		break;
+	case FlyHotkeyKind::SingleBump:
+		bumpSingleStat(action.index, action.delta);
+		break;
+	case FlyHotkeyKind::TimerToggle:
+		toggleTimerRunning(action.index);
+		break;
+	case FlyHotkeyKind::Undo:
+	case FlyHotkeyKind::Redo:
+		if (const FlyBoard *board = findBoard(activeBoardId_))
+			stepHistory(*board, action.kind == FlyHotkeyKind::Redo);
+		break;
+	case FlyHotkeyKind::Preset:
+		if (const FlyBoard *board = findBoard(activeBoardId_))
+			applyPreset(*board, action.preset);
+		break;
+	case FlyHotkeyKind::None:
+		break;
+	}
+}
+
+void FlyScoreDock::registerHotkey(const FlyHotkeyBinding &b)
+{
+	FlyHotkeyRegistration reg;
+	reg.binding = b;
+	reg.obsId = fly_obs_hotkey_register(b.actionId, b.label, b.sequence, this,
+					    [this, action = b.action](uint64_t pressedUs) {
+						    runHotkeyAction(action, pressedUs);
+					    },
+					    [this, actionId = b.actionId](const QKeySequence &seq) {
+						    onObsHotkeyRebound(actionId, seq);
+					    });
+	if (reg.obsId == kFlyObsHotkeyInvalid) {
+		// No libobs key for this sequence: fall back to a shortcut that only
+		// fires while OBS has focus.
+		reg.shortcut = new QShortcut(b.sequence, this);
+		reg.shortcut->setContext(Qt::ApplicationShortcut);
+		connect(reg.shortcut, &QShortcut::activated, this,
+			[this, action = b.action]() { runHotkeyAction(action, fly_trace_now_us()); });
+	}
+	hotkeyRegs_.insert(b.actionId, reg);
+}
+
+// OBS Settings > Hotkeys edits the same binding: adopt it and save hotkeys.json,
+// or the next rebind from the dock would overwrite it.
+void FlyScoreDock::onObsHotkeyRebound(const QString &actionId, const QKeySequence &seq)
+{
+	QList<FlyHotkeyBinding> bindings = hotkeyBindings_;
+	for (FlyHotkeyBinding &b : bindings) {
+		if (b.actionId != actionId)
+			continue;
+		if (b.sequence == seq)
+			return;
+		LOGI("Hotkey %s rebound in OBS settings: %s", actionId.toUtf8().constData(),
+		     seq.toString(QKeySequence::PortableText).toUtf8().constData());
+		b.sequence = seq;
+		applyHotkeyBindings(bindings, true);
+		return;
 	}
+}
 
-	return merged;
+void FlyScoreDock::unregisterHotkey(const QString &actionId)
+{
+	const FlyHotkeyRegistration reg = hotkeyRegs_.take(actionId);
+	fly_obs_hotkey_unregister(reg.obsId);
+	if (reg.shortcut)
+		reg.shortcut->deleteLater();
 }
 
-void FlyScoreDock::clearAllShortcuts()
+// Bindings belong to the board: hotkeys.json sits next to its state, so extra
+// boards keep theirs in boards/<id>/. Until one is saved there, an extra board
+// starts from the bindings of its template folder.
+void FlyScoreDock::loadHotkeyBindings()
 {
-	for (auto *sc : shortcuts_) {
-		if (sc)
-			sc->deleteLater();
-	}
-	shortcuts_.clear();
+	hotkeyBindings_ = fly_hotkeys_load(stateDir_);
+	if (hotkeyBindings_.isEmpty() && !isDefaultBoardActive())
+		hotkeyBindings_ = fly_hotkeys_load(dataDir_);
+	hotkeyBindings_ = buildMergedHotkeyBindings();
+	applyHotkeyBindings(hotkeyBindings_);
 }
 
-void FlyScoreDock::applyHotkeyBindings(const QList<FlyHotkeyBinding> &bindings)
+void FlyScoreDock::applyHotkeyBindings(const QList<FlyHotkeyBinding> &bindings, bool persist)
 {
-	clearAllShortcuts();
+	FLY_TRACE_SCOPE_CAT("dock", "applyHotkeyBindings");
+	const bool edited = !fly_hotkeys_same_sequences(hotkeyBindings_, bindings);
 	hotkeyBindings_ = bindings;
+	if (persist && edited)
+		fly_hotkeys_save(stateDir_, hotkeyBindings_);
 
-	fly_hotkeys_save(dataDir_, hotkeyBindings_);
-
-	for (const auto &b : bindings) {
-		if (b.sequence.isEmpty())
+	// Only bindings whose sequence or action changed are re-registered.
+	QSet<QString> bound;
+	for (const FlyHotkeyBinding &b : bindings) {
+		if (b.sequence.isEmpty() || b.action.kind == FlyHotkeyKind::None)
 			continue;
-
-		auto *sc = new QShortcut(b.sequence, this);
-		sc->setContext(Qt::ApplicationShortcut);
-		shortcuts_.push_back(sc);
-
-		const QString &id = b.actionId;
-
-		if (id == QLatin1String("swap_sides")) {
-			connect(sc, &QShortcut::activated, this, [this]() { toggleSwap(); });
-		} else if (id == QLatin1String("toggle_scoreboard")) {
-			connect(sc, &QShortcut::activated, this, [this]() { toggleScoreboardVisible(); });
-
-		} else if (id.startsWith(QLatin1String("field_"))) {
-			const auto parts = id.split(QLatin1Char('_'));
-			if (parts.size() < 3)
-				continue;
-
-			bool ok = false;
-			int idx = parts[1].toInt(&ok);
-			if (!ok)
-				continue;
-
-			if (parts.size() == 3 && parts[2] == QLatin1String("toggle")) {
-				connect(sc, &QShortcut::activated, this,
-					[this, idx]() { toggleCustomFieldVisible(idx); });
-			} else if (parts.size() == 4) {
-				const QString side = parts[2];
-				const QString dir = parts[3];
-
-				if (side == QLatin1String("home") && dir == QLatin1String("inc"))
-					connect(sc, &QShortcut::activated, this,
-						[this, idx]() { bumpCustomFieldHome(idx, +1); });
-				else if (side == QLatin1String("home") && dir == QLatin1String("dec"))
-					connect(sc, &QShortcut::activated, this,
-						[this, idx]() { bumpCustomFieldHome(idx, -1); });
-				else if (side == QLatin1String("away") && dir == QLatin1String("inc"))
-					connect(sc, &QShortcut::activated, this,
-						[this, idx]() { bumpCustomFieldAway(idx, +1); });
-				else if (side == QLatin1String("away") && dir == QLatin1String("dec"))
-					connect(sc, &QShortcut::activated, this,
-						[this, idx]() { bumpCustomFieldAway(idx, -1); });
-			}
-
-		} else if (id.startsWith(QLatin1String("single_"))) {
-			const auto parts = id.split(QLatin1Char('_'));
-			if (parts.size() != 3)
-				continue;
-
-			bool ok = false;
-			int idx = parts[1].toInt(&ok);
-			if (!ok)
-				continue;
-
-			const QString action = parts[2];
-			if (action == QLatin1String("toggle"))
-				connect(sc, &QShortcut::activated, this,
-					[this, idx]() { toggleSingleStatVisible(idx); });
-			else if (action == QLatin1String("inc"))
-				connect(sc, &QShortcut::activated, this, [this, idx]() { bumpSingleStat(idx, +1); });
-			else if (action == QLatin1String("dec"))
-				connect(sc, &QShortcut::activated, this, [this, idx]() { bumpSingleStat(idx, -1); });
-
-		} else if (id.startsWith(QLatin1String("timer_"))) {
-			const auto parts = id.split(QLatin1Char('_'));
-			if (parts.size() == 3 && parts[2] == QLatin1String("toggle")) {
-				bool ok = false;
-				int idx = parts[1].toInt(&ok);
-				if (!ok)
+		bound.insert(b.actionId);
+
+		const auto it = hotkeyRegs_.find(b.actionId);
+		if (it != hotkeyRegs_.end() && it->binding.action == b.action) {
+			if (it->binding.sequence != b.sequence) {
+				if (it->shortcut || !fly_obs_hotkey_rebind(it->obsId, b.sequence)) {
+					unregisterHotkey(b.actionId);
+					registerHotkey(b);
 					continue;
-
-				connect(sc, &QShortcut::activated, this, [this, idx]() { toggleTimerRunning(idx); });
+				}
+				it->binding.sequence = b.sequence;
 			}
+			if (it->binding.label != b.label) {
+				fly_obs_hotkey_set_label(it->obsId, b.label);
+				it->binding.label = b.label;
+			}
+			continue;
 		}
+
+		if (it != hotkeyRegs_.end())
+			unregisterHotkey(b.actionId);
+		registerHotkey(b);
+	}
+
+	const QStringList registered = hotkeyRegs_.keys();
+	for (const QString &id : registered) {
+		if (!bound.contains(id))
+			unregisterHotkey(id);
 	}
 }
 
@@ -320,8 +423,10 @@ void FlyScoreDock::openHotkeysDialog()
 	auto *dlg = new FlyHotkeysDialog(initial, this);
 	dlg->setAttribute(Qt::WA_DeleteOnClose, true);
 
-	connect(dlg, &FlyHotkeysDialog::bindingsChanged, this,
-		[this](const QList<FlyHotkeyBinding> &b) { applyHotkeyBindings(b); });
+	connect(dlg, &FlyHotkeysDialog::bindingsChanged, this, [this](const QList<FlyHotkeyBinding> &b) {
+		const QVector<FlyPreset> presets = boardPresets_.value(activeBoardId_);
+		applyHotkeyBindings(fly_hotkeys_merge(fly_hotkeys_default_bindings(st_, presets), b), true);
+	});
 
 	dlg->show();
 }
@@ -329,11 +434,20 @@ void FlyScoreDock::openHotkeysDialog()
 bool FlyScoreDock::init()
 {
 	dataDir_ = fly_get_data_root();
+	boards_ = fly_boards_load();
+	activeBoardId_ = fly_load_active_board_id();
+	const FlyBoard *activeBoard = findBoard(activeBoardId_);
+	if (!activeBoard) {
+		activeBoardId_ = fly_default_board_id();
+		activeBoard = findBoard(activeBoardId_);
+	}
+	if (!isDefaultBoardActive())
+		dataDir_ = activeBoard->templatePath;
+	stateDir_ = fly_board_state_dir(*activeBoard);
 
 	loadState();
-	ensureResourcesDefaults();
-
-	hotkeyBindings_ = fly_hotkeys_load(dataDir_);
+	boardPresets(*activeBoard);
+	histories_[activeBoardId_].begin(st_);
 
 	setObjectName(QStringLiteral("FlyScoreDock"));
 	setAttribute(Qt::WA_StyledBackground, true);
@@ -353,6 +467,40 @@ bool FlyScoreDock::init()
 
 	outer->addWidget(content);
 
+	{
+		auto *boardRow = new QHBoxLayout();
+		boardRow->setContentsMargins(0, 0, 0, 0);
+		boardRow->setSpacing(6);
+
+		boardCombo_ = new QComboBox(content);
+		boardCombo_->setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+		boardCombo_->setToolTip(fly_i18n("Dock.BoardTooltip"));
+
+		auto *addBoardBtn = new QToolButton(content);
+		addBoardBtn->setText(QStringLiteral("+"));
+		addBoardBtn->setToolTip(fly_i18n("Dock.AddBoard"));
+		addBoardBtn->setCursor(Qt::PointingHandCursor);
+
+		removeBoardBtn_ = new QToolButton(content);
+		removeBoardBtn_->setText(QStringLiteral("−"));
+		removeBoardBtn_->setToolTip(fly_i18n("Dock.RemoveBoard"));
+		removeBoardBtn_->setCursor(Qt::PointingHandCursor);
+
+		boardRow->addWidget(new QLabel(fly_i18n("Dock.Board"), content));
+		boardRow->addWidget(boardCombo_, 1);
+		boardRow->addWidget(addBoardBtn);
+		boardRow->addWidget(removeBoardBtn_);
+		root->addLayout(boardRow);
+
+		refreshBoardCombo();
+		connect(boardCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int idx) {
+			if (idx >= 0)
+				switchBoard(boardCombo_->itemData(idx).toString());
+		});
+		connect(addBoardBtn, &QToolButton::clicked, this, &FlyScoreDock::onAddBoard);
+		connect(removeBoardBtn_, &QToolButton::clicked, this, &FlyScoreDock::onRemoveBoard);
+	}
+
 	const QString cardStyle = QStringLiteral("QGroupBox {"
 						 "  background-color: rgba(255, 255, 255, 0.06);"
 						 "  border: 1px solid rgba(255, 255, 255, 0.10);"
@@ -471,12 +619,18 @@ bool FlyScoreDock::init()
 	setTemplatesRootBtn_->setCursor(Qt::PointingHandCursor);
 	setTemplatesRootBtn_->setToolTip(fly_i18n("Dock.TemplatesRootTooltip"));
 
+	forkTemplateBtn_ = new QPushButton(fly_i18n("Dock.ForkTemplate"), content);
+	forkTemplateBtn_->setCursor(Qt::PointingHandCursor);
+	forkTemplateBtn_->setToolTip(fly_i18n("Dock.ForkTemplateTooltip"));
+	forkTemplateBtn_->setVisible(false);
+
 	webSocketStatus_ = new QLabel(content);
 	webSocketStatus_->setTextInteractionFlags(Qt::TextSelectableByMouse);
 	webSocketStatus_->setToolTip(fly_i18n("Dock.WebSocketTooltip"));
 
 	templateRow->addWidget(templateLbl);
 	templateRow->addWidget(templateCombo_, 1);
+	templateRow->addWidget(forkTemplateBtn_);
 	templateRow->addWidget(setTemplatesRootBtn_);
 	templateRow->addWidget(webSocketStatus_);
 	root->addLayout(templateRow);
@@ -504,10 +658,59 @@ bool FlyScoreDock::init()
 	toggleCarouselBtn_->setCheckable(true);
 	toggleCarouselBtn_->setCursor(Qt::PointingHandCursor);
 
+	auto *traceBtn = new QToolButton(content);
+	traceBtn->setText(QStringLiteral("⏱️"));
+	traceBtn->setCursor(Qt::PointingHandCursor);
+	traceBtn->setToolTip(fly_i18n("Dock.TraceTooltip"));
+	traceBtn->setPopupMode(QToolButton::InstantPopup);
+	auto *traceMenu = new QMenu(traceBtn);
+	traceEnableAct_ = traceMenu->addAction(fly_i18n("Dock.TraceEnable"));
+	traceEnableAct_->setCheckable(true);
+	traceEnableAct_->setChecked(fly_trace_enabled());
+	QAction *traceDumpAct = traceMenu->addAction(fly_i18n("Dock.TraceDump"));
+	traceBtn->setMenu(traceMenu);
+	connect(traceEnableAct_, &QAction::toggled, this, &FlyScoreDock::onToggleTracing);
+	connect(traceDumpAct, &QAction::triggered, this, &FlyScoreDock::onDumpTrace);
+
+	ingestBtn_ = new QToolButton(content);
+	ingestBtn_->setText(QStringLiteral("📡"));
+	ingestBtn_->setCursor(Qt::PointingHandCursor);
+	ingestBtn_->setToolTip(fly_i18n("Dock.IngestTooltip"));
+	ingestBtn_->setPopupMode(QToolButton::InstantPopup);
+	ingestBtn_->setMenu(new QMenu(ingestBtn_));
+	connect(ingestBtn_->menu(), &QMenu::aboutToShow, this, &FlyScoreDock::rebuildIngestMenu);
+
+	undoBtn_ = new QToolButton(content);
+	undoBtn_->setText(QStringLiteral("↶"));
+	undoBtn_->setCursor(Qt::PointingHandCursor);
+	redoBtn_ = new QToolButton(content);
+	redoBtn_->setText(QStringLiteral("↷"));
+	redoBtn_->setCursor(Qt::PointingHandCursor);
+	for (QToolButton *btn : {undoBtn_, redoBtn_}) {
+		connect(btn, &QToolButton::clicked, this, [this, redo = btn == redoBtn_]() {
+			if (const FlyBoard *board = findBoard(activeBoardId_))
+				stepHistory(*board, redo);
+		});
+	}
+	updateHistoryButtons();
+
+	presetsBtn_ = new QToolButton(content);
+	presetsBtn_->setText(QStringLiteral("🎬"));
+	presetsBtn_->setCursor(Qt::PointingHandCursor);
+	presetsBtn_->setToolTip(fly_i18n("Dock.PresetsTooltip"));
+	presetsBtn_->setPopupMode(QToolButton::InstantPopup);
+	presetsBtn_->setMenu(new QMenu(presetsBtn_));
+	connect(presetsBtn_->menu(), &QMenu::aboutToShow, this, &FlyScoreDock::rebuildPresetsMenu);
+
 	bottomRow->addWidget(browserSourceCombo_, 1);
 	bottomRow->addWidget(clearBtn);
+	bottomRow->addWidget(undoBtn_);
+	bottomRow->addWidget(redoBtn_);
+	bottomRow->addWidget(presetsBtn_);
 	bottomRow->addStretch(1);
 	bottomRow->addWidget(toggleCarouselBtn_);
+	bottomRow->addWidget(traceBtn);
+	bottomRow->addWidget(ingestBtn_);
 	bottomRow->addWidget(hotkeysBtn);
 
 	root->addLayout(bottomRow);
@@ -516,8 +719,9 @@ bool FlyScoreDock::init()
 	widgetCarousel_ = create_widget_carousel(this);
 	root->addWidget(widgetCarousel_);
 
-	refreshBrowserSourceCombo(true);
-	refreshTemplateCombo(true);
+	templateWatcher_ = new FlyTemplateWatcher(this);
+	connect(templateWatcher_, &FlyTemplateWatcher::templateChanged, this, &FlyScoreDock::onTemplateFilesChanged);
+
 	connect(browserSourceCombo_, QOverload<int>::of(&QComboBox::currentIndexChanged), this, [this](int idx) {
 		const QString name = selectedBrowserSourceName();
 
@@ -542,16 +746,6 @@ bool FlyScoreDock::init()
 		loadTemplateByPath(path);
 	});
 
-	obsSignalHandler_ = obs_get_signal_handler();
-	if (obsSignalHandler_) {
-		auto *sh = static_cast<signal_handler_t *>(obsSignalHandler_);
-		signal_handler_connect(sh, "source_create", fly_on_source_list_changed, this);
-
-		signal_handler_connect(sh, "source_destroy", fly_on_source_list_changed, this);
-
-		obsSignalsConnected_ = true;
-	}
-
 	connect(swapSides_, &QCheckBox::toggled, this, [this](bool on) {
 		st_.swap_sides = on;
 		saveState();
@@ -565,6 +759,7 @@ bool FlyScoreDock::init()
 	connect(clearBtn, &QPushButton::clicked, this, &FlyScoreDock::onClearTeamsAndReset);
 
 	connect(setTemplatesRootBtn_, &QPushButton::clicked, this, &FlyScoreDock::onSetTemplatesRoot);
+	connect(forkTemplateBtn_, &QPushButton::clicked, this, &FlyScoreDock::onForkBuiltInTemplate);
 
 	connect(editFieldsBtn_, &QPushButton::clicked, this, &FlyScoreDock::onOpenCustomFieldsDialog);
 	connect(editTimersBtn_, &QPushButton::clicked, this, &FlyScoreDock::onOpenTimersDialog);
@@ -574,22 +769,148 @@ bool FlyScoreDock::init()
 	connect(toggleCarouselBtn_, &QPushButton::clicked, this, &FlyScoreDock::toggleWidgetCarouselVisible);
 
 	webSocketServer_ = new FlyScoreWebSocketServer(this);
+	webSocketServer_->setHttpHandler(
+		[this](const FlyHttpRequest &req, FlyHttpResponse &res) { serveOverlayHttp(req, res); });
 	connect(webSocketServer_, &FlyScoreWebSocketServer::commandReceived, this, &FlyScoreDock::handleRemoteCommand);
 	connect(webSocketServer_, &FlyScoreWebSocketServer::statusChanged, this, &FlyScoreDock::updateWebSocketStatus);
+	connect(webSocketServer_, &FlyScoreWebSocketServer::tracingChanged, this, [this]() {
+		const QSignalBlocker block(traceEnableAct_);
+		traceEnableAct_->setChecked(fly_trace_enabled());
+	});
+	fly_apply_rate_limit(webSocketServer_);
 	webSocketServer_->start(fly_load_websocket_port());
+	webSocketServer_->listenLocal(fly_load_local_socket_name());
 	updateWebSocketStatus();
+	connect(&fly_settings(), &FlySettings::changed, this, [this](const QString &key) {
+		if (key == fly_settings_key_local_socket()) {
+			webSocketServer_->listenLocal(fly_load_local_socket_name());
+		} else if (key == fly_settings_key_rate_burst() || key == fly_settings_key_rate_per_sec()) {
+			fly_apply_rate_limit(webSocketServer_);
+		} else if (key == fly_settings_key_shm_name()) {
+			shm_.open(fly_load_shm_name());
+			broadcastCurrentState();
+			updateWebSocketStatus();
+		}
+	});
+
+	ingest_ = new FlyIngestManager(this);
+	connect(ingest_, &FlyIngestManager::batchReady, this, &FlyScoreDock::handleIngestBatch);
+	connect(ingest_, &FlyIngestManager::healthChanged, this, &FlyScoreDock::updateIngestStatus);
+
+	auto *ingestStatusTimer = new QTimer(this);
+	ingestStatusTimer->setInterval(kIngestStatusIntervalMs);
+	connect(ingestStatusTimer, &QTimer::timeout, this, &FlyScoreDock::updateIngestStatus);
+	ingestStatusTimer->start();
+
+	auto *metricsTimer = new QTimer(this);
+	metricsTimer->setInterval(kMetricsLogIntervalMs);
+	connect(metricsTimer, &QTimer::timeout, this, []() { fly_metrics_log_summary(); });
+	metricsTimer->start();
 
 	refreshUiFromState(false);
 	refreshWidgetCarouselToggleUi();
-	updateBrowserSourceToCurrentResources();
-	broadcastCurrentState();
-
-	hotkeyBindings_ = buildMergedHotkeyBindings();
-	applyHotkeyBindings(hotkeyBindings_);
 
 	return true;
 }
 
+// Logos are shared by content hash, so they are only swept here, before any
+// board has undo steps that could still point at an old one.
+void FlyScoreDock::collectUnusedLogos()
+{
+	QStringList roots{QDir(fly_get_data_root_no_ui()).absolutePath()};
+	for (const FlyBoard &board : std::as_const(boards_)) {
+		if (!board.templatePath.isEmpty())
+			roots << QDir(board.templatePath).absolutePath();
+	}
+	roots.removeDuplicates();
+	for (const QString &root : std::as_const(roots))
+		fly_logo_collect_garbage(root);
+}
+
+// Runs one startup stage per event-loop turn so OBS stays responsive while the
+// dock catches up; each stage is timed and traced.
+void FlyScoreDock::finishStartup()
+{
+	if (startupStarted_)
+		return;
+	startupStarted_ = true;
+
+	startupStages_ = {
+		{"resources",
+		 [this]() {
+			 ensureResourcesDefaults();
+			 collectUnusedLogos();
+		 }},
+		{"templates", [this]() { startThemeIndex(); }},
+		{"browser_source",
+		 [this]() {
+			 connectSourceSignals();
+			 refreshBrowserSourceCombo(true);
+			 updateBrowserSourceToCurrentResources();
+		 }},
+		{"hotkeys",
+		 [this]() {
+			 loadHotkeyBindings();
+		 }},
+		{"ingest",
+		 [this]() {
+			 ingest_->setSources(fly_load_ingest_sources());
+			 shm_.open(fly_load_shm_name());
+			 updateWebSocketStatus();
+		 }},
+		{"broadcast", [this]() { broadcastCurrentState(); }},
+	};
+	startupDeferredUs_ = 0;
+	QTimer::singleShot(0, this, &FlyScoreDock::runNextStartupStage);
+}
+
+// Loads the theme cache and starts the folder scan on a worker.
+void FlyScoreDock::startThemeIndex()
+{
+	themeIndex_ = new FlyThemeIndex(QDir(fly_data_dir()).filePath(QStringLiteral("theme-index.json")), this);
+	connect(themeIndex_, &FlyThemeIndex::themesChanged, this, [this]() { refreshTemplateCombo(true); });
+	connect(themeIndex_, &FlyThemeIndex::scanFinished, this, &FlyScoreDock::onThemeIndexScanFinished);
+	refreshTemplateCombo(true);
+	templateWatcher_->setPath(dataDir_);
+}
+
+// Not connected during startup: while a scene collection loads, every source
+// creation would re-list the browser sources.
+void FlyScoreDock::connectSourceSignals()
+{
+	obsSignalHandler_ = obs_get_signal_handler();
+	if (!obsSignalHandler_)
+		return;
+	auto *sh = static_cast<signal_handler_t *>(obsSignalHandler_);
+	signal_handler_connect(sh, "source_create", fly_on_source_list_changed, this);
+	signal_handler_connect(sh, "source_destroy", fly_on_source_list_changed, this);
+	obsSignalsConnected_ = true;
+}
+
+void FlyScoreDock::runNextStartupStage()
+{
+	if (startupStages_.isEmpty())
+		return;
+
+	const auto [name, run] = startupStages_.takeFirst();
+	QElapsedTimer timer;
+	timer.start();
+	{
+		FlyTraceScope trace("startup", name);
+		run();
+	}
+	const qint64 us = timer.nsecsElapsed() / 1000;
+	startupDeferredUs_ += us;
+	LOGI("Startup stage '%s' took %.2f ms", name, double(us) / 1000.0);
+
+	if (!startupStages_.isEmpty()) {
+		QTimer::singleShot(0, this, &FlyScoreDock::runNextStartupStage);
+		return;
+	}
+	fly_metrics().startupDeferredUs.set(startupDeferredUs_);
+	LOGI("Deferred startup finished in %.2f ms", double(startupDeferredUs_) / 1000.0);
+}
+
 void FlyScoreDock::refreshWidgetCarouselToggleUi()
 {
 	updateWidgetCarouselToggleUi(toggleCarouselBtn_, widgetCarousel_, style());
@@ -604,10 +925,27 @@ void FlyScoreDock::toggleWidgetCarouselVisible()
 	refreshWidgetCarouselToggleUi();
 }
 
-void FlyScoreDock::updateBrowserSourceToCurrentResources()
+namespace {
+static bool fly_same_path(const QString &a, const QString &b)
+{
+	if (a.isEmpty() || b.isEmpty())
+		return false;
+	return QDir(a).absolutePath() == QDir(b).absolutePath();
+}
+
+// No index.html on disk but the template is compiled in: served from memory.
+static bool fly_is_builtin_template(const QString &path)
 {
+	return !path.isEmpty() && fly_embedded_available() &&
+	       !QFileInfo::exists(QDir(path).filePath(QStringLiteral("index.html")));
+}
+}
+
+void FlyScoreDock::updateBrowserSourceToCurrentResources(bool forceReload)
+{
+	FLY_TRACE_SCOPE_CAT("dock", "updateBrowserSourceToCurrentResources");
 	const QString bsName = selectedBrowserSourceName();
-	if (bsName.isEmpty())
+	if (bsName.isEmpty() || !isDefaultBoardActive())
 		return;
 
 	const QString overlayRoot = fly_get_data_root_no_ui();
@@ -621,197 +959,124 @@ void FlyScoreDock::updateBrowserSourceToCurrentResources()
 	fly_state_ensure_json_exists(overlayRoot, &st_);
 	fly_state_save(overlayRoot, st_);
 
+	const bool builtIn = fly_is_builtin_template(overlayRoot);
+	if (builtIn && webSocketServer_ && webSocketServer_->isWebSocketListening()) {
+		// Nothing on disk: the overlay is served from memory over HTTP, so
+		// there is no shell file to hot swap against.
+		const QString url =
+			QStringLiteral("http://127.0.0.1:%1/overlay/index.html").arg(webSocketServer_->port());
+		if (forceReload || fly_browser_source_url(bsName) != url)
+			fly_ensure_browser_source_in_current_scene(url, bsName);
+		shellIndexPath_.clear();
+		liveRuntimeHash_.clear();
+		templateHotSwapped_ = false;
+		LOGI("Browser source synced to the built-in template: %s", url.toUtf8().constData());
+		return;
+	}
+	if (builtIn) {
+		// No port to serve it from (taken, or the server failed): the browser
+		// source can only load files, so write the theme out.
+		LOGW("WebSocket port is not listening; writing the built-in template to %s",
+		     overlayRoot.toUtf8().constData());
+		if (!fly_embedded_extract_template(overlayRoot))
+			LOGW("Could not write the built-in template; the overlay will stay blank");
+		else if (themeIndex_)
+			themeIndex_->rescan();
+	}
+
 	if (!QFileInfo::exists(indexPath)) {
 		LOGW("index.html not found in active template folder: %s", indexPath.toUtf8().constData());
 	}
 
+	const QString loaded = fly_browser_source_local_file(bsName);
+	if (!forceReload &&
+	    (fly_same_path(loaded, indexPath) || (templateHotSwapped_ && fly_same_path(loaded, shellIndexPath_)))) {
+		if (liveRuntimeHash_.isEmpty()) {
+			shellIndexPath_ = QDir::cleanPath(loaded);
+			liveRuntimeHash_ = fly_template_runtime_hash(QFileInfo(loaded).absolutePath());
+		}
+		LOGD("Browser source already shows the active template: %s", loaded.toUtf8().constData());
+		return;
+	}
+
 	fly_ensure_browser_source_in_current_scene(indexPath, bsName);
+	shellIndexPath_ = QDir::cleanPath(indexPath);
+	liveRuntimeHash_ = fly_template_runtime_hash(overlayRoot);
+	templateHotSwapped_ = false;
 
 	LOGI("Browser source synced to: %s", indexPath.toUtf8().constData());
 }
 
-namespace {
-struct FlyThemeManifest {
-	QString title;
-	QString author;
-	QString authorUrl;
-	QString description;
-	QString version;
-};
-
-struct FlyThemeInfo {
-	FlyThemeManifest manifest;
-	QString path;
-	QString folderName;
-	QString error;
-	bool hasIndex = false;
-	bool hasManifest = false;
-	bool valid = false;
-};
-
-static QString fly_theme_manifest_path(const QString &themePath)
-{
-	return QDir(themePath).filePath(QStringLiteral("manifest.ini"));
-}
-
-static QString fly_normalize_manifest_key(QString key, const QString &section)
-{
-	key = key.trimmed().toLower();
-	if (!section.trimmed().isEmpty())
-		key = section.trimmed().toLower() + QStringLiteral("/") + key;
-	return key;
-}
-
-static void fly_apply_manifest_value(FlyThemeManifest &out, const QString &key, const QString &value)
-{
-	const QString k = key.trimmed().toLower();
-	const QString v = value.trimmed();
-	if ((k == QLatin1String("title") || k == QLatin1String("theme/title")) && out.title.isEmpty())
-		out.title = v;
-	else if ((k == QLatin1String("author") || k == QLatin1String("theme/author")) && out.author.isEmpty())
-		out.author = v;
-	else if ((k == QLatin1String("author_url") || k == QLatin1String("theme/author_url")) &&
-		 out.authorUrl.isEmpty())
-		out.authorUrl = v;
-	else if ((k == QLatin1String("description") || k == QLatin1String("theme/description")) &&
-		 out.description.isEmpty())
-		out.description = v;
-	else if ((k == QLatin1String("version") || k == QLatin1String("theme/version")) && out.version.isEmpty())
-		out.version = v;
-}
-
-static void fly_read_theme_manifest_text(const QString &manifestPath, FlyThemeManifest &out)
-{
-	QFile file(manifestPath);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
-		return;
-
-	QTextStream stream(&file);
-	QString section;
-	while (!stream.atEnd()) {
-		QString line = stream.readLine().trimmed();
-		if (line.startsWith(QChar(0xFEFF)))
-			line.remove(0, 1);
-		if (line.isEmpty() || line.startsWith(QLatin1Char(';')) || line.startsWith(QLatin1Char('#')))
-			continue;
-		if (line.startsWith(QLatin1Char('[')) && line.endsWith(QLatin1Char(']'))) {
-			section = line.mid(1, line.size() - 2).trimmed();
-			continue;
-		}
-
-		int pos = line.indexOf(QLatin1Char('='));
-		if (pos < 0)
-			pos = line.indexOf(QLatin1Char(':'));
-		if (pos < 0)
-			continue;
+bool FlyScoreDock::hotSwapTemplate(const QString &path, const QString &name)
+{
+	if (!isDefaultBoardActive() || !webSocketServer_ ||
+	    !webSocketServer_->hasOverlayWithCapability(QStringLiteral("template_swap"), fly_default_board_id()))
+		return false;
 
-		QString value = line.mid(pos + 1).trimmed();
-		if ((value.startsWith(QLatin1Char('"')) && value.endsWith(QLatin1Char('"'))) ||
-		    (value.startsWith(QLatin1Char('\'')) && value.endsWith(QLatin1Char('\''))))
-			value = value.mid(1, value.size() - 2).trimmed();
+	const QString bsName = selectedBrowserSourceName();
+	if (bsName.isEmpty() || shellIndexPath_.isEmpty() ||
+	    !fly_same_path(fly_browser_source_local_file(bsName), shellIndexPath_))
+		return false;
 
-		fly_apply_manifest_value(out, fly_normalize_manifest_key(line.left(pos), section), value);
+	if (liveRuntimeHash_.isEmpty() || fly_template_runtime_hash(path) != liveRuntimeHash_) {
+		LOGI("Template '%s' loads different scripts; reloading the browser source instead",
+		     name.toUtf8().constData());
+		return false;
 	}
-}
 
-static bool fly_read_theme_manifest(const QString &themePath, FlyThemeManifest &out)
-{
-	const QString manifestPath = fly_theme_manifest_path(themePath);
-	if (!QFileInfo::exists(manifestPath))
+	const QJsonObject msg = fly_template_swap_message(path, name);
+	if (msg.isEmpty())
 		return false;
 
-	QSettings manifest(manifestPath, QSettings::IniFormat);
-	out.title = manifest.value(QStringLiteral("title")).toString().trimmed();
-	out.author = manifest.value(QStringLiteral("author")).toString().trimmed();
-	out.authorUrl = manifest.value(QStringLiteral("author_url")).toString().trimmed();
-	out.description = manifest.value(QStringLiteral("description")).toString().trimmed();
-	out.version = manifest.value(QStringLiteral("version")).toString().trimmed();
-
-	if (out.title.isEmpty())
-		out.title = manifest.value(QStringLiteral("theme/title")).toString().trimmed();
-	if (out.author.isEmpty())
-		out.author = manifest.value(QStringLiteral("theme/author")).toString().trimmed();
-	if (out.authorUrl.isEmpty())
-		out.authorUrl = manifest.value(QStringLiteral("theme/author_url")).toString().trimmed();
-	if (out.description.isEmpty())
-		out.description = manifest.value(QStringLiteral("theme/description")).toString().trimmed();
-	if (out.version.isEmpty())
-		out.version = manifest.value(QStringLiteral("theme/version")).toString().trimmed();
-	if (out.title.isEmpty())
-		out.title = manifest.value(QStringLiteral("Theme/title")).toString().trimmed();
-	if (out.author.isEmpty())
-		out.author = manifest.value(QStringLiteral("Theme/author")).toString().trimmed();
-	if (out.authorUrl.isEmpty())
-		out.authorUrl = manifest.value(QStringLiteral("Theme/author_url")).toString().trimmed();
-	if (out.description.isEmpty())
-		out.description = manifest.value(QStringLiteral("Theme/description")).toString().trimmed();
-	if (out.version.isEmpty())
-		out.version = manifest.value(QStringLiteral("Theme/version")).toString().trimmed();
-
-	fly_read_theme_manifest_text(manifestPath, out);
-
-	return !out.title.isEmpty() && !out.author.isEmpty() && !out.authorUrl.isEmpty() &&
-	       !out.description.isEmpty() && !out.version.isEmpty();
-}
-
-static FlyThemeInfo fly_read_theme_info(const QString &themePath)
-{
-	FlyThemeInfo info;
-	const QFileInfo themeDirInfo(themePath);
-	info.path = QDir(themePath).absolutePath();
-	info.folderName = themeDirInfo.fileName();
-	info.hasIndex = QFileInfo::exists(QDir(themePath).filePath(QStringLiteral("index.html")));
-	info.hasManifest = QFileInfo::exists(fly_theme_manifest_path(themePath));
-
-	const bool manifestOk = fly_read_theme_manifest(themePath, info.manifest);
-	info.valid = info.hasIndex && manifestOk;
-
-	if (!info.hasIndex)
-		info.error = fly_i18n("Dock.TemplateMissingIndex");
-	else if (!info.hasManifest)
-		info.error = fly_i18n("Dock.TemplateMissingManifest");
-	else if (!manifestOk)
-		info.error = fly_i18n("Dock.TemplateInvalidManifest");
-
-	if (info.manifest.title.isEmpty())
-		info.manifest.title = info.folderName.isEmpty() ? info.path : info.folderName;
-
-	return info;
-}
-
-static bool fly_is_valid_theme_folder(const QString &themePath, FlyThemeManifest *manifest = nullptr)
-{
-	FlyThemeInfo info = fly_read_theme_info(themePath);
-	if (!info.valid)
-		return false;
+	webSocketServer_->broadcastMessage(msg, fly_default_board_id(), QStringLiteral("template_swap"));
+	templateHotSwapped_ = !fly_same_path(QFileInfo(shellIndexPath_).absolutePath(), path);
 
-	if (manifest)
-		*manifest = info.manifest;
+	LOGI("Template hot-swapped over WebSocket: %s", path.toUtf8().constData());
 	return true;
 }
 
-static QString fly_theme_tooltip(const FlyThemeManifest &manifest)
+void FlyScoreDock::onTemplateFilesChanged(const FlyTemplateChange &change)
 {
-	return QStringLiteral("%1\n%2: %3\n%4\n%5")
-		.arg(manifest.description, fly_i18n("Theme.Author"), manifest.author, manifest.authorUrl,
-		     fly_i18n("Theme.Version").arg(manifest.version));
-}
+	if (dataDir_.isEmpty() || !templateWatcher_ || !fly_same_path(templateWatcher_->path(), dataDir_))
+		return;
 
-static bool fly_same_path(const QString &a, const QString &b)
-{
-	if (a.isEmpty() || b.isEmpty())
-		return false;
-	return QDir(a).absolutePath() == QDir(b).absolutePath();
-}
+	const bool canPatchAssets = webSocketServer_ &&
+				    webSocketServer_->hasOverlayWithCapability(QStringLiteral("asset_reload"), activeBoardId_);
+
+	// Extra boards run in browser sources the dock does not manage; only assets can be patched there.
+	if (!isDefaultBoardActive()) {
+		if (canPatchAssets && (!change.styles.isEmpty() || !change.images.isEmpty()))
+			webSocketServer_->broadcastMessage(fly_template_asset_message(dataDir_, change.styles, change.images,
+										     ++assetRevision_),
+							   activeBoardId_, QStringLiteral("asset_reload"));
+		const int dropped = int(change.markup.size() + change.scripts.size() + change.other.size());
+		if (dropped > 0)
+			LOGI("Board '%s': %d changed template file(s) need a browser source reload; refresh it in OBS",
+			     activeBoardId_.toUtf8().constData(), dropped);
+		return;
+	}
 
-static bool fly_list_has_same_path(const QStringList &paths, const QString &path)
-{
-	for (const QString &existing : paths) {
-		if (fly_same_path(existing, path))
-			return true;
+	// Fonts, data files and the like have no live patch; reload like scripts.
+	if (!change.scripts.isEmpty() || !change.other.isEmpty() ||
+	    (!canPatchAssets && (!change.styles.isEmpty() || !change.images.isEmpty()))) {
+		updateBrowserSourceToCurrentResources(true);
+		return;
 	}
-	return false;
-}
+
+	if (!change.markup.isEmpty()) {
+		const QString title = themeIndex_ ? themeIndex_->info(dataDir_).manifest.title : QString();
+		if (!hotSwapTemplate(dataDir_, title)) {
+			updateBrowserSourceToCurrentResources(true);
+			return;
+		}
+	}
+
+	if (change.styles.isEmpty() && change.images.isEmpty())
+		return;
+
+	webSocketServer_->broadcastMessage(
+		fly_template_asset_message(dataDir_, change.styles, change.images, ++assetRevision_), activeBoardId_,
+		QStringLiteral("asset_reload"));
 }
 
 void FlyScoreDock::onSetTemplatesRoot()
@@ -825,14 +1090,52 @@ void FlyScoreDock::onSetTemplatesRoot()
 	fly_save_templates_root(picked);
 	refreshTemplateCombo(false);
 
+	selectFirstThemeAfterScan_ = themeIndex_ && themeIndex_->isScanning();
+	loadSelectedThemeIfValid();
+}
+
+void FlyScoreDock::loadSelectedThemeIfValid()
+{
 	if (!templateCombo_ || templateCombo_->currentIndex() < 0)
 		return;
 
 	const QString path = templateCombo_->currentData().toString();
-	if (!path.isEmpty() && fly_is_valid_theme_folder(path))
+	if (path.isEmpty() || fly_same_path(path, dataDir_))
+		return;
+
+	if ((themeIndex_ && themeIndex_->info(path).valid) || fly_is_builtin_template(path))
 		loadTemplateByPath(path);
 }
 
+void FlyScoreDock::onForkBuiltInTemplate()
+{
+	if (!fly_is_builtin_template(dataDir_))
+		return;
+
+	if (!fly_embedded_extract_template(dataDir_)) {
+		QMessageBox::warning(this, fly_i18n("Dock.ForkTemplateFailedTitle"),
+				     fly_i18n("Dock.ForkTemplateFailedMessage").arg(dataDir_));
+		return;
+	}
+	LOGI("Built-in template forked into: %s", dataDir_.toUtf8().constData());
+
+	if (themeIndex_)
+		themeIndex_->rescan();
+	refreshTemplateCombo(true);
+	updateBrowserSourceToCurrentResources(true);
+	broadcastCurrentState();
+}
+
+void FlyScoreDock::onThemeIndexScanFinished()
+{
+	if (!selectFirstThemeAfterScan_)
+		return;
+
+	selectFirstThemeAfterScan_ = false;
+	refreshTemplateCombo(false);
+	loadSelectedThemeIfValid();
+}
+
 QString FlyScoreDock::selectedTemplateName() const
 {
 	if (!templateCombo_)
@@ -850,67 +1153,54 @@ QString FlyScoreDock::selectedTemplatePath() const
 
 void FlyScoreDock::refreshTemplateCombo(bool preserveSelection)
 {
-	if (!templateCombo_)
+	if (!templateCombo_ || !themeIndex_)
 		return;
 
 	const QString previousPath = preserveSelection ? selectedTemplatePath() : QString();
-	const QString current = fly_get_data_root_no_ui();
+	const QString current = dataDir_;
+	forkTemplateBtn_->setVisible(fly_is_builtin_template(current));
+	const QString root = fly_load_templates_root();
+
+	QStringList roots{root};
+	if (!current.isEmpty()) {
+		roots.push_back(current);
+		roots.push_back(QFileInfo(current).absoluteDir().absolutePath());
+	}
+	themeIndex_->setRoots(roots);
 
 	QSignalBlocker block(templateCombo_);
 	templateCombo_->clear();
 
 	bool currentListed = false;
 	int firstThemeIndex = -1;
-	QStringList listedPaths;
-	auto addTheme = [&](const QString &themePath) {
-		if (themePath.isEmpty() || fly_list_has_same_path(listedPaths, themePath))
-			return;
-
-		const QString absolutePath = QDir(themePath).absolutePath();
-		FlyThemeInfo info = fly_read_theme_info(absolutePath);
-		if (!info.hasIndex && !info.hasManifest)
-			return;
-
-		templateCombo_->addItem(info.manifest.title, absolutePath);
+	const QVector<FlyThemeInfo> themes = themeIndex_->themes();
+	for (const FlyThemeInfo &info : themes) {
+		templateCombo_->addItem(info.manifest.title, info.path);
 		const int idx = templateCombo_->count() - 1;
 		if (firstThemeIndex < 0 && info.valid)
 			firstThemeIndex = idx;
-		templateCombo_->setItemData(idx, info.valid ? fly_theme_tooltip(info.manifest) : info.error,
+		templateCombo_->setItemData(idx, info.valid ? fly_theme_tooltip(info.manifest) : fly_theme_info_error(info),
 					    Qt::ToolTipRole);
-		listedPaths.push_back(absolutePath);
 
-		if (fly_same_path(absolutePath, current))
+		if (fly_same_path(info.path, current))
 			currentListed = true;
-	};
-	auto scanThemeRoot = [&](const QString &root) {
-		if (root.isEmpty())
-			return;
-
-		addTheme(root);
-
-		const QDir dir(root);
-		const auto entries = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
-		for (const QFileInfo &entry : entries)
-			addTheme(entry.absoluteFilePath());
-	};
-
-	const QString root = fly_load_templates_root();
-	scanThemeRoot(root);
-
-	if (!current.isEmpty()) {
-		scanThemeRoot(current);
-		scanThemeRoot(QFileInfo(current).absoluteDir().absolutePath());
 	}
 
 	if (!current.isEmpty() && !currentListed && (preserveSelection || templateCombo_->count() == 0)) {
-		FlyThemeManifest manifest;
-		const bool validTheme = fly_is_valid_theme_folder(current, &manifest);
-		templateCombo_->addItem(validTheme ? manifest.title : fly_i18n("Dock.CurrentResources"), current);
+		const FlyThemeInfo info = themeIndex_->info(current);
+		const char *fallbackKey =
+			fly_is_builtin_template(current) ? "Dock.BuiltInTemplate" : "Dock.CurrentResources";
+		templateCombo_->addItem(info.valid ? info.manifest.title : fly_i18n(fallbackKey), current);
 		const int idx = templateCombo_->count() - 1;
-		if (validTheme)
-			templateCombo_->setItemData(idx, fly_theme_tooltip(manifest), Qt::ToolTipRole);
+		if (info.valid)
+			templateCombo_->setItemData(idx, fly_theme_tooltip(info.manifest), Qt::ToolTipRole);
 	}
 
+	// The built-in template stays selectable after switching away from it.
+	const QString builtInRoot = fly_default_data_root();
+	if (fly_is_builtin_template(builtInRoot) && templateCombo_->findData(builtInRoot) < 0)
+		templateCombo_->addItem(fly_i18n("Dock.BuiltInTemplate"), builtInRoot);
+
 	int idx = previousPath.isEmpty() ? -1 : templateCombo_->findData(previousPath);
 	if (idx < 0 && preserveSelection)
 		idx = templateCombo_->findData(current);
@@ -920,8 +1210,9 @@ void FlyScoreDock::refreshTemplateCombo(bool preserveSelection)
 		idx = 0;
 
 	templateCombo_->setCurrentIndex(idx);
-	LOGI("Theme selector scanned root='%s', current='%s', listed=%d",
-	     root.toUtf8().constData(), current.toUtf8().constData(), templateCombo_->count());
+	LOGD("Theme selector populated from index: root='%s', current='%s', listed=%d, scanning=%d",
+	     root.toUtf8().constData(), current.toUtf8().constData(), templateCombo_->count(),
+	     themeIndex_->isScanning() ? 1 : 0);
 }
 
 void FlyScoreDock::loadTemplateByPath(const QString &path)
@@ -929,32 +1220,54 @@ void FlyScoreDock::loadTemplateByPath(const QString &path)
 	if (path.isEmpty())
 		return;
 
-	FlyThemeInfo info = fly_read_theme_info(path);
-	if (!info.valid) {
+	const FlyThemeInfo info = themeIndex_ ? themeIndex_->info(path) : fly_read_theme_info(path);
+	const bool builtIn = fly_is_builtin_template(path);
+	if (!info.valid && !builtIn) {
 		LOGW("Invalid theme selected: path='%s', hasIndex=%d, hasManifest=%d, reason='%s'",
 		     info.path.toUtf8().constData(), info.hasIndex ? 1 : 0, info.hasManifest ? 1 : 0,
-		     info.error.toUtf8().constData());
+		     fly_theme_info_error(info).toUtf8().constData());
 		QMessageBox::warning(this, fly_i18n("Dock.TemplateInvalidTitle"),
 				     fly_i18n("Dock.TemplateInvalidMessage"));
 		refreshTemplateCombo(true);
 		return;
 	}
 
-	fly_set_data_root(path);
-	dataDir_ = fly_get_data_root_no_ui();
+	if (isDefaultBoardActive()) {
+		fly_set_data_root(path);
+		dataDir_ = fly_get_data_root_no_ui();
+	} else {
+		dataDir_ = QDir(path).absolutePath();
+	}
+
+	for (FlyBoard &board : boards_) {
+		if (board.id == activeBoardId_) {
+			board.templatePath = dataDir_;
+			stateDir_ = fly_board_state_dir(board);
+		}
+	}
+	if (!isDefaultBoardActive())
+		fly_boards_save(boards_);
+
 	ensureResourcesDefaults();
 	loadState();
+	// Another template's plugin.json: the old steps would write its scores back.
+	histories_[activeBoardId_].reset(st_);
+	updateHistoryButtons();
 	refreshUiFromState(false);
-	updateBrowserSourceToCurrentResources();
+	if (builtIn || !hotSwapTemplate(dataDir_, info.manifest.title))
+		updateBrowserSourceToCurrentResources();
+	if (templateWatcher_)
+		templateWatcher_->setPath(dataDir_);
 	refreshTemplateCombo(true);
 	broadcastCurrentState();
 }
 
 void FlyScoreDock::broadcastCurrentState()
 {
+	shm_.publish(st_, activeBoardId_);
 	if (!webSocketServer_ || !webSocketServer_->isListening())
 		return;
-	webSocketServer_->broadcastState(st_, selectedTemplateName(), selectedTemplatePath());
+	webSocketServer_->broadcastState(st_, selectedTemplateName(), selectedTemplatePath(), activeBoardId_);
 }
 
 void FlyScoreDock::updateWebSocketStatus()
@@ -962,366 +1275,708 @@ void FlyScoreDock::updateWebSocketStatus()
 	if (!webSocketStatus_ || !webSocketServer_)
 		return;
 
-	const QString text = webSocketServer_->isListening()
+	const QString text = webSocketServer_->isWebSocketListening()
 				     ? fly_i18n("Dock.WSOnline").arg(webSocketServer_->url()).arg(webSocketServer_->clientCount())
 				     : fly_i18n("Dock.WSOffline");
 	webSocketStatus_->setText(text);
+
+	QString tooltip = fly_i18n("Dock.WebSocketTooltip");
+	const QString local = webSocketServer_->localServerName();
+	if (!local.isEmpty())
+		tooltip += QLatin1Char('\n') + fly_i18n("Dock.LocalSocket").arg(local);
+	if (shm_.isOpen())
+		tooltip += QLatin1Char('\n') + fly_i18n("Dock.SharedMemory").arg(shm_.name());
+	webSocketStatus_->setToolTip(tooltip);
 }
 
-static int jsonInt(const QJsonObject &o, const QString &key, int fallback = 0)
+void FlyScoreDock::updateIngestStatus()
 {
-	const QJsonValue v = o.value(key);
-	if (v.isDouble())
-		return v.toInt(fallback);
-	if (v.isString()) {
-		bool ok = false;
-		const int n = v.toString().toInt(&ok);
-		return ok ? n : fallback;
+	if (!ingestBtn_ || !ingest_)
+		return;
+
+	const QVector<FlyIngestHealth> health = ingest_->health();
+	if (health.isEmpty()) {
+		ingestBtn_->setText(QStringLiteral("📡"));
+		ingestBtn_->setToolTip(fly_i18n("Dock.IngestTooltip"));
+		return;
+	}
+
+	const qint64 now = fly_now_ms();
+	int live = 0;
+	QStringList lines{fly_i18n("Dock.IngestTooltip")};
+	for (const FlyIngestHealth &h : health) {
+		if (h.error.isEmpty() && h.lastPacketMs > 0 && now - h.lastPacketMs < kIngestStaleMs)
+			++live;
+		lines << fly_ingest_source_title(h.config) + QStringLiteral(": ") + fly_ingest_health_text(h, now);
 	}
-	return fallback;
+	ingestBtn_->setText(QStringLiteral("📡 %1/%2").arg(live).arg(health.size()));
+	ingestBtn_->setToolTip(lines.join(QLatin1Char('\n')));
 }
 
-static qint64 jsonInt64(const QJsonObject &o, const QString &key, qint64 fallback = 0)
+void FlyScoreDock::rebuildIngestMenu()
 {
-	const QJsonValue v = o.value(key);
-	if (v.isDouble())
-		return static_cast<qint64>(v.toDouble(fallback));
-	if (v.isString()) {
-		bool ok = false;
-		const qint64 n = v.toString().toLongLong(&ok);
-		return ok ? n : fallback;
+	QMenu *menu = ingestBtn_ ? ingestBtn_->menu() : nullptr;
+	if (!menu || !ingest_)
+		return;
+
+	menu->clear();
+	const qint64 now = fly_now_ms();
+	for (const FlyIngestHealth &h : ingest_->health()) {
+		QMenu *sub = menu->addMenu(fly_ingest_source_title(h.config));
+		sub->addAction(fly_ingest_health_text(h, now))->setEnabled(false);
+		const FlyIngestSourceConfig config = h.config;
+		connect(sub->addAction(fly_i18n("Dock.IngestRemove")), &QAction::triggered, this, [this, config]() {
+			QVector<FlyIngestSourceConfig> sources = ingest_->sources();
+			sources.removeAll(config);
+			ingest_->setSources(sources);
+			fly_save_ingest_sources(sources);
+		});
 	}
-	return fallback;
+	if (!menu->isEmpty())
+		menu->addSeparator();
+	QAction *addAct = menu->addAction(fly_i18n("Dock.IngestAdd"));
+	connect(addAct, &QAction::triggered, this, &FlyScoreDock::onAddIngestSource);
 }
 
-static bool jsonBool(const QJsonObject &o, const QString &key, bool fallback = false)
+void FlyScoreDock::onAddIngestSource()
 {
-	const QJsonValue v = o.value(key);
-	if (v.isBool())
-		return v.toBool(fallback);
-	if (v.isDouble())
-		return v.toInt() != 0;
-	if (v.isString()) {
-		const QString s = v.toString().trimmed().toLower();
-		if (s == QLatin1String("true") || s == QLatin1String("1") || s == QLatin1String("yes"))
-			return true;
-		if (s == QLatin1String("false") || s == QLatin1String("0") || s == QLatin1String("no"))
-			return false;
+	bool ok = false;
+	const int port = QInputDialog::getInt(this, fly_i18n("Dock.IngestAddTitle"), fly_i18n("Dock.IngestPortPrompt"),
+					      4460, 1, 65535, 1, &ok);
+	if (!ok)
+		return;
+
+	const QString adapter = QInputDialog::getItem(this, fly_i18n("Dock.IngestAddTitle"),
+						      fly_i18n("Dock.IngestAdapterPrompt"), fly_ingest_adapter_names(),
+						      0, false, &ok);
+	if (!ok || adapter.isEmpty())
+		return;
+
+	FlyIngestSourceConfig config;
+	const QString address = QInputDialog::getText(this, fly_i18n("Dock.IngestAddTitle"),
+						      fly_i18n("Dock.IngestAddressPrompt"), QLineEdit::Normal,
+						      config.address, &ok)
+					.trimmed();
+	if (!ok || address.isEmpty())
+		return;
+	config.address = address;
+	config.port = static_cast<quint16>(port);
+	config.adapter = adapter;
+	config.board = activeBoardId_;
+
+	QVector<FlyIngestSourceConfig> sources = ingest_->sources();
+	sources.erase(std::remove_if(sources.begin(), sources.end(),
+				     [&config](const FlyIngestSourceConfig &s) { return s.port == config.port; }),
+		      sources.end());
+	sources.push_back(config);
+	ingest_->setSources(sources);
+	fly_save_ingest_sources(sources);
+}
+
+void FlyScoreDock::handleIngestBatch(const QString &boardId, const QList<QJsonObject> &commands)
+{
+	FLY_TRACE_SCOPE_CAT("dock", "handleIngestBatch");
+	FlyMetricsTimer timer(fly_metrics().commandUs);
+
+	const FlyBoard *board = findBoard(boardId);
+	if (!board) {
+		fly_metrics().commandsIgnored.add(uint64_t(commands.size()));
+		return;
+	}
+
+	const bool active = board->id == activeBoardId_;
+	FlyState &st = active ? st_ : boardState(*board);
+	const qint64 now = fly_now_ms();
+	int effects = FlyCommandIgnored;
+	for (const QJsonObject &command : commands) {
+		fly_metrics().commands.add();
+		const int e = fly_apply_state_command(st, fly_command_action(command), command, now);
+		if (e == FlyCommandIgnored)
+			fly_metrics().commandsIgnored.add();
+		effects |= e;
+	}
+	if (effects == FlyCommandIgnored)
+		return;
+
+	// One save and one broadcast per batch, however many packets it folded.
+	// A console clock streams at 10 Hz, so ingest stays out of the undo
+	// history and only rebuilds the rows when the structure changed.
+	if (!active) {
+		saveBoardState(*board, false);
+		return;
+	}
+
+	saveState(false);
+	if (!(effects & FlyCommandStructure)) {
+		updateControlsFromState();
+		return;
+	}
+	refreshUiFromState(false);
+	hotkeyBindings_ = buildMergedHotkeyBindings();
+	applyHotkeyBindings(hotkeyBindings_);
+}
+
+const FlyBoard *FlyScoreDock::findBoard(const QString &id) const
+{
+	for (const FlyBoard &board : boards_) {
+		if (board.id == id)
+			return &board;
+	}
+	return nullptr;
+}
+
+bool FlyScoreDock::isDefaultBoardActive() const
+{
+	return fly_board_is_default(activeBoardId_);
+}
+
+QString FlyScoreDock::resolveTemplatePath(const QJsonObject &command) const
+{
+	const QString path = fly_command_string(command, QStringLiteral("path"));
+	if (!path.isEmpty())
+		return path;
+
+	const QString name = fly_command_string(command, QStringLiteral("name"));
+	if (name.isEmpty() || !templateCombo_)
+		return QString();
+
+	const int idx = templateCombo_->findText(name);
+	return idx >= 0 ? templateCombo_->itemData(idx).toString() : QString();
+}
+
+// A clock sync (set_timer keep_running) is a feed like ingest: undoing it
+// would only move the clock back one packet.
+static bool fly_command_undoable(const QString &action, const QJsonObject &command)
+{
+	return action != QLatin1String("set_timer") || !fly_command_bool(command, QStringLiteral("keep_running"));
+}
+
+void FlyScoreDock::handleRemoteCommand(FlyClientSession *session, const QJsonObject &command)
+{
+	FLY_TRACE_SCOPE_CAT("dock", "handleRemoteCommand");
+	FlyMetricsTimer timer(fly_metrics().commandUs);
+	fly_metrics().commands.add();
+
+	const QString action = fly_command_action(command);
+	const QString boardId = fly_board_normalize_id(command.value(QStringLiteral("board")).toString());
+
+	if (boardId != activeBoardId_) {
+		const FlyBoard *board = findBoard(boardId);
+		if (!board) {
+			fly_metrics().commandsIgnored.add();
+			LOGW("Command '%s' for unknown board '%s' ignored", action.toUtf8().constData(),
+			     boardId.toUtf8().constData());
+			return;
+		}
+		handleBoardCommand(session, *board, action, command);
+		return;
+	}
+
+	const FlyBoard *activeBoard = findBoard(activeBoardId_);
+	if (action == QLatin1String("get_state")) {
+		if (activeBoard)
+			sendBoardState(session, *activeBoard);
+		return;
+	}
+
+	if (activeBoard && handlePresetCommand(*activeBoard, action, command))
+		return;
+
+	if (activeBoard && (action == QLatin1String("undo") || action == QLatin1String("redo"))) {
+		stepHistory(*activeBoard, action == QLatin1String("redo"));
+		return;
+	}
+
+	if (action == QLatin1String("load_template")) {
+		const QString path = resolveTemplatePath(command);
+		if (!path.isEmpty())
+			loadTemplateByPath(path);
+		return;
+	}
+
+	// Actions with live dock widgets go through the same slots as the UI.
+	const int index = fly_command_int(command, QStringLiteral("index"));
+	if (action == QLatin1String("swap")) {
+		toggleSwap();
+		return;
+	}
+	if (action == QLatin1String("toggle_scoreboard")) {
+		toggleScoreboardVisible();
+		return;
+	}
+	if (action == QLatin1String("bump_score")) {
+		const int delta = fly_command_int(command, QStringLiteral("delta"), 1);
+		if (fly_command_side_is_away(fly_command_string(command, QStringLiteral("side")), st_.swap_sides))
+			bumpCustomFieldAway(index, delta);
+		else
+			bumpCustomFieldHome(index, delta);
+		return;
+	}
+	if (action == QLatin1String("bump_single")) {
+		bumpSingleStat(index, fly_command_int(command, QStringLiteral("delta"), 1));
+		return;
+	}
+	if (action == QLatin1String("toggle_single") && index >= 0 && index < st_.single_stats.size()) {
+		toggleSingleStatVisible(index);
+		return;
+	}
+	if (action == QLatin1String("timer_toggle")) {
+		toggleTimerRunning(index);
+		return;
+	}
+
+	const int effects = fly_apply_state_command(st_, action, command, fly_now_ms());
+	if (effects == FlyCommandIgnored) {
+		fly_metrics().commandsIgnored.add();
+		return;
+	}
+
+	saveState(fly_command_undoable(action, command));
+	refreshUiFromState(false);
+	if (effects & FlyCommandStructure) {
+		hotkeyBindings_ = buildMergedHotkeyBindings();
+		applyHotkeyBindings(hotkeyBindings_);
 	}
-	return fallback;
 }
 
-static QString jsonString(const QJsonObject &o, const QString &key)
+void FlyScoreDock::handleBoardCommand(FlyClientSession *session, const FlyBoard &board, const QString &action,
+				      const QJsonObject &command)
 {
-	return o.value(key).toString().trimmed();
+	if (action == QLatin1String("load_template")) {
+		const QString path = resolveTemplatePath(command);
+		if (path.isEmpty() || !fly_read_theme_info(path).valid)
+			return;
+
+		for (FlyBoard &b : boards_) {
+			if (b.id == board.id)
+				b.templatePath = QDir(path).absolutePath();
+		}
+		fly_boards_save(boards_);
+		boardStates_.remove(board.id);
+		histories_[board.id].reset(boardState(board));
+		broadcastBoardState(board.id);
+		return;
+	}
+
+	if (action == QLatin1String("get_state")) {
+		sendBoardState(session, board);
+		return;
+	}
+
+	if (handlePresetCommand(board, action, command))
+		return;
+
+	if (action == QLatin1String("undo") || action == QLatin1String("redo")) {
+		stepHistory(board, action == QLatin1String("redo"));
+		return;
+	}
+
+	FlyState &st = boardState(board);
+	if (fly_apply_state_command(st, action, command, fly_now_ms()) == FlyCommandIgnored) {
+		fly_metrics().commandsIgnored.add();
+		return;
+	}
+
+	saveBoardState(board, fly_command_undoable(action, command));
+}
+
+void FlyScoreDock::serveOverlayHttp(const FlyHttpRequest &req, FlyHttpResponse &res)
+{
+	const QString boardPrefix = QStringLiteral("/board/");
+	if (!req.path.startsWith(boardPrefix)) {
+		fly_overlay_http_serve(fly_get_data_root_no_ui(), req, res);
+		return;
+	}
+
+	// "/board/<id>/overlay/<file>": the same files, rooted at the board's template.
+	const qsizetype slash = req.path.indexOf(QLatin1Char('/'), boardPrefix.size());
+	if (slash < 0)
+		return;
+	const FlyBoard *board =
+		findBoard(fly_board_normalize_id(req.path.mid(boardPrefix.size(), slash - boardPrefix.size())));
+	if (!board)
+		return;
+
+	FlyHttpRequest rooted = req;
+	rooted.path = req.path.mid(slash);
+	fly_overlay_http_serve(fly_board_is_default(board->id) ? fly_get_data_root_no_ui() : board->templatePath,
+			       rooted, res);
+}
+
+FlyState &FlyScoreDock::boardState(const FlyBoard &board)
+{
+	auto it = boardStates_.find(board.id);
+	if (it != boardStates_.end())
+		return it.value();
+
+	FlyState st;
+	const QString dir = fly_board_state_dir(board);
+	if (!fly_state_load(dir, st)) {
+		st = fly_state_make_defaults();
+		fly_state_save(dir, st);
+	}
+	histories_[board.id].begin(st);
+	return boardStates_.insert(board.id, st).value();
 }
 
-static uint32_t jsonColor(const QJsonObject &o, const QString &key, uint32_t fallback)
+void FlyScoreDock::saveBoardState(const FlyBoard &board, bool undoable)
 {
-	const QJsonValue v = o.value(key);
-	if (v.isDouble())
-		return static_cast<uint32_t>(v.toInt(static_cast<int>(fallback)));
-	if (v.isString()) {
-		QString s = v.toString().trimmed();
-		if (s.startsWith(QLatin1Char('#')))
-			s.remove(0, 1);
-		bool ok = false;
-		const uint n = s.startsWith(QStringLiteral("0x"), Qt::CaseInsensitive) ? s.mid(2).toUInt(&ok, 16)
-											: s.toUInt(&ok, 16);
-		if (ok)
-			return static_cast<uint32_t>(n);
-		const uint dec = s.toUInt(&ok, 10);
-		if (ok)
-			return static_cast<uint32_t>(dec);
+	const FlyState &st = boardState(board);
+	if (undoable)
+		histories_[board.id].commit(st);
+	else
+		histories_[board.id].follow(st);
+	fly_state_save(fly_board_state_dir(board), st);
+	broadcastBoardState(board.id);
+}
+
+void FlyScoreDock::stepHistory(const FlyBoard &board, bool redo)
+{
+	FLY_TRACE_SCOPE_CAT("dock", "stepHistory");
+	const bool active = board.id == activeBoardId_;
+	FlyState &st = active ? st_ : boardState(board);
+	FlyHistory &history = histories_[board.id];
+	if (!(redo ? history.redo(st) : history.undo(st))) {
+		fly_metrics().commandsIgnored.add();
+		return;
+	}
+
+	// Not saveState(): the restored state is already the history's current one.
+	if (!active) {
+		fly_state_save(fly_board_state_dir(board), st);
+		broadcastBoardState(board.id);
+		return;
+	}
+
+	fly_state_save(stateDir_, st_);
+	broadcastCurrentState();
+	refreshUiFromState(false);
+	hotkeyBindings_ = buildMergedHotkeyBindings();
+	applyHotkeyBindings(hotkeyBindings_);
+	updateHistoryButtons();
+}
+
+void FlyScoreDock::updateHistoryButtons()
+{
+	const FlyHistory history = histories_.value(activeBoardId_);
+	if (undoBtn_) {
+		undoBtn_->setEnabled(history.canUndo());
+		undoBtn_->setToolTip(fly_i18n("Dock.UndoTooltip").arg(history.undoCount()));
+	}
+	if (redoBtn_) {
+		redoBtn_->setEnabled(history.canRedo());
+		redoBtn_->setToolTip(fly_i18n("Dock.RedoTooltip").arg(history.redoCount()));
 	}
-	return fallback;
 }
 
-static void setTimerStoppedAtInitial(FlyTimer &timer)
+QVector<FlyPreset> &FlyScoreDock::boardPresets(const FlyBoard &board)
 {
-	timer.running = false;
-	timer.last_tick_ms = 0;
-	if (timer.initial_ms < 0)
-		timer.initial_ms = 0;
-	timer.remaining_ms = timer.initial_ms;
+	auto it = boardPresets_.find(board.id);
+	if (it != boardPresets_.end())
+		return it.value();
+
+	QStringList errors;
+	QVector<FlyPreset> presets = fly_presets_load(fly_board_state_dir(board), &errors);
+	if (!errors.isEmpty())
+		LOGW("Board '%s': %d preset(s) rejected", board.id.toUtf8().constData(), int(errors.size()));
+	return boardPresets_.insert(board.id, presets).value();
 }
 
-void FlyScoreDock::handleRemoteCommand(const QJsonObject &command)
+bool FlyScoreDock::handlePresetCommand(const FlyBoard &board, const QString &action, const QJsonObject &command)
 {
-	const QString action = jsonString(command, QStringLiteral("action")).isEmpty()
-				       ? jsonString(command, QStringLiteral("type"))
-				       : jsonString(command, QStringLiteral("action"));
-
-	if (action == QLatin1String("get_state")) {
-		broadcastCurrentState();
-		return;
+	if (action == QLatin1String("apply_preset")) {
+		applyPreset(board, fly_command_string(command, QStringLiteral("id")));
+		return true;
 	}
+	if (action == QLatin1String("remove_preset")) {
+		removePreset(board, fly_command_string(command, QStringLiteral("id")));
+		return true;
+	}
+	if (action != QLatin1String("save_preset"))
+		return false;
 
-	if (action == QLatin1String("set_state") && command.value(QStringLiteral("state")).isObject()) {
-		FlyState next;
-		if (fly_state_from_json_object(command.value(QStringLiteral("state")).toObject(), next)) {
-			st_ = next;
-			saveState();
-			refreshUiFromState(false);
+	FlyPreset preset;
+	if (command.contains(QStringLiteral("state")) || command.contains(QStringLiteral("commands"))) {
+		QString error;
+		if (!fly_preset_from_json(command, preset, &error)) {
+			fly_metrics().commandsIgnored.add();
+			LOGW("save_preset rejected: %s", error.toUtf8().constData());
+			return true;
 		}
-		return;
+	} else {
+		const FlyState &st = board.id == activeBoardId_ ? st_ : boardState(board);
+		preset = fly_preset_capture(fly_command_string(command, QStringLiteral("id")),
+					    fly_command_string(command, QStringLiteral("name")), st, fly_now_ms());
 	}
+	storePreset(board, std::move(preset));
+	return true;
+}
 
-	if (action == QLatin1String("load_template")) {
-		const QString name = jsonString(command, QStringLiteral("name"));
-		const QString path = jsonString(command, QStringLiteral("path"));
-		if (!path.isEmpty()) {
-			loadTemplateByPath(path);
-		} else if (!name.isEmpty() && templateCombo_) {
-			const int idx = templateCombo_->findText(name);
-			if (idx >= 0)
-				loadTemplateByPath(templateCombo_->itemData(idx).toString());
-		}
+void FlyScoreDock::applyPreset(const FlyBoard &board, const QString &key)
+{
+	FLY_TRACE_SCOPE_CAT("dock", "applyPreset");
+	const FlyPreset *preset = fly_preset_find(boardPresets(board), key);
+	if (!preset) {
+		fly_metrics().commandsIgnored.add();
+		LOGW("Board '%s': unknown preset '%s'", board.id.toUtf8().constData(), key.toUtf8().constData());
 		return;
 	}
 
-	if (action == QLatin1String("swap")) {
-		toggleSwap();
+	const bool active = board.id == activeBoardId_;
+	FlyState &st = active ? st_ : boardState(board);
+	const int effects = fly_preset_apply(*preset, st, fly_now_ms());
+	if (effects == FlyCommandIgnored)
 		return;
-	}
-	if (action == QLatin1String("show_scoreboard")) {
-		st_.show_scoreboard = command.value(QStringLiteral("value")).toBool(st_.show_scoreboard);
-		saveState();
-		refreshUiFromState(false);
+
+	if (!active) {
+		saveBoardState(board);
 		return;
 	}
-	if (action == QLatin1String("toggle_scoreboard")) {
-		toggleScoreboardVisible();
-		return;
+
+	saveState();
+	refreshUiFromState(false);
+	if (effects & FlyCommandStructure) {
+		hotkeyBindings_ = buildMergedHotkeyBindings();
+		applyHotkeyBindings(hotkeyBindings_);
 	}
+}
 
-	if (action == QLatin1String("set_team")) {
-		const QString side = jsonString(command, QStringLiteral("side"));
-		FlyTeam *team = nullptr;
-		if (side == QLatin1String("away") || side == QLatin1String("guest") || side == QLatin1String("guests"))
-			team = &st_.away;
-		else
-			team = &st_.home;
+void FlyScoreDock::storePreset(const FlyBoard &board, FlyPreset preset)
+{
+	QVector<FlyPreset> &presets = boardPresets(board);
+	auto it = std::find_if(presets.begin(), presets.end(),
+			       [&preset](const FlyPreset &p) { return p.id == preset.id; });
+	if (it != presets.end())
+		*it = std::move(preset);
+	else
+		presets.push_back(std::move(preset));
 
-		if (command.contains(QStringLiteral("title")))
-			team->title = jsonString(command, QStringLiteral("title"));
-		if (command.contains(QStringLiteral("subtitle")))
-			team->subtitle = jsonString(command, QStringLiteral("subtitle"));
-		if (command.contains(QStringLiteral("logo")))
-			team->logo = jsonString(command, QStringLiteral("logo"));
-		if (command.contains(QStringLiteral("color")))
-			team->color = jsonColor(command, QStringLiteral("color"), team->color);
+	fly_presets_save(fly_board_state_dir(board), presets);
+	if (board.id == activeBoardId_) {
+		hotkeyBindings_ = buildMergedHotkeyBindings();
+		applyHotkeyBindings(hotkeyBindings_);
+	}
+}
 
-		saveState();
-		refreshUiFromState(false);
+void FlyScoreDock::removePreset(const FlyBoard &board, const QString &key)
+{
+	QVector<FlyPreset> &presets = boardPresets(board);
+	const FlyPreset *preset = fly_preset_find(presets, key);
+	if (!preset)
 		return;
-	}
 
-	const int index = jsonInt(command, QStringLiteral("index"));
-	if (action == QLatin1String("add_score") || action == QLatin1String("add_field")) {
-		FlyCustomField cf;
-		cf.label = jsonString(command, QStringLiteral("label"));
-		if (cf.label.isEmpty())
-			cf.label = QStringLiteral("Score");
-		cf.home = std::max(0, jsonInt(command, QStringLiteral("home")));
-		cf.away = std::max(0, jsonInt(command, QStringLiteral("away")));
-		cf.visible = jsonBool(command, QStringLiteral("visible"), true);
-		st_.custom_fields.push_back(cf);
-		saveState();
-		refreshUiFromState(false);
+	presets.removeAt(preset - presets.constData());
+	fly_presets_save(fly_board_state_dir(board), presets);
+	if (board.id == activeBoardId_) {
 		hotkeyBindings_ = buildMergedHotkeyBindings();
 		applyHotkeyBindings(hotkeyBindings_);
-		return;
-	}
-	if ((action == QLatin1String("remove_score") || action == QLatin1String("remove_field")) && index >= 0 &&
-	    index < st_.custom_fields.size()) {
-		if (st_.custom_fields.size() > 1) {
-			st_.custom_fields.removeAt(index);
-			saveState();
-			refreshUiFromState(false);
-			hotkeyBindings_ = buildMergedHotkeyBindings();
-			applyHotkeyBindings(hotkeyBindings_);
-		}
-		return;
-	}
-	if ((action == QLatin1String("set_field") || action == QLatin1String("set_score_field")) && index >= 0 &&
-	    index < st_.custom_fields.size()) {
-		FlyCustomField &cf = st_.custom_fields[index];
-		if (command.contains(QStringLiteral("label")))
-			cf.label = jsonString(command, QStringLiteral("label"));
-		if (command.contains(QStringLiteral("home")))
-			cf.home = std::max(0, jsonInt(command, QStringLiteral("home")));
-		if (command.contains(QStringLiteral("away")))
-			cf.away = std::max(0, jsonInt(command, QStringLiteral("away")));
-		if (command.contains(QStringLiteral("visible")))
-			cf.visible = jsonBool(command, QStringLiteral("visible"), cf.visible);
-		saveState();
-		refreshUiFromState(false);
-		return;
 	}
-	if ((action == QLatin1String("toggle_field") || action == QLatin1String("score_visibility")) && index >= 0 &&
-	    index < st_.custom_fields.size()) {
-		st_.custom_fields[index].visible = !st_.custom_fields[index].visible;
-		saveState();
-		refreshUiFromState(false);
+}
+
+void FlyScoreDock::rebuildPresetsMenu()
+{
+	QMenu *menu = presetsBtn_ ? presetsBtn_->menu() : nullptr;
+	const FlyBoard *board = findBoard(activeBoardId_);
+	if (!menu || !board)
 		return;
+
+	menu->clear();
+	const QVector<FlyPreset> &presets = boardPresets(*board);
+	for (const FlyPreset &p : presets) {
+		connect(menu->addAction(p.name), &QAction::triggered, this, [this, id = p.id]() {
+			if (const FlyBoard *b = findBoard(activeBoardId_))
+				applyPreset(*b, id);
+		});
 	}
-	if (action == QLatin1String("bump_score")) {
-		const QString side = jsonString(command, QStringLiteral("side"));
-		const int delta = jsonInt(command, QStringLiteral("delta"), 1);
-		if (side == QLatin1String("away") || side == QLatin1String("guest") ||
-		    (side == QLatin1String("y") && !st_.swap_sides) || (side == QLatin1String("x") && st_.swap_sides))
-			bumpCustomFieldAway(index, delta);
-		else
-			bumpCustomFieldHome(index, delta);
+	if (!presets.isEmpty())
+		menu->addSeparator();
+
+	connect(menu->addAction(fly_i18n("Dock.PresetSave")), &QAction::triggered, this, &FlyScoreDock::onSavePreset);
+	if (presets.isEmpty())
 		return;
+
+	QMenu *removeMenu = menu->addMenu(fly_i18n("Dock.PresetRemove"));
+	for (const FlyPreset &p : presets) {
+		connect(removeMenu->addAction(p.name), &QAction::triggered, this, [this, id = p.id]() {
+			if (const FlyBoard *b = findBoard(activeBoardId_))
+				removePreset(*b, id);
+		});
 	}
-	if (action == QLatin1String("set_score") && index >= 0 && index < st_.custom_fields.size()) {
-		const QString side = jsonString(command, QStringLiteral("side"));
-		const int value = std::max(0, jsonInt(command, QStringLiteral("value")));
-		const bool away = side == QLatin1String("away") || side == QLatin1String("guest") ||
-				  (side == QLatin1String("y") && !st_.swap_sides) ||
-				  (side == QLatin1String("x") && st_.swap_sides);
-		if (away)
-			st_.custom_fields[index].away = value;
-		else
-			st_.custom_fields[index].home = value;
-		saveState();
-		refreshUiFromState(false);
+}
+
+void FlyScoreDock::onSavePreset()
+{
+	const FlyBoard *board = findBoard(activeBoardId_);
+	if (!board)
 		return;
-	}
-	if (action == QLatin1String("bump_single")) {
-		bumpSingleStat(index, jsonInt(command, QStringLiteral("delta"), 1));
+
+	bool ok = false;
+	const QString name = QInputDialog::getText(this, fly_i18n("Dock.PresetSaveTitle"),
+						   fly_i18n("Dock.PresetSavePrompt"), QLineEdit::Normal, QString(), &ok)
+				     .trimmed();
+	if (!ok || name.isEmpty())
 		return;
-	}
-	if (action == QLatin1String("toggle_single") && index >= 0 && index < st_.single_stats.size()) {
-		toggleSingleStatVisible(index);
+
+	storePreset(*board, fly_preset_capture(QString(), name, st_, fly_now_ms()));
+}
+
+void FlyScoreDock::broadcastBoardState(const QString &boardId)
+{
+	if (!webSocketServer_ || !webSocketServer_->isListening())
 		return;
-	}
-	if (action == QLatin1String("add_single")) {
-		FlySingleStat ss;
-		ss.label = jsonString(command, QStringLiteral("label"));
-		if (ss.label.isEmpty())
-			ss.label = QStringLiteral("STAT");
-		ss.value = jsonInt(command, QStringLiteral("value"));
-		ss.visible = jsonBool(command, QStringLiteral("visible"), true);
-		st_.single_stats.push_back(ss);
-		saveState();
-		refreshUiFromState(false);
-		hotkeyBindings_ = buildMergedHotkeyBindings();
-		applyHotkeyBindings(hotkeyBindings_);
+
+	const FlyBoard *board = findBoard(boardId);
+	if (!board)
 		return;
-	}
-	if (action == QLatin1String("remove_single") && index >= 0 && index < st_.single_stats.size()) {
-		if (st_.single_stats.size() > 1) {
-			st_.single_stats.removeAt(index);
-			saveState();
-			refreshUiFromState(false);
-			hotkeyBindings_ = buildMergedHotkeyBindings();
-			applyHotkeyBindings(hotkeyBindings_);
-		}
+
+	const FlyThemeInfo info = themeIndex_ ? themeIndex_->info(board->templatePath)
+					      : fly_read_theme_info(board->templatePath);
+	webSocketServer_->broadcastState(boardState(*board), info.manifest.title, board->templatePath, board->id);
+}
+
+void FlyScoreDock::sendBoardState(FlyClientSession *session, const FlyBoard &board)
+{
+	if (!webSocketServer_ || !session)
 		return;
-	}
-	if (action == QLatin1String("set_single") && index >= 0 && index < st_.single_stats.size()) {
-		FlySingleStat &ss = st_.single_stats[index];
-		if (command.contains(QStringLiteral("label")))
-			ss.label = jsonString(command, QStringLiteral("label"));
-		if (command.contains(QStringLiteral("value")))
-			ss.value = jsonInt(command, QStringLiteral("value"));
-		if (command.contains(QStringLiteral("visible")))
-			ss.visible = jsonBool(command, QStringLiteral("visible"), ss.visible);
-		saveState();
-		refreshUiFromState(false);
+
+	if (board.id == activeBoardId_) {
+		webSocketServer_->sendState(session, st_, selectedTemplateName(), selectedTemplatePath(), board.id);
 		return;
 	}
-	if (action == QLatin1String("add_timer")) {
-		FlyTimer timer;
-		timer.label = jsonString(command, QStringLiteral("label"));
-		if (timer.label.isEmpty())
-			timer.label = QStringLiteral("Timer");
-		timer.mode = jsonString(command, QStringLiteral("mode"));
-		if (timer.mode != QLatin1String("countup"))
-			timer.mode = QStringLiteral("countdown");
-		timer.initial_ms = std::max<qint64>(0, jsonInt64(command, QStringLiteral("initial_ms")));
-		timer.visible = jsonBool(command, QStringLiteral("visible"), true);
-		setTimerStoppedAtInitial(timer);
-		st_.timers.push_back(timer);
-		saveState();
-		refreshUiFromState(false);
-		hotkeyBindings_ = buildMergedHotkeyBindings();
-		applyHotkeyBindings(hotkeyBindings_);
+
+	const FlyThemeInfo info = themeIndex_ ? themeIndex_->info(board.templatePath)
+					      : fly_read_theme_info(board.templatePath);
+	webSocketServer_->sendState(session, boardState(board), info.manifest.title, board.templatePath, board.id);
+}
+
+void FlyScoreDock::refreshBoardCombo()
+{
+	if (!boardCombo_)
 		return;
+
+	QSignalBlocker block(boardCombo_);
+	boardCombo_->clear();
+	for (const FlyBoard &board : boards_) {
+		const QString label = fly_board_is_default(board.id)
+					      ? fly_i18n("Dock.MainBoard")
+					      : (board.name.isEmpty() ? board.id : board.name);
+		boardCombo_->addItem(label, board.id);
+		boardCombo_->setItemData(boardCombo_->count() - 1,
+					 QStringLiteral("%1\n%2").arg(board.id, board.templatePath), Qt::ToolTipRole);
 	}
-	if (action == QLatin1String("remove_timer") && index >= 0 && index < st_.timers.size()) {
-		if (st_.timers.size() > 1) {
-			st_.timers.removeAt(index);
-			saveState();
-			refreshUiFromState(false);
-			hotkeyBindings_ = buildMergedHotkeyBindings();
-			applyHotkeyBindings(hotkeyBindings_);
-		}
+	boardCombo_->setCurrentIndex(std::max(0, boardCombo_->findData(activeBoardId_)));
+
+	if (removeBoardBtn_)
+		removeBoardBtn_->setEnabled(!isDefaultBoardActive());
+}
+
+void FlyScoreDock::switchBoard(const QString &boardId)
+{
+	const FlyBoard *board = findBoard(boardId);
+	if (!board || boardId == activeBoardId_)
 		return;
+
+	boardStates_.insert(activeBoardId_, st_);
+
+	activeBoardId_ = board->id;
+	fly_save_active_board_id(activeBoardId_);
+	dataDir_ = board->templatePath;
+	stateDir_ = fly_board_state_dir(*board);
+
+	if (boardStates_.contains(activeBoardId_)) {
+		st_ = boardStates_.take(activeBoardId_);
+		histories_[activeBoardId_].begin(st_);
+	} else {
+		loadState();
+		histories_[activeBoardId_].reset(st_);
 	}
-	if (action == QLatin1String("set_timer") && index >= 0 && index < st_.timers.size()) {
-		FlyTimer &timer = st_.timers[index];
-		const bool wasRunning = timer.running;
-		if (wasRunning)
-			toggleTimerRunning(index);
+	boardPresets(*board);
+	updateHistoryButtons();
 
-		if (command.contains(QStringLiteral("label")))
-			timer.label = jsonString(command, QStringLiteral("label"));
-		if (command.contains(QStringLiteral("mode"))) {
-			const QString mode = jsonString(command, QStringLiteral("mode"));
-			timer.mode = mode == QLatin1String("countup") ? QStringLiteral("countup") : QStringLiteral("countdown");
-		}
-		if (command.contains(QStringLiteral("initial_ms")))
-			timer.initial_ms = std::max<qint64>(0, jsonInt64(command, QStringLiteral("initial_ms")));
-		if (command.contains(QStringLiteral("remaining_ms")))
-			timer.remaining_ms = std::max<qint64>(0, jsonInt64(command, QStringLiteral("remaining_ms")));
-		else if (command.contains(QStringLiteral("initial_ms")))
-			timer.remaining_ms = timer.initial_ms;
-		if (command.contains(QStringLiteral("visible")))
-			timer.visible = jsonBool(command, QStringLiteral("visible"), timer.visible);
-
-		timer.running = false;
-		timer.last_tick_ms = 0;
-		saveState();
-		refreshUiFromState(false);
+	loadHotkeyBindings();
+
+	refreshUiFromState(false);
+	refreshTemplateCombo(true);
+	refreshBoardCombo();
+	if (templateWatcher_)
+		templateWatcher_->setPath(dataDir_);
+	broadcastCurrentState();
+
+	LOGI("Active board: %s (%s)", activeBoardId_.toUtf8().constData(), stateDir_.toUtf8().constData());
+}
+
+void FlyScoreDock::onToggleTracing(bool enabled)
+{
+	fly_trace_set_enabled(enabled);
+}
+
+void FlyScoreDock::onDumpTrace()
+{
+	const int events = fly_trace_event_count();
+	const QString path = fly_trace_dump();
+	if (path.isEmpty()) {
+		QMessageBox::warning(this, fly_i18n("Dock.TraceDump"), fly_i18n("Dock.TraceDumpFailed"));
 		return;
 	}
-	if (action == QLatin1String("timer_toggle")) {
-		toggleTimerRunning(index);
+	QMessageBox::information(this, fly_i18n("Dock.TraceDump"),
+				 fly_i18n("Dock.TraceDumpDone").arg(events).arg(QDir::toNativeSeparators(path)));
+}
+
+void FlyScoreDock::onAddBoard()
+{
+	bool ok = false;
+	const QString name = QInputDialog::getText(this, fly_i18n("Dock.AddBoardTitle"), fly_i18n("Dock.AddBoardPrompt"),
+						   QLineEdit::Normal, QString(), &ok)
+				     .trimmed();
+	if (!ok || name.isEmpty())
 		return;
-	}
-	if (action == QLatin1String("timer_visibility") && index >= 0 && index < st_.timers.size()) {
-		st_.timers[index].visible = !st_.timers[index].visible;
-		saveState();
-		refreshUiFromState(false);
+
+	QString id = fly_board_normalize_id(name);
+	for (int n = 2; findBoard(id); ++n)
+		id = fly_board_normalize_id(name) + QStringLiteral("-%1").arg(n);
+
+	FlyBoard board;
+	board.id = id;
+	board.name = name;
+	board.templatePath = dataDir_;
+	boards_.push_back(board);
+	fly_boards_save(boards_);
+
+	switchBoard(id);
+}
+
+void FlyScoreDock::onRemoveBoard()
+{
+	if (isDefaultBoardActive())
 		return;
-	}
-	if ((action == QLatin1String("timer_start") || action == QLatin1String("timer_pause")) && index >= 0 &&
-	    index < st_.timers.size()) {
-		const bool shouldRun = action == QLatin1String("timer_start");
-		if (st_.timers[index].running != shouldRun)
-			toggleTimerRunning(index);
+
+	const FlyBoard *board = findBoard(activeBoardId_);
+	if (!board)
 		return;
-	}
-	if (action == QLatin1String("timer_reset") && index >= 0 && index < st_.timers.size()) {
-		FlyTimer &t = st_.timers[index];
-		t.remaining_ms = std::max<qint64>(0, t.initial_ms);
-		t.running = false;
-		t.last_tick_ms = 0;
-		saveState();
-		refreshUiFromState(false);
+
+	const auto rc = QMessageBox::question(this, fly_i18n("Dock.RemoveBoardTitle"),
+					      fly_i18n("Dock.RemoveBoardMessage").arg(boardCombo_->currentText()));
+	if (rc != QMessageBox::Yes)
 		return;
-	}
+
+	const QString removed = activeBoardId_;
+	switchBoard(fly_default_board_id());
+
+	boards_.erase(std::remove_if(boards_.begin(), boards_.end(),
+				     [&removed](const FlyBoard &b) { return b.id == removed; }),
+		      boards_.end());
+	boardStates_.remove(removed);
+	boardPresets_.remove(removed);
+	histories_.remove(removed);
+	fly_boards_save(boards_);
+	refreshBoardCombo();
 }
 
 void FlyScoreDock::loadState()
 {
-	if (!fly_state_load(dataDir_, st_)) {
+	if (!fly_state_load(stateDir_, st_)) {
 		st_ = fly_state_make_defaults();
-		fly_state_save(dataDir_, st_);
+		fly_state_save(stateDir_, st_);
 	}
 
 	if (st_.timers.isEmpty()) {
@@ -1333,21 +1988,27 @@ void FlyScoreDock::loadState()
 		main.remaining_ms = 0;
 		main.last_tick_ms = 0;
 		st_.timers.push_back(main);
-		fly_state_save(dataDir_, st_);
+		fly_state_save(stateDir_, st_);
 	} else if (st_.timers[0].mode.isEmpty()) {
 		st_.timers[0].mode = QStringLiteral("countdown");
 	}
 }
 
-void FlyScoreDock::saveState()
+void FlyScoreDock::saveState(bool undoable)
 {
-	fly_state_save(dataDir_, st_);
+	if (!undoable)
+		histories_[activeBoardId_].follow(st_);
+	else if (histories_[activeBoardId_].commit(st_))
+		updateHistoryButtons();
+	fly_state_save(stateDir_, st_);
 	broadcastCurrentState();
 }
 
 void FlyScoreDock::refreshUiFromState(bool onlyTimeIfRunning)
 {
 	Q_UNUSED(onlyTimeIfRunning);
+	FLY_TRACE_SCOPE_CAT("dock", "refreshUiFromState");
+	FlyMetricsTimer timer(fly_metrics().refreshUiUs);
 
 	if (swapSides_ && swapSides_->isChecked() != st_.swap_sides)
 		swapSides_->setChecked(st_.swap_sides);
@@ -1359,6 +2020,79 @@ void FlyScoreDock::refreshUiFromState(bool onlyTimeIfRunning)
 	loadTimerControlsFromState();
 }
 
+static void fly_update_spin(QSpinBox *spin, int value)
+{
+	if (!spin || spin->value() == value || spin->hasFocus())
+		return;
+	const QSignalBlocker block(spin);
+	spin->setValue(value);
+}
+
+static void fly_update_check(QCheckBox *check, bool on)
+{
+	if (!check || check->isChecked() == on)
+		return;
+	const QSignalBlocker block(check);
+	check->setChecked(on);
+}
+
+static void fly_update_label(QLabel *label, const QString &text)
+{
+	if (label && label->text() != text)
+		label->setText(text);
+}
+
+// Writes values into the existing rows. Signals are blocked so nothing is
+// saved back, and a field the operator is typing in keeps its text.
+void FlyScoreDock::updateControlsFromState()
+{
+	FLY_TRACE_SCOPE_CAT("dock", "updateControlsFromState");
+	if (customFields_.size() != st_.custom_fields.size() || singleStats_.size() != st_.single_stats.size() ||
+	    timers_.size() != st_.timers.size()) {
+		refreshUiFromState(false);
+		return;
+	}
+
+	fly_update_check(swapSides_, st_.swap_sides);
+	fly_update_check(showScoreboard_, st_.show_scoreboard);
+
+	for (qsizetype i = 0; i < customFields_.size(); ++i) {
+		const FlyCustomField &cf = st_.custom_fields[i];
+		const FlyCustomFieldUi &ui = customFields_[i];
+		fly_update_check(ui.visibleCheck, cf.visible);
+		fly_update_label(ui.labelLbl, cf.label.isEmpty() ? QStringLiteral("(unnamed)") : cf.label);
+		fly_update_spin(ui.homeSpin, std::max(0, cf.home));
+		fly_update_spin(ui.awaySpin, std::max(0, cf.away));
+	}
+
+	for (qsizetype i = 0; i < singleStats_.size(); ++i) {
+		const FlySingleStat &ss = st_.single_stats[i];
+		const FlySingleStatUi &ui = singleStats_[i];
+		fly_update_check(ui.visibleCheck, ss.visible);
+		const QString label = ss.label.isEmpty() ? fly_i18n("Hotkey.SingleStatN").arg(i + 1) : ss.label;
+		fly_update_label(ui.labelLbl, label);
+		fly_update_spin(ui.valueSpin, ss.value);
+	}
+
+	for (qsizetype i = 0; i < timers_.size(); ++i) {
+		const FlyTimer &tm = st_.timers[i];
+		const FlyTimerUi &ui = timers_[i];
+		fly_update_check(ui.visibleCheck, tm.visible);
+		fly_update_label(ui.labelLbl, tm.label.isEmpty() ? QStringLiteral("(unnamed)") : tm.label);
+		const QString time = fly_format_ms_mmss(tm.remaining_ms);
+		if (ui.timeEdit && !ui.timeEdit->hasFocus() && ui.timeEdit->text() != time)
+			ui.timeEdit->setText(time);
+		if (ui.startStop) {
+			const QString icon = tm.running ? QStringLiteral("⏸️") : QStringLiteral("▶️");
+			if (ui.startStop->text() != icon) {
+				ui.startStop->setText(icon);
+				ui.startStop->setToolTip(tm.running ? fly_i18n("Dock.PauseTimer")
+								    : fly_i18n("Dock.StartTimer"));
+			}
+		}
+	}
+}
+
 void FlyScoreDock::onClearTeamsAndReset()
 {
 	auto rc = QMessageBox::question(
@@ -1385,6 +2119,8 @@ void FlyScoreDock::onClearTeamsAndReset()
 		tm.last_tick_ms = 0;
 	}
 
+	st_.roster.resetValues();
+
 	saveState();
 	refreshUiFromState(false);
 }
@@ -1404,175 +2140,13 @@ void FlyScoreDock::clearAllCustomFieldRows()
 
 void FlyScoreDock::loadCustomFieldControlsFromState()
 {
+	FLY_TRACE_SCOPE_CAT("dock", "loadCustomFieldControlsFromState");
 	clearAllCustomFieldRows();
 	if (!customFieldsLayout_)
 		return;
 
-	customFields_.reserve(st_.custom_fields.size());
-
-	{
-		auto *hdrRow = new QWidget(this);
-		auto *grid = new QGridLayout(hdrRow);
-		grid->setContentsMargins(0, 0, 0, 0);
-		grid->setHorizontalSpacing(6);
-		grid->setVerticalSpacing(0);
-
-		auto *cbSpacer = new QSpacerItem(22, 0, QSizePolicy::Fixed, QSizePolicy::Minimum);
-		grid->addItem(cbSpacer, 0, 0);
-
-		auto *statHdr = new QLabel(fly_i18n("Common.Stat"), hdrRow);
-		statHdr->setStyleSheet(QStringLiteral("font-weight:bold;"));
-		grid->addWidget(statHdr, 0, 1);
-
-		auto *homeHdr = new QLabel(fly_i18n("Common.Home"), hdrRow);
-		homeHdr->setStyleSheet(QStringLiteral("font-weight:bold;"));
-		homeHdr->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
-		grid->addWidget(homeHdr, 0, 2);
-
-		auto *guestHdr = new QLabel(fly_i18n("Common.Guests"), hdrRow);
-		guestHdr->setStyleSheet(QStringLiteral("font-weight:bold;"));
-		guestHdr->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
-		grid->addWidget(guestHdr, 0, 3);
-
-		grid->setColumnStretch(1, 2);
-		grid->setColumnStretch(2, 1);
-		grid->setColumnStretch(3, 1);
-
-		customFieldsLayout_->addWidget(hdrRow);
-	}
-
-	for (int i = 0; i < st_.custom_fields.size(); ++i) {
-		const auto &cf = st_.custom_fields[i];
-		FlyCustomFieldUi ui;
-
-		auto *row = new QWidget(this);
-		auto *grid = new QGridLayout(row);
-		grid->setContentsMargins(0, 0, 0, 0);
-		grid->setHorizontalSpacing(6);
-		grid->setVerticalSpacing(0);
-
-		auto *visibleCheck = new QCheckBox(row);
-		visibleCheck->setChecked(cf.visible);
-		grid->addWidget(visibleCheck, 0, 0, Qt::AlignLeft | Qt::AlignVCenter);
-
-		auto *labelLbl = new QLabel(cf.label.isEmpty() ? QStringLiteral("(unnamed)") : cf.label, row);
-		labelLbl->setMinimumWidth(120);
-		grid->addWidget(labelLbl, 0, 1);
-
-		auto makeStepBtn = [this](const QString &themeIconName, QStyle::StandardPixmap fallbackPixmap,
-					  const QString &fallbackText, const QString &tooltip,
-					  QWidget *parent) -> QToolButton * {
-			auto *btn = new QToolButton(parent);
-			btn->setToolTip(tooltip);
-			btn->setCursor(Qt::PointingHandCursor);
-			btn->setAutoRaise(false);
-			btn->setFocusPolicy(Qt::StrongFocus);
-			btn->setFixedSize(28, 28);
-			btn->setIconSize(QSize(14, 14));
-
-			QIcon icon = QIcon::fromTheme(themeIconName);
-			if (icon.isNull())
-				icon = style()->standardIcon(fallbackPixmap);
-
-			if (!icon.isNull()) {
-				btn->setIcon(icon);
-			} else {
-				btn->setText(fallbackText);
-			}
-
-			return btn;
-		};
-
-		auto *homeSpin = new QSpinBox(row);
-		homeSpin->setRange(0, std::numeric_limits<int>::max());
-		homeSpin->setValue(std::max(0, cf.home));
-		homeSpin->setMinimumWidth(86);
-		homeSpin->setMaximumHeight(32);
-		homeSpin->setButtonSymbols(QAbstractSpinBox::NoButtons);
-
-		auto *minusHome = makeStepBtn(QStringLiteral("list-remove"), QStyle::SP_ArrowDown, QStringLiteral("-"),
-					      fly_i18n("Dock.HomeMinusOne"), row);
-
-		auto *plusHome = makeStepBtn(QStringLiteral("list-add"), QStyle::SP_ArrowUp, QStringLiteral("+"),
-					     fly_i18n("Dock.HomePlusOne"), row);
-
-		auto *awaySpin = new QSpinBox(row);
-		awaySpin->setRange(0, std::numeric_limits<int>::max());
-		awaySpin->setValue(std::max(0, cf.away));
-		awaySpin->setMinimumWidth(86);
-		awaySpin->setMaximumHeight(32);
-		awaySpin->setButtonSymbols(QAbstractSpinBox::NoButtons);
-
-		auto *minusAway = makeStepBtn(QStringLiteral("list-remove"), QStyle::SP_ArrowDown, QStringLiteral("-"),
-					      fly_i18n("Dock.GuestsMinusOne"), row);
-
-		auto *plusAway = makeStepBtn(QStringLiteral("list-add"), QStyle::SP_ArrowUp, QStringLiteral("+"),
-					     fly_i18n("Dock.GuestsPlusOne"), row);
-
-		auto *homeBox = new QWidget(row);
-		auto *homeLay = new QHBoxLayout(homeBox);
-		homeLay->setContentsMargins(0, 0, 0, 0);
-		homeLay->setSpacing(4);
-		homeLay->addWidget(minusHome, 0, Qt::AlignHCenter | Qt::AlignVCenter);
-		homeLay->addWidget(homeSpin, 0, Qt::AlignHCenter | Qt::AlignVCenter);
-		homeLay->addWidget(plusHome, 0, Qt::AlignHCenter | Qt::AlignVCenter);
-
-		auto *awayBox = new QWidget(row);
-		auto *awayLay = new QHBoxLayout(awayBox);
-		awayLay->setContentsMargins(0, 0, 0, 0);
-		awayLay->setSpacing(4);
-		awayLay->addWidget(minusAway, 0, Qt::AlignHCenter | Qt::AlignVCenter);
-		awayLay->addWidget(awaySpin, 0, Qt::AlignHCenter | Qt::AlignVCenter);
-		awayLay->addWidget(plusAway, 0, Qt::AlignHCenter | Qt::AlignVCenter);
-
-		grid->addWidget(homeBox, 0, 2, Qt::AlignHCenter | Qt::AlignVCenter);
-		grid->addWidget(awayBox, 0, 3, Qt::AlignHCenter | Qt::AlignVCenter);
-
-		grid->setColumnStretch(1, 2);
-		grid->setColumnStretch(2, 1);
-		grid->setColumnStretch(3, 1);
-
-		customFieldsLayout_->addWidget(row);
-
-		ui.row = row;
-		ui.visibleCheck = visibleCheck;
-		ui.labelLbl = labelLbl;
-		ui.homeSpin = homeSpin;
-		ui.awaySpin = awaySpin;
-		ui.minusHome = minusHome;
-		ui.plusHome = plusHome;
-		ui.minusAway = minusAway;
-		ui.plusAway = plusAway;
-
-		auto sync = [this]() {
-			syncCustomFieldControlsToState();
-		};
-
-		connect(homeSpin, qOverload<int>(&QSpinBox::valueChanged), this, [sync](int) { sync(); });
-		connect(awaySpin, qOverload<int>(&QSpinBox::valueChanged), this, [sync](int) { sync(); });
-		connect(visibleCheck, &QCheckBox::toggled, this, [sync](bool) { sync(); });
-
-		connect(minusHome, &QToolButton::clicked, this, [homeSpin, sync]() {
-			homeSpin->setValue(std::max(0, homeSpin->value() - 1));
-			sync();
-		});
-		connect(plusHome, &QToolButton::clicked, this, [homeSpin, sync]() {
-			homeSpin->setValue(homeSpin->value() + 1);
-			sync();
-		});
-		connect(minusAway, &QToolButton::clicked, this, [awaySpin, sync]() {
-			awaySpin->setValue(std::max(0, awaySpin->value() - 1));
-			sync();
-		});
-		connect(plusAway, &QToolButton::clicked, this, [awaySpin, sync]() {
-			awaySpin->setValue(awaySpin->value() + 1);
-			sync();
-		});
-
-		customFields_.push_back(ui);
-	}
-
-	customFieldsLayout_->addStretch(1);
+	customFields_ = fly_custom_field_rows(customFieldsLayout_, st_.custom_fields, this,
+					      [this]() { syncCustomFieldControlsToState(); });
 }
 
 void FlyScoreDock::syncCustomFieldControlsToState()
@@ -1608,6 +2182,7 @@ void FlyScoreDock::clearAllSingleStatRows()
 
 void FlyScoreDock::loadSingleStatControlsFromState()
 {
+	FLY_TRACE_SCOPE_CAT("dock", "loadSingleStatControlsFromState");
 	clearAllSingleStatRows();
 	if (!singleStatsLayout_)
 		return;
@@ -1737,6 +2312,7 @@ void FlyScoreDock::clearAllTimerRows()
 
 void FlyScoreDock::loadTimerControlsFromState()
 {
+	FLY_TRACE_SCOPE_CAT("dock", "loadTimerControlsFromState");
 	clearAllTimerRows();
 	if (!timersLayout_)
 		return;
@@ -1966,34 +2542,7 @@ void FlyScoreDock::toggleTimerRunning(int index)
 	if (index < 0 || index >= st_.timers.size())
 		return;
 
-	FlyTimer &tm = st_.timers[index];
-	const qint64 now = fly_now_ms();
-
-	if (!tm.running) {
-		if (tm.remaining_ms < 0) {
-			if (tm.mode == QStringLiteral("countdown"))
-				tm.remaining_ms = (tm.initial_ms > 0) ? tm.initial_ms : 0;
-			else
-				tm.remaining_ms = 0;
-		}
-		tm.last_tick_ms = now;
-		tm.running = true;
-	} else {
-		if (tm.last_tick_ms > 0) {
-			qint64 elapsed = now - tm.last_tick_ms;
-			if (elapsed < 0)
-				elapsed = 0;
-
-			if (tm.mode == QStringLiteral("countup"))
-				tm.remaining_ms += elapsed;
-			else {
-				tm.remaining_ms -= elapsed;
-				if (tm.remaining_ms < 0)
-					tm.remaining_ms = 0;
-			}
-		}
-		tm.running = false;
-	}
+	fly_timer_toggle(st_.timers[index], fly_now_ms());
 
 	saveState();
 	refreshUiFromState(false);
@@ -2001,10 +2550,13 @@ void FlyScoreDock::toggleTimerRunning(int index)
 
 void FlyScoreDock::onOpenCustomFieldsDialog()
 {
-	FlyFieldsDialog dlg(dataDir_, st_, this);
+	FlyFieldsDialog dlg(stateDir_, st_, this);
 	dlg.exec();
 
 	loadState();
+	// The dialog saved the same board: an operator edit, not a reload.
+	if (histories_[activeBoardId_].commit(st_))
+		updateHistoryButtons();
 	refreshUiFromState(false);
 
 	hotkeyBindings_ = buildMergedHotkeyBindings();
@@ -2013,10 +2565,12 @@ void FlyScoreDock::onOpenCustomFieldsDialog()
 
 void FlyScoreDock::onOpenTimersDialog()
 {
-	FlyTimersDialog dlg(dataDir_, st_, this);
+	FlyTimersDialog dlg(stateDir_, st_, this);
 	dlg.exec();
 
 	loadState();
+	if (histories_[activeBoardId_].commit(st_))
+		updateHistoryButtons();
 	refreshUiFromState(false);
 
 	hotkeyBindings_ = buildMergedHotkeyBindings();
@@ -2025,10 +2579,12 @@ void FlyScoreDock::onOpenTimersDialog()
 
 void FlyScoreDock::onOpenTeamsDialog()
 {
-	FlyTeamsDialog dlg(dataDir_, st_, this);
+	FlyTeamsDialog dlg(dataDir_, stateDir_, st_, this);
 	dlg.exec();
 
 	loadState();
+	if (histories_[activeBoardId_].commit(st_))
+		updateHistoryButtons();
 	refreshUiFromState(false);
 }
 
@@ -2038,29 +2594,16 @@ void FlyScoreDock::ensureResourcesDefaults()
 	if (resDir.isEmpty())
 		resDir = dataDir_;
 
-#ifdef ENABLE_EMBEDDED_DEFAULTS
-	auto writeDefaultText = [](const QString &path, const char *contents) {
-		if (QFileInfo::exists(path) || !contents)
-			return;
-		QDir().mkpath(QFileInfo(path).absolutePath());
-		QFile f(path);
-		if (f.open(QIODevice::WriteOnly | QIODevice::Truncate))
-			f.write(contents);
-	};
-
-	writeDefaultText(QDir(resDir).filePath(QStringLiteral("index.html")), fly_score_embedded::index_html);
-	writeDefaultText(QDir(resDir).filePath(QStringLiteral("manifest.ini")), fly_score_embedded::manifest_ini);
-	writeDefaultText(QDir(resDir).filePath(QStringLiteral("style.css")), fly_score_embedded::style_css);
-	writeDefaultText(QDir(resDir).filePath(QStringLiteral("script.js")), fly_score_embedded::script_js);
-#endif
-
-	fly_state_ensure_json_exists(resDir, &st_);
+	// The built-in template is served from memory (fly_overlay_http_serve) and
+	// only reaches the disk when forked.
+	fly_state_ensure_json_exists(resDir, isDefaultBoardActive() ? &st_ : nullptr);
 }
 
 static QWidget *g_dockContent = nullptr;
 
 FlyScoreDock::~FlyScoreDock()
 {
+	clearAllHotkeys();
 	if (obsSignalsConnected_ && obsSignalHandler_) {
 		auto *sh = static_cast<signal_handler_t *>(obsSignalHandler_);
 		signal_handler_disconnect(sh, "source_create", fly_on_source_list_changed, this);
@@ -2129,13 +2672,27 @@ void FlyScoreDock::refreshBrowserSourceCombo(bool preserveSelection)
 	     prev.toUtf8().constData(), selectedBrowserSourceName().toUtf8().constData(), static_cast<int>(names.size()));
 }
 
+static void fly_on_frontend_event(enum obs_frontend_event event, void *)
+{
+	if (event != OBS_FRONTEND_EVENT_FINISHED_LOADING)
+		return;
+	if (FlyScoreDock *dock = fly_get_dock())
+		dock->finishStartup();
+}
+
 void fly_create_dock()
 {
 	if (g_dockContent)
 		return;
 
+	QElapsedTimer timer;
+	timer.start();
+
 	auto *panel = new FlyScoreDock(nullptr);
-	panel->init();
+	{
+		FlyTraceScope trace("startup", "init");
+		panel->init();
+	}
 
 #if defined(HAVE_OBS_DOCK_BY_ID)
 	obs_frontend_add_dock_by_id(kFlyDockId, kFlyDockTitle, panel);
@@ -2144,7 +2701,12 @@ void fly_create_dock()
 #endif
 
 	g_dockContent = panel;
-	LOGI("Fly Scoreboard dock created");
+	obs_frontend_add_event_callback(fly_on_frontend_event, nullptr);
+
+	const qint64 us = timer.nsecsElapsed() / 1000;
+	fly_metrics().startupLoadUs.set(us);
+	LOGI("Fly Scoreboard dock created in %.2f ms; the rest of startup waits for OBS to finish loading",
+	     double(us) / 1000.0);
 }
 
 void fly_destroy_dock()
@@ -2152,6 +2714,8 @@ void fly_destroy_dock()
 	if (!g_dockContent)
 		return;
 
+	obs_frontend_remove_event_callback(fly_on_frontend_event, nullptr);
+
 #if defined(HAVE_OBS_DOCK_BY_ID)
 	obs_frontend_remove_dock(kFlyDockId);
 #else
@@ -0,0 +1,188 @@
+#include "fly_score_embedded.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][embedded]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_trace.hpp"
+#include "fly_score_websocket_server.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+
+#ifdef ENABLE_EMBEDDED_DEFAULTS
+#include "embedded_assets.hpp"
+#include <zlib.h>
+#endif
+
+bool fly_embedded_available()
+{
+#ifdef ENABLE_EMBEDDED_DEFAULTS
+	FlyEmbeddedAsset index;
+	return fly_embedded_find(QStringLiteral("index.html"), index);
+#else
+	return false;
+#endif
+}
+
+bool fly_embedded_find(const QString &name, FlyEmbeddedAsset &out)
+{
+#ifdef ENABLE_EMBEDDED_DEFAULTS
+	for (const auto &a : fly_score_embedded::assets) {
+		if (name != QLatin1String(a.name))
+			continue;
+		out.name = name;
+		out.gzip = QByteArray::fromRawData(reinterpret_cast<const char *>(a.gzip), qsizetype(a.gzipSize));
+		out.size = qsizetype(a.size);
+		out.sha256 = QByteArray(a.sha256);
+		return true;
+	}
+#else
+	Q_UNUSED(name);
+	Q_UNUSED(out);
+#endif
+	return false;
+}
+
+QByteArray fly_embedded_inflate(const FlyEmbeddedAsset &asset)
+{
+#ifdef ENABLE_EMBEDDED_DEFAULTS
+	FLY_TRACE_SCOPE_CAT("io", "fly_embedded_inflate");
+	QByteArray out(asset.size, Qt::Uninitialized);
+	z_stream zs{};
+	// 16 + MAX_WBITS: expect a gzip header.
+	if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+		return QByteArray();
+	zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(asset.gzip.constData()));
+	zs.avail_in = uInt(asset.gzip.size());
+	zs.next_out = reinterpret_cast<Bytef *>(out.data());
+	zs.avail_out = uInt(out.size());
+	const int rc = inflate(&zs, Z_FINISH);
+	const bool ok = rc == Z_STREAM_END && zs.total_out == uLong(asset.size);
+	inflateEnd(&zs);
+	if (!ok) {
+		LOGW("Embedded asset %s is corrupt (zlib %d)", asset.name.toUtf8().constData(), rc);
+		return QByteArray();
+	}
+	return out;
+#else
+	Q_UNUSED(asset);
+	return QByteArray();
+#endif
+}
+
+QStringList fly_embedded_template_files()
+{
+	return {QStringLiteral("index.html"), QStringLiteral("manifest.ini"), QStringLiteral("style.css"),
+		QStringLiteral("script.js")};
+}
+
+bool fly_embedded_extract_template(const QString &dir)
+{
+	FLY_TRACE_SCOPE_CAT("io", "fly_embedded_extract_template");
+	if (dir.isEmpty() || !QDir().mkpath(dir))
+		return false;
+
+	bool ok = true;
+	for (const QString &name : fly_embedded_template_files()) {
+		const QString path = QDir(dir).filePath(name);
+		FlyEmbeddedAsset asset;
+		if (QFileInfo::exists(path) || !fly_embedded_find(name, asset))
+			continue;
+
+		const QByteArray bytes = fly_embedded_inflate(asset);
+		QSaveFile f(path);
+		if (bytes.size() != asset.size || !f.open(QIODevice::WriteOnly) || f.write(bytes) != bytes.size() ||
+		    !f.commit()) {
+			LOGW("Failed to write built-in template file: %s", path.toUtf8().constData());
+			ok = false;
+			continue;
+		}
+		LOGI("Wrote built-in template file: %s", path.toUtf8().constData());
+	}
+	return ok;
+}
+
+static QByteArray fly_overlay_content_type(const QString &name)
+{
+	const QString ext = QFileInfo(name).suffix().toLower();
+	if (ext == QLatin1String("html") || ext == QLatin1String("htm"))
+		return "text/html; charset=utf-8";
+	if (ext == QLatin1String("css"))
+		return "text/css; charset=utf-8";
+	if (ext == QLatin1String("js"))
+		return "text/javascript; charset=utf-8";
+	if (ext == QLatin1String("json"))
+		return "application/json";
+	if (ext == QLatin1String("ini") || ext == QLatin1String("txt"))
+		return "text/plain; charset=utf-8";
+	if (ext == QLatin1String("png"))
+		return "image/png";
+	if (ext == QLatin1String("jpg") || ext == QLatin1String("jpeg"))
+		return "image/jpeg";
+	if (ext == QLatin1String("gif"))
+		return "image/gif";
+	if (ext == QLatin1String("webp"))
+		return "image/webp";
+	if (ext == QLatin1String("svg"))
+		return "image/svg+xml";
+	if (ext == QLatin1String("woff2"))
+		return "font/woff2";
+	return "application/octet-stream";
+}
+
+void fly_overlay_http_serve(const QString &root, const FlyHttpRequest &req, FlyHttpResponse &res)
+{
+	FLY_TRACE_SCOPE_CAT("io", "fly_overlay_http_serve");
+	const QString prefix = QStringLiteral("/overlay/");
+	if (!req.path.startsWith(prefix))
+		return;
+
+	QString rel = req.path.mid(prefix.size());
+	if (rel.isEmpty())
+		rel = QStringLiteral("index.html");
+	// Drive letters ("C:/..."), UNC and absolute paths would make filePath() ignore root.
+	if (rel.contains(QLatin1Char('\\')) || rel.contains(QLatin1Char(':')) || rel.startsWith(QLatin1Char('/')) ||
+	    QDir::isAbsolutePath(rel) || rel.split(QLatin1Char('/')).contains(QStringLiteral(".."))) {
+		res.status = 400;
+		return;
+	}
+	res.contentType = fly_overlay_content_type(rel);
+
+	if (!root.isEmpty()) {
+		const QString path = QDir(root).filePath(rel);
+		if (QFileInfo::exists(path)) {
+			// Symlinks may still point outside the template folder.
+			const QString canonicalRoot = QFileInfo(root).canonicalFilePath();
+			const QString canonical = QFileInfo(path).canonicalFilePath();
+			if (canonicalRoot.isEmpty() || !canonical.startsWith(canonicalRoot + QLatin1Char('/'))) {
+				LOGW("Refusing overlay request outside the template folder: %s",
+				     rel.toUtf8().constData());
+				res.status = 403;
+				return;
+			}
+			QFile f(canonical);
+			if (!f.open(QIODevice::ReadOnly))
+				return;
+			res.status = 200;
+			res.body = f.readAll();
+			return;
+		}
+	}
+
+	FlyEmbeddedAsset asset;
+	if (!fly_embedded_find(rel, asset))
+		return;
+	res.status = 200;
+	res.etag = '"' + asset.sha256.left(32) + '"';
+	if (req.acceptGzip) {
+		res.body = asset.gzip;
+		res.gzip = true;
+	} else {
+		res.body = fly_embedded_inflate(asset);
+		if (res.body.isEmpty() && asset.size > 0)
+			res.status = 404;
+	}
+}
@@ -0,0 +1,182 @@
+#include "fly_score_field_rows.hpp"
+#include "fly_score_i18n.hpp"
+
+#include <QBoxLayout>
+#include <QCheckBox>
+#include <QGridLayout>
+#include <QHBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QSpacerItem>
+#include <QSpinBox>
+#include <QStyle>
+#include <QToolButton>
+#include <QWidget>
+
+#include <algorithm>
+#include <limits>
+
+static QToolButton *fly_step_button(const QString &themeIconName, QStyle::StandardPixmap fallbackPixmap,
+				    const QString &fallbackText, const QString &tooltip, QWidget *parent)
+{
+	auto *btn = new QToolButton(parent);
+	btn->setToolTip(tooltip);
+	btn->setCursor(Qt::PointingHandCursor);
+	btn->setAutoRaise(false);
+	btn->setFocusPolicy(Qt::StrongFocus);
+	btn->setFixedSize(28, 28);
+	btn->setIconSize(QSize(14, 14));
+
+	QIcon icon = QIcon::fromTheme(themeIconName);
+	if (icon.isNull())
+		icon = parent->style()->standardIcon(fallbackPixmap);
+
+	if (!icon.isNull()) {
+		btn->setIcon(icon);
+	} else {
+		btn->setText(fallbackText);
+	}
+
+	return btn;
+}
+
+static QSpinBox *fly_score_spin(int value, QWidget *parent)
+{
+	auto *spin = new QSpinBox(parent);
+	spin->setRange(0, std::numeric_limits<int>::max());
+	spin->setValue(std::max(0, value));
+	spin->setMinimumWidth(86);
+	spin->setMaximumHeight(32);
+	spin->setButtonSymbols(QAbstractSpinBox::NoButtons);
+	return spin;
+}
+
+static QWidget *fly_stepper_box(QToolButton *minus, QSpinBox *spin, QToolButton *plus, QWidget *parent)
+{
+	auto *box = new QWidget(parent);
+	auto *lay = new QHBoxLayout(box);
+	lay->setContentsMargins(0, 0, 0, 0);
+	lay->setSpacing(4);
+	lay->addWidget(minus, 0, Qt::AlignHCenter | Qt::AlignVCenter);
+	lay->addWidget(spin, 0, Qt::AlignHCenter | Qt::AlignVCenter);
+	lay->addWidget(plus, 0, Qt::AlignHCenter | Qt::AlignVCenter);
+	return box;
+}
+
+QWidget *fly_custom_field_header_row(QWidget *parent)
+{
+	auto *hdrRow = new QWidget(parent);
+	auto *grid = new QGridLayout(hdrRow);
+	grid->setContentsMargins(0, 0, 0, 0);
+	grid->setHorizontalSpacing(6);
+	grid->setVerticalSpacing(0);
+
+	auto *cbSpacer = new QSpacerItem(22, 0, QSizePolicy::Fixed, QSizePolicy::Minimum);
+	grid->addItem(cbSpacer, 0, 0);
+
+	auto *statHdr = new QLabel(fly_i18n("Common.Stat"), hdrRow);
+	statHdr->setStyleSheet(QStringLiteral("font-weight:bold;"));
+	grid->addWidget(statHdr, 0, 1);
+
+	auto *homeHdr = new QLabel(fly_i18n("Common.Home"), hdrRow);
+	homeHdr->setStyleSheet(QStringLiteral("font-weight:bold;"));
+	homeHdr->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+	grid->addWidget(homeHdr, 0, 2);
+
+	auto *guestHdr = new QLabel(fly_i18n("Common.Guests"), hdrRow);
+	guestHdr->setStyleSheet(QStringLiteral("font-weight:bold;"));
+	guestHdr->setAlignment(Qt::AlignHCenter | Qt::AlignVCenter);
+	grid->addWidget(guestHdr, 0, 3);
+
+	grid->setColumnStretch(1, 2);
+	grid->setColumnStretch(2, 1);
+	grid->setColumnStretch(3, 1);
+	return hdrRow;
+}
+
+FlyCustomFieldUi fly_custom_field_row(const FlyCustomField &cf, QWidget *parent, const std::function<void()> &onChanged)
+{
+	FlyCustomFieldUi ui;
+
+	auto *row = new QWidget(parent);
+	auto *grid = new QGridLayout(row);
+	grid->setContentsMargins(0, 0, 0, 0);
+	grid->setHorizontalSpacing(6);
+	grid->setVerticalSpacing(0);
+
+	auto *visibleCheck = new QCheckBox(row);
+	visibleCheck->setChecked(cf.visible);
+	grid->addWidget(visibleCheck, 0, 0, Qt::AlignLeft | Qt::AlignVCenter);
+
+	auto *labelLbl = new QLabel(cf.label.isEmpty() ? QStringLiteral("(unnamed)") : cf.label, row);
+	labelLbl->setMinimumWidth(120);
+	grid->addWidget(labelLbl, 0, 1);
+
+	auto *homeSpin = fly_score_spin(cf.home, row);
+	auto *minusHome = fly_step_button(QStringLiteral("list-remove"), QStyle::SP_ArrowDown, QStringLiteral("-"),
+					  fly_i18n("Dock.HomeMinusOne"), row);
+	auto *plusHome = fly_step_button(QStringLiteral("list-add"), QStyle::SP_ArrowUp, QStringLiteral("+"),
+					 fly_i18n("Dock.HomePlusOne"), row);
+
+	auto *awaySpin = fly_score_spin(cf.away, row);
+	auto *minusAway = fly_step_button(QStringLiteral("list-remove"), QStyle::SP_ArrowDown, QStringLiteral("-"),
+					  fly_i18n("Dock.GuestsMinusOne"), row);
+	auto *plusAway = fly_step_button(QStringLiteral("list-add"), QStyle::SP_ArrowUp, QStringLiteral("+"),
+					 fly_i18n("Dock.GuestsPlusOne"), row);
+
+	grid->addWidget(fly_stepper_box(minusHome, homeSpin, plusHome, row), 0, 2, Qt::AlignHCenter | Qt::AlignVCenter);
+	grid->addWidget(fly_stepper_box(minusAway, awaySpin, plusAway, row), 0, 3, Qt::AlignHCenter | Qt::AlignVCenter);
+
+	grid->setColumnStretch(1, 2);
+	grid->setColumnStretch(2, 1);
+	grid->setColumnStretch(3, 1);
+
+	ui.row = row;
+	ui.visibleCheck = visibleCheck;
+	ui.labelLbl = labelLbl;
+	ui.homeSpin = homeSpin;
+	ui.awaySpin = awaySpin;
+	ui.minusHome = minusHome;
+	ui.plusHome = plusHome;
+	ui.minusAway = minusAway;
+	ui.plusAway = plusAway;
+
+	const auto sync = onChanged;
+	QObject::connect(homeSpin, qOverload<int>(&QSpinBox::valueChanged), row, [sync](int) { sync(); });
+	QObject::connect(awaySpin, qOverload<int>(&QSpinBox::valueChanged), row, [sync](int) { sync(); });
+	QObject::connect(visibleCheck, &QCheckBox::toggled, row, [sync](bool) { sync(); });
+
+	QObject::connect(minusHome, &QToolButton::clicked, row, [homeSpin, sync]() {
+		homeSpin->setValue(std::max(0, homeSpin->value() - 1));
+		sync();
+	});
+	QObject::connect(plusHome, &QToolButton::clicked, row, [homeSpin, sync]() {
+		homeSpin->setValue(homeSpin->value() + 1);
+		sync();
+	});
+	QObject::connect(minusAway, &QToolButton::clicked, row, [awaySpin, sync]() {
+		awaySpin->setValue(std::max(0, awaySpin->value() - 1));
+		sync();
+	});
+	QObject::connect(plusAway, &QToolButton::clicked, row, [awaySpin, sync]() {
+		awaySpin->setValue(awaySpin->value() + 1);
+		sync();
+	});
+
+	return ui;
+}
+
+QList<FlyCustomFieldUi> fly_custom_field_rows(QBoxLayout *layout, const QVector<FlyCustomField> &fields,
+					      QWidget *parent, const std::function<void()> &onChanged)
+{
+	QList<FlyCustomFieldUi> rows;
+	rows.reserve(fields.size());
+	layout->addWidget(fly_custom_field_header_row(parent));
+	for (const auto &cf : fields) {
+		FlyCustomFieldUi ui = fly_custom_field_row(cf, parent, onChanged);
+		layout->addWidget(ui.row);
+		rows.push_back(ui);
+	}
+	layout->addStretch(1);
+	return rows;
+}
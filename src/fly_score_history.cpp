@@ -0,0 +1,64 @@
+#include "fly_score_history.hpp"
+
+#include <utility>
+
+void FlyHistory::begin(const FlyState &st)
+{
+	if (hasBase_)
+		return;
+	current_ = st;
+	hasBase_ = true;
+}
+
+void FlyHistory::reset(const FlyState &st)
+{
+	clear();
+	current_ = st;
+	hasBase_ = true;
+}
+
+bool FlyHistory::commit(const FlyState &st)
+{
+	if (!hasBase_) {
+		begin(st);
+		return false;
+	}
+	if (st == current_)
+		return false;
+
+	undo_.push_back(std::exchange(current_, st));
+	redo_.clear();
+	while (undo_.size() > limit_)
+		undo_.removeFirst();
+	return true;
+}
+
+void FlyHistory::follow(const FlyState &st)
+{
+	current_ = st;
+	hasBase_ = true;
+}
+
+bool FlyHistory::undo(FlyState &st)
+{
+	if (undo_.isEmpty())
+		return false;
+	redo_.push_back(std::exchange(current_, undo_.takeLast()));
+	st = current_;
+	return true;
+}
+
+bool FlyHistory::redo(FlyState &st)
+{
+	if (redo_.isEmpty())
+		return false;
+	undo_.push_back(std::exchange(current_, redo_.takeLast()));
+	st = current_;
+	return true;
+}
+
+void FlyHistory::clear()
+{
+	undo_.clear();
+	redo_.clear();
+}
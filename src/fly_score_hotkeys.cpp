@@ -0,0 +1,176 @@
+#include "fly_score_hotkeys.hpp"
+#include "fly_score_i18n.hpp"
+
+#include <QHash>
+#include <QStringList>
+
+static FlyHotkeyAction fly_hotkey_action(FlyHotkeyKind kind, int index = -1, int delta = 0)
+{
+	FlyHotkeyAction a;
+	a.kind = kind;
+	a.index = index;
+	a.delta = delta;
+	return a;
+}
+
+QVector<FlyHotkeyBinding> fly_hotkeys_default_bindings(const FlyState &st, const QVector<FlyPreset> &presets)
+{
+	QVector<FlyHotkeyBinding> v;
+	v.reserve(4 + st.custom_fields.size() * 5 + st.single_stats.size() * 3 + st.timers.size() + presets.size());
+
+	v.push_back({"swap_sides", fly_i18n("Hotkey.SwapSides"), QKeySequence(),
+		     fly_hotkey_action(FlyHotkeyKind::SwapSides)});
+	v.push_back({"toggle_scoreboard", fly_i18n("Hotkey.ToggleScoreboard"), QKeySequence(),
+		     fly_hotkey_action(FlyHotkeyKind::ToggleScoreboard)});
+	v.push_back({"undo", fly_i18n("Hotkey.Undo"), QKeySequence(), fly_hotkey_action(FlyHotkeyKind::Undo)});
+	v.push_back({"redo", fly_i18n("Hotkey.Redo"), QKeySequence(), fly_hotkey_action(FlyHotkeyKind::Redo)});
+
+	for (int i = 0; i < st.custom_fields.size(); ++i) {
+		const auto &cf = st.custom_fields[i];
+		const QString label = cf.label.isEmpty() ? fly_i18n("Hotkey.CustomFieldN").arg(i + 1) : cf.label;
+		const QString baseId = QStringLiteral("field_%1").arg(i);
+
+		v.push_back({baseId + "_toggle", fly_i18n("Hotkey.CustomToggle").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::FieldToggle, i)});
+		v.push_back({baseId + "_home_inc", fly_i18n("Hotkey.CustomHomeInc").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::FieldHome, i, +1)});
+		v.push_back({baseId + "_home_dec", fly_i18n("Hotkey.CustomHomeDec").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::FieldHome, i, -1)});
+		v.push_back({baseId + "_away_inc", fly_i18n("Hotkey.CustomGuestsInc").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::FieldAway, i, +1)});
+		v.push_back({baseId + "_away_dec", fly_i18n("Hotkey.CustomGuestsDec").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::FieldAway, i, -1)});
+	}
+
+	for (int i = 0; i < st.single_stats.size(); ++i) {
+		const auto &ss = st.single_stats[i];
+		const QString label = ss.label.isEmpty() ? fly_i18n("Hotkey.SingleStatN").arg(i + 1) : ss.label;
+		const QString baseId = QStringLiteral("single_%1").arg(i);
+
+		v.push_back({baseId + "_toggle", fly_i18n("Hotkey.SingleToggle").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::SingleToggle, i)});
+		v.push_back({baseId + "_inc", fly_i18n("Hotkey.SingleInc").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::SingleBump, i, +1)});
+		v.push_back({baseId + "_dec", fly_i18n("Hotkey.SingleDec").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::SingleBump, i, -1)});
+	}
+
+	for (int i = 0; i < st.timers.size(); ++i) {
+		const auto &tm = st.timers[i];
+		const QString label = tm.label.isEmpty() ? fly_i18n("Hotkey.TimerN").arg(i + 1) : tm.label;
+		const QString baseId = QStringLiteral("timer_%1").arg(i);
+
+		v.push_back({baseId + "_toggle", fly_i18n("Hotkey.TimerToggle").arg(label), QKeySequence(),
+			     fly_hotkey_action(FlyHotkeyKind::TimerToggle, i)});
+	}
+
+	for (const FlyPreset &p : presets) {
+		FlyHotkeyAction a = fly_hotkey_action(FlyHotkeyKind::Preset);
+		a.preset = p.id;
+		v.push_back(
+			{QStringLiteral("preset:") + p.id, fly_i18n("Hotkey.Preset").arg(p.name), QKeySequence(), a});
+	}
+
+	return v;
+}
+
+QVector<FlyHotkeyBinding> fly_hotkeys_merge(const QVector<FlyHotkeyBinding> &defaults,
+					    const QVector<FlyHotkeyBinding> &current)
+{
+	QVector<FlyHotkeyBinding> merged = defaults;
+	if (current.isEmpty())
+		return merged;
+
+	QHash<QString, QKeySequence> existing;
+	existing.reserve(current.size());
+	for (const auto &b : current)
+		existing.insert(b.actionId, b.sequence);
+
+	for (auto &b : merged) {
+		const auto it = existing.constFind(b.actionId);
+		if (it != existing.constEnd())
+			b.sequence = it.value();
+	}
+
+	return merged;
+}
+
+static QHash<QString, QKeySequence> fly_hotkeys_bound(const QVector<FlyHotkeyBinding> &bindings)
+{
+	QHash<QString, QKeySequence> bound;
+	for (const auto &b : bindings) {
+		if (!b.sequence.isEmpty())
+			bound.insert(b.actionId, b.sequence);
+	}
+	return bound;
+}
+
+bool fly_hotkeys_same_sequences(const QVector<FlyHotkeyBinding> &a, const QVector<FlyHotkeyBinding> &b)
+{
+	return fly_hotkeys_bound(a) == fly_hotkeys_bound(b);
+}
+
+FlyHotkeyAction fly_hotkey_parse_action(const QString &id)
+{
+	FlyHotkeyAction a;
+
+	if (id == QLatin1String("swap_sides")) {
+		a.kind = FlyHotkeyKind::SwapSides;
+		return a;
+	}
+	if (id == QLatin1String("toggle_scoreboard")) {
+		a.kind = FlyHotkeyKind::ToggleScoreboard;
+		return a;
+	}
+	if (id == QLatin1String("undo") || id == QLatin1String("redo")) {
+		a.kind = id == QLatin1String("undo") ? FlyHotkeyKind::Undo : FlyHotkeyKind::Redo;
+		return a;
+	}
+	// Preset ids may contain '_', so they use their own prefix.
+	if (id.startsWith(QLatin1String("preset:"))) {
+		a.preset = id.mid(7);
+		if (!a.preset.isEmpty())
+			a.kind = FlyHotkeyKind::Preset;
+		return a;
+	}
+
+	const QStringList parts = id.split(QLatin1Char('_'));
+	if (parts.size() < 3)
+		return a;
+
+	bool ok = false;
+	const int idx = parts[1].toInt(&ok);
+	if (!ok)
+		return a;
+	a.index = idx;
+
+	const QString &head = parts[0];
+	if (head == QLatin1String("field")) {
+		if (parts.size() == 3 && parts[2] == QLatin1String("toggle")) {
+			a.kind = FlyHotkeyKind::FieldToggle;
+		} else if (parts.size() == 4) {
+			const QString &side = parts[2];
+			const QString &dir = parts[3];
+			a.delta = dir == QLatin1String("inc") ? +1 : dir == QLatin1String("dec") ? -1 : 0;
+			if (a.delta != 0 && side == QLatin1String("home"))
+				a.kind = FlyHotkeyKind::FieldHome;
+			else if (a.delta != 0 && side == QLatin1String("away"))
+				a.kind = FlyHotkeyKind::FieldAway;
+		}
+	} else if (head == QLatin1String("single") && parts.size() == 3) {
+		const QString &action = parts[2];
+		if (action == QLatin1String("toggle")) {
+			a.kind = FlyHotkeyKind::SingleToggle;
+		} else if (action == QLatin1String("inc")) {
+			a.kind = FlyHotkeyKind::SingleBump;
+			a.delta = +1;
+		} else if (action == QLatin1String("dec")) {
+			a.kind = FlyHotkeyKind::SingleBump;
+			a.delta = -1;
+		}
+	} else if (head == QLatin1String("timer") && parts.size() == 3 && parts[2] == QLatin1String("toggle")) {
+		a.kind = FlyHotkeyKind::TimerToggle;
+	}
+
+	return a;
+}
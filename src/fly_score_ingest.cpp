@@ -0,0 +1,388 @@
+#include "fly_score_ingest.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][ingest]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_commands.hpp"
+#include "fly_score_metrics.hpp"
+#include "fly_score_trace.hpp"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkDatagram>
+#include <QRegularExpression>
+#include <QTimer>
+#include <QUdpSocket>
+#include <QVariant>
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+// Upper bound on how often a board is saved and broadcast because of ingest.
+static constexpr int kIngestFlushMs = 100;
+
+namespace {
+
+class FlyJsonIngestAdapter : public FlyIngestAdapter {
+public:
+	QString name() const override { return QStringLiteral("json"); }
+
+	bool decode(const QByteArray &packet, QList<QJsonObject> &commands) const override
+	{
+		QJsonParseError err{};
+		const QJsonDocument doc = QJsonDocument::fromJson(packet, &err);
+		if (err.error != QJsonParseError::NoError)
+			return false;
+
+		if (doc.isObject())
+			return accept(doc.object(), commands);
+		if (!doc.isArray())
+			return false;
+
+		bool ok = true;
+		for (const QJsonValue &v : doc.array())
+			ok = (v.isObject() && accept(v.toObject(), commands)) && ok;
+		return ok;
+	}
+
+private:
+	static bool accept(const QJsonObject &command, QList<QJsonObject> &commands)
+	{
+		if (fly_command_action(command).isEmpty())
+			return false;
+		commands.push_back(command);
+		return true;
+	}
+};
+
+class FlyTextIngestAdapter : public FlyIngestAdapter {
+public:
+	QString name() const override { return QStringLiteral("text"); }
+
+	bool decode(const QByteArray &packet, QList<QJsonObject> &commands) const override
+	{
+		static const QRegularExpression separators(QStringLiteral("[\\s;,]+"));
+		const QStringList tokens = QString::fromUtf8(packet).split(separators, Qt::SkipEmptyParts);
+
+		bool ok = !tokens.isEmpty();
+		QList<QJsonObject> decoded;
+		for (const QString &token : tokens)
+			ok = decodeToken(token, decoded) && ok;
+
+		// "running=1 clock=11:42" must still leave the clock running.
+		std::stable_partition(decoded.begin(), decoded.end(), [](const QJsonObject &c) {
+			const QString action = fly_command_action(c);
+			return action != QLatin1String("timer_start") && action != QLatin1String("timer_pause");
+		});
+		commands.append(decoded);
+		return ok;
+	}
+
+private:
+	static bool decodeToken(const QString &token, QList<QJsonObject> &commands)
+	{
+		const qsizetype eq = token.indexOf(QLatin1Char('='));
+		if (eq <= 0)
+			return false;
+
+		QString key = token.left(eq).toLower();
+		const QString value = token.mid(eq + 1);
+		qsizetype digits = key.size();
+		while (digits > 0 && key.at(digits - 1).isDigit())
+			--digits;
+		const int index = digits < key.size() ? key.mid(digits).toInt() : 0;
+		key.truncate(digits);
+
+		QJsonObject cmd;
+		cmd.insert(QStringLiteral("index"), index);
+
+		if (key == QLatin1String("home") || key == QLatin1String("away")) {
+			bool isInt = false;
+			const int score = value.toInt(&isInt);
+			if (!isInt || score < 0)
+				return false;
+			cmd.insert(QStringLiteral("action"), QStringLiteral("set_score"));
+			cmd.insert(QStringLiteral("side"), key);
+			cmd.insert(QStringLiteral("value"), score);
+		} else if (key == QLatin1String("clock")) {
+			qint64 ms = 0;
+			if (!parseClock(value, ms))
+				return false;
+			cmd.insert(QStringLiteral("action"), QStringLiteral("set_timer"));
+			cmd.insert(QStringLiteral("remaining_ms"), ms);
+			cmd.insert(QStringLiteral("keep_running"), true);
+		} else if (key == QLatin1String("running")) {
+			const QString v = value.toLower();
+			const auto is = [&v](const char *s) { return v == QLatin1String(s); };
+			const bool on = is("1") || is("true") || is("on");
+			if (!on && !is("0") && !is("false") && !is("off"))
+				return false;
+			cmd.insert(QStringLiteral("action"),
+				   on ? QStringLiteral("timer_start") : QStringLiteral("timer_pause"));
+		} else if (key == QLatin1String("single")) {
+			bool isInt = false;
+			const int v = value.toInt(&isInt);
+			if (!isInt)
+				return false;
+			cmd.insert(QStringLiteral("action"), QStringLiteral("set_single"));
+			cmd.insert(QStringLiteral("value"), v);
+		} else {
+			return false;
+		}
+
+		commands.push_back(cmd);
+		return true;
+	}
+
+	// "754000", "12:34", "12:34.5", "1:02:03".
+	static bool parseClock(const QString &text, qint64 &ms)
+	{
+		bool ok = false;
+		if (!text.contains(QLatin1Char(':'))) {
+			ms = text.toLongLong(&ok);
+			return ok && ms >= 0;
+		}
+
+		const QStringList parts = text.split(QLatin1Char(':'));
+		if (parts.size() > 3)
+			return false;
+
+		double seconds = 0;
+		for (int i = 0; i < parts.size(); ++i) {
+			const bool last = i + 1 == parts.size();
+			if (!last && parts[i].contains(QLatin1Char('.')))
+				return false;
+			const double v = parts[i].toDouble(&ok);
+			if (!ok || v < 0 || !std::isfinite(v))
+				return false;
+			seconds = seconds * 60 + v;
+		}
+		ms = static_cast<qint64>(std::llround(seconds * 1000.0));
+		return true;
+	}
+};
+
+// Commands whose effect only depends on their own payload; "" for anything
+// relative or structural.
+QString fly_ingest_coalesce_key(const QJsonObject &command)
+{
+	const QString action = fly_command_action(command);
+	const QString index = QString::number(fly_command_int(command, QStringLiteral("index")));
+
+	if (action == QLatin1String("set_score") || action == QLatin1String("set_team"))
+		return action + QLatin1Char('|') + index + QLatin1Char('|') +
+		       fly_command_string(command, QStringLiteral("side")).toLower();
+	if (action == QLatin1String("set_player_stat"))
+		return action + QLatin1Char('|') + fly_command_string(command, QStringLiteral("team")).toLower() +
+		       QLatin1Char('|') + QString::number(fly_command_int(command, QStringLiteral("number"))) +
+		       QLatin1Char('|') + command.value(QStringLiteral("stat")).toVariant().toString().toLower();
+	if (action == QLatin1String("set_field") || action == QLatin1String("set_single"))
+		return action + QLatin1Char('|') + index;
+	// A plain set_timer also stops the clock; only the keep_running form commutes with start/pause.
+	if (action == QLatin1String("set_timer"))
+		return fly_command_bool(command, QStringLiteral("keep_running")) ? action + QLatin1Char('|') + index
+										  : QString();
+	if (action == QLatin1String("timer_start") || action == QLatin1String("timer_pause"))
+		return QStringLiteral("timer_run|") + index;
+	if (action == QLatin1String("show_scoreboard"))
+		return action;
+	return QString();
+}
+
+} // namespace
+
+QStringList fly_ingest_adapter_names()
+{
+	return {QStringLiteral("text"), QStringLiteral("json")};
+}
+
+std::unique_ptr<FlyIngestAdapter> fly_ingest_make_adapter(const QString &name)
+{
+	if (name == QLatin1String("text"))
+		return std::make_unique<FlyTextIngestAdapter>();
+	if (name == QLatin1String("json"))
+		return std::make_unique<FlyJsonIngestAdapter>();
+	return nullptr;
+}
+
+void FlyIngestCoalescer::add(const QJsonObject &command)
+{
+	const QString key = fly_ingest_coalesce_key(command);
+	if (key.isEmpty()) {
+		slots_.clear();
+		batch_.push_back(command);
+		return;
+	}
+
+	const auto it = slots_.constFind(key);
+	if (it == slots_.constEnd()) {
+		slots_.insert(key, int(batch_.size()));
+		batch_.push_back(command);
+		return;
+	}
+
+	QJsonObject &slot = batch_[it.value()];
+	if (key.startsWith(QLatin1String("timer_run|"))) {
+		slot = command;
+	} else {
+		// set_timer with only initial_ms also resets remaining_ms.
+		if (command.contains(QStringLiteral("initial_ms")) && !command.contains(QStringLiteral("remaining_ms")))
+			slot.remove(QStringLiteral("remaining_ms"));
+		for (auto v = command.constBegin(); v != command.constEnd(); ++v)
+			slot.insert(v.key(), v.value());
+	}
+	++merged_;
+}
+
+QList<QJsonObject> FlyIngestCoalescer::take()
+{
+	slots_.clear();
+	merged_ = 0;
+	return std::exchange(batch_, QList<QJsonObject>());
+}
+
+FlyIngestManager::FlyIngestManager(QObject *parent) : QObject(parent), flushTimer_(new QTimer(this))
+{
+	flushTimer_->setSingleShot(true);
+	connect(flushTimer_, &QTimer::timeout, this, &FlyIngestManager::flush);
+	sinceFlush_.start();
+}
+
+FlyIngestManager::~FlyIngestManager()
+{
+	for (auto &source : sources_)
+		delete source->socket;
+}
+
+void FlyIngestManager::setSources(const QVector<FlyIngestSourceConfig> &sources)
+{
+	std::vector<std::unique_ptr<Source>> next;
+	for (const FlyIngestSourceConfig &config : sources) {
+		const auto reuse = std::find_if(sources_.begin(), sources_.end(), [&config](const auto &s) {
+			return s && s->health.config == config;
+		});
+		if (reuse != sources_.end()) {
+			next.push_back(std::move(*reuse));
+			continue;
+		}
+
+		auto source = std::make_unique<Source>();
+		source->health.config = config;
+		source->adapter = fly_ingest_make_adapter(config.adapter);
+		bind(*source);
+		next.push_back(std::move(source));
+	}
+
+	for (auto &old : sources_) {
+		if (old)
+			delete old->socket;
+	}
+	sources_ = std::move(next);
+	emit healthChanged();
+}
+
+QVector<FlyIngestSourceConfig> FlyIngestManager::sources() const
+{
+	QVector<FlyIngestSourceConfig> out;
+	out.reserve(qsizetype(sources_.size()));
+	for (const auto &source : sources_)
+		out.push_back(source->health.config);
+	return out;
+}
+
+QVector<FlyIngestHealth> FlyIngestManager::health() const
+{
+	QVector<FlyIngestHealth> out;
+	out.reserve(qsizetype(sources_.size()));
+	for (const auto &source : sources_)
+		out.push_back(source->health);
+	return out;
+}
+
+void FlyIngestManager::bind(Source &source)
+{
+	FlyIngestHealth &h = source.health;
+	if (!source.adapter) {
+		h.error = QStringLiteral("unknown adapter '%1'").arg(h.config.adapter);
+		LOGW("Ingest source :%u: %s", unsigned(h.config.port), h.error.toUtf8().constData());
+		return;
+	}
+
+	const QHostAddress address(h.config.address.isEmpty() ? QStringLiteral("127.0.0.1") : h.config.address);
+	if (address.isNull()) {
+		h.error = QStringLiteral("invalid address '%1'").arg(h.config.address);
+		LOGW("Ingest source :%u: %s", unsigned(h.config.port), h.error.toUtf8().constData());
+		return;
+	}
+
+	auto *socket = new QUdpSocket(this);
+	if (!socket->bind(address, h.config.port)) {
+		h.error = socket->errorString();
+		LOGW("Ingest source %s:%u: bind failed: %s", address.toString().toUtf8().constData(),
+		     unsigned(h.config.port), h.error.toUtf8().constData());
+		delete socket;
+		return;
+	}
+
+	source.socket = socket;
+	h.listening = true;
+	h.error.clear();
+	Source *raw = &source;
+	connect(socket, &QUdpSocket::readyRead, this, [this, raw]() { readPending(raw); });
+	LOGI("Ingest listening on udp %s:%u (%s) for board '%s'", address.toString().toUtf8().constData(),
+	     unsigned(h.config.port), h.config.adapter.toUtf8().constData(), h.config.board.toUtf8().constData());
+}
+
+void FlyIngestManager::readPending(Source *source)
+{
+	FLY_TRACE_SCOPE_CAT("ingest", "readPending");
+	FlyIngestHealth &h = source->health;
+	FlyIngestCoalescer &pending = pending_[h.config.board];
+	QList<QJsonObject> commands;
+
+	while (source->socket->hasPendingDatagrams()) {
+		const QNetworkDatagram datagram = source->socket->receiveDatagram();
+		if (!datagram.isValid())
+			break;
+
+		++h.packets;
+		fly_metrics().ingestPackets.add();
+		h.lastPacketMs = QDateTime::currentMSecsSinceEpoch();
+		h.lastSender = datagram.senderAddress().toString();
+
+		commands.clear();
+		if (!source->adapter->decode(datagram.data(), commands)) {
+			++h.malformed;
+			fly_metrics().ingestMalformed.add();
+		}
+		h.commands += quint64(commands.size());
+		for (const QJsonObject &command : commands)
+			pending.add(command);
+	}
+
+	if (pending.isEmpty()) {
+		pending_.remove(h.config.board);
+		return;
+	}
+
+	// Leading edge goes out on the next loop turn; a flood waits for the window.
+	if (!flushTimer_->isActive())
+		flushTimer_->start(int(std::max<qint64>(0, kIngestFlushMs - sinceFlush_.elapsed())));
+}
+
+void FlyIngestManager::flush()
+{
+	FLY_TRACE_SCOPE_CAT("ingest", "flush");
+	auto pending = std::exchange(pending_, QHash<QString, FlyIngestCoalescer>());
+	sinceFlush_.restart();
+
+	for (auto it = pending.begin(); it != pending.end(); ++it) {
+		fly_metrics().ingestCoalesced.add(uint64_t(it->merged()));
+		emit batchReady(it.key(), it->take());
+	}
+}
@@ -4,11 +4,22 @@
 #define LOG_TAG "[" PLUGIN_NAME "][dock-logo]"
 #include "fly_score_log.hpp"
 
+#include "fly_score_state.hpp"
+#include "fly_score_theme_index.hpp"
+
 #include <QMimeDatabase>
 #include <QFileInfo>
 #include <QFile>
 #include <QDir>
+#include <QBuffer>
 #include <QCryptographicHash>
+#include <QImage>
+#include <QImageIOHandler>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QSaveFile>
+
+#include <utility>
 
 QString fly_normalized_ext_from_mime(const QString &path)
 {
@@ -31,56 +42,253 @@ QString fly_normalized_ext_from_mime(const QString &path)
 	return ext.isEmpty() ? QStringLiteral("png") : ext;
 }
 
-static QString fly_short_hash_of_file(const QString &path)
+static constexpr int kDefaultLogoBox = 256;
+static constexpr int kMaxLogoBox = 2048;
+static constexpr int kLogoWebpQuality = 90;
+
+static QString fly_doc_root(const QString &dataDir)
+{
+	return QDir(dataDir).absolutePath();
+}
+
+static bool fly_logo_webp_supported()
+{
+	static const bool supported = QImageWriter::supportedImageFormats().contains("webp");
+	return supported;
+}
+
+static bool fly_write_file_atomic(const QString &path, const QByteArray &data)
+{
+	QSaveFile f(path);
+	if (!f.open(QIODevice::WriteOnly))
+		return false;
+	if (f.write(data) != data.size()) {
+		f.cancelWriting();
+		return false;
+	}
+	return f.commit();
+}
+
+static QByteArray fly_read_file(const QString &path, bool *ok)
 {
 	QFile f(path);
-	if (!f.open(QIODevice::ReadOnly))
-		return QString();
-	QCryptographicHash h(QCryptographicHash::Sha256);
-	while (!f.atEnd())
-		h.addData(f.read(64 * 1024));
-	return QString::fromLatin1(h.result().toHex().left(8));
+	*ok = f.open(QIODevice::ReadOnly);
+	return *ok ? f.readAll() : QByteArray();
 }
 
-static QString fly_doc_root(const QString &dataDir)
+static bool fly_encode_logo(const QImage &img, QByteArray &out, QString &ext)
 {
-	return QDir(dataDir).absolutePath();
+	const bool webp = fly_logo_webp_supported();
+	{
+		QBuffer buf(&out);
+		buf.open(QIODevice::WriteOnly);
+		QImageWriter writer(&buf, webp ? QByteArrayLiteral("webp") : QByteArrayLiteral("png"));
+		if (webp)
+			writer.setQuality(kLogoWebpQuality);
+		if (writer.write(img)) {
+			ext = webp ? QStringLiteral("webp") : QStringLiteral("png");
+			return true;
+		}
+		LOGW("Logo encode failed (%s): %s", webp ? "webp" : "png", writer.errorString().toUtf8().constData());
+	}
+
+	if (!webp)
+		return false;
+
+	out.clear();
+	QBuffer buf(&out);
+	buf.open(QIODevice::WriteOnly);
+	QImageWriter writer(&buf, QByteArrayLiteral("png"));
+	if (!writer.write(img))
+		return false;
+	ext = QStringLiteral("png");
+	return true;
 }
 
-QString fly_copy_logo_to_overlay(const QString &dataDir, const QString &srcAbs, const QString &baseName)
+QSize fly_logo_box_for_template(const QString &templatePath)
 {
-	if (srcAbs.isEmpty())
-		return QString();
+	const FlyThemeManifest manifest = fly_read_theme_info(templatePath).manifest;
+	int w = manifest.logoWidth;
+	int h = manifest.logoHeight;
+	if (w <= 0 && h <= 0)
+		return QSize(kDefaultLogoBox, kDefaultLogoBox);
+	if (w <= 0)
+		w = h;
+	if (h <= 0)
+		h = w;
+	return QSize(qMin(w, kMaxLogoBox), qMin(h, kMaxLogoBox));
+}
 
-	const QString rootDirPath = fly_doc_root(dataDir);
-	QDir rootDir(rootDirPath);
-	if (!rootDir.exists()) {
-		if (!rootDir.mkpath(QStringLiteral("."))) {
-			LOGW("Failed to create docRoot for logos: %s", rootDirPath.toUtf8().constData());
-			return QString();
+QString fly_logo_cache_dir()
+{
+	return QDir(fly_data_dir()).filePath(QStringLiteral("logo-cache"));
+}
+
+FlyLogoIngestResult fly_ingest_logo(const FlyLogoIngestRequest &request, const std::function<void(int)> &progress)
+{
+	FlyLogoIngestResult result;
+	const auto report = [&progress](int value) {
+		if (progress)
+			progress(value);
+	};
+
+	if (request.source.isEmpty() || request.dataDir.isEmpty()) {
+		result.error = QStringLiteral("No logo source or template folder");
+		return result;
+	}
+
+	QDir rootDir(fly_doc_root(request.dataDir));
+	if (!rootDir.exists() && !rootDir.mkpath(QStringLiteral("."))) {
+		result.error = QStringLiteral("Cannot create template folder");
+		return result;
+	}
+
+	bool ok = false;
+	const QByteArray bytes = fly_read_file(request.source, &ok);
+	if (!ok || bytes.isEmpty()) {
+		result.error = QStringLiteral("Cannot read %1").arg(request.source);
+		return result;
+	}
+	report(15);
+
+	const QString srcHash =
+		QString::fromLatin1(QCryptographicHash::hash(bytes, QCryptographicHash::Sha256).toHex().left(32));
+	const QString srcExt = fly_normalized_ext_from_mime(request.source);
+	const QSize box = request.box.isValid() ? request.box : QSize(kDefaultLogoBox, kDefaultLogoBox);
+	report(25);
+
+	QDir cacheDir(request.cacheDir);
+	const bool useCache = !request.cacheDir.isEmpty() && cacheDir.mkpath(QStringLiteral("."));
+	const QString cacheKey = QStringLiteral("%1-%2x%3").arg(srcHash).arg(box.width()).arg(box.height());
+
+	QByteArray out;
+	QString ext;
+	if (useCache) {
+		const QStringList hits = cacheDir.entryList(QStringList{cacheKey + QStringLiteral(".*")}, QDir::Files);
+		if (!hits.isEmpty()) {
+			out = fly_read_file(cacheDir.filePath(hits.first()), &ok);
+			if (ok && !out.isEmpty()) {
+				ext = QFileInfo(hits.first()).suffix();
+				result.cached = true;
+			} else {
+				out.clear();
+			}
 		}
 	}
 
-	const auto files = rootDir.entryList(QStringList{QString("%1*.*").arg(baseName)}, QDir::Files);
-	for (const auto &fn : files)
-		QFile::remove(rootDir.filePath(fn));
+	if (out.isEmpty()) {
+		QBuffer in;
+		in.setData(bytes);
+		in.open(QIODevice::ReadOnly);
+		QImageReader reader(&in);
+		reader.setAutoTransform(true);
+
+		const bool animated = reader.supportsAnimation() && reader.imageCount() > 1;
+		if (srcExt == QLatin1String("svg") || animated) {
+			// Vector and animated logos are cheap to render as-is and lose too much when rasterized.
+			out = bytes;
+			ext = srcExt;
+		} else {
+			QSize srcSize = reader.size();
+			const bool rotated = reader.transformation().testFlag(QImageIOHandler::TransformationRotate90);
+			if (rotated)
+				srcSize.transpose();
+			if (srcSize.isValid() && (srcSize.width() > box.width() || srcSize.height() > box.height())) {
+				QSize target = srcSize.scaled(box, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+				if (rotated)
+					target.transpose();
+				reader.setScaledSize(target);
+				reader.setQuality(100);
+			}
 
-	const QString ext = fly_normalized_ext_from_mime(srcAbs);
-	const QString sh = fly_short_hash_of_file(srcAbs);
+			QImage img = reader.read();
+			if (img.isNull()) {
+				result.error = reader.errorString();
+				return result;
+			}
+			report(60);
 
-	const QString rel = sh.isEmpty() ? QString("%1.%2").arg(baseName, ext)
-					 : QString("%1-%2.%3").arg(baseName, sh, ext);
+			if (img.width() > box.width() || img.height() > box.height())
+				img = img.scaled(box, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+			result.size = img.size();
 
-	const QString dst = rootDir.filePath(rel);
+			if (!fly_encode_logo(img, out, ext)) {
+				result.error = QStringLiteral("Cannot encode logo");
+				return result;
+			}
+		}
 
-	if (!QFile::copy(srcAbs, dst)) {
-		LOGW("Failed to copy logo to docRoot: %s -> %s", srcAbs.toUtf8().constData(), dst.toUtf8().constData());
-		return QString();
+		if (useCache && !fly_write_file_atomic(cacheDir.filePath(cacheKey + QLatin1Char('.') + ext), out))
+			LOGW("Failed to cache logo: %s", cacheKey.toUtf8().constData());
 	}
+	report(85);
 
-	LOGI("Logo copied to docRoot: %s (rel=%s)", dst.toUtf8().constData(), rel.toUtf8().constData());
+	const QString outHash =
+		QString::fromLatin1(QCryptographicHash::hash(out, QCryptographicHash::Sha256).toHex().left(16));
+	result.rel = QStringLiteral("logo-%1.%2").arg(outHash, ext);
 
-	return rel;
+	const QString dst = rootDir.filePath(result.rel);
+	if (!QFileInfo::exists(dst) && !fly_write_file_atomic(dst, out)) {
+		result.error = QStringLiteral("Cannot write %1").arg(dst);
+		return result;
+	}
+
+	if (request.keepOriginal) {
+		const QDir originals(useCache ? cacheDir.filePath(QStringLiteral("originals"))
+					      : rootDir.filePath(QStringLiteral("originals")));
+		originals.mkpath(QStringLiteral("."));
+		result.original = originals.filePath(QStringLiteral("%1.%2").arg(srcHash, srcExt));
+		if (!QFileInfo::exists(result.original) && !fly_write_file_atomic(result.original, bytes))
+			LOGW("Failed to keep original logo: %s", result.original.toUtf8().constData());
+	}
+	report(100);
+
+	result.ok = true;
+	LOGI("Logo ingested: %s -> %s (%s, %d bytes -> %d bytes)", request.source.toUtf8().constData(),
+	     result.rel.toUtf8().constData(), result.cached ? "cached" : "decoded", static_cast<int>(bytes.size()),
+	     static_cast<int>(out.size()));
+	return result;
+}
+
+int fly_logo_collect_garbage(const QString &templateRoot)
+{
+	QDir root(fly_doc_root(templateRoot));
+	const QStringList logos = root.entryList(QStringList{QStringLiteral("logo-*")}, QDir::Files);
+	if (logos.isEmpty())
+		return 0;
+
+	// Presets may also carry logos inside commands, so look at the raw files.
+	QStringList dirs{root.absolutePath()};
+	const QDir boards(root.filePath(QStringLiteral("boards")));
+	for (const QString &id : boards.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+		dirs << boards.filePath(id);
+
+	QByteArray referenced;
+	for (const QString &dir : std::as_const(dirs)) {
+		for (const char *name : {"plugin.json", "presets.json"}) {
+			QFile f(QDir(dir).filePath(QLatin1String(name)));
+			if (!f.exists())
+				continue;
+			if (!f.open(QIODevice::ReadOnly)) {
+				LOGW("Cannot read %s; keeping every logo", f.fileName().toUtf8().constData());
+				return 0;
+			}
+			referenced += f.readAll();
+		}
+	}
+
+	int removed = 0;
+	for (const QString &logo : logos) {
+		if (referenced.contains(logo.toUtf8()))
+			continue;
+		if (QFile::remove(root.filePath(logo)))
+			++removed;
+		else
+			LOGW("Failed removing unused logo: %s", root.filePath(logo).toUtf8().constData());
+	}
+	if (removed)
+		LOGI("Removed %d unused logo(s) from %s", removed, root.absolutePath().toUtf8().constData());
+	return removed;
 }
 
 bool fly_delete_logo_if_exists(const QString &dataDir, const QString &relPath)
@@ -0,0 +1,157 @@
+#include "fly_score_metrics.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][metrics]"
+#include "fly_score_log.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+int FlyHistogram::bucketFor(uint64_t us)
+{
+	if (us < static_cast<uint64_t>(kSub))
+		return static_cast<int>(us);
+
+	const int e = static_cast<int>(std::bit_width(us)) - 1;
+	if (e >= kMaxExp)
+		return kBuckets - 1;
+	const int sub = static_cast<int>((us >> (e - kSubBits)) & (kSub - 1));
+	return kSub + (e - kSubBits) * kSub + sub;
+}
+
+uint64_t FlyHistogram::bucketMid(int idx)
+{
+	if (idx < kSub)
+		return static_cast<uint64_t>(idx);
+
+	const int rel = idx - kSub;
+	const int shift = rel / kSub;
+	const uint64_t low = static_cast<uint64_t>(kSub + rel % kSub) << shift;
+	return low + ((uint64_t(1) << shift) >> 1);
+}
+
+void FlyHistogram::record(uint64_t us)
+{
+	buckets_[bucketFor(us)].fetch_add(1, std::memory_order_relaxed);
+	count_.fetch_add(1, std::memory_order_relaxed);
+	sum_.fetch_add(us, std::memory_order_relaxed);
+
+	uint64_t prev = max_.load(std::memory_order_relaxed);
+	while (us > prev && !max_.compare_exchange_weak(prev, us, std::memory_order_relaxed))
+		;
+}
+
+uint64_t FlyHistogram::percentile(double q) const
+{
+	uint64_t total = 0;
+	std::array<uint64_t, kBuckets> snap;
+	for (int i = 0; i < kBuckets; ++i) {
+		snap[i] = buckets_[i].load(std::memory_order_relaxed);
+		total += snap[i];
+	}
+	if (total == 0)
+		return 0;
+
+	const uint64_t target =
+		std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(std::clamp(q, 0.0, 1.0) * double(total))));
+	uint64_t seen = 0;
+	for (int i = 0; i < kBuckets; ++i) {
+		seen += snap[i];
+		if (seen >= target)
+			return std::min(bucketMid(i), max_.load(std::memory_order_relaxed));
+	}
+	return max_.load(std::memory_order_relaxed);
+}
+
+QJsonObject FlyHistogram::toJson() const
+{
+	const uint64_t n = count();
+	QJsonObject o;
+	o.insert(QStringLiteral("count"), static_cast<qint64>(n));
+	o.insert(QStringLiteral("mean_us"), n ? double(sum_.load(std::memory_order_relaxed)) / double(n) : 0.0);
+	o.insert(QStringLiteral("p50_us"), static_cast<qint64>(percentile(0.50)));
+	o.insert(QStringLiteral("p90_us"), static_cast<qint64>(percentile(0.90)));
+	o.insert(QStringLiteral("p99_us"), static_cast<qint64>(percentile(0.99)));
+	o.insert(QStringLiteral("max_us"), static_cast<qint64>(max_.load(std::memory_order_relaxed)));
+	return o;
+}
+
+FlyMetrics &fly_metrics()
+{
+	static FlyMetrics metrics;
+	return metrics;
+}
+
+QJsonObject fly_metrics_to_json()
+{
+	const FlyMetrics &m = fly_metrics();
+	auto n = [](const FlyCounter &c) { return static_cast<qint64>(c.value()); };
+
+	QJsonObject counters;
+	counters.insert(QStringLiteral("state_saves"), n(m.stateSaves));
+	counters.insert(QStringLiteral("state_save_failures"), n(m.stateSaveFailures));
+	counters.insert(QStringLiteral("broadcasts"), n(m.broadcasts));
+	counters.insert(QStringLiteral("broadcasts_unchanged"), n(m.broadcastsUnchanged));
+	counters.insert(QStringLiteral("clients_skipped"), n(m.clientsSkipped));
+	counters.insert(QStringLiteral("messages_sent"), n(m.messagesSent));
+	counters.insert(QStringLiteral("bytes_sent"), n(m.bytesSent));
+	counters.insert(QStringLiteral("bytes_received"), n(m.bytesReceived));
+	counters.insert(QStringLiteral("frames_received"), n(m.framesReceived));
+	counters.insert(QStringLiteral("commands"), n(m.commands));
+	counters.insert(QStringLiteral("commands_ignored"), n(m.commandsIgnored));
+	counters.insert(QStringLiteral("commands_rate_limited"), n(m.commandsRateLimited));
+	counters.insert(QStringLiteral("commands_coalesced"), n(m.commandsCoalesced));
+	counters.insert(QStringLiteral("parse_failures"), n(m.parseFailures));
+	counters.insert(QStringLiteral("template_scans"), n(m.templateScans));
+	counters.insert(QStringLiteral("derived_recomputes"), n(m.derivedRecomputes));
+	counters.insert(QStringLiteral("ingest_packets"), n(m.ingestPackets));
+	counters.insert(QStringLiteral("ingest_malformed"), n(m.ingestMalformed));
+	counters.insert(QStringLiteral("ingest_coalesced"), n(m.ingestCoalesced));
+
+	QJsonObject gauges;
+	gauges.insert(QStringLiteral("clients"), static_cast<qint64>(m.clients.value()));
+	gauges.insert(QStringLiteral("startup_load_us"), static_cast<qint64>(m.startupLoadUs.value()));
+	gauges.insert(QStringLiteral("startup_deferred_us"), static_cast<qint64>(m.startupDeferredUs.value()));
+
+	QJsonObject histograms;
+	histograms.insert(QStringLiteral("state_save"), m.stateSaveUs.toJson());
+	histograms.insert(QStringLiteral("broadcast"), m.broadcastUs.toJson());
+	histograms.insert(QStringLiteral("process_buffer"), m.processBufferUs.toJson());
+	histograms.insert(QStringLiteral("command"), m.commandUs.toJson());
+	histograms.insert(QStringLiteral("refresh_ui"), m.refreshUiUs.toJson());
+	histograms.insert(QStringLiteral("template_scan"), m.templateScanUs.toJson());
+	histograms.insert(QStringLiteral("broadcast_to_render"), m.broadcastToRenderUs.toJson());
+	histograms.insert(QStringLiteral("input_to_render"), m.inputToRenderUs.toJson());
+
+	QJsonObject o;
+	o.insert(QStringLiteral("counters"), counters);
+	o.insert(QStringLiteral("gauges"), gauges);
+	o.insert(QStringLiteral("histograms"), histograms);
+	return o;
+}
+
+void fly_metrics_log_summary()
+{
+	const FlyMetrics &m = fly_metrics();
+
+	static uint64_t lastActivity = 0;
+	const uint64_t activity = m.commands.value() + m.broadcasts.value() + m.stateSaves.value() +
+				  m.framesReceived.value() + m.templateScans.value() + m.ingestPackets.value();
+	if (activity == lastActivity)
+		return;
+	lastActivity = activity;
+
+	LOGI("commands=%llu (p99 %llu us), broadcasts=%llu (p99 %llu us), saves=%llu (p99 %llu us, %llu failed), "
+	     "sent=%llu msgs/%llu B, received=%llu frames/%llu B, parse_failures=%llu, rate_limited=%llu, "
+	     "clients=%lld, input->render p50 %llu us / p99 %llu us (%llu samples)",
+	     (unsigned long long)m.commands.value(), (unsigned long long)m.commandUs.percentile(0.99),
+	     (unsigned long long)m.broadcasts.value(), (unsigned long long)m.broadcastUs.percentile(0.99),
+	     (unsigned long long)m.stateSaves.value(), (unsigned long long)m.stateSaveUs.percentile(0.99),
+	     (unsigned long long)m.stateSaveFailures.value(), (unsigned long long)m.messagesSent.value(),
+	     (unsigned long long)m.bytesSent.value(), (unsigned long long)m.framesReceived.value(),
+	     (unsigned long long)m.bytesReceived.value(), (unsigned long long)m.parseFailures.value(),
+	     (unsigned long long)m.commandsRateLimited.value(), (long long)m.clients.value(),
+	     (unsigned long long)m.inputToRenderUs.percentile(0.50),
+	     (unsigned long long)m.inputToRenderUs.percentile(0.99), (unsigned long long)m.inputToRenderUs.count());
+}
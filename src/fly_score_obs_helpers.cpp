@@ -6,6 +6,7 @@
 
 #include "fly_score_qt_helpers.hpp"
 #include "fly_score_const.hpp"
+#include "fly_score_trace.hpp"
 
 #include <obs.h>
 
@@ -21,6 +22,7 @@ static void refreshSourceSettings(obs_source_t *s)
 	if (!s)
 		return;
 
+	FLY_TRACE_SCOPE_CAT("libobs", "refreshSourceSettings");
 	obs_data_t *data = obs_source_get_settings(s);
 	obs_source_update(s, data);
 	obs_data_release(data);
@@ -125,7 +127,10 @@ bool fly_ensure_browser_source_in_current_scene(const QString &urlOrLocalIndex,
     }
 
     if (br) {
-	    obs_source_update(br, settings);
+	    {
+		    FLY_TRACE_SCOPE_CAT("libobs", "obs_source_update");
+		    obs_source_update(br, settings);
+	    }
 		refreshSourceSettings(br);
 	    LOGI("Updated Browser Source '%s' -> %s", browserSourceName.toUtf8().constData(),
 		 isLocal ? localIndex.toUtf8().constData() : url.toUtf8().constData());
@@ -165,6 +170,7 @@ bool fly_ensure_browser_source_in_current_scene(const QString &urlOrLocalIndex,
 
 QStringList fly_list_browser_sources()
 {
+    FLY_TRACE_SCOPE_CAT("libobs", "obs_enum_sources");
     QStringList names;
 
     obs_enum_sources(
@@ -191,3 +197,41 @@ QStringList fly_list_browser_sources()
     names.sort(Qt::CaseInsensitive);
     return names;
 }
+
+QString fly_browser_source_local_file(const QString &browserSourceName)
+{
+	obs_source_t *src = obs_get_source_by_name(browserSourceName.toUtf8().constData());
+	if (!src)
+		return QString();
+
+	QString localFile;
+	const char *id = obs_source_get_id(src);
+	if (id && strcmp(id, kBrowserSourceId) == 0) {
+		obs_data_t *settings = obs_source_get_settings(src);
+		if (obs_data_get_bool(settings, "is_local_file"))
+			localFile = QString::fromUtf8(obs_data_get_string(settings, "local_file"));
+		obs_data_release(settings);
+	}
+
+	obs_source_release(src);
+	return localFile;
+}
+
+QString fly_browser_source_url(const QString &browserSourceName)
+{
+	obs_source_t *src = obs_get_source_by_name(browserSourceName.toUtf8().constData());
+	if (!src)
+		return QString();
+
+	QString url;
+	const char *id = obs_source_get_id(src);
+	if (id && strcmp(id, kBrowserSourceId) == 0) {
+		obs_data_t *settings = obs_source_get_settings(src);
+		if (!obs_data_get_bool(settings, "is_local_file"))
+			url = QString::fromUtf8(obs_data_get_string(settings, "url"));
+		obs_data_release(settings);
+	}
+
+	obs_source_release(src);
+	return url;
+}
@@ -0,0 +1,297 @@
+#include "fly_score_obs_hotkeys.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][hotkeys]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_trace.hpp"
+
+#include <obs.h>
+
+#include <QCoreApplication>
+#include <QHash>
+#include <QMetaObject>
+#include <QPointer>
+#include <QtGlobal>
+
+namespace {
+struct FlyObsHotkeyContext {
+	QPointer<QObject> receiver;
+	FlyObsHotkeyHandler handler;
+	FlyObsHotkeyRebound rebound;
+};
+
+// Owned here, keyed by hotkey id; only touched from the GUI thread.
+QHash<size_t, FlyObsHotkeyContext *> g_contexts;
+bool g_bindingsSignal = false;
+}
+
+static QByteArray fly_obs_key_name(int key, bool keypad)
+{
+	if (key >= Qt::Key_A && key <= Qt::Key_Z)
+		return "OBS_KEY_" + QByteArray(1, char('A' + (key - Qt::Key_A)));
+	if (key >= Qt::Key_0 && key <= Qt::Key_9)
+		return (keypad ? "OBS_KEY_NUM" : "OBS_KEY_") + QByteArray::number(key - Qt::Key_0);
+	if (key >= Qt::Key_F1 && key <= Qt::Key_F24)
+		return "OBS_KEY_F" + QByteArray::number(key - Qt::Key_F1 + 1);
+
+	switch (key) {
+	case Qt::Key_Space:
+		return "OBS_KEY_SPACE";
+	case Qt::Key_Return:
+		return "OBS_KEY_RETURN";
+	case Qt::Key_Enter:
+		return "OBS_KEY_ENTER";
+	case Qt::Key_Escape:
+		return "OBS_KEY_ESCAPE";
+	case Qt::Key_Tab:
+		return "OBS_KEY_TAB";
+	case Qt::Key_Backspace:
+		return "OBS_KEY_BACKSPACE";
+	case Qt::Key_Insert:
+		return "OBS_KEY_INSERT";
+	case Qt::Key_Delete:
+		return "OBS_KEY_DELETE";
+	case Qt::Key_Home:
+		return "OBS_KEY_HOME";
+	case Qt::Key_End:
+		return "OBS_KEY_END";
+	case Qt::Key_PageUp:
+		return "OBS_KEY_PAGEUP";
+	case Qt::Key_PageDown:
+		return "OBS_KEY_PAGEDOWN";
+	case Qt::Key_Left:
+		return "OBS_KEY_LEFT";
+	case Qt::Key_Right:
+		return "OBS_KEY_RIGHT";
+	case Qt::Key_Up:
+		return "OBS_KEY_UP";
+	case Qt::Key_Down:
+		return "OBS_KEY_DOWN";
+	case Qt::Key_Plus:
+		return keypad ? "OBS_KEY_NUMPLUS" : "OBS_KEY_PLUS";
+	case Qt::Key_Minus:
+		return keypad ? "OBS_KEY_NUMMINUS" : "OBS_KEY_MINUS";
+	case Qt::Key_Asterisk:
+		return keypad ? "OBS_KEY_NUMASTERISK" : "OBS_KEY_ASTERISK";
+	case Qt::Key_Slash:
+		return keypad ? "OBS_KEY_NUMSLASH" : "OBS_KEY_SLASH";
+	case Qt::Key_Period:
+		return keypad ? "OBS_KEY_NUMPERIOD" : "OBS_KEY_PERIOD";
+	case Qt::Key_Comma:
+		return "OBS_KEY_COMMA";
+	case Qt::Key_Equal:
+		return "OBS_KEY_EQUAL";
+	case Qt::Key_Semicolon:
+		return "OBS_KEY_SEMICOLON";
+	case Qt::Key_Apostrophe:
+		return "OBS_KEY_APOSTROPHE";
+	case Qt::Key_BracketLeft:
+		return "OBS_KEY_BRACKETLEFT";
+	case Qt::Key_BracketRight:
+		return "OBS_KEY_BRACKETRIGHT";
+	case Qt::Key_Backslash:
+		return "OBS_KEY_BACKSLASH";
+	case Qt::Key_QuoteLeft:
+		return "OBS_KEY_QUOTELEFT";
+	default:
+		return QByteArray();
+	}
+}
+
+static bool fly_obs_key_combination(const QKeySequence &seq, obs_key_combination_t &out)
+{
+	// OBS hotkeys are single chords; "Ctrl+K, Ctrl+S" stays on the QShortcut fallback.
+	if (seq.count() != 1)
+		return false;
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	const QKeyCombination chord = seq[0];
+	const Qt::KeyboardModifiers mods = chord.keyboardModifiers();
+	const int key = chord.key();
+#else
+	const int chord = seq[0];
+	const Qt::KeyboardModifiers mods = Qt::KeyboardModifiers(chord & Qt::KeyboardModifierMask);
+	const int key = chord & ~Qt::KeyboardModifierMask;
+#endif
+	const QByteArray name = fly_obs_key_name(key, mods.testFlag(Qt::KeypadModifier));
+	if (name.isEmpty())
+		return false;
+	out.key = obs_key_from_name(name.constData());
+	if (out.key == OBS_KEY_NONE)
+		return false;
+
+	out.modifiers = 0;
+	if (mods.testFlag(Qt::ShiftModifier))
+		out.modifiers |= INTERACT_SHIFT_KEY;
+	if (mods.testFlag(Qt::AltModifier))
+		out.modifiers |= INTERACT_ALT_KEY;
+#ifdef __APPLE__
+	// Qt maps Command to ControlModifier and Control to MetaModifier on macOS.
+	if (mods.testFlag(Qt::ControlModifier))
+		out.modifiers |= INTERACT_COMMAND_KEY;
+	if (mods.testFlag(Qt::MetaModifier))
+		out.modifiers |= INTERACT_CONTROL_KEY;
+#else
+	if (mods.testFlag(Qt::ControlModifier))
+		out.modifiers |= INTERACT_CONTROL_KEY;
+	if (mods.testFlag(Qt::MetaModifier))
+		out.modifiers |= INTERACT_COMMAND_KEY;
+#endif
+	return true;
+}
+
+// Inverse of fly_obs_key_name over the keys it knows; 0 when name is not one of them.
+static int fly_qt_key_from_obs_name(const QByteArray &name, bool &keypad)
+{
+	const auto scan = [&name, &keypad](int first, int last) {
+		for (int key = first; key <= last; ++key) {
+			for (const bool kp : {false, true}) {
+				if (fly_obs_key_name(key, kp) == name) {
+					keypad = kp;
+					return key;
+				}
+			}
+		}
+		return 0;
+	};
+	const int key = scan(Qt::Key_Space, Qt::Key_AsciiTilde);
+	return key ? key : scan(Qt::Key_Escape, Qt::Key_F24);
+}
+
+// First binding of id as OBS stores it; empty when it has none or a key the dock cannot show.
+static QKeySequence fly_obs_hotkey_sequence(obs_hotkey_id id)
+{
+	obs_data_array_t *bindings = obs_hotkey_save(id);
+	if (!bindings)
+		return QKeySequence();
+
+	QKeySequence seq;
+	if (obs_data_array_count(bindings) > 0) {
+		obs_data_t *binding = obs_data_array_item(bindings, 0);
+		bool keypad = false;
+		const int key = fly_qt_key_from_obs_name(obs_data_get_string(binding, "key"), keypad);
+		if (key) {
+			int mods = keypad ? Qt::KeypadModifier : 0;
+			if (obs_data_get_bool(binding, "shift"))
+				mods |= Qt::ShiftModifier;
+			if (obs_data_get_bool(binding, "alt"))
+				mods |= Qt::AltModifier;
+#ifdef __APPLE__
+			if (obs_data_get_bool(binding, "command"))
+				mods |= Qt::ControlModifier;
+			if (obs_data_get_bool(binding, "control"))
+				mods |= Qt::MetaModifier;
+#else
+			if (obs_data_get_bool(binding, "control"))
+				mods |= Qt::ControlModifier;
+			if (obs_data_get_bool(binding, "command"))
+				mods |= Qt::MetaModifier;
+#endif
+			seq = QKeySequence(key | mods);
+		}
+		obs_data_release(binding);
+	}
+	obs_data_array_release(bindings);
+	return seq;
+}
+
+// Any thread, possibly under the hotkey lock: read the binding back on the GUI thread.
+static void fly_obs_hotkey_bindings_changed(void *, calldata_t *data)
+{
+	auto *hotkey = static_cast<obs_hotkey_t *>(calldata_ptr(data, "key"));
+	if (!hotkey)
+		return;
+	const obs_hotkey_id id = obs_hotkey_get_id(hotkey);
+	QMetaObject::invokeMethod(
+		QCoreApplication::instance(),
+		[id]() {
+			const FlyObsHotkeyContext *ctx = g_contexts.value(id);
+			if (!ctx || !ctx->receiver || !ctx->rebound)
+				return;
+			// The callback may unregister id, which frees ctx.
+			const FlyObsHotkeyRebound rebound = ctx->rebound;
+			rebound(fly_obs_hotkey_sequence(id));
+		},
+		Qt::QueuedConnection);
+}
+
+static void fly_obs_hotkey_pressed(void *data, obs_hotkey_id, obs_hotkey_t *, bool pressed)
+{
+	if (!pressed)
+		return;
+
+	// Hotkey thread: stamp the press here, run the action on the receiver's thread.
+	const uint64_t pressedUs = fly_trace_now_us();
+	auto *ctx = static_cast<FlyObsHotkeyContext *>(data);
+	QObject *receiver = ctx->receiver.data();
+	if (!receiver)
+		return;
+	QMetaObject::invokeMethod(
+		receiver, [handler = ctx->handler, pressedUs]() { handler(pressedUs); }, Qt::QueuedConnection);
+}
+
+bool fly_obs_hotkey_supported(const QKeySequence &seq)
+{
+	obs_key_combination_t combo{};
+	return fly_obs_key_combination(seq, combo);
+}
+
+size_t fly_obs_hotkey_register(const QString &actionId, const QString &label, const QKeySequence &seq,
+			       QObject *receiver, FlyObsHotkeyHandler handler, FlyObsHotkeyRebound rebound)
+{
+	obs_key_combination_t combo{};
+	if (!fly_obs_key_combination(seq, combo))
+		return kFlyObsHotkeyInvalid;
+
+	if (!g_bindingsSignal) {
+		signal_handler_connect(obs_get_signal_handler(), "hotkey_bindings_changed",
+				       fly_obs_hotkey_bindings_changed, nullptr);
+		g_bindingsSignal = true;
+	}
+
+	auto *ctx = new FlyObsHotkeyContext{receiver, std::move(handler), std::move(rebound)};
+	const QByteArray name = "fly_scoreboard." + actionId.toUtf8();
+	const QByteArray desc = QStringLiteral("Fly Scoreboard: %1").arg(label).toUtf8();
+	const obs_hotkey_id id =
+		obs_hotkey_register_frontend(name.constData(), desc.constData(), fly_obs_hotkey_pressed, ctx);
+	if (id == OBS_INVALID_HOTKEY_ID) {
+		LOGW("Failed to register hotkey %s", name.constData());
+		delete ctx;
+		return kFlyObsHotkeyInvalid;
+	}
+
+	obs_hotkey_load_bindings(id, &combo, 1);
+	g_contexts.insert(id, ctx);
+	return id;
+}
+
+bool fly_obs_hotkey_rebind(size_t id, const QKeySequence &seq)
+{
+	obs_key_combination_t combo{};
+	if (id == kFlyObsHotkeyInvalid || !fly_obs_key_combination(seq, combo))
+		return false;
+	obs_hotkey_load_bindings(id, &combo, 1);
+	return true;
+}
+
+void fly_obs_hotkey_set_label(size_t id, const QString &label)
+{
+	if (id == kFlyObsHotkeyInvalid)
+		return;
+	obs_hotkey_set_description(id, QStringLiteral("Fly Scoreboard: %1").arg(label).toUtf8().constData());
+}
+
+void fly_obs_hotkey_unregister(size_t id)
+{
+	if (id == kFlyObsHotkeyInvalid)
+		return;
+	// Returns once no press for id is being dispatched, so the context can go.
+	obs_hotkey_unregister(id);
+	delete g_contexts.take(id);
+	if (g_contexts.isEmpty() && g_bindingsSignal) {
+		signal_handler_disconnect(obs_get_signal_handler(), "hotkey_bindings_changed",
+					  fly_obs_hotkey_bindings_changed, nullptr);
+		g_bindingsSignal = false;
+	}
+}
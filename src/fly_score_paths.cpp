@@ -4,18 +4,11 @@
 #define LOG_TAG "[" PLUGIN_NAME "][paths]"
 #include "fly_score_log.hpp"
 
+#include "fly_score_settings.hpp"
+
 #include <QDir>
 #include <QStandardPaths>
-#include <QSettings>
 
-static inline QString org_name()
-{
-	return QStringLiteral("MMLTech");
-}
-static inline QString app_name()
-{
-	return QStringLiteral("fly-scoreboard");
-}
 static inline QString key_data()
 {
 	return QStringLiteral("paths/data_root");
@@ -42,16 +35,21 @@ QString fly_default_data_root()
 
 QString fly_get_data_root_no_ui()
 {
-	QSettings s(org_name(), app_name());
-	QString p = s.value(key_data()).toString();
+	const QString p = fly_settings().string(key_data());
 	if (p.isEmpty())
 		return QString();
 
-	QDir d(p);
-	if (!d.exists())
-		d.mkpath(QStringLiteral("."));
-
-	return d.absolutePath();
+	// Only touch the disk when the root changes; this runs on every resource refresh.
+	static QString ensured;
+	static QString ensuredAbs;
+	if (p != ensured) {
+		QDir d(p);
+		if (!d.exists())
+			d.mkpath(QStringLiteral("."));
+		ensured = p;
+		ensuredAbs = d.absolutePath();
+	}
+	return ensuredAbs;
 }
 
 void fly_set_data_root(const QString &path)
@@ -66,9 +64,7 @@ void fly_set_data_root(const QString &path)
 
 	const QString abs = d.absolutePath();
 
-	QSettings s(org_name(), app_name());
-	s.setValue(key_data(), abs);
-	s.sync();
+	fly_settings().setValue(key_data(), abs);
 
 	LOGI("Global data root set to: %s", abs.toUtf8().constData());
 }
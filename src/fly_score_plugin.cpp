@@ -10,6 +10,7 @@
 #include <QDir>
 
 #include "fly_score_paths.hpp"
+#include "fly_score_settings.hpp"
 #include "fly_score_state.hpp"
 #include "fly_score_dock.hpp"
 #include "fly_score_const.hpp"
@@ -42,5 +43,6 @@ void obs_module_unload(void)
 	LOGI("Plugin unloading...");
 
 	fly_destroy_dock();
+	fly_settings().sync();
 	LOGI("Plugin unloaded");
 }
@@ -0,0 +1,172 @@
+#include "fly_score_presets.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][presets]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_boards.hpp"
+#include "fly_score_commands.hpp"
+#include "fly_score_trace.hpp"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+#include <utility>
+
+static QString fly_presets_path(const QString &stateDir)
+{
+	return QDir(stateDir).filePath(QStringLiteral("presets.json"));
+}
+
+bool fly_preset_from_json(const QJsonObject &json, FlyPreset &preset, QString *error)
+{
+	auto fail = [error](const QString &why) {
+		if (error)
+			*error = why;
+		return false;
+	};
+
+	FlyPreset p;
+	p.name = json.value(QStringLiteral("name")).toString().trimmed();
+	const QString rawId = json.value(QStringLiteral("id")).toString().trimmed();
+	if (rawId.isEmpty() && p.name.isEmpty())
+		return fail(QStringLiteral("missing id"));
+	p.id = fly_board_normalize_id(rawId.isEmpty() ? p.name : rawId);
+	if (p.name.isEmpty())
+		p.name = p.id;
+
+	const QJsonValue state = json.value(QStringLiteral("state"));
+	if (state.isObject()) {
+		if (!fly_state_from_json_object(state.toObject(), p.state))
+			return fail(QStringLiteral("invalid state"));
+		p.hasState = true;
+	}
+
+	const QJsonArray commands = json.value(QStringLiteral("commands")).toArray();
+	p.commands.reserve(commands.size());
+	for (int i = 0; i < commands.size(); ++i) {
+		const QJsonObject command = commands.at(i).toObject();
+		const QString action = fly_command_action(command);
+		if (!fly_command_is_state_action(action))
+			return fail(QStringLiteral("command %1: unsupported action '%2'").arg(i).arg(action));
+		p.commands.push_back({action, command});
+	}
+
+	if (!p.hasState && p.commands.isEmpty())
+		return fail(QStringLiteral("no state and no commands"));
+
+	preset = std::move(p);
+	return true;
+}
+
+QJsonObject fly_preset_to_json(const FlyPreset &preset)
+{
+	QJsonObject o;
+	o.insert(QStringLiteral("id"), preset.id);
+	o.insert(QStringLiteral("name"), preset.name);
+	if (preset.hasState)
+		o.insert(QStringLiteral("state"), fly_state_to_json_object(preset.state));
+	if (!preset.commands.isEmpty()) {
+		QJsonArray commands;
+		for (const FlyPresetCommand &c : preset.commands)
+			commands.append(c.command);
+		o.insert(QStringLiteral("commands"), commands);
+	}
+	return o;
+}
+
+QVector<FlyPreset> fly_presets_load(const QString &stateDir, QStringList *errors)
+{
+	FLY_TRACE_SCOPE_CAT("io", "fly_presets_load");
+	QVector<FlyPreset> presets;
+	QFile f(fly_presets_path(stateDir));
+	if (!f.exists() || !f.open(QIODevice::ReadOnly))
+		return presets;
+
+	const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+	const QJsonArray arr = doc.object().value(QStringLiteral("presets")).toArray();
+	for (const QJsonValue v : arr) {
+		const QJsonObject o = v.toObject();
+		FlyPreset preset;
+		QString error;
+		if (!fly_preset_from_json(o, preset, &error)) {
+			const QString id = o.value(QStringLiteral("id")).toString();
+			LOGW("Preset '%s' in %s skipped: %s", id.toUtf8().constData(), stateDir.toUtf8().constData(),
+			     error.toUtf8().constData());
+			if (errors)
+				*errors << id + QStringLiteral(": ") + error;
+			continue;
+		}
+		if (fly_preset_find(presets, preset.id)) {
+			if (errors)
+				*errors << preset.id + QStringLiteral(": duplicate id");
+			continue;
+		}
+		presets.push_back(std::move(preset));
+	}
+	return presets;
+}
+
+bool fly_presets_save(const QString &stateDir, const QVector<FlyPreset> &presets)
+{
+	FLY_TRACE_SCOPE_CAT("io", "fly_presets_save");
+	QJsonArray arr;
+	for (const FlyPreset &preset : presets)
+		arr.append(fly_preset_to_json(preset));
+
+	QJsonObject root;
+	root.insert(QStringLiteral("presets"), arr);
+
+	const QString path = fly_presets_path(stateDir);
+	QDir().mkpath(QFileInfo(path).absolutePath());
+	QSaveFile f(path);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		return false;
+	f.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
+	return f.commit();
+}
+
+FlyPreset fly_preset_capture(const QString &id, const QString &name, const FlyState &st, qint64 nowMs)
+{
+	FlyPreset preset;
+	preset.id = fly_board_normalize_id(id.isEmpty() ? name : id);
+	preset.name = name.isEmpty() ? preset.id : name;
+	preset.hasState = true;
+	preset.state = st;
+	for (FlyTimer &timer : preset.state.timers) {
+		if (timer.running)
+			fly_timer_toggle(timer, nowMs);
+	}
+	return preset;
+}
+
+const FlyPreset *fly_preset_find(const QVector<FlyPreset> &presets, const QString &key)
+{
+	const QString k = key.trimmed();
+	for (const FlyPreset &p : presets) {
+		if (p.id == k)
+			return &p;
+	}
+	for (const FlyPreset &p : presets) {
+		if (p.name.compare(k, Qt::CaseInsensitive) == 0)
+			return &p;
+	}
+	return nullptr;
+}
+
+int fly_preset_apply(const FlyPreset &preset, FlyState &st, qint64 nowMs)
+{
+	FLY_TRACE_SCOPE("fly_preset_apply");
+	FlyState next = preset.hasState ? preset.state : st;
+	int effects = preset.hasState ? (FlyCommandValues | FlyCommandStructure) : FlyCommandIgnored;
+	for (const FlyPresetCommand &c : preset.commands)
+		effects |= fly_apply_state_command(next, c.action, c.command, nowMs);
+
+	if (effects != FlyCommandIgnored)
+		st = std::move(next);
+	return effects;
+}
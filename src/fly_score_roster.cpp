@@ -0,0 +1,176 @@
+#include "fly_score_roster.hpp"
+
+#include <algorithm>
+#include <utility>
+
+static QJsonArray fly_roster_int_array(const QVector<int> &column)
+{
+	QJsonArray a;
+	for (int v : column)
+		a.append(v);
+	return a;
+}
+
+int FlyRoster::find(int t, int n) const
+{
+	for (int row = 0; row < rows(); ++row) {
+		if (team[row] == t && number[row] == n)
+			return row;
+	}
+	return -1;
+}
+
+int FlyRoster::statIndex(const QString &stat) const
+{
+	bool numeric = false;
+	const int idx = stat.toInt(&numeric);
+	if (numeric)
+		return (idx >= 0 && idx < stats.size()) ? idx : -1;
+
+	for (int i = 0; i < stats.size(); ++i) {
+		if (stats[i].compare(stat, Qt::CaseInsensitive) == 0)
+			return i;
+	}
+	return -1;
+}
+
+int FlyRoster::addPlayer(int t, int n, const QString &playerName)
+{
+	const int existing = find(t, n);
+	if (existing >= 0) {
+		name[existing] = playerName;
+		return existing;
+	}
+
+	int row = 0;
+	while (row < rows() && (team[row] < t || (team[row] == t && number[row] < n)))
+		++row;
+
+	team.insert(row, t);
+	number.insert(row, n);
+	name.insert(row, playerName);
+	for (QVector<int> &column : values)
+		column.insert(row, 0);
+	return row;
+}
+
+bool FlyRoster::removePlayer(int t, int n)
+{
+	const int row = find(t, n);
+	if (row < 0)
+		return false;
+
+	team.removeAt(row);
+	number.removeAt(row);
+	name.removeAt(row);
+	for (QVector<int> &column : values)
+		column.removeAt(row);
+	return true;
+}
+
+void FlyRoster::setStats(const QStringList &next)
+{
+	QVector<QVector<int>> columns;
+	columns.reserve(next.size());
+	for (const QString &stat : next) {
+		const int old = stats.indexOf(stat);
+		columns.push_back(old >= 0 ? values[old] : QVector<int>(rows(), 0));
+	}
+	stats = next;
+	values = std::move(columns);
+}
+
+void FlyRoster::resetValues()
+{
+	for (QVector<int> &column : values)
+		column.fill(0);
+}
+
+bool FlyRoster::sameShape(const FlyRoster &other) const
+{
+	return stats == other.stats && team == other.team && number == other.number && name == other.name;
+}
+
+QJsonObject fly_roster_to_json(const FlyRoster &roster)
+{
+	QJsonArray names;
+	for (const QString &n : roster.name)
+		names.append(n);
+
+	QJsonArray values;
+	for (const QVector<int> &column : roster.values)
+		values.append(fly_roster_int_array(column));
+
+	QJsonObject o;
+	o.insert(QStringLiteral("stats"), QJsonArray::fromStringList(roster.stats));
+	o.insert(QStringLiteral("team"), fly_roster_int_array(roster.team));
+	o.insert(QStringLiteral("number"), fly_roster_int_array(roster.number));
+	o.insert(QStringLiteral("name"), names);
+	o.insert(QStringLiteral("values"), values);
+	return o;
+}
+
+FlyRoster fly_roster_from_json(const QJsonObject &json)
+{
+	FlyRoster roster;
+	QStringList stats;
+	for (const QJsonValue v : json.value(QStringLiteral("stats")).toArray()) {
+		const QString stat = v.toString().trimmed();
+		if (!stat.isEmpty() && !stats.contains(stat))
+			stats << stat;
+	}
+	roster.setStats(stats);
+
+	const QJsonArray teams = json.value(QStringLiteral("team")).toArray();
+	const QJsonArray numbers = json.value(QStringLiteral("number")).toArray();
+	const QJsonArray names = json.value(QStringLiteral("name")).toArray();
+	const QJsonArray values = json.value(QStringLiteral("values")).toArray();
+
+	// Re-inserting keeps the rows sorted and unique even for hand-edited files.
+	for (int i = 0; i < numbers.size(); ++i) {
+		const int team = teams.at(i).toInt() ? 1 : 0;
+		const int row = roster.addPlayer(team, numbers.at(i).toInt(), names.at(i).toString());
+		for (int s = 0; s < roster.stats.size(); ++s)
+			roster.values[s][row] = values.at(s).toArray().at(i).toInt();
+	}
+	return roster;
+}
+
+QVector<int> fly_roster_top(const FlyRoster &roster, int stat, int n, int team)
+{
+	QVector<int> rows;
+	if (stat < 0 || stat >= roster.values.size() || n <= 0)
+		return rows;
+
+	rows.reserve(roster.rows());
+	for (int row = 0; row < roster.rows(); ++row) {
+		if (team < 0 || roster.team[row] == team)
+			rows.push_back(row);
+	}
+
+	// Rows are already in (team, number) order, so the index breaks ties.
+	const QVector<int> &column = roster.values[stat];
+	const auto mid = rows.begin() + std::min<qsizetype>(n, rows.size());
+	std::partial_sort(rows.begin(), mid, rows.end(),
+			  [&column](int a, int b) { return column[a] != column[b] ? column[a] > column[b] : a < b; });
+	rows.erase(mid, rows.end());
+	return rows;
+}
+
+bool fly_roster_diff_cells(const FlyRoster &before, const FlyRoster &after, QJsonArray &cells)
+{
+	if (!before.sameShape(after))
+		return false;
+
+	for (int s = 0; s < after.values.size(); ++s) {
+		const QVector<int> &a = before.values[s];
+		const QVector<int> &b = after.values[s];
+		if (a == b)
+			continue;
+		for (int row = 0; row < b.size(); ++row) {
+			if (a[row] != b[row])
+				cells.append(QJsonArray{row, s, b[row]});
+		}
+	}
+	return true;
+}
@@ -0,0 +1,166 @@
+#include "fly_score_settings.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][settings]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_trace.hpp"
+
+#include <QSettings>
+#include <QTimer>
+
+#include <utility>
+
+static inline QString org_name()
+{
+	return QStringLiteral("MMLTech");
+}
+static inline QString app_name()
+{
+	return QStringLiteral("fly-scoreboard");
+}
+
+FlySettings::FlySettings(QObject *parent) : QObject(parent), flushTimer_(new QTimer(this))
+{
+	FLY_TRACE_SCOPE_CAT("io", "FlySettings::load");
+	QSettings s(org_name(), app_name());
+	const QStringList keys = s.allKeys();
+	values_.reserve(keys.size());
+	for (const QString &key : keys)
+		values_.insert(key, s.value(key));
+
+	// One thread keeps the batches in order.
+	writer_.setMaxThreadCount(1);
+	flushTimer_->setSingleShot(true);
+	flushTimer_->setInterval(kFlushDelayMs);
+	connect(flushTimer_, &QTimer::timeout, this, &FlySettings::flush);
+}
+
+FlySettings::~FlySettings()
+{
+	sync();
+}
+
+QVariant FlySettings::value(const QString &key, const QVariant &def) const
+{
+	return values_.value(key, def);
+}
+
+QString FlySettings::string(const QString &key, const QString &def) const
+{
+	const auto it = values_.constFind(key);
+	return it == values_.constEnd() ? def : it->toString();
+}
+
+int FlySettings::integer(const QString &key, int def) const
+{
+	const auto it = values_.constFind(key);
+	if (it == values_.constEnd())
+		return def;
+	bool ok = false;
+	const int v = it->toInt(&ok);
+	return ok ? v : def;
+}
+
+QList<QVariantMap> FlySettings::array(const QString &key) const
+{
+	QList<QVariantMap> rows;
+	const int n = integer(key + QStringLiteral("/size"));
+	rows.reserve(qMax(0, n));
+	for (int i = 1; i <= n; ++i) {
+		const QString prefix = key + QLatin1Char('/') + QString::number(i) + QLatin1Char('/');
+		QVariantMap row;
+		for (auto it = values_.constBegin(); it != values_.constEnd(); ++it) {
+			if (it.key().startsWith(prefix))
+				row.insert(it.key().mid(prefix.size()), it.value());
+		}
+		rows.push_back(row);
+	}
+	return rows;
+}
+
+void FlySettings::setValue(const QString &key, const QVariant &value)
+{
+	const auto it = values_.constFind(key);
+	if (it != values_.constEnd() && *it == value)
+		return;
+	set(key, value);
+	flushTimer_->start();
+	emit changed(key);
+}
+
+void FlySettings::remove(const QString &key)
+{
+	if (!erase(key))
+		return;
+	flushTimer_->start();
+	emit changed(key);
+}
+
+void FlySettings::setArray(const QString &key, const QList<QVariantMap> &rows)
+{
+	erase(key);
+	set(key + QStringLiteral("/size"), int(rows.size()));
+	for (int i = 0; i < rows.size(); ++i) {
+		const QString prefix = key + QLatin1Char('/') + QString::number(i + 1) + QLatin1Char('/');
+		for (auto it = rows[i].constBegin(); it != rows[i].constEnd(); ++it)
+			set(prefix + it.key(), it.value());
+	}
+	flushTimer_->start();
+	emit changed(key);
+}
+
+void FlySettings::set(const QString &key, const QVariant &value)
+{
+	values_.insert(key, value);
+	pending_.insert(key, value);
+}
+
+bool FlySettings::erase(const QString &key)
+{
+	const QString prefix = key + QLatin1Char('/');
+	bool erased = false;
+	for (auto it = values_.begin(); it != values_.end();) {
+		if (it.key() == key || it.key().startsWith(prefix)) {
+			pending_.insert(it.key(), QVariant());
+			it = values_.erase(it);
+			erased = true;
+		} else {
+			++it;
+		}
+	}
+	return erased;
+}
+
+void FlySettings::flush()
+{
+	if (pending_.isEmpty())
+		return;
+
+	writer_.start([batch = std::exchange(pending_, {})]() {
+		FLY_TRACE_SCOPE_CAT("io", "FlySettings::flush");
+		QSettings s(org_name(), app_name());
+		for (auto it = batch.constBegin(); it != batch.constEnd(); ++it) {
+			if (it->isValid())
+				s.setValue(it.key(), it.value());
+			else
+				s.remove(it.key());
+		}
+		s.sync();
+		if (s.status() != QSettings::NoError)
+			LOGW("Writing %d settings failed", int(batch.size()));
+	});
+}
+
+void FlySettings::sync()
+{
+	flushTimer_->stop();
+	flush();
+	writer_.waitForDone();
+}
+
+FlySettings &fly_settings()
+{
+	static FlySettings settings;
+	return settings;
+}
@@ -0,0 +1,142 @@
+#include "fly_score_shm_publisher.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][shm]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_trace.hpp"
+
+#include <QByteArray>
+
+#include <algorithm>
+#include <cstring>
+
+// Truncates on a UTF-8 sequence boundary and always leaves a terminating NUL.
+template<size_t N> static void fly_shm_copy_text(char (&dst)[N], const QString &text)
+{
+	const QByteArray utf8 = text.toUtf8();
+	size_t n = std::min<size_t>(size_t(utf8.size()), N - 1);
+	if (n < size_t(utf8.size())) {
+		while (n > 0 && (uint8_t(utf8[qsizetype(n)]) & 0xC0) == 0x80)
+			--n;
+	}
+	std::memcpy(dst, utf8.constData(), n);
+	std::memset(dst + n, 0, N - n);
+}
+
+static void fly_shm_fill_team(const FlyTeam &team, FlyShmTeam &out)
+{
+	fly_shm_copy_text(out.title, team.title);
+	fly_shm_copy_text(out.subtitle, team.subtitle);
+	out.color = team.color;
+}
+
+void fly_shm_fill_state(const FlyState &st, const QString &board, FlyShmState &out)
+{
+	const uint64_t rev = out.rev;
+	std::memset(&out, 0, sizeof(out));
+	out.rev = rev;
+
+	fly_shm_copy_text(out.board, board);
+	out.swap_sides = st.swap_sides;
+	out.show_scoreboard = st.show_scoreboard;
+	fly_shm_fill_team(st.home, out.home);
+	fly_shm_fill_team(st.away, out.away);
+
+	out.field_count = uint32_t(std::min<qsizetype>(st.custom_fields.size(), kFlyShmMaxFields));
+	for (uint32_t i = 0; i < out.field_count; ++i) {
+		const FlyCustomField &f = st.custom_fields[i];
+		fly_shm_copy_text(out.fields[i].label, f.label);
+		out.fields[i].home = f.home;
+		out.fields[i].away = f.away;
+		out.fields[i].visible = f.visible;
+	}
+
+	out.single_count = uint32_t(std::min<qsizetype>(st.single_stats.size(), kFlyShmMaxSingles));
+	for (uint32_t i = 0; i < out.single_count; ++i) {
+		const FlySingleStat &s = st.single_stats[i];
+		fly_shm_copy_text(out.singles[i].label, s.label);
+		out.singles[i].value = s.value;
+		out.singles[i].visible = s.visible;
+	}
+
+	out.timer_count = uint32_t(std::min<qsizetype>(st.timers.size(), kFlyShmMaxTimers));
+	for (uint32_t i = 0; i < out.timer_count; ++i) {
+		const FlyTimer &t = st.timers[i];
+		FlyShmTimer &o = out.timers[i];
+		fly_shm_copy_text(o.label, t.label);
+		o.running = t.running;
+		o.countup = t.mode == QLatin1String("countup");
+		o.visible = t.visible;
+		o.initial_ms = t.initial_ms;
+		o.remaining_ms = t.remaining_ms;
+		o.last_tick_ms = t.last_tick_ms;
+	}
+}
+
+bool FlyShmPublisher::open(const QString &name)
+{
+	close();
+	if (name.isEmpty())
+		return false;
+
+	mem_.setKey(name);
+	if (!mem_.create(int(sizeof(FlyShmSegment)))) {
+		if (mem_.error() != QSharedMemory::AlreadyExists || !mem_.attach()) {
+			error_ = mem_.errorString();
+			LOGW("Shared memory '%s' unavailable: %s", name.toUtf8().constData(),
+			     error_.toUtf8().constData());
+			return false;
+		}
+		if (mem_.size() < int(sizeof(FlyShmSegment))) {
+			error_ = QStringLiteral("existing segment is too small");
+			LOGW("Shared memory '%s': %s", name.toUtf8().constData(), error_.toUtf8().constData());
+			mem_.detach();
+			return false;
+		}
+	}
+
+	// Readers ignore the segment while the magic is wrong, so it can be
+	// reset even if a previous run died half-way through a write.
+	auto *seg = static_cast<FlyShmSegment *>(mem_.data());
+	seg->magic = 0;
+	std::atomic_thread_fence(std::memory_order_release);
+	seg->version = kFlyShmVersion;
+	seg->size = uint32_t(sizeof(FlyShmSegment));
+	seg->seq.store(0, std::memory_order_relaxed);
+	std::memset(&seg->state, 0, sizeof(seg->state));
+	std::atomic_thread_fence(std::memory_order_release);
+	seg->magic = kFlyShmMagic;
+
+	segment_ = seg;
+	scratch_ = FlyShmState{};
+	last_ = FlyShmState{};
+	rev_ = 0;
+	error_.clear();
+	LOGI("Publishing state to shared memory '%s' (%zu bytes)", name.toUtf8().constData(), sizeof(FlyShmSegment));
+	return true;
+}
+
+void FlyShmPublisher::close()
+{
+	segment_ = nullptr;
+	if (mem_.isAttached())
+		mem_.detach();
+}
+
+bool FlyShmPublisher::publish(const FlyState &st, const QString &board)
+{
+	if (!segment_)
+		return false;
+
+	FLY_TRACE_SCOPE_CAT("shm", "publish");
+	scratch_.rev = rev_;
+	fly_shm_fill_state(st, board, scratch_);
+	if (rev_ > 0 && std::memcmp(&scratch_, &last_, sizeof(FlyShmState)) == 0)
+		return false;
+
+	scratch_.rev = ++rev_;
+	fly_shm_write_snapshot(segment_, scratch_);
+	last_ = scratch_;
+	return true;
+}
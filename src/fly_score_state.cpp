@@ -4,10 +4,14 @@
 #include "fly_score_log.hpp"
 
 #include "fly_score_i18n.hpp"
+#include "fly_score_metrics.hpp"
 #include "fly_score_state.hpp"
+#include "fly_score_trace.hpp"
 
+#ifndef FLY_SCORE_HEADLESS
 #include <obs-module.h>
 #include <util/platform.h>
+#endif
 
 #include <QDir>
 #include <QFile>
@@ -15,14 +19,20 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QStandardPaths>
 
 static QString moduleBaseDirFromConfigFile()
 {
+#ifdef FLY_SCORE_HEADLESS
+	const QString base = QStandardPaths::writableLocation(QStandardPaths::TempLocation);
+	return QDir(base.isEmpty() ? QDir::tempPath() : base).filePath(QStringLiteral(PLUGIN_NAME "-headless"));
+#else
 	char *p = obs_module_config_path("plugin.json");
 	QString filePath = p ? QString::fromUtf8(p) : QString();
 	if (p)
 		bfree(p);
 	return filePath.isEmpty() ? QDir::homePath() : QFileInfo(filePath).absolutePath();
+#endif
 }
 
 static QString overlay_dir_path(const QString &base_dir)
@@ -122,6 +132,7 @@ static FlyTimer timerFromJson(const QJsonObject &o)
 
 QJsonObject fly_state_to_json_object(const FlyState &stIn)
 {
+    FLY_TRACE_SCOPE("fly_state_to_json_object");
     FlyState st = stIn;
 
     ensureDefaultCustomFields(st);
@@ -176,11 +187,26 @@ QJsonObject fly_state_to_json_object(const FlyState &stIn)
     }
     j["timers"] = timersArr;
 
+    if (!st.derived.isEmpty()) {
+        QJsonArray dArr;
+        for (const auto &d : st.derived) {
+            QJsonObject o;
+            o["id"] = d.id;
+            o["expr"] = d.expr;
+            dArr.append(o);
+        }
+        j["derived"] = dArr;
+    }
+
+    if (!st.roster.isEmpty())
+        j["roster"] = fly_roster_to_json(st.roster);
+
     return j;
 }
 
 bool fly_state_from_json_object(const QJsonObject &j, FlyState &st)
 {
+	FLY_TRACE_SCOPE("fly_state_from_json_object");
 	auto readColor = [](const QJsonObject &o, const char *key, uint32_t def = 0xFFFFFF) -> uint32_t {
 		const QJsonValue v = o.value(key);
 
@@ -283,6 +309,18 @@ bool fly_state_from_json_object(const QJsonObject &j, FlyState &st)
 	if (st.timers.isEmpty())
 		st.timers.push_back(makeDefaultMainTimer());
 
+	st.derived.clear();
+	for (const QJsonValue v : j.value("derived").toArray()) {
+		const QJsonObject o = v.toObject();
+		FlyDerivedField d;
+		d.id = o.value("id").toString().trimmed();
+		d.expr = o.value("expr").toString();
+		if (!d.id.isEmpty())
+			st.derived.push_back(d);
+	}
+
+	st.roster = fly_roster_from_json(j.value("roster").toObject());
+
 	FlyTimer &main = st.timers[0];
 	if (main.mode.isEmpty())
 		main.mode = "countdown";
@@ -316,6 +354,7 @@ bool fly_state_write_json(const std::string &base_dir_s, const std::string &json
 
 static bool write_one_json(const QString &path, const QJsonDocument &doc)
 {
+	FLY_TRACE_SCOPE_CAT("io", "write_one_json");
 	QDir().mkpath(QFileInfo(path).absolutePath());
 	QFile f(path);
 	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
@@ -326,6 +365,7 @@ static bool write_one_json(const QString &path, const QJsonDocument &doc)
 
 bool fly_state_load(const QString &base_dir, FlyState &out)
 {
+	FLY_TRACE_SCOPE_CAT("io", "fly_state_load");
 	const QString path = overlay_plugin_json(base_dir);
 	QFile f(path);
 	if (!f.exists() || !f.open(QIODevice::ReadOnly))
@@ -340,9 +380,15 @@ bool fly_state_load(const QString &base_dir, FlyState &out)
 
 bool fly_state_save(const QString &base_dir, const FlyState &st)
 {
+	FlyMetricsTimer timer(fly_metrics().stateSaveUs);
+	fly_metrics().stateSaves.add();
+
 	const QJsonDocument doc(fly_state_to_json_object(st));
 	const QString path = overlay_plugin_json(base_dir);
-	return write_one_json(path, doc);
+	const bool ok = write_one_json(path, doc);
+	if (!ok)
+		fly_metrics().stateSaveFailures.add();
+	return ok;
 }
 
 QByteArray fly_state_to_json_bytes(const FlyState &st, bool compact)
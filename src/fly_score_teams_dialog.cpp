@@ -22,6 +22,12 @@
 #include <QMessageBox>
 #include <QStyle>
 #include <QColorDialog>
+#include <QCheckBox>
+#include <QCoreApplication>
+#include <QFutureWatcher>
+#include <QPointer>
+#include <QProgressBar>
+#include <QtConcurrent/QtConcurrentRun>
 
 static QColor colorFromU32(uint32_t c)
 {
@@ -39,9 +45,10 @@ static uint32_t u32FromColor(const QColor &qc)
     return (r << 16) | (g << 8) | b;
 }
 
-FlyTeamsDialog::FlyTeamsDialog(const QString &dataDir, FlyState &state, QWidget *parent)
+FlyTeamsDialog::FlyTeamsDialog(const QString &dataDir, const QString &stateDir, FlyState &state, QWidget *parent)
 	: QDialog(parent),
 	  dataDir_(dataDir),
+	  stateDir_(stateDir),
 	  state_(state)
 {
 	setObjectName(QStringLiteral("FlyTeamsDialog"));
@@ -152,16 +159,27 @@ FlyTeamsDialog::FlyTeamsDialog(const QString &dataDir, FlyState &state, QWidget
 	buttonsRow->setContentsMargins(0, 0, 0, 0);
 	buttonsRow->setSpacing(8);
 
+	keepOriginal_ = new QCheckBox(fly_i18n("Teams.KeepOriginalLogo"), this);
+	keepOriginal_->setToolTip(fly_i18n("Teams.KeepOriginalLogoTip"));
+
+	logoProgress_ = new QProgressBar(this);
+	logoProgress_->setRange(0, 100);
+	logoProgress_->setTextVisible(false);
+	logoProgress_->setMaximumWidth(120);
+	logoProgress_->setVisible(false);
+
+	buttonsRow->addWidget(keepOriginal_);
+	buttonsRow->addWidget(logoProgress_);
 	buttonsRow->addStretch(1);
 
 	applyBtn_ = new QPushButton(fly_i18n("Common.SaveAndClose"), this);
-	auto *closeBtn = new QPushButton(fly_i18n("Common.Close"), this);
+	closeBtn_ = new QPushButton(fly_i18n("Common.Close"), this);
 
 	applyBtn_->setCursor(Qt::PointingHandCursor);
-	closeBtn->setCursor(Qt::PointingHandCursor);
+	closeBtn_->setCursor(Qt::PointingHandCursor);
 
 	buttonsRow->addWidget(applyBtn_);
-	buttonsRow->addWidget(closeBtn);
+	buttonsRow->addWidget(closeBtn_);
 
 	root->addWidget(gbHome);
 	root->addWidget(gbAway);
@@ -177,7 +195,11 @@ FlyTeamsDialog::FlyTeamsDialog(const QString &dataDir, FlyState &state, QWidget
     connect(awayColor_, &QToolButton::clicked, this, &FlyTeamsDialog::onPickAwayColor);
 
 	connect(applyBtn_, &QPushButton::clicked, this, &FlyTeamsDialog::onApply);
-	connect(closeBtn, &QPushButton::clicked, this, &FlyTeamsDialog::close);
+	connect(closeBtn_, &QPushButton::clicked, this, &FlyTeamsDialog::close);
+
+	logoWatcher_ = new QFutureWatcher<FlyLogoIngestResult>(this);
+	connect(logoWatcher_, &QFutureWatcher<FlyLogoIngestResult>::finished, this,
+		&FlyTeamsDialog::onLogoIngestFinished);
 }
 
 FlyTeamsDialog::~FlyTeamsDialog() = default;
@@ -251,7 +273,7 @@ void FlyTeamsDialog::onPickHomeColor()
 
     state_.home.color = u32FromColor(chosen);
     updateColorButton(homeColor_, state_.home.color);
-    fly_state_save(dataDir_, state_);
+    fly_state_save(stateDir_, state_);
     LOGI("Home color updated: %u", state_.home.color);
 }
 
@@ -268,7 +290,7 @@ void FlyTeamsDialog::onPickAwayColor()
 
     state_.away.color = u32FromColor(chosen);
     updateColorButton(awayColor_, state_.away.color);
-    fly_state_save(dataDir_, state_);
+    fly_state_save(stateDir_, state_);
     LOGI("Guests color updated: %u", state_.away.color);
 }
 
@@ -279,20 +301,7 @@ void FlyTeamsDialog::onBrowseHomeLogo()
 	if (p.isEmpty())
 		return;
 
-	const QString rel = fly_copy_logo_to_overlay(dataDir_, p, QStringLiteral("home"));
-	if (rel.isEmpty()) {
-		QMessageBox::warning(this, fly_i18n("Teams.MessageTitle"),
-				     fly_i18n("Teams.CopyLogoFailed"));
-		return;
-	}
-
-	if (homeLogo_)
-		homeLogo_->setText(rel);
-	state_.home.logo = rel;
-
-	fly_state_save(dataDir_, state_);
-
-	LOGI("Home logo updated: %s", rel.toUtf8().constData());
+	startLogoIngest(p, true);
 }
 
 void FlyTeamsDialog::onBrowseAwayLogo()
@@ -302,26 +311,90 @@ void FlyTeamsDialog::onBrowseAwayLogo()
 	if (p.isEmpty())
 		return;
 
-	const QString rel = fly_copy_logo_to_overlay(dataDir_, p, QStringLiteral("guest"));
-	if (rel.isEmpty()) {
-		QMessageBox::warning(this, fly_i18n("Teams.MessageTitle"),
-				     fly_i18n("Teams.CopyLogoFailed"));
+	startLogoIngest(p, false);
+}
+
+void FlyTeamsDialog::startLogoIngest(const QString &source, bool home)
+{
+	if (logoWatcher_->isRunning())
+		return;
+
+	FlyLogoIngestRequest request;
+	request.source = source;
+	request.dataDir = dataDir_;
+	request.cacheDir = fly_logo_cache_dir();
+	request.box = fly_logo_box_for_template(dataDir_);
+	request.keepOriginal = keepOriginal_ && keepOriginal_->isChecked();
+
+	ingestHome_ = home;
+	setLogoBusy(true);
+
+	QPointer<QProgressBar> bar = logoProgress_;
+	const auto progress = [bar](int value) {
+		QMetaObject::invokeMethod(
+			QCoreApplication::instance(),
+			[bar, value]() {
+				if (bar)
+					bar->setValue(value);
+			},
+			Qt::QueuedConnection);
+	};
+
+	logoWatcher_->setFuture(QtConcurrent::run([request, progress]() { return fly_ingest_logo(request, progress); }));
+}
+
+void FlyTeamsDialog::onLogoIngestFinished()
+{
+	setLogoBusy(false);
+
+	const FlyLogoIngestResult result = logoWatcher_->result();
+	if (!result.ok) {
+		LOGW("Logo ingestion failed: %s", result.error.toUtf8().constData());
+		QMessageBox::warning(this, fly_i18n("Teams.MessageTitle"), fly_i18n("Teams.CopyLogoFailed"));
 		return;
 	}
 
-	if (awayLogo_)
-		awayLogo_->setText(rel);
-	state_.away.logo = rel;
+	QLineEdit *edit = ingestHome_ ? homeLogo_ : awayLogo_;
+	FlyTeam &team = ingestHome_ ? state_.home : state_.away;
+	if (edit)
+		edit->setText(result.rel);
+	team.logo = result.rel;
+
+	fly_state_save(stateDir_, state_);
+
+	// The previous logo-<hash> file stays: other boards, presets and undo steps
+	// may still use it. fly_logo_collect_garbage() removes it on the next start.
+	fly_clean_overlay_prefix(dataDir_, ingestHome_ ? QStringLiteral("home") : QStringLiteral("guest"));
+
+	LOGI("%s logo updated: %s", ingestHome_ ? "Home" : "Guests", result.rel.toUtf8().constData());
+}
 
-	fly_state_save(dataDir_, state_);
+void FlyTeamsDialog::setLogoBusy(bool busy)
+{
+	if (logoProgress_) {
+		logoProgress_->setValue(0);
+		logoProgress_->setVisible(busy);
+	}
+	for (QWidget *w : {static_cast<QWidget *>(homeBrowse_), static_cast<QWidget *>(awayBrowse_),
+			   static_cast<QWidget *>(applyBtn_), static_cast<QWidget *>(closeBtn_)}) {
+		if (w)
+			w->setEnabled(!busy);
+	}
+}
 
-	LOGI("Guests logo updated: %s", rel.toUtf8().constData());
+// Escape and the title bar close button land here too. The ingest result is
+// written to the state on finish, so the dialog stays open until it arrives.
+void FlyTeamsDialog::reject()
+{
+	if (logoWatcher_ && logoWatcher_->isRunning())
+		return;
+	QDialog::reject();
 }
 
 void FlyTeamsDialog::onApply()
 {
 	syncStateFromUi();
-	fly_state_save(dataDir_, state_);
+	fly_state_save(stateDir_, state_);
 	LOGI("Teams dialog: titles/subtitles/logos/colors saved.");
 	accept();
 }
@@ -0,0 +1,91 @@
+#include "fly_score_template_swap.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][template-swap]"
+#include "fly_score_log.hpp"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QRegularExpression>
+#include <QUrl>
+
+static QByteArray readTemplateFile(const QString &templatePath, const QString &name, bool *ok = nullptr)
+{
+	QFile f(QDir(templatePath).filePath(name));
+	const bool opened = f.open(QIODevice::ReadOnly);
+	if (ok)
+		*ok = opened;
+	return opened ? f.readAll() : QByteArray();
+}
+
+// Hot swaps drop the new page's <script> elements and keep the live runtime,
+// so two templates are swappable only when index.html loads the same scripts:
+// same inline bodies, same src URLs and, for local files, the same contents.
+QString fly_template_runtime_hash(const QString &templatePath)
+{
+	bool ok = false;
+	const QByteArray html = readTemplateFile(templatePath, QStringLiteral("index.html"), &ok);
+	if (!ok)
+		return QString();
+
+	static const QRegularExpression scriptRe(QStringLiteral("<script\\b([^>]*)>(.*?)</script\\s*>"),
+						 QRegularExpression::CaseInsensitiveOption |
+							 QRegularExpression::DotMatchesEverythingOption);
+	static const QRegularExpression srcRe(QStringLiteral("\\bsrc\\s*=\\s*(?:\"([^\"]*)\"|'([^']*)'|([^\\s>]+))"),
+					      QRegularExpression::CaseInsensitiveOption);
+
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+	auto it = scriptRe.globalMatch(QString::fromUtf8(html));
+	while (it.hasNext()) {
+		const QRegularExpressionMatch script = it.next();
+		const QRegularExpressionMatch src = srcRe.match(script.captured(1));
+		if (!src.hasMatch()) {
+			hash.addData(QByteArrayLiteral("inline:"));
+			hash.addData(script.captured(2).toUtf8());
+			continue;
+		}
+
+		const QString url = src.captured(1) + src.captured(2) + src.captured(3);
+		hash.addData(QByteArrayLiteral("src:"));
+		hash.addData(url.toUtf8());
+		const QUrl parsed(url);
+		if (parsed.isRelative() && !url.startsWith(QLatin1String("//")) && !QDir::isAbsolutePath(url)) {
+			bool found = false;
+			const QByteArray body = readTemplateFile(templatePath, parsed.path(), &found);
+			hash.addData(found ? body : QByteArrayLiteral("missing"));
+		}
+	}
+	return QString::fromLatin1(hash.result().toHex());
+}
+
+QJsonObject fly_template_swap_message(const QString &templatePath, const QString &templateName)
+{
+	bool ok = false;
+	const QByteArray html = readTemplateFile(templatePath, QStringLiteral("index.html"), &ok);
+	if (!ok || html.isEmpty()) {
+		LOGW("Cannot read index.html for template swap: %s", templatePath.toUtf8().constData());
+		return QJsonObject();
+	}
+
+	QJsonObject msg;
+	msg.insert(QStringLiteral("type"), QStringLiteral("template"));
+	msg.insert(QStringLiteral("name"), templateName);
+	msg.insert(QStringLiteral("path"), QDir(templatePath).absolutePath());
+	msg.insert(QStringLiteral("base_path"), QDir::fromNativeSeparators(QDir(templatePath).absolutePath()));
+	msg.insert(QStringLiteral("html"), QString::fromUtf8(html));
+	return msg;
+}
+
+QJsonObject fly_template_asset_message(const QString &templatePath, const QStringList &styles,
+				       const QStringList &images, quint64 revision)
+{
+	QJsonObject msg;
+	msg.insert(QStringLiteral("type"), QStringLiteral("asset_update"));
+	msg.insert(QStringLiteral("base_path"), QDir::fromNativeSeparators(QDir(templatePath).absolutePath()));
+	msg.insert(QStringLiteral("styles"), QJsonArray::fromStringList(styles));
+	msg.insert(QStringLiteral("images"), QJsonArray::fromStringList(images));
+	msg.insert(QStringLiteral("rev"), static_cast<qint64>(revision));
+	return msg;
+}
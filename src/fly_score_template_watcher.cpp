@@ -0,0 +1,168 @@
+#include "fly_score_template_watcher.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][template-watch]"
+#include "fly_score_log.hpp"
+
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSet>
+#include <QTimer>
+
+#include <utility>
+
+static constexpr int kTemplateDebounceMs = 150;
+static constexpr int kTemplateMaxDepth = 4;
+static constexpr int kTemplateMaxFiles = 2000;
+
+static bool fly_template_file_ignored(const QString &relPath)
+{
+	const QString name = QFileInfo(relPath).fileName().toLower();
+	if (relPath.indexOf(QLatin1Char('/')) < 0 &&
+	    (name == QLatin1String("plugin.json") || name == QLatin1String("hotkeys.json") ||
+	     name == QLatin1String("presets.json")))
+		return true;
+	if (relPath == QLatin1String("boards") || relPath.startsWith(QLatin1String("boards/")))
+		return true;
+
+	// Hidden folders, editor swap/backup files and QSaveFile temporaries.
+	return relPath.startsWith(QLatin1Char('.')) || relPath.contains(QLatin1String("/.")) ||
+	       name.endsWith(QLatin1Char('~')) || name.endsWith(QLatin1String(".swp")) ||
+	       name.endsWith(QLatin1String(".tmp")) || name.contains(QLatin1String(".new."));
+}
+
+static void fly_classify_template_file(const QString &relPath, FlyTemplateChange &change)
+{
+	const QString ext = QFileInfo(relPath).suffix().toLower();
+
+	if (ext == QLatin1String("css"))
+		change.styles << relPath;
+	else if (ext == QLatin1String("html") || ext == QLatin1String("htm"))
+		change.markup << relPath;
+	else if (ext == QLatin1String("js") || ext == QLatin1String("mjs"))
+		change.scripts << relPath;
+	else if (ext == QLatin1String("png") || ext == QLatin1String("jpg") || ext == QLatin1String("jpeg") ||
+		 ext == QLatin1String("gif") || ext == QLatin1String("webp") || ext == QLatin1String("svg") ||
+		 ext == QLatin1String("bmp") || ext == QLatin1String("ico"))
+		change.images << relPath;
+	else
+		change.other << relPath;
+}
+
+FlyTemplateWatcher::FlyTemplateWatcher(QObject *parent) : QObject(parent)
+{
+	watcher_ = new QFileSystemWatcher(this);
+	debounce_ = new QTimer(this);
+	debounce_->setSingleShot(true);
+	debounce_->setInterval(kTemplateDebounceMs);
+
+	connect(debounce_, &QTimer::timeout, this, &FlyTemplateWatcher::flush);
+	connect(watcher_, &QFileSystemWatcher::directoryChanged, debounce_, qOverload<>(&QTimer::start));
+	connect(watcher_, &QFileSystemWatcher::fileChanged, debounce_, qOverload<>(&QTimer::start));
+}
+
+void FlyTemplateWatcher::setPath(const QString &templatePath)
+{
+	const QString clean = templatePath.isEmpty() ? QString() : QDir(templatePath).absolutePath();
+	if (clean == path_)
+		return;
+
+	debounce_->stop();
+	const QStringList watched = watcher_->directories() + watcher_->files();
+	if (!watched.isEmpty())
+		watcher_->removePaths(watched);
+
+	path_ = clean;
+	files_.clear();
+	if (path_.isEmpty())
+		return;
+
+	QStringList dirs;
+	snapshot(files_, dirs);
+	updateWatches(files_, dirs);
+
+	LOGD("Watching template folder: %s (%d files)", path_.toUtf8().constData(), static_cast<int>(files_.size()));
+}
+
+void FlyTemplateWatcher::snapshot(QHash<QString, FileStamp> &files, QStringList &dirs) const
+{
+	const QDir root(path_);
+	if (!root.exists())
+		return;
+
+	dirs << path_;
+
+	QDirIterator it(path_, QDir::Files | QDir::Dirs | QDir::NoDotAndDotDot, QDirIterator::Subdirectories);
+	while (it.hasNext() && files.size() < kTemplateMaxFiles) {
+		it.next();
+		const QFileInfo fi = it.fileInfo();
+		const QString rel = root.relativeFilePath(fi.absoluteFilePath());
+		if (rel.count(QLatin1Char('/')) >= kTemplateMaxDepth || fly_template_file_ignored(rel))
+			continue;
+
+		if (fi.isDir()) {
+			dirs << fi.absoluteFilePath();
+			continue;
+		}
+
+		FileStamp stamp;
+		stamp.mtime = fi.lastModified().toMSecsSinceEpoch();
+		stamp.size = fi.size();
+		files.insert(rel, stamp);
+	}
+}
+
+void FlyTemplateWatcher::updateWatches(const QHash<QString, FileStamp> &files, const QStringList &dirs)
+{
+	QSet<QString> wanted(dirs.cbegin(), dirs.cend());
+	const QDir root(path_);
+	for (auto it = files.cbegin(); it != files.cend(); ++it)
+		wanted.insert(root.absoluteFilePath(it.key()));
+
+	QStringList toRemove;
+	for (const QString &p : watcher_->directories() + watcher_->files()) {
+		if (!wanted.remove(p))
+			toRemove << p;
+	}
+
+	if (!toRemove.isEmpty())
+		watcher_->removePaths(toRemove);
+	if (!wanted.isEmpty())
+		watcher_->addPaths(QStringList(wanted.cbegin(), wanted.cend()));
+}
+
+void FlyTemplateWatcher::flush()
+{
+	if (path_.isEmpty())
+		return;
+
+	QHash<QString, FileStamp> now;
+	QStringList dirs;
+	snapshot(now, dirs);
+
+	FlyTemplateChange change;
+	for (auto it = now.cbegin(); it != now.cend(); ++it) {
+		const auto prev = files_.constFind(it.key());
+		if (prev == files_.cend() || prev->mtime != it->mtime || prev->size != it->size)
+			fly_classify_template_file(it.key(), change);
+	}
+	for (auto it = files_.cbegin(); it != files_.cend(); ++it) {
+		if (!now.contains(it.key()))
+			fly_classify_template_file(it.key(), change);
+	}
+
+	files_ = std::move(now);
+	updateWatches(files_, dirs);
+
+	if (change.isEmpty())
+		return;
+
+	LOGI("Template files changed: css=%d, images=%d, html=%d, js=%d, other=%d",
+	     static_cast<int>(change.styles.size()), static_cast<int>(change.images.size()),
+	     static_cast<int>(change.markup.size()), static_cast<int>(change.scripts.size()),
+	     static_cast<int>(change.other.size()));
+	emit templateChanged(change);
+}
@@ -0,0 +1,485 @@
+#include "fly_score_theme_index.hpp"
+
+#include "config.hpp"
+#define LOG_TAG "[" PLUGIN_NAME "][themes]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_i18n.hpp"
+#include "fly_score_metrics.hpp"
+#include "fly_score_trace.hpp"
+
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QSet>
+#include <QTextStream>
+#include <QTimer>
+#include <QtConcurrent/QtConcurrentRun>
+
+#include <algorithm>
+#include <utility>
+
+static constexpr int kThemeIndexVersion = 2;
+static constexpr int kRescanDebounceMs = 300;
+
+static QString fly_theme_index_path(const QString &themePath)
+{
+	return QDir(themePath).filePath(QStringLiteral("index.html"));
+}
+
+static QString fly_theme_manifest_path(const QString &themePath)
+{
+	return QDir(themePath).filePath(QStringLiteral("manifest.ini"));
+}
+
+static qint64 fly_file_mtime(const QString &path)
+{
+	const QFileInfo fi(path);
+	return fi.exists() ? fi.lastModified().toMSecsSinceEpoch() : -1;
+}
+
+static QString fly_normalize_manifest_key(QString key, const QString &section)
+{
+	key = key.trimmed().toLower();
+	const QString sec = section.trimmed().toLower();
+	if (!sec.isEmpty() && sec != QLatin1String("general"))
+		key = sec + QStringLiteral("/") + key;
+	return key;
+}
+
+static QHash<QString, QString> fly_parse_manifest_text(const QString &manifestPath)
+{
+	QHash<QString, QString> values;
+
+	QFile file(manifestPath);
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		return values;
+
+	QTextStream stream(&file);
+	QString section;
+	while (!stream.atEnd()) {
+		QString line = stream.readLine().trimmed();
+		if (line.startsWith(QChar(0xFEFF)))
+			line.remove(0, 1);
+		if (line.isEmpty() || line.startsWith(QLatin1Char(';')) || line.startsWith(QLatin1Char('#')))
+			continue;
+		if (line.startsWith(QLatin1Char('[')) && line.endsWith(QLatin1Char(']'))) {
+			section = line.mid(1, line.size() - 2).trimmed();
+			continue;
+		}
+
+		int pos = line.indexOf(QLatin1Char('='));
+		if (pos < 0)
+			pos = line.indexOf(QLatin1Char(':'));
+		if (pos < 0)
+			continue;
+
+		QString value = line.mid(pos + 1).trimmed();
+		if ((value.startsWith(QLatin1Char('"')) && value.endsWith(QLatin1Char('"'))) ||
+		    (value.startsWith(QLatin1Char('\'')) && value.endsWith(QLatin1Char('\''))))
+			value = value.mid(1, value.size() - 2).trimmed();
+
+		const QString key = fly_normalize_manifest_key(line.left(pos), section);
+		if (!values.contains(key) || values.value(key).isEmpty())
+			values.insert(key, value);
+	}
+
+	return values;
+}
+
+static QString fly_manifest_value(const QHash<QString, QString> &values, const char *key)
+{
+	const QString plain = QString::fromLatin1(key);
+	const QString v = values.value(plain);
+	if (!v.isEmpty())
+		return v;
+	return values.value(QStringLiteral("theme/") + plain);
+}
+
+static bool fly_read_theme_manifest(const QString &themePath, FlyThemeManifest &out)
+{
+	const QString manifestPath = fly_theme_manifest_path(themePath);
+	if (!QFileInfo::exists(manifestPath))
+		return false;
+
+	const QHash<QString, QString> values = fly_parse_manifest_text(manifestPath);
+	out.title = fly_manifest_value(values, "title");
+	out.author = fly_manifest_value(values, "author");
+	out.authorUrl = fly_manifest_value(values, "author_url");
+	out.description = fly_manifest_value(values, "description");
+	out.version = fly_manifest_value(values, "version");
+	out.logoWidth = qMax(0, fly_manifest_value(values, "logo_width").toInt());
+	out.logoHeight = qMax(0, fly_manifest_value(values, "logo_height").toInt());
+
+	return !out.title.isEmpty() && !out.author.isEmpty() && !out.authorUrl.isEmpty() &&
+	       !out.description.isEmpty() && !out.version.isEmpty();
+}
+
+FlyThemeInfo fly_read_theme_info(const QString &themePath)
+{
+	FlyThemeInfo info;
+	const QFileInfo themeDirInfo(themePath);
+	info.path = QDir(themePath).absolutePath();
+	info.folderName = themeDirInfo.fileName();
+	info.indexMtime = fly_file_mtime(fly_theme_index_path(themePath));
+	info.manifestMtime = fly_file_mtime(fly_theme_manifest_path(themePath));
+	info.hasIndex = info.indexMtime >= 0;
+	info.hasManifest = info.manifestMtime >= 0;
+
+	info.manifestOk = info.hasManifest && fly_read_theme_manifest(themePath, info.manifest);
+	info.valid = info.hasIndex && info.manifestOk;
+
+	if (info.manifest.title.isEmpty())
+		info.manifest.title = info.folderName.isEmpty() ? info.path : info.folderName;
+
+	return info;
+}
+
+QString fly_theme_info_error(const FlyThemeInfo &info)
+{
+	if (!info.hasIndex)
+		return fly_i18n("Dock.TemplateMissingIndex");
+	if (!info.hasManifest)
+		return fly_i18n("Dock.TemplateMissingManifest");
+	if (!info.manifestOk)
+		return fly_i18n("Dock.TemplateInvalidManifest");
+	return QString();
+}
+
+QString fly_theme_tooltip(const FlyThemeManifest &manifest)
+{
+	return QStringLiteral("%1\n%2: %3\n%4\n%5")
+		.arg(manifest.description, fly_i18n("Theme.Author"), manifest.author, manifest.authorUrl,
+		     fly_i18n("Theme.Version").arg(manifest.version));
+}
+
+static QJsonObject themeInfoToJson(const FlyThemeInfo &info)
+{
+	QJsonObject o;
+	o["path"] = info.path;
+	o["folder"] = info.folderName;
+	o["has_index"] = info.hasIndex;
+	o["has_manifest"] = info.hasManifest;
+	o["manifest_ok"] = info.manifestOk;
+	o["index_mtime"] = QString::number(info.indexMtime);
+	o["manifest_mtime"] = QString::number(info.manifestMtime);
+	o["title"] = info.manifest.title;
+	o["author"] = info.manifest.author;
+	o["author_url"] = info.manifest.authorUrl;
+	o["description"] = info.manifest.description;
+	o["version"] = info.manifest.version;
+	o["logo_width"] = info.manifest.logoWidth;
+	o["logo_height"] = info.manifest.logoHeight;
+	return o;
+}
+
+static FlyThemeInfo themeInfoFromJson(const QJsonObject &o)
+{
+	FlyThemeInfo info;
+	info.path = o.value("path").toString();
+	info.folderName = o.value("folder").toString();
+	info.hasIndex = o.value("has_index").toBool(false);
+	info.hasManifest = o.value("has_manifest").toBool(false);
+	info.manifestOk = o.value("manifest_ok").toBool(false);
+	info.valid = info.hasIndex && info.manifestOk;
+	info.indexMtime = o.value("index_mtime").toString("-1").toLongLong();
+	info.manifestMtime = o.value("manifest_mtime").toString("-1").toLongLong();
+	info.manifest.title = o.value("title").toString();
+	info.manifest.author = o.value("author").toString();
+	info.manifest.authorUrl = o.value("author_url").toString();
+	info.manifest.description = o.value("description").toString();
+	info.manifest.version = o.value("version").toString();
+	info.manifest.logoWidth = o.value("logo_width").toInt(0);
+	info.manifest.logoHeight = o.value("logo_height").toInt(0);
+	return info;
+}
+
+static QString parentPathOf(const QString &path)
+{
+	return QFileInfo(path).absolutePath();
+}
+
+FlyThemeIndex::FlyThemeIndex(const QString &cacheFile, QObject *parent) : QObject(parent), cacheFile_(cacheFile)
+{
+	watcher_ = new QFileSystemWatcher(this);
+	rescanTimer_ = new QTimer(this);
+	rescanTimer_->setSingleShot(true);
+	rescanTimer_->setInterval(kRescanDebounceMs);
+
+	connect(rescanTimer_, &QTimer::timeout, this, &FlyThemeIndex::rescan);
+	connect(watcher_, &QFileSystemWatcher::directoryChanged, rescanTimer_, qOverload<>(&QTimer::start));
+	connect(watcher_, &QFileSystemWatcher::fileChanged, rescanTimer_, qOverload<>(&QTimer::start));
+
+	loadCache();
+}
+
+FlyThemeIndex::~FlyThemeIndex()
+{
+	// The scan runs plugin code on the global pool; it must not outlive the module.
+	scanFuture_.waitForFinished();
+}
+
+void FlyThemeIndex::loadCache()
+{
+	if (cacheFile_.isEmpty())
+		return;
+
+	QFile f(cacheFile_);
+	if (!f.exists() || !f.open(QIODevice::ReadOnly))
+		return;
+
+	const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+	if (!doc.isObject() || doc.object().value("version").toInt() != kThemeIndexVersion)
+		return;
+
+	const QJsonArray arr = doc.object().value("themes").toArray();
+	cache_.reserve(arr.size());
+	for (const QJsonValue v : arr) {
+		if (!v.isObject())
+			continue;
+		FlyThemeInfo info = themeInfoFromJson(v.toObject());
+		if (!info.path.isEmpty())
+			cache_.insert(info.path, info);
+	}
+
+	LOGI("Loaded theme index cache with %d entries", static_cast<int>(cache_.size()));
+}
+
+void FlyThemeIndex::setRoots(const QStringList &roots)
+{
+	QStringList normalized;
+	for (const QString &r : roots) {
+		if (r.trimmed().isEmpty())
+			continue;
+		const QString abs = QDir(r).absolutePath();
+		if (!normalized.contains(abs))
+			normalized.push_back(abs);
+	}
+
+	if (normalized == roots_)
+		return;
+
+	roots_ = normalized;
+	if (scanning_)
+		++generation_;
+	rescan();
+}
+
+QStringList FlyThemeIndex::roots() const
+{
+	return roots_;
+}
+
+QVector<FlyThemeInfo> FlyThemeIndex::themes() const
+{
+	QVector<FlyThemeInfo> out;
+	QSet<QString> listed;
+
+	for (const QString &root : roots_) {
+		auto it = cache_.constFind(root);
+		if (it != cache_.constEnd() && !listed.contains(root)) {
+			out.push_back(*it);
+			listed.insert(root);
+		}
+
+		QVector<FlyThemeInfo> children;
+		for (auto c = cache_.constBegin(); c != cache_.constEnd(); ++c) {
+			if (c.key() != root && !listed.contains(c.key()) && parentPathOf(c.key()) == root)
+				children.push_back(c.value());
+		}
+
+		std::sort(children.begin(), children.end(), [](const FlyThemeInfo &a, const FlyThemeInfo &b) {
+			return a.folderName.compare(b.folderName, Qt::CaseInsensitive) < 0;
+		});
+
+		for (const auto &c : children) {
+			out.push_back(c);
+			listed.insert(c.path);
+		}
+	}
+
+	return out;
+}
+
+FlyThemeInfo FlyThemeIndex::info(const QString &themePath) const
+{
+	const QString abs = QDir(themePath).absolutePath();
+	auto it = cache_.constFind(abs);
+	if (it != cache_.constEnd())
+		return *it;
+	return fly_read_theme_info(abs);
+}
+
+bool FlyThemeIndex::isScanning() const
+{
+	return scanning_;
+}
+
+void FlyThemeIndex::rescan()
+{
+	if (scanning_) {
+		rescanPending_ = true;
+		return;
+	}
+
+	scanning_ = true;
+	rescanPending_ = false;
+
+	auto *watcher = new QFutureWatcher<ScanResult>(this);
+	connect(watcher, &QFutureWatcher<ScanResult>::finished, this, [this, watcher]() {
+		onScanFinished(watcher->result());
+		watcher->deleteLater();
+	});
+	scanFuture_ = QtConcurrent::run(&FlyThemeIndex::scan, ++generation_, roots_, cache_, cacheFile_);
+	watcher->setFuture(scanFuture_);
+}
+
+FlyThemeIndex::ScanResult FlyThemeIndex::scan(quint64 generation, const QStringList &roots,
+					      QHash<QString, FlyThemeInfo> cache, const QString &cacheFile)
+{
+	QElapsedTimer timer;
+	timer.start();
+	FLY_TRACE_SCOPE_CAT("io", "FlyThemeIndex::scan");
+	FlyMetricsTimer metricsTimer(fly_metrics().templateScanUs);
+	fly_metrics().templateScans.add();
+
+	ScanResult r;
+	r.generation = generation;
+
+	QSet<QString> rootSet;
+	QSet<QString> seen;
+	int parsed = 0;
+
+	for (const QString &root : roots) {
+		const QDir dir(root);
+		if (!dir.exists())
+			continue;
+
+		rootSet.insert(root);
+		r.watchDirs.push_back(root);
+
+		QStringList candidates{root};
+		const auto entries = dir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot, QDir::Name);
+		for (const QFileInfo &entry : entries)
+			candidates.push_back(QDir(entry.absoluteFilePath()).absolutePath());
+
+		for (const QString &path : candidates) {
+			if (seen.contains(path))
+				continue;
+			seen.insert(path);
+
+			const qint64 indexMtime = fly_file_mtime(fly_theme_index_path(path));
+			const qint64 manifestMtime = fly_file_mtime(fly_theme_manifest_path(path));
+
+			auto it = cache.constFind(path);
+			if (it != cache.constEnd() && it->indexMtime == indexMtime && it->manifestMtime == manifestMtime)
+				continue;
+
+			if (indexMtime < 0 && manifestMtime < 0) {
+				if (cache.remove(path) > 0)
+					r.changed = true;
+				continue;
+			}
+
+			cache.insert(path, fly_read_theme_info(path));
+			r.changed = true;
+			++parsed;
+		}
+	}
+
+	for (auto it = cache.begin(); it != cache.end();) {
+		const bool underRoot = rootSet.contains(it.key()) || rootSet.contains(parentPathOf(it.key()));
+		if (underRoot && !seen.contains(it.key())) {
+			it = cache.erase(it);
+			r.changed = true;
+			continue;
+		}
+		if (underRoot) {
+			if (!rootSet.contains(it.key()))
+				r.watchDirs.push_back(it.key());
+			if (it->hasManifest)
+				r.watchFiles.push_back(fly_theme_manifest_path(it.key()));
+		}
+		++it;
+	}
+
+	if (r.changed && !cacheFile.isEmpty()) {
+		QJsonArray arr;
+		for (const auto &info : cache)
+			arr.append(themeInfoToJson(info));
+
+		QJsonObject root;
+		root["version"] = kThemeIndexVersion;
+		root["themes"] = arr;
+
+		QDir().mkpath(QFileInfo(cacheFile).absolutePath());
+		QSaveFile f(cacheFile);
+		if (f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+			if (!f.commit())
+				LOGW("Failed to write theme index cache: %s", cacheFile.toUtf8().constData());
+		}
+	}
+
+	r.cache = std::move(cache);
+
+	LOGI("Theme index scanned %d folders in %d roots (%d parsed) in %lld ms", static_cast<int>(seen.size()),
+	     static_cast<int>(rootSet.size()), parsed, static_cast<long long>(timer.elapsed()));
+	return r;
+}
+
+void FlyThemeIndex::onScanFinished(const ScanResult &result)
+{
+	scanning_ = false;
+
+	// The roots changed while this scan ran; its result describes the old set.
+	if (result.generation != generation_) {
+		rescan();
+		return;
+	}
+
+	cache_ = result.cache;
+	updateWatches(result.watchDirs, result.watchFiles);
+
+	if (result.changed)
+		emit themesChanged();
+	emit scanFinished();
+
+	if (rescanPending_)
+		rescan();
+}
+
+void FlyThemeIndex::updateWatches(const QStringList &dirs, const QStringList &files)
+{
+	QSet<QString> wanted;
+	for (const QString &p : dirs + files)
+		wanted.insert(p);
+
+	QSet<QString> current;
+	for (const QString &p : watcher_->directories() + watcher_->files())
+		current.insert(p);
+
+	QStringList toRemove;
+	for (const QString &p : current) {
+		if (!wanted.contains(p))
+			toRemove.push_back(p);
+	}
+	if (!toRemove.isEmpty())
+		watcher_->removePaths(toRemove);
+
+	QStringList toAdd;
+	for (const QString &p : wanted) {
+		if (!current.contains(p))
+			toAdd.push_back(p);
+	}
+	if (!toAdd.isEmpty())
+		watcher_->addPaths(toAdd);
+}
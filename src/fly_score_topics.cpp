@@ -0,0 +1,104 @@
+#include "fly_score_topics.hpp"
+
+#include <QJsonArray>
+
+static QString fly_pointer_unescape(QString token)
+{
+	token.replace(QLatin1String("~1"), QLatin1String("/"));
+	token.replace(QLatin1String("~0"), QLatin1String("~"));
+	return token;
+}
+
+static QString fly_pointer_head(const QString &pointer)
+{
+	const int next = pointer.indexOf(QLatin1Char('/'), 1);
+	return fly_pointer_unescape(pointer.mid(1, next < 0 ? -1 : next - 1));
+}
+
+QStringList fly_topic_pointers(const QString &topic)
+{
+	const QString t = topic.trimmed();
+	if (t.startsWith(QLatin1Char('/')))
+		return {t};
+
+	const QString name = t.toLower();
+	if (name == QLatin1String("teams"))
+		return {QStringLiteral("/home"), QStringLiteral("/away"), QStringLiteral("/swap_sides")};
+	if (name == QLatin1String("fields"))
+		return {QStringLiteral("/custom_fields")};
+	if (name == QLatin1String("singles"))
+		return {QStringLiteral("/single_stats")};
+	if (name == QLatin1String("timers"))
+		return {QStringLiteral("/timers")};
+	if (name == QLatin1String("visibility"))
+		return {QStringLiteral("/show_scoreboard")};
+	if (name == QLatin1String("derived"))
+		return {QStringLiteral("/derived_values")};
+	if (name == QLatin1String("roster"))
+		return {QStringLiteral("/roster")};
+	if (name == QLatin1String("all") || name == QLatin1String("*"))
+		return {QString()};
+	return {};
+}
+
+QStringList fly_topic_pointers(const QStringList &topics)
+{
+	QStringList out;
+	for (const QString &topic : topics) {
+		for (const QString &p : fly_topic_pointers(topic)) {
+			if (!out.contains(p))
+				out << p;
+		}
+	}
+	return out;
+}
+
+QJsonValue fly_json_pointer_value(const QJsonObject &root, const QString &pointer)
+{
+	if (pointer.isEmpty())
+		return root;
+	if (!pointer.startsWith(QLatin1Char('/')))
+		return QJsonValue(QJsonValue::Undefined);
+
+	QJsonValue cur = root;
+	for (const QString &raw : pointer.mid(1).split(QLatin1Char('/'))) {
+		const QString token = fly_pointer_unescape(raw);
+		if (cur.isObject()) {
+			const QJsonObject o = cur.toObject();
+			const auto it = o.constFind(token);
+			if (it == o.constEnd())
+				return QJsonValue(QJsonValue::Undefined);
+			cur = it.value();
+		} else if (cur.isArray()) {
+			bool ok = false;
+			const int idx = token.toInt(&ok);
+			const QJsonArray a = cur.toArray();
+			if (!ok || idx < 0 || idx >= a.size())
+				return QJsonValue(QJsonValue::Undefined);
+			cur = a.at(idx);
+		} else {
+			return QJsonValue(QJsonValue::Undefined);
+		}
+	}
+	return cur;
+}
+
+bool fly_json_pointer_changed(const QJsonObject &before, const QJsonObject &after, const QString &pointer)
+{
+	return fly_json_pointer_value(before, pointer) != fly_json_pointer_value(after, pointer);
+}
+
+QJsonObject fly_state_slice(const QJsonObject &state, const QStringList &pointers)
+{
+	QJsonObject out;
+	for (const QString &p : pointers) {
+		if (p.isEmpty())
+			return state;
+
+		const QString key = fly_pointer_head(p);
+		const auto it = state.constFind(key);
+		if (it != state.constEnd())
+			out.insert(key, it.value());
+	}
+	return out;
+}
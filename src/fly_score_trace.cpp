@@ -0,0 +1,174 @@
+#include "fly_score_trace.hpp"
+
+#define LOG_TAG "[" PLUGIN_NAME "][trace]"
+#include "fly_score_log.hpp"
+
+#include "fly_score_state.hpp"
+
+#ifndef FLY_SCORE_HEADLESS
+#include <util/platform.h>
+#endif
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+static constexpr size_t kTraceCapacity = 1 << 16;
+
+std::atomic<bool> g_fly_trace_enabled{false};
+
+namespace {
+
+struct FlyTraceEvent {
+	const char *category = nullptr;
+	const char *name = nullptr;
+	uint64_t startUs = 0;
+	uint64_t durUs = 0;
+	uint32_t tid = 0;
+};
+
+struct FlyTraceRing {
+	std::mutex lock;
+	std::vector<FlyTraceEvent> events;
+	size_t next = 0;
+	bool wrapped = false;
+};
+
+FlyTraceRing &fly_trace_ring()
+{
+	static FlyTraceRing ring;
+	return ring;
+}
+
+uint32_t fly_trace_tid()
+{
+	static std::atomic<uint32_t> nextTid{1};
+	thread_local const uint32_t tid = nextTid.fetch_add(1, std::memory_order_relaxed);
+	return tid;
+}
+
+} // namespace
+
+uint64_t fly_trace_now_us()
+{
+#ifdef FLY_SCORE_HEADLESS
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+					     std::chrono::steady_clock::now().time_since_epoch())
+					     .count());
+#else
+	return os_gettime_ns() / 1000;
+#endif
+}
+
+void FlyTraceScope::finish()
+{
+	FlyTraceEvent ev;
+	ev.category = category_;
+	ev.name = name_;
+	ev.startUs = startUs_;
+	ev.durUs = fly_trace_now_us() - startUs_;
+	ev.tid = fly_trace_tid();
+
+	FlyTraceRing &ring = fly_trace_ring();
+	std::lock_guard<std::mutex> guard(ring.lock);
+	if (ring.events.size() < kTraceCapacity) {
+		ring.events.push_back(ev);
+		return;
+	}
+	ring.events[ring.next] = ev;
+	ring.next = (ring.next + 1) % kTraceCapacity;
+	ring.wrapped = true;
+}
+
+void fly_trace_set_enabled(bool enabled)
+{
+	if (g_fly_trace_enabled.exchange(enabled) != enabled)
+		LOGI("Tracing %s", enabled ? "enabled" : "disabled");
+}
+
+int fly_trace_event_count()
+{
+	FlyTraceRing &ring = fly_trace_ring();
+	std::lock_guard<std::mutex> guard(ring.lock);
+	return static_cast<int>(ring.events.size());
+}
+
+void fly_trace_clear()
+{
+	FlyTraceRing &ring = fly_trace_ring();
+	std::lock_guard<std::mutex> guard(ring.lock);
+	ring.events.clear();
+	ring.next = 0;
+	ring.wrapped = false;
+}
+
+QString fly_trace_dump(const QString &path)
+{
+	std::vector<FlyTraceEvent> events;
+	bool wrapped = false;
+	{
+		FlyTraceRing &ring = fly_trace_ring();
+		std::lock_guard<std::mutex> guard(ring.lock);
+		events.reserve(ring.events.size());
+		events.insert(events.end(), ring.events.begin() + static_cast<std::ptrdiff_t>(ring.next),
+			      ring.events.end());
+		events.insert(events.end(), ring.events.begin(),
+			      ring.events.begin() + static_cast<std::ptrdiff_t>(ring.next));
+		wrapped = ring.wrapped;
+	}
+
+	const qint64 pid = QCoreApplication::applicationPid();
+	QJsonArray arr;
+	for (const FlyTraceEvent &ev : events) {
+		QJsonObject o;
+		o.insert(QStringLiteral("name"), QString::fromUtf8(ev.name));
+		o.insert(QStringLiteral("cat"), QString::fromUtf8(ev.category));
+		o.insert(QStringLiteral("ph"), QStringLiteral("X"));
+		o.insert(QStringLiteral("ts"), static_cast<qint64>(ev.startUs));
+		o.insert(QStringLiteral("dur"), static_cast<qint64>(ev.durUs));
+		o.insert(QStringLiteral("pid"), pid);
+		o.insert(QStringLiteral("tid"), static_cast<qint64>(ev.tid));
+		arr.append(o);
+	}
+
+	QJsonObject meta;
+	meta.insert(QStringLiteral("plugin"), QStringLiteral(PLUGIN_NAME));
+	meta.insert(QStringLiteral("version"), QStringLiteral(PLUGIN_VERSION));
+#ifdef FLY_SCORE_HEADLESS
+	meta.insert(QStringLiteral("clock"), QStringLiteral("steady_clock"));
+#else
+	meta.insert(QStringLiteral("clock"), QStringLiteral("os_gettime_ns"));
+#endif
+	meta.insert(QStringLiteral("wrapped"), wrapped);
+
+	QJsonObject root;
+	root.insert(QStringLiteral("traceEvents"), arr);
+	root.insert(QStringLiteral("displayTimeUnit"), QStringLiteral("ms"));
+	root.insert(QStringLiteral("metadata"), meta);
+
+	QString out = path;
+	if (out.isEmpty()) {
+		const QDir dir(QDir(fly_data_dir()).filePath(QStringLiteral("traces")));
+		dir.mkpath(QStringLiteral("."));
+		out = dir.filePath(QStringLiteral("fly-trace-%1.json")
+					   .arg(QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss"))));
+	}
+
+	QSaveFile f(out);
+	if (!f.open(QIODevice::WriteOnly) || f.write(QJsonDocument(root).toJson(QJsonDocument::Compact)) < 0 ||
+	    !f.commit()) {
+		LOGW("Failed to write trace: %s", out.toUtf8().constData());
+		return QString();
+	}
+
+	LOGI("Wrote %d trace events to %s", static_cast<int>(events.size()), out.toUtf8().constData());
+	return out;
+}
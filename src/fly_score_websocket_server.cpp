@@ -4,34 +4,84 @@
 #define LOG_TAG "[" PLUGIN_NAME "][websocket]"
 #include "fly_score_log.hpp"
 
+#include "fly_score_boards.hpp"
+#include "fly_score_commands.hpp"
+#include "fly_score_derived.hpp"
+#include "fly_score_metrics.hpp"
+#include "fly_score_topics.hpp"
+#include "fly_score_trace.hpp"
+#include "fly_score_ws_frame.hpp"
+
 #include <QByteArray>
-#include <QCryptographicHash>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QHostAddress>
+#include <QLocalServer>
+#include <QLocalSocket>
 #include <QTcpServer>
 #include <QTcpSocket>
 
-static QByteArray websocketFrame(const QByteArray &payload)
+#include <utility>
+
+static constexpr int kRevisionStampsPerBoard = 64;
+static constexpr uint64_t kInputMarkMaxAgeUs = 1000000;
+static constexpr quint64 kMaxFramePayload = 1024 * 1024;
+// A client that keeps sending while throttled is dropped after this many rejections in a row.
+static constexpr quint64 kRateLimitDisconnectAfter = 1000;
+
+FlyClientSession::FlyClientSession(QIODevice *socket, Transport transport, quint64 id, QObject *parent)
+	: QObject(parent),
+	  socket_(socket),
+	  transport_(transport),
+	  id_(id),
+	  handshaken_(transport == Transport::Local),
+	  board_(fly_default_board_id())
 {
-	QByteArray frame;
-	frame.append(char(0x81));
+	socket_->setParent(this);
+}
 
-	const qsizetype len = payload.size();
-	if (len < 126) {
-		frame.append(char(len));
-	} else if (len <= 0xffff) {
-		frame.append(char(126));
-		frame.append(char((len >> 8) & 0xff));
-		frame.append(char(len & 0xff));
-	} else {
-		frame.append(char(127));
-		for (int i = 7; i >= 0; --i)
-			frame.append(char((quint64(len) >> (8 * i)) & 0xff));
-	}
+bool FlyClientSession::isOpen() const
+{
+	if (auto *tcp = qobject_cast<QTcpSocket *>(socket_))
+		return handshaken_ && tcp->state() == QAbstractSocket::ConnectedState;
+	if (auto *local = qobject_cast<QLocalSocket *>(socket_))
+		return local->state() == QLocalSocket::ConnectedState;
+	return false;
+}
 
-	frame.append(payload);
-	return frame;
+void FlyClientSession::close()
+{
+	if (auto *tcp = qobject_cast<QTcpSocket *>(socket_))
+		tcp->disconnectFromHost();
+	else if (auto *local = qobject_cast<QLocalSocket *>(socket_))
+		local->disconnectFromServer();
+}
+
+void FlyClientSession::sendText(const QString &message)
+{
+	if (!handshaken_)
+		return;
+
+	const QByteArray frame = transport_ == Transport::Local ? fly_local_encode_frame(message.toUtf8())
+								 : fly_ws_encode_frame(message.toUtf8());
+	fly_metrics().messagesSent.add();
+	fly_metrics().bytesSent.add(static_cast<uint64_t>(frame.size()));
+	if (corked_ > 0)
+		pending_.append(frame);
+	else
+		socket_->write(frame);
+}
+
+void FlyClientSession::uncork()
+{
+	if (corked_ > 0 && --corked_ == 0 && !pending_.isEmpty())
+		socket_->write(std::exchange(pending_, QByteArray()));
+}
+
+void FlyClientSession::sendJson(const QJsonObject &message)
+{
+	sendText(QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact)));
 }
 
 FlyScoreWebSocketServer::FlyScoreWebSocketServer(QObject *parent) : QObject(parent) {}
@@ -41,18 +91,19 @@ FlyScoreWebSocketServer::~FlyScoreWebSocketServer()
 	stop();
 }
 
-bool FlyScoreWebSocketServer::start(quint16 port)
+bool FlyScoreWebSocketServer::start(quint16 port, const QHostAddress &address)
 {
-	if (server_ && server_->isListening() && port_ == port)
+	if (server_ && server_->isListening() && port_ == port && address_ == address)
 		return true;
 
 	stop();
 	port_ = port ? port : 4457;
+	address_ = address;
 	server_ = new QTcpServer(this);
 	connect(server_, &QTcpServer::newConnection, this, &FlyScoreWebSocketServer::onNewConnection);
 
-	if (!server_->listen(QHostAddress::LocalHost, port_)) {
-		LOGW("Failed to listen on ws://127.0.0.1:%u", static_cast<unsigned>(port_));
+	if (!server_->listen(address_, port_)) {
+		LOGW("Failed to listen on %s", url().toUtf8().constData());
 		server_->deleteLater();
 		server_ = nullptr;
 		emit statusChanged();
@@ -64,25 +115,72 @@ bool FlyScoreWebSocketServer::start(quint16 port)
 	return true;
 }
 
+bool FlyScoreWebSocketServer::listenLocal(const QString &name)
+{
+	if (localServer_) {
+		localServer_->close();
+		localServer_->deleteLater();
+		localServer_ = nullptr;
+	}
+	if (name.isEmpty())
+		return false;
+
+	localServer_ = new QLocalServer(this);
+	localServer_->setSocketOptions(QLocalServer::UserAccessOption);
+	connect(localServer_, &QLocalServer::newConnection, this, &FlyScoreWebSocketServer::onNewLocalConnection);
+
+	// A socket file left behind by a crashed OBS would make listen() fail.
+	QLocalServer::removeServer(name);
+	if (!localServer_->listen(name)) {
+		LOGW("Failed to listen on local socket '%s': %s", name.toUtf8().constData(),
+		     localServer_->errorString().toUtf8().constData());
+		localServer_->deleteLater();
+		localServer_ = nullptr;
+		emit statusChanged();
+		return false;
+	}
+
+	LOGI("Listening on local socket %s", localServer_->fullServerName().toUtf8().constData());
+	emit statusChanged();
+	return true;
+}
+
+QString FlyScoreWebSocketServer::localServerName() const
+{
+	return localServer_ ? localServer_->fullServerName() : QString();
+}
+
 void FlyScoreWebSocketServer::stop()
 {
-	for (auto *client : clients_) {
-		if (client)
-			client->disconnectFromHost();
+	// Deleting a session drops its disconnected() connection along with it.
+	for (auto *session : std::exchange(sessions_, QList<FlyClientSession *>())) {
+		session->close();
+		session->deleteLater();
 	}
-	clients_.clear();
-	buffers_.clear();
-	handshaken_.clear();
+	fly_metrics().clients.set(0);
+	lastStates_.clear();
+	derived_.clear();
+	revisionStamps_.clear();
 
 	if (server_) {
 		server_->close();
 		server_->deleteLater();
 		server_ = nullptr;
 	}
+	if (localServer_) {
+		localServer_->close();
+		localServer_->deleteLater();
+		localServer_ = nullptr;
+	}
 	emit statusChanged();
 }
 
 bool FlyScoreWebSocketServer::isListening() const
+{
+	return isWebSocketListening() || (localServer_ && localServer_->isListening());
+}
+
+bool FlyScoreWebSocketServer::isWebSocketListening() const
 {
 	return server_ && server_->isListening();
 }
@@ -94,12 +192,37 @@ quint16 FlyScoreWebSocketServer::port() const
 
 QString FlyScoreWebSocketServer::url() const
 {
-	return QStringLiteral("ws://127.0.0.1:%1").arg(port_);
+	QString host = address_.toString();
+	if (address_ == QHostAddress(QHostAddress::Any))
+		host = QStringLiteral("0.0.0.0");
+	else if (address_.protocol() == QAbstractSocket::IPv6Protocol)
+		host = QStringLiteral("[%1]").arg(host);
+	return QStringLiteral("ws://%1:%2").arg(host).arg(port_);
 }
 
 int FlyScoreWebSocketServer::clientCount() const
 {
-	return clients_.size();
+	return sessions_.size();
+}
+
+bool FlyScoreWebSocketServer::hasOverlayWithCapability(const QString &capability, const QString &board) const
+{
+	for (const auto *session : sessions_) {
+		if (session->obs_ && clientOnBoard(session, board) && session->hasCapability(capability))
+			return true;
+	}
+	return false;
+}
+
+bool FlyScoreWebSocketServer::clientOnBoard(const FlyClientSession *session, const QString &board) const
+{
+	return board.isEmpty() || session->board_ == board;
+}
+
+QString FlyScoreWebSocketServer::targetBoard(const FlyClientSession *session, const QJsonObject &message) const
+{
+	const QString board = message.value(QStringLiteral("board")).toString();
+	return board.isEmpty() ? session->board_ : fly_board_normalize_id(board);
 }
 
 void FlyScoreWebSocketServer::onNewConnection()
@@ -107,36 +230,92 @@ void FlyScoreWebSocketServer::onNewConnection()
 	if (!server_)
 		return;
 
-	while (auto *client = server_->nextPendingConnection()) {
-		clients_.push_back(client);
-		handshaken_.insert(client, false);
-		connect(client, &QTcpSocket::readyRead, this, &FlyScoreWebSocketServer::onReadyRead);
-		connect(client, &QTcpSocket::disconnected, this, [this, client]() { removeClient(client); });
-		emit statusChanged();
+	while (auto *socket = server_->nextPendingConnection()) {
+		auto *session =
+			new FlyClientSession(socket, FlyClientSession::Transport::WebSocket, ++nextSessionId_, this);
+		connect(socket, &QTcpSocket::disconnected, session, [this, session]() { removeSession(session); });
+		addSession(session);
 	}
 }
 
-void FlyScoreWebSocketServer::onReadyRead()
+void FlyScoreWebSocketServer::onNewLocalConnection()
 {
-	auto *client = qobject_cast<QTcpSocket *>(sender());
-	if (!client)
+	if (!localServer_)
 		return;
 
-	buffers_[client].append(client->readAll());
-	processBuffer(client);
+	while (auto *socket = localServer_->nextPendingConnection()) {
+		auto *session =
+			new FlyClientSession(socket, FlyClientSession::Transport::Local, ++nextSessionId_, this);
+		connect(socket, &QLocalSocket::disconnected, session, [this, session]() { removeSession(session); });
+		addSession(session);
+	}
+}
+
+void FlyScoreWebSocketServer::addSession(FlyClientSession *session)
+{
+	sessions_.push_back(session);
+	fly_metrics().clients.set(sessions_.size());
+	connect(session->socket_, &QIODevice::readyRead, session, [this, session]() { onReadyRead(session); });
+	emit statusChanged();
+}
+
+void FlyScoreWebSocketServer::onReadyRead(FlyClientSession *session)
+{
+	const QByteArray data = session->socket_->readAll();
+	fly_metrics().bytesReceived.add(static_cast<uint64_t>(data.size()));
+	session->buffer_.append(data);
+	processBuffer(session);
 }
 
-void FlyScoreWebSocketServer::processBuffer(QTcpSocket *client)
+void FlyScoreWebSocketServer::processBuffer(FlyClientSession *session)
 {
-	QByteArray &buffer = buffers_[client];
+	FLY_TRACE_SCOPE_CAT("websocket", "processBuffer");
+	FlyMetricsTimer timer(fly_metrics().processBufferUs);
+	// Taken out of the session while handlers run; the session outlives them
+	// (deleteLater) even when the client drops.
+	QByteArray buffer = std::exchange(session->buffer_, QByteArray());
+	qsizetype pos = 0;
 
-	if (!handshaken_.value(client, false)) {
+	if (session->transport_ == FlyClientSession::Transport::Local) {
+		// Pipelined requests are answered with one write.
+		QList<QByteArray> messages;
+		QByteArray payload;
+		FlyWsDecode result;
+		while ((result = fly_local_decode_frame(buffer, pos, payload, kMaxFramePayload)) ==
+		       FlyWsDecode::Frame) {
+			fly_metrics().framesReceived.add();
+			messages.push_back(payload);
+		}
+		session->cork();
+		handleTextMessages(session, messages);
+		session->uncork();
+
+		if (result == FlyWsDecode::TooLarge) {
+			session->close();
+			return;
+		}
+		if (sessions_.contains(session))
+			session->buffer_ = pos < buffer.size() ? buffer.mid(pos) : QByteArray();
+		return;
+	}
+
+	if (!session->handshaken_) {
 		const int end = buffer.indexOf("\r\n\r\n");
-		if (end < 0)
+		if (end < 0) {
+			session->buffer_ = buffer;
 			return;
+		}
 
 		const QByteArray header = buffer.left(end + 4);
-		buffer.remove(0, end + 4);
+		pos = end + 4;
+
+		// Request line: "GET /board/<id> HTTP/1.1" selects the board channel.
+		const QByteArray target = header.left(header.indexOf('\n')).split(' ').value(1);
+		const QByteArray boardPrefix("/board/");
+		if (target.startsWith(boardPrefix)) {
+			const QByteArray id = QByteArray::fromPercentEncoding(target.mid(boardPrefix.size()).split('?').value(0));
+			session->board_ = fly_board_normalize_id(QString::fromUtf8(id));
+		}
 
 		QByteArray key;
 		for (const QByteArray &line : header.split('\n')) {
@@ -148,129 +327,733 @@ void FlyScoreWebSocketServer::processBuffer(QTcpSocket *client)
 		}
 
 		if (key.isEmpty()) {
-			client->disconnectFromHost();
+			handleHttp(session, header);
 			return;
 		}
 
-		const QByteArray accept = QCryptographicHash::hash(
-						  key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11",
-						  QCryptographicHash::Sha1)
-						  .toBase64();
 		QByteArray response;
 		response += "HTTP/1.1 101 Switching Protocols\r\n";
 		response += "Upgrade: websocket\r\n";
 		response += "Connection: Upgrade\r\n";
-		response += "Sec-WebSocket-Accept: " + accept + "\r\n\r\n";
-		client->write(response);
-		handshaken_[client] = true;
-	}
-
-	while (buffer.size() >= 2) {
-		const quint8 b0 = quint8(buffer[0]);
-		const quint8 b1 = quint8(buffer[1]);
-		const quint8 opcode = b0 & 0x0f;
-		const bool masked = (b1 & 0x80) != 0;
-		quint64 len = b1 & 0x7f;
-		int pos = 2;
-
-		if (len == 126) {
-			if (buffer.size() < pos + 2)
-				return;
-			len = (quint8(buffer[pos]) << 8) | quint8(buffer[pos + 1]);
-			pos += 2;
-		} else if (len == 127) {
-			if (buffer.size() < pos + 8)
-				return;
-			len = 0;
-			for (int i = 0; i < 8; ++i)
-				len = (len << 8) | quint8(buffer[pos + i]);
-			pos += 8;
-		}
+		response += "Sec-WebSocket-Accept: " + fly_ws_accept_key(key) + "\r\n\r\n";
+		session->socket_->write(response);
+		session->handshaken_ = true;
+	}
 
-		QByteArray mask;
-		if (masked) {
-			if (buffer.size() < pos + 4)
-				return;
-			mask = buffer.mid(pos, 4);
-			pos += 4;
+	// Drain every complete frame, then drop the consumed prefix once; removing
+	// per frame made pipelined input quadratic.
+	FlyWsFrame frame;
+	FlyWsDecode result;
+	QList<QByteArray> messages;
+	bool closing = false;
+	while ((result = fly_ws_decode_frame(buffer, pos, frame, kMaxFramePayload)) == FlyWsDecode::Frame) {
+		fly_metrics().framesReceived.add();
+		if (frame.opcode == 0x8) {
+			closing = true;
+			break;
 		}
+		if (frame.opcode == 0x1)
+			messages.push_back(frame.payload);
+	}
+	session->cork();
+	handleTextMessages(session, messages);
+	session->uncork();
 
-		if (len > 1024 * 1024) {
-			client->disconnectFromHost();
-			return;
-		}
-		if (buffer.size() < pos + qsizetype(len))
+	if (closing) {
+		session->close();
+		return;
+	}
+
+	if (result == FlyWsDecode::TooLarge) {
+		session->close();
+		return;
+	}
+
+	if (sessions_.contains(session))
+		session->buffer_ = pos < buffer.size() ? buffer.mid(pos) : QByteArray();
+}
+
+static QByteArray fly_http_reason(int status)
+{
+	switch (status) {
+	case 200:
+		return "OK";
+	case 304:
+		return "Not Modified";
+	case 400:
+		return "Bad Request";
+	case 403:
+		return "Forbidden";
+	case 405:
+		return "Method Not Allowed";
+	default:
+		return "Not Found";
+	}
+}
+
+void FlyScoreWebSocketServer::handleHttp(FlyClientSession *session, const QByteArray &header)
+{
+	FLY_TRACE_SCOPE_CAT("websocket", "handleHttp");
+	const QList<QByteArray> lines = header.split('\n');
+	const QList<QByteArray> requestLine = lines.value(0).trimmed().split(' ');
+
+	FlyHttpRequest req;
+	req.method = requestLine.value(0);
+	req.path = QString::fromUtf8(QByteArray::fromPercentEncoding(requestLine.value(1).split('?').value(0)));
+	for (const QByteArray &line : lines) {
+		const int colon = line.indexOf(':');
+		if (colon <= 0)
+			continue;
+		const QByteArray name = line.left(colon).trimmed().toLower();
+		const QByteArray value = line.mid(colon + 1).trimmed();
+		if (name == "accept-encoding")
+			req.acceptGzip = value.toLower().contains("gzip");
+		else if (name == "if-none-match")
+			req.ifNoneMatch = value;
+	}
+
+	FlyHttpResponse res;
+	const bool head = req.method == "HEAD";
+	if (req.method != "GET" && !head)
+		res.status = 405;
+	else if (httpHandler_)
+		httpHandler_(req, res);
+
+	if (res.status == 200 && !res.etag.isEmpty() && req.ifNoneMatch == res.etag) {
+		res.status = 304;
+		res.body.clear();
+	}
+
+	QByteArray response = "HTTP/1.1 " + QByteArray::number(res.status) + ' ' + fly_http_reason(res.status) + "\r\n";
+	if (!res.contentType.isEmpty())
+		response += "Content-Type: " + res.contentType + "\r\n";
+	if (res.gzip)
+		response += "Content-Encoding: gzip\r\n";
+	if (!res.etag.isEmpty())
+		response += "ETag: " + res.etag + "\r\nVary: Accept-Encoding\r\n";
+	response += "Cache-Control: no-cache\r\n";
+	response += "Content-Length: " + QByteArray::number(res.body.size()) + "\r\n";
+	response += "Connection: close\r\n\r\n";
+	if (!head)
+		response += res.body;
+	session->socket_->write(response);
+	fly_metrics().bytesSent.add(static_cast<uint64_t>(response.size()));
+	session->close();
+}
+
+void FlyScoreWebSocketServer::setRateLimit(int burst, double perSecond)
+{
+	rateBurst_ = qMax(1, burst);
+	ratePerSec_ = perSecond;
+	for (FlyClientSession *session : std::as_const(sessions_))
+		session->tokens_ = -1.0;
+	if (perSecond > 0)
+		LOGI("Command rate limit: burst %d, %.1f/s per client", rateBurst_, perSecond);
+	else
+		LOGI("Command rate limit off");
+}
+
+bool FlyScoreWebSocketServer::takeCommandToken(FlyClientSession *session, uint64_t nowUs, qint64 &retryAfterMs)
+{
+	if (ratePerSec_ <= 0)
+		return true;
+
+	if (session->tokens_ < 0) {
+		session->tokens_ = rateBurst_;
+	} else if (nowUs > session->tokensUs_) {
+		const double refill = ratePerSec_ * double(nowUs - session->tokensUs_) / 1e6;
+		session->tokens_ = qMin(double(rateBurst_), session->tokens_ + refill);
+	}
+	session->tokensUs_ = nowUs;
+
+	if (session->tokens_ >= 1.0) {
+		session->tokens_ -= 1.0;
+		return true;
+	}
+	retryAfterMs = qint64((1.0 - session->tokens_) * 1000.0 / ratePerSec_) + 1;
+	return false;
+}
+
+QJsonObject FlyScoreWebSocketServer::rejectRateLimited(FlyClientSession *session, const QJsonObject &obj,
+						       qint64 retryAfterMs)
+{
+	fly_metrics().commandsRateLimited.add();
+	const bool first = session->rejectedStreak_++ == 0;
+	if (first)
+		LOGW("Client %llu exceeded the command rate limit; rejecting until it slows down",
+		     (unsigned long long)session->id_);
+
+	QJsonObject reply;
+	reply.insert(QStringLiteral("type"), obj.contains(QStringLiteral("id")) ? QStringLiteral("ack")
+									  : QStringLiteral("error"));
+	if (obj.contains(QStringLiteral("id")))
+		reply.insert(QStringLiteral("id"), obj.value(QStringLiteral("id")));
+	reply.insert(QStringLiteral("action"), fly_command_action(obj));
+	reply.insert(QStringLiteral("error"), QStringLiteral("rate_limited"));
+	reply.insert(QStringLiteral("retry_after_ms"), retryAfterMs);
+
+	// Commands with an id always get their ack; anonymous ones get one notice per streak.
+	if (obj.contains(QStringLiteral("id")) || first)
+		session->sendJson(reply);
+
+	if (session->rejectedStreak_ > kRateLimitDisconnectAfter) {
+		LOGW("Client %llu kept flooding while throttled; disconnecting", (unsigned long long)session->id_);
+		session->close();
+	}
+	return reply;
+}
+
+// Non-empty for set_* commands: action, board, the ids of the row/team/player
+// they address and the fields they set. Two commands with the same key leave
+// the same state, so only the last of a run needs to run.
+static QString fly_command_coalesce_key(const QJsonObject &obj, const QString &action, const QString &board)
+{
+	if (!action.startsWith(QLatin1String("set_")))
+		return QString();
+
+	QStringList parts{action, board};
+	QStringList keys = obj.keys();
+	keys.sort();
+	for (const QString &key : keys) {
+		// "id" is the ack id, except for set_derived where it names the value.
+		if (key == QLatin1String("id") && action != QLatin1String("set_derived"))
+			continue;
+		const bool target = key == QLatin1String("index") || key == QLatin1String("side") ||
+				    key == QLatin1String("team") || key == QLatin1String("number") ||
+				    key == QLatin1String("stat") || key == QLatin1String("id");
+		const QJsonValue v = obj.value(key);
+		parts.push_back(target ? key + QLatin1Char('=') + (v.isDouble() ? QString::number(v.toDouble())
+										   : v.toString())
+				       : key);
+	}
+	return parts.join(QLatin1Char('\x1f'));
+}
+
+// Why a command carrying derived expressions is refused, or empty. The engine
+// would skip such a declaration anyway; refusing it here tells the client.
+static QString fly_command_expr_error(const QJsonObject &obj, const QString &action)
+{
+	if (action == QLatin1String("set_derived"))
+		return fly_derived_expr_error(fly_command_string(obj, QStringLiteral("expr")));
+	if (action != QLatin1String("set_state"))
+		return QString();
+
+	const QJsonObject state = obj.value(QStringLiteral("state")).toObject();
+	for (const QJsonValue v : state.value(QStringLiteral("derived")).toArray()) {
+		const QJsonObject d = v.toObject();
+		const QString error = fly_derived_expr_error(d.value(QStringLiteral("expr")).toString());
+		if (!error.isEmpty())
+			return QStringLiteral("%1: %2").arg(d.value(QStringLiteral("id")).toString(), error);
+	}
+	return QString();
+}
+
+void FlyScoreWebSocketServer::handleTextMessages(FlyClientSession *session, const QList<QByteArray> &messages)
+{
+	if (messages.isEmpty())
+		return;
+	FLY_TRACE_SCOPE_CAT("websocket", "handleTextMessages");
+
+	QList<QJsonObject> objs;
+	objs.reserve(messages.size());
+	for (const QByteArray &message : messages) {
+		const auto doc = QJsonDocument::fromJson(message);
+		if (doc.isObject())
+			objs.push_back(doc.object());
+		else
+			fly_metrics().parseFailures.add();
+	}
+
+	QStringList keys;
+	keys.reserve(objs.size());
+	for (const QJsonObject &obj : std::as_const(objs))
+		keys.push_back(fly_command_coalesce_key(obj, fly_command_action(obj), targetBoard(session, obj)));
+
+	// Ids of the folded commands, acked with the outcome of the command that survives them.
+	QJsonArray coalescedIds;
+	for (qsizetype i = 0; i < objs.size(); ++i) {
+		// The client may have disconnected while a command was handled.
+		if (!sessions_.contains(session))
 			return;
 
-		QByteArray payload = buffer.mid(pos, qsizetype(len));
-		buffer.remove(0, pos + qsizetype(len));
+		if (!keys[i].isEmpty() && i + 1 < objs.size() && keys[i] == keys[i + 1]) {
+			fly_metrics().commandsCoalesced.add();
+			if (objs[i].contains(QStringLiteral("id")))
+				coalescedIds.push_back(objs[i].value(QStringLiteral("id")));
+			continue;
+		}
 
-		if (masked) {
-			for (qsizetype i = 0; i < payload.size(); ++i)
-				payload[i] = payload[i] ^ mask[int(i % 4)];
+		const QJsonObject outcome = handleMessage(session, objs[i]);
+		if (coalescedIds.isEmpty())
+			continue;
+		if (!outcome.isEmpty() && sessions_.contains(session)) {
+			for (const QJsonValue id : std::as_const(coalescedIds)) {
+				QJsonObject ack = outcome;
+				ack.insert(QStringLiteral("type"), QStringLiteral("ack"));
+				ack.insert(QStringLiteral("id"), id);
+				ack.insert(QStringLiteral("coalesced"), true);
+				session->sendJson(ack);
+			}
 		}
+		coalescedIds = QJsonArray();
+	}
+}
 
-		if (opcode == 0x8) {
-			client->disconnectFromHost();
-			return;
+QJsonObject FlyScoreWebSocketServer::handleMessage(FlyClientSession *session, QJsonObject obj)
+{
+	FLY_TRACE_SCOPE_CAT("websocket", "handleMessage");
+	const QString type = obj.value(QStringLiteral("type")).toString();
+	if (type == QLatin1String("hello")) {
+		handleHello(session, obj);
+		return QJsonObject();
+	}
+	if (type == QLatin1String("subscribe")) {
+		setClientTopics(session, obj.value(QStringLiteral("topics")));
+		return QJsonObject();
+	}
+	if (type == QLatin1String("rendered")) {
+		handleRendered(session, obj);
+		return QJsonObject();
+	}
+
+	qint64 retryAfterMs = 0;
+	if (!takeCommandToken(session, fly_trace_now_us(), retryAfterMs))
+		return rejectRateLimited(session, obj, retryAfterMs);
+	session->rejectedStreak_ = 0;
+
+	const QString action = fly_command_action(obj);
+	if (adminActions_ && action == QLatin1String("get_metrics")) {
+		QJsonObject reply;
+		reply.insert(QStringLiteral("type"), QStringLiteral("metrics"));
+		reply.insert(QStringLiteral("metrics"), fly_metrics_to_json());
+		session->sendJson(reply);
+		return QJsonObject();
+	}
+	if (adminActions_ && (action == QLatin1String("trace_enable") || action == QLatin1String("dump_trace"))) {
+		if (action == QLatin1String("trace_enable")) {
+			fly_trace_set_enabled(fly_command_bool(obj, QStringLiteral("value"), true));
+			emit tracingChanged();
 		}
-		if (opcode == 0x1)
-			handleTextMessage(QString::fromUtf8(payload));
+
+		QJsonObject reply;
+		reply.insert(QStringLiteral("type"), QStringLiteral("trace"));
+		reply.insert(QStringLiteral("enabled"), fly_trace_enabled());
+		reply.insert(QStringLiteral("events"), fly_trace_event_count());
+		if (action == QLatin1String("dump_trace"))
+			reply.insert(QStringLiteral("path"), fly_trace_dump());
+		session->sendJson(reply);
+		return QJsonObject();
+	}
+	if (action == QLatin1String("get_leaders")) {
+		session->sendJson(leaders(session, obj));
+		return QJsonObject();
+	}
+
+	const QString exprError = fly_command_expr_error(obj, action);
+	if (!exprError.isEmpty()) {
+		fly_metrics().commandsIgnored.add();
+		QJsonObject reply;
+		reply.insert(QStringLiteral("type"), obj.contains(QStringLiteral("id")) ? QStringLiteral("ack")
+										  : QStringLiteral("error"));
+		if (obj.contains(QStringLiteral("id")))
+			reply.insert(QStringLiteral("id"), obj.value(QStringLiteral("id")));
+		reply.insert(QStringLiteral("action"), action);
+		reply.insert(QStringLiteral("error"), QStringLiteral("invalid_expression"));
+		reply.insert(QStringLiteral("message"), exprError);
+		session->sendJson(reply);
+		return reply;
 	}
+
+	const QString board = targetBoard(session, obj);
+	obj.insert(QStringLiteral("board"), board);
+
+	// A handler that spins a nested event loop (a message box) can run other
+	// commands before returning; each one pushes and pops its own context.
+	CommandContext context;
+	context.receivedUs = fly_trace_now_us();
+	context.board = board;
+	context.rev = revision(board);
+	commands_.push_back(context);
+
+	emit commandReceived(session, obj);
+
+	const CommandContext done = commands_.takeLast();
+
+	// The client may have disconnected while the command was handled.
+	if (!sessions_.contains(session))
+		return QJsonObject();
+
+	QJsonObject ack;
+	ack.insert(QStringLiteral("type"), QStringLiteral("ack"));
+	if (obj.contains(QStringLiteral("id")))
+		ack.insert(QStringLiteral("id"), obj.value(QStringLiteral("id")));
+	ack.insert(QStringLiteral("action"), action);
+	ack.insert(QStringLiteral("board"), done.board);
+	ack.insert(QStringLiteral("rev"), static_cast<qint64>(done.rev));
+	ack.insert(QStringLiteral("changed"), done.changed);
+	ack.insert(QStringLiteral("received_us"), static_cast<qint64>(done.receivedUs));
+	if (done.appliedUs)
+		ack.insert(QStringLiteral("applied_us"), static_cast<qint64>(done.appliedUs));
+	if (done.broadcastUs)
+		ack.insert(QStringLiteral("broadcast_us"), static_cast<qint64>(done.broadcastUs));
+	ack.insert(QStringLiteral("done_us"), static_cast<qint64>(fly_trace_now_us()));
+	if (obj.contains(QStringLiteral("id")))
+		session->sendJson(ack);
+	return ack;
 }
 
-void FlyScoreWebSocketServer::handleTextMessage(const QString &message)
+void FlyScoreWebSocketServer::handleRendered(FlyClientSession *session, const QJsonObject &rendered)
 {
-	const auto doc = QJsonDocument::fromJson(message.toUtf8());
-	if (!doc.isObject())
+	const uint64_t now = fly_trace_now_us();
+	const QString boardKey = targetBoard(session, rendered);
+	const qint64 rev = static_cast<qint64>(rendered.value(QStringLiteral("rev")).toDouble(0));
+	if (rev <= 0)
 		return;
 
-	emit commandReceived(doc.object());
+	// Every overlay on the board reports each rev; only the first one is a
+	// latency sample, the later ones would skew the histogram upwards.
+	const auto stamps = revisionStamps_.find(boardKey);
+	if (stamps == revisionStamps_.end())
+		return;
+	for (RevisionStamp &stamp : stamps.value()) {
+		if (stamp.rev != static_cast<quint64>(rev))
+			continue;
+		if (stamp.rendered)
+			return;
+		stamp.rendered = true;
+		fly_metrics().broadcastToRenderUs.record(now - stamp.broadcastUs);
+		if (stamp.receivedUs)
+			fly_metrics().inputToRenderUs.record(now - stamp.receivedUs);
+		return;
+	}
 }
 
-void FlyScoreWebSocketServer::removeClient(QObject *client)
+void FlyScoreWebSocketServer::markInput(uint64_t us)
 {
-	auto *sock = qobject_cast<QTcpSocket *>(client);
-	clients_.removeAll(sock);
-	buffers_.remove(sock);
-	handshaken_.remove(sock);
-	if (client)
-		client->deleteLater();
+	inputUs_ = us ? us : fly_trace_now_us();
+}
+
+QJsonObject FlyScoreWebSocketServer::leaders(FlyClientSession *session, const QJsonObject &request) const
+{
+	const QString boardKey = targetBoard(session, request);
+	const FlyRoster roster = lastStates_.value(boardKey).roster;
+
+	const QJsonValue statArg = request.value(QStringLiteral("stat"));
+	const int stat =
+		roster.statIndex(statArg.isDouble() ? QString::number(statArg.toInt()) : statArg.toString().trimmed());
+	const QString teamArg = fly_command_string(request, QStringLiteral("team")).toLower();
+	const int team = (teamArg.isEmpty() || teamArg == QLatin1String("all"))
+				 ? -1
+				 : (fly_command_side_is_away(teamArg, false) ? 1 : 0);
+
+	QJsonArray rows;
+	for (int row : fly_roster_top(roster, stat, fly_command_int(request, QStringLiteral("n"), 5), team)) {
+		QJsonObject o;
+		o.insert(QStringLiteral("team"), roster.team[row] ? QStringLiteral("away") : QStringLiteral("home"));
+		o.insert(QStringLiteral("number"), roster.number[row]);
+		o.insert(QStringLiteral("name"), roster.name[row]);
+		o.insert(QStringLiteral("value"), roster.values[stat][row]);
+		rows.append(o);
+	}
+
+	QJsonObject reply;
+	reply.insert(QStringLiteral("type"), QStringLiteral("leaders"));
+	reply.insert(QStringLiteral("board"), boardKey);
+	reply.insert(QStringLiteral("stat"), stat >= 0 ? QJsonValue(roster.stats[stat]) : QJsonValue());
+	reply.insert(QStringLiteral("team"), team < 0   ? QStringLiteral("all")
+					     : team ? QStringLiteral("away")
+						    : QStringLiteral("home"));
+	reply.insert(QStringLiteral("rows"), rows);
+	return reply;
+}
+
+quint64 FlyScoreWebSocketServer::revision(const QString &board) const
+{
+	return revisions_.value(board.isEmpty() ? fly_default_board_id() : board, 0);
+}
+
+void FlyScoreWebSocketServer::handleHello(FlyClientSession *session, const QJsonObject &hello)
+{
+	QSet<QString> caps;
+	for (const QJsonValue v : hello.value(QStringLiteral("capabilities")).toArray()) {
+		const QString cap = v.toString().trimmed();
+		if (!cap.isEmpty())
+			caps.insert(cap);
+	}
+	session->capabilities_ = caps;
+
+	const QString board = hello.value(QStringLiteral("board")).toString();
+	if (!board.isEmpty())
+		session->board_ = fly_board_normalize_id(board);
+
+	session->obs_ = hello.value(QStringLiteral("obs")).toBool(false);
+	setClientTopics(session, hello.value(QStringLiteral("topics")));
+
+	LOGD("Client #%llu hello: board=%s, obs=%d, capabilities=%d, topics=%s",
+	     static_cast<unsigned long long>(session->id_), session->board_.toUtf8().constData(),
+	     session->obs_ ? 1 : 0, static_cast<int>(caps.size()),
+	     session->topics_.isEmpty() ? "all" : session->topics_.join(QLatin1Char(',')).toUtf8().constData());
+}
+
+void FlyScoreWebSocketServer::setClientTopics(FlyClientSession *session, const QJsonValue &topics)
+{
+	QStringList names;
+	if (topics.isArray()) {
+		for (const QJsonValue v : topics.toArray())
+			names << v.toString();
+	} else if (topics.isString()) {
+		names = topics.toString().split(QLatin1Char(','));
+	}
+
+	const QStringList pointers = fly_topic_pointers(names);
+	if (pointers.isEmpty() || pointers.contains(QString()))
+		session->topics_.clear();
+	else
+		session->topics_ = pointers;
+}
+
+void FlyScoreWebSocketServer::removeSession(FlyClientSession *session)
+{
+	if (!sessions_.removeOne(session))
+		return;
+	fly_metrics().clients.set(sessions_.size());
+	session->deleteLater();
 	emit statusChanged();
 }
 
-QJsonObject FlyScoreWebSocketServer::makeStateEnvelope(const FlyState &state, const QString &templateName,
-						       const QString &templatePath) const
+QJsonObject FlyScoreWebSocketServer::makeStateEnvelope(const QJsonObject &state, const QString &templateName,
+						       const QString &templatePath, const QString &board) const
 {
 	QJsonObject env;
 	env.insert(QStringLiteral("type"), QStringLiteral("state"));
-	env.insert(QStringLiteral("state"), fly_state_to_json_object(state));
+	if (!board.isEmpty())
+		env.insert(QStringLiteral("board"), board);
+	env.insert(QStringLiteral("rev"), static_cast<qint64>(revision(board)));
+	env.insert(QStringLiteral("state"), state);
 	env.insert(QStringLiteral("template"), templateName);
 	env.insert(QStringLiteral("template_path"), templatePath);
 	return env;
 }
 
-void FlyScoreWebSocketServer::sendText(QTcpSocket *client, const QString &message)
+void FlyScoreWebSocketServer::sendState(FlyClientSession *session, const FlyState &state, const QString &templateName,
+					const QString &templatePath, const QString &board)
 {
-	if (!client || !handshaken_.value(client, false))
+	FLY_TRACE_SCOPE_CAT("websocket", "sendState");
+	if (!session || !sessions_.contains(session))
 		return;
 
-	client->write(websocketFrame(message.toUtf8()));
+	QJsonObject json = fly_state_to_json_object(state);
+	insertDerivedValues(json, state, board.isEmpty() ? fly_default_board_id() : board);
+	const bool partial = !session->topics_.isEmpty();
+	if (partial)
+		json = fly_state_slice(json, session->topics_);
+
+	QJsonObject env = makeStateEnvelope(json, templateName, templatePath, board);
+	if (partial)
+		env.insert(QStringLiteral("partial"), true);
+	session->sendJson(env);
 }
 
-void FlyScoreWebSocketServer::sendState(QTcpSocket *client, const FlyState &state, const QString &templateName,
-					const QString &templatePath)
+bool FlyScoreWebSocketServer::sendLastState(FlyClientSession *session, const QString &board)
 {
-	const QJsonDocument doc(makeStateEnvelope(state, templateName, templatePath));
-	sendText(client, QString::fromUtf8(doc.toJson(QJsonDocument::Compact)));
+	if (!session || !sessions_.contains(session))
+		return false;
+	const auto it = lastStates_.constFind(board.isEmpty() ? fly_default_board_id() : board);
+	if (it == lastStates_.cend())
+		return false;
+
+	const bool partial = !session->topics_.isEmpty();
+	QJsonObject env = makeStateEnvelope(partial ? fly_state_slice(it->state, session->topics_) : it->state,
+					    it->templateName, it->templatePath, board);
+	if (partial)
+		env.insert(QStringLiteral("partial"), true);
+	session->sendJson(env);
+	return true;
+}
+
+void FlyScoreWebSocketServer::insertDerivedValues(QJsonObject &json, const FlyState &state, const QString &boardKey)
+{
+	if (state.derived.isEmpty() && !derived_.contains(boardKey))
+		return;
+
+	FlyDerivedEngine &engine = derived_[boardKey];
+	engine.setDefinitions(state.derived);
+	if (engine.isEmpty())
+		return;
+
+	json.insert(QStringLiteral("derived_values"), engine.update(json));
+	fly_metrics().derivedRecomputes.add(static_cast<uint64_t>(engine.lastRecomputed()));
 }
 
 void FlyScoreWebSocketServer::broadcastState(const FlyState &state, const QString &templateName,
-					     const QString &templatePath)
+					     const QString &templatePath, const QString &board)
+{
+	FLY_TRACE_SCOPE_CAT("websocket", "broadcastState");
+	FlyMetricsTimer timer(fly_metrics().broadcastUs);
+	fly_metrics().broadcasts.add();
+
+	const uint64_t appliedUs = fly_trace_now_us();
+	QJsonObject json = fly_state_to_json_object(state);
+	insertDerivedValues(json, state, board.isEmpty() ? fly_default_board_id() : board);
+	publishState(json, state.roster, templateName, templatePath, board, 0, appliedUs);
+}
+
+void FlyScoreWebSocketServer::relayState(const QJsonObject &state, quint64 rev, const QString &templateName,
+					 const QString &templatePath, const QString &board)
 {
-	const QJsonDocument doc(makeStateEnvelope(state, templateName, templatePath));
-	const QString payload = QString::fromUtf8(doc.toJson(QJsonDocument::Compact));
+	FLY_TRACE_SCOPE_CAT("websocket", "relayState");
+	FlyMetricsTimer timer(fly_metrics().broadcastUs);
+	fly_metrics().broadcasts.add();
+
+	const uint64_t appliedUs = fly_trace_now_us();
+	const FlyRoster roster = fly_roster_from_json(state.value(QStringLiteral("roster")).toObject());
+	publishState(state, roster, templateName, templatePath, board, rev, appliedUs);
+}
 
-	for (auto *client : clients_)
-		sendText(client, payload);
+void FlyScoreWebSocketServer::publishState(const QJsonObject &json, const FlyRoster &roster,
+					   const QString &templateName, const QString &templatePath,
+					   const QString &board, quint64 rev, uint64_t appliedUs)
+{
+	const QString boardKey = board.isEmpty() ? fly_default_board_id() : board;
+
+	// Compare against the last broadcast for this board so each client only
+	// receives the slices it subscribed to, and only when one of them changed.
+	const auto prevIt = lastStates_.constFind(boardKey);
+	const bool havePrev = prevIt != lastStates_.cend();
+	const BoardSnapshot prev = havePrev ? *prevIt : BoardSnapshot();
+	const bool templateChanged =
+		!havePrev || prev.templateName != templateName || prev.templatePath != templatePath;
+	const bool anyChanged = templateChanged || prev.state != json;
+	lastStates_.insert(boardKey, BoardSnapshot{json, templateName, templatePath, roster});
+	if (rev)
+		revisions_.insert(boardKey, rev);
+	else if (anyChanged)
+		++revisions_[boardKey];
+
+	CommandContext *command = nullptr;
+	if (!commands_.isEmpty() && commands_.last().board == boardKey)
+		command = &commands_.last();
+	if (command) {
+		command->rev = revision(boardKey);
+		command->changed = command->changed || anyChanged;
+		if (!command->appliedUs)
+			command->appliedUs = appliedUs;
+	}
+
+	if (!anyChanged) {
+		fly_metrics().broadcastsUnchanged.add();
+		return;
+	}
+
+	// When only roster values moved, clients with the "roster_delta" capability
+	// get the changed cells and a partial state without the table.
+	QJsonArray rosterCells;
+	const bool rosterDelta = havePrev && !templateChanged &&
+				 fly_roster_diff_cells(prev.roster, roster, rosterCells) &&
+				 !rosterCells.isEmpty();
+	QJsonObject slim;
+	bool slimChanged = true;
+	QString deltaPayload;
+	if (rosterDelta) {
+		slim = json;
+		slim.remove(QStringLiteral("roster"));
+		QJsonObject prevSlim = prev.state;
+		prevSlim.remove(QStringLiteral("roster"));
+		slimChanged = prevSlim != slim;
+
+		QJsonObject delta;
+		delta.insert(QStringLiteral("type"), QStringLiteral("roster_delta"));
+		if (!board.isEmpty())
+			delta.insert(QStringLiteral("board"), board);
+		delta.insert(QStringLiteral("rev"), static_cast<qint64>(revision(boardKey)));
+		delta.insert(QStringLiteral("cells"), rosterCells);
+		deltaPayload = QString::fromUtf8(QJsonDocument(delta).toJson(QJsonDocument::Compact));
+	}
+
+	QHash<QString, bool> pointerChanged;
+	QHash<QString, QString> payloads;
+	QString fullPayload;
+	QString slimPayload;
+
+	for (auto *session : sessions_) {
+		if (!clientOnBoard(session, board))
+			continue;
+
+		const QStringList &topics = session->topics_;
+		const bool cells = rosterDelta && session->hasCapability(QStringLiteral("roster_delta")) &&
+				   (topics.isEmpty() || topics.contains(QStringLiteral("/roster")));
+		if (cells) {
+			session->sendText(deltaPayload);
+			if (!slimChanged)
+				continue;
+		}
+
+		if (topics.isEmpty()) {
+			QString &payload = cells ? slimPayload : fullPayload;
+			if (payload.isEmpty()) {
+				QJsonObject env =
+					makeStateEnvelope(cells ? slim : json, templateName, templatePath, board);
+				if (cells)
+					env.insert(QStringLiteral("partial"), true);
+				payload = QString::fromUtf8(QJsonDocument(env).toJson(QJsonDocument::Compact));
+			}
+			session->sendText(payload);
+			continue;
+		}
+
+		bool interested = templateChanged;
+		for (const QString &p : topics) {
+			if (interested)
+				break;
+			if (cells && p == QLatin1String("/roster"))
+				continue;
+			auto it = pointerChanged.find(p);
+			if (it == pointerChanged.end())
+				it = pointerChanged.insert(p, fly_json_pointer_changed(prev.state, json, p));
+			interested = it.value();
+		}
+		if (!interested) {
+			if (!cells)
+				fly_metrics().clientsSkipped.add();
+			continue;
+		}
+
+		const QString key = (cells ? QStringLiteral("cells\n") : QString()) + topics.join(QLatin1Char('\n'));
+		auto payload = payloads.find(key);
+		if (payload == payloads.end()) {
+			QJsonObject env = makeStateEnvelope(fly_state_slice(cells ? slim : json, topics), templateName,
+							    templatePath, board);
+			env.insert(QStringLiteral("partial"), true);
+			payload = payloads.insert(
+				key, QString::fromUtf8(QJsonDocument(env).toJson(QJsonDocument::Compact)));
+		}
+		session->sendText(payload.value());
+	}
+
+	const uint64_t broadcastUs = fly_trace_now_us();
+	if (command)
+		command->broadcastUs = broadcastUs;
+
+	uint64_t receivedUs = 0;
+	if (command)
+		receivedUs = command->receivedUs;
+	else if (inputUs_ && appliedUs - inputUs_ < kInputMarkMaxAgeUs)
+		receivedUs = inputUs_;
+	inputUs_ = 0;
+
+	QList<RevisionStamp> &stamps = revisionStamps_[boardKey];
+	stamps.append(RevisionStamp{revision(boardKey), receivedUs, broadcastUs});
+	while (stamps.size() > kRevisionStampsPerBoard)
+		stamps.removeFirst();
+}
+
+void FlyScoreWebSocketServer::broadcastMessage(const QJsonObject &message, const QString &board,
+						const QString &capability)
+{
+	const QString payload = QString::fromUtf8(QJsonDocument(message).toJson(QJsonDocument::Compact));
+
+	for (auto *session : sessions_) {
+		if (clientOnBoard(session, board) && (capability.isEmpty() || session->hasCapability(capability)))
+			session->sendText(payload);
+	}
 }
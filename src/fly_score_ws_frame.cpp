@@ -0,0 +1,125 @@
+#include "fly_score_ws_frame.hpp"
+
+#include <QCryptographicHash>
+
+#include <cstring>
+
+QByteArray fly_ws_encode_frame(const QByteArray &payload, quint8 opcode, const quint8 *mask)
+{
+	const qsizetype len = payload.size();
+	const char maskBit = mask ? char(0x80) : char(0);
+
+	QByteArray frame;
+	frame.reserve(len + 14);
+	frame.append(char(0x80 | (opcode & 0x0f)));
+
+	if (len < 126) {
+		frame.append(char(maskBit | char(len)));
+	} else if (len <= 0xffff) {
+		frame.append(char(maskBit | 126));
+		frame.append(char((len >> 8) & 0xff));
+		frame.append(char(len & 0xff));
+	} else {
+		frame.append(char(maskBit | 127));
+		for (int i = 7; i >= 0; --i)
+			frame.append(char((quint64(len) >> (8 * i)) & 0xff));
+	}
+
+	if (!mask) {
+		frame.append(payload);
+		return frame;
+	}
+
+	frame.append(reinterpret_cast<const char *>(mask), 4);
+	const qsizetype start = frame.size();
+	frame.append(payload);
+	char *d = frame.data() + start;
+	for (qsizetype i = 0; i < len; ++i)
+		d[i] = char(d[i] ^ mask[i & 3]);
+	return frame;
+}
+
+FlyWsDecode fly_ws_decode_frame(const QByteArray &buffer, qsizetype &pos, FlyWsFrame &frame, quint64 maxPayload)
+{
+	const qsizetype avail = buffer.size() - pos;
+	if (avail < 2)
+		return FlyWsDecode::Incomplete;
+
+	const auto *p = reinterpret_cast<const quint8 *>(buffer.constData() + pos);
+	const bool masked = (p[1] & 0x80) != 0;
+	quint64 len = p[1] & 0x7f;
+	qsizetype hdr = 2;
+
+	if (len == 126) {
+		if (avail < hdr + 2)
+			return FlyWsDecode::Incomplete;
+		len = (quint64(p[2]) << 8) | p[3];
+		hdr += 2;
+	} else if (len == 127) {
+		if (avail < hdr + 8)
+			return FlyWsDecode::Incomplete;
+		len = 0;
+		for (int i = 0; i < 8; ++i)
+			len = (len << 8) | p[2 + i];
+		hdr += 8;
+	}
+
+	quint8 mask[4] = {0, 0, 0, 0};
+	if (masked) {
+		if (avail < hdr + 4)
+			return FlyWsDecode::Incomplete;
+		std::memcpy(mask, p + hdr, 4);
+		hdr += 4;
+	}
+
+	if (len > maxPayload)
+		return FlyWsDecode::TooLarge;
+	if (quint64(avail - hdr) < len)
+		return FlyWsDecode::Incomplete;
+
+	frame.opcode = p[0] & 0x0f;
+	frame.payload = QByteArray(reinterpret_cast<const char *>(p + hdr), qsizetype(len));
+	if (masked) {
+		char *d = frame.payload.data();
+		for (qsizetype i = 0; i < qsizetype(len); ++i)
+			d[i] = char(d[i] ^ mask[i & 3]);
+	}
+
+	pos += hdr + qsizetype(len);
+	return FlyWsDecode::Frame;
+}
+
+QByteArray fly_ws_accept_key(const QByteArray &clientKey)
+{
+	return QCryptographicHash::hash(clientKey + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11", QCryptographicHash::Sha1)
+		.toBase64();
+}
+
+QByteArray fly_local_encode_frame(const QByteArray &payload)
+{
+	const quint32 len = quint32(payload.size());
+	QByteArray frame;
+	frame.reserve(payload.size() + 4);
+	for (int i = 3; i >= 0; --i)
+		frame.append(char((len >> (8 * i)) & 0xff));
+	frame.append(payload);
+	return frame;
+}
+
+FlyWsDecode fly_local_decode_frame(const QByteArray &buffer, qsizetype &pos, QByteArray &payload, quint64 maxPayload)
+{
+	const qsizetype avail = buffer.size() - pos;
+	if (avail < 4)
+		return FlyWsDecode::Incomplete;
+
+	const auto *p = reinterpret_cast<const quint8 *>(buffer.constData() + pos);
+	const quint64 len = (quint64(p[0]) << 24) | (quint64(p[1]) << 16) | (quint64(p[2]) << 8) | p[3];
+	if (len > maxPayload)
+		return FlyWsDecode::TooLarge;
+	if (quint64(avail - 4) < len)
+		return FlyWsDecode::Incomplete;
+
+	payload = buffer.mid(pos + 4, qsizetype(len));
+	pos += 4 + qsizetype(len);
+	return FlyWsDecode::Frame;
+}
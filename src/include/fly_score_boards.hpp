@@ -0,0 +1,26 @@
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+struct FlyBoard {
+	QString id;
+	QString name;
+	QString templatePath;
+};
+
+QString fly_default_board_id();
+QString fly_board_normalize_id(const QString &raw);
+bool fly_board_is_default(const QString &id);
+
+// The default board always exists and uses the global data root as its template;
+// additional boards are stored in the plugin settings.
+QVector<FlyBoard> fly_boards_load();
+void fly_boards_save(const QVector<FlyBoard> &boards);
+
+QString fly_load_active_board_id();
+void fly_save_active_board_id(const QString &id);
+
+// plugin.json location: the template folder for the default board,
+// <template>/boards/<id> for the others so several boards can share a template.
+QString fly_board_state_dir(const FlyBoard &board);
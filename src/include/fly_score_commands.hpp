@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+#include "fly_score_state.hpp"
+
+enum FlyCommandEffect {
+	FlyCommandIgnored = 0,
+	FlyCommandValues = 1 << 0,
+	FlyCommandStructure = 1 << 1,
+};
+
+QString fly_command_action(const QJsonObject &command);
+int fly_command_int(const QJsonObject &command, const QString &key, int fallback = 0);
+qint64 fly_command_int64(const QJsonObject &command, const QString &key, qint64 fallback = 0);
+bool fly_command_bool(const QJsonObject &command, const QString &key, bool fallback = false);
+QString fly_command_string(const QJsonObject &command, const QString &key);
+uint32_t fly_command_color(const QJsonObject &command, const QString &key, uint32_t fallback);
+bool fly_command_side_is_away(const QString &side, bool swapSides);
+
+void fly_timer_toggle(FlyTimer &timer, qint64 nowMs);
+
+// True for actions fly_apply_state_command() understands (as opposed to dock,
+// server or preset actions such as load_template, get_state, apply_preset).
+bool fly_command_is_state_action(const QString &action);
+
+// Applies a state-mutating remote action to st without touching UI or disk.
+// Returns a FlyCommandEffect mask: Values for plain value edits, Structure when
+// rows were added/removed (hotkeys and dock rows must be rebuilt).
+int fly_apply_state_command(FlyState &st, const QString &action, const QJsonObject &command, qint64 nowMs);
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <vector>
+
+#include "fly_score_state.hpp"
+
+// Computed statistics declared in the state as "derived": [{"id", "expr"}] and
+// published next to it as "derived_values": {id: number}.
+//
+// Expressions are arithmetic/comparison/ternary over:
+//   field[0].home, field["Sets"].away, field[i].visible   custom fields
+//   single[0], single["Fouls"].visible                    single stats (.value)
+//   timer[0].remaining_ms, .initial_ms, .running          timers
+//   swap_sides, show_scoreboard, true, false
+//   other derived ids
+// and the functions min, max, abs, round, floor, ceil, clamp(x, lo, hi),
+// pct(part, total), sum_home(), sum_away(), count_fields().
+//
+// Definitions compile into a DAG; each update re-reads the leaf inputs and
+// re-evaluates only the nodes downstream of an input that changed. Division by
+// zero yields 0 so values stay valid JSON. Expressions are capped at 4096
+// characters and 64 levels of nesting.
+class FlyDerivedEngine {
+public:
+	// Recompiles only when defs differ from the current ones. Returns an
+	// "id: message" entry per definition that was rejected.
+	QStringList setDefinitions(const QVector<FlyDerivedField> &defs);
+	// Reads inputs from a serialized state and returns every valid value.
+	QJsonObject update(const QJsonObject &state);
+
+	bool isEmpty() const { return nodes_.empty(); }
+	const QStringList &errors() const { return errors_; }
+	// Nodes re-evaluated by the last update().
+	int lastRecomputed() const { return lastRecomputed_; }
+
+private:
+	friend class FlyDerivedParser;
+
+	enum class Op {
+		Num,
+		Input,
+		Node,
+		Neg,
+		Not,
+		Add,
+		Sub,
+		Mul,
+		Div,
+		Mod,
+		Lt,
+		Le,
+		Gt,
+		Ge,
+		Eq,
+		Ne,
+		And,
+		Or,
+		Cond,
+		Min,
+		Max,
+		Abs,
+		Round,
+		Floor,
+		Ceil,
+		Clamp,
+		Pct,
+	};
+
+	struct Expr {
+		Op op = Op::Num;
+		double num = 0;
+		int ref = -1;
+		// Longest path to a leaf; bounds eval()'s recursion.
+		int depth = 1;
+		std::vector<int> args;
+	};
+
+	enum class InputKind {
+		Scalar,
+		Item,
+		SumHome,
+		SumAway,
+		Count,
+	};
+
+	// A leaf read from the state: state[key], state[collection][index or label][prop].
+	struct Input {
+		InputKind kind = InputKind::Scalar;
+		QString collection;
+		int index = -1;
+		QString label;
+		QString prop;
+		double value = 0;
+		bool read = false;
+		std::vector<int> dependents;
+	};
+
+	struct Node {
+		QString id;
+		int root = -1;
+		bool ok = true;
+		double value = 0;
+		std::vector<int> nodeDeps;
+		std::vector<int> dependents;
+	};
+
+	int addInput(Input in);
+	double readInput(const Input &in, const QJsonObject &state) const;
+	double eval(int expr) const;
+
+	QVector<FlyDerivedField> defs_;
+	std::vector<Expr> exprs_;
+	std::vector<Input> inputs_;
+	std::vector<Node> nodes_;
+	// Valid nodes in dependency order.
+	std::vector<int> order_;
+	QJsonObject values_;
+	QStringList errors_;
+	bool primed_ = false;
+	int lastRecomputed_ = 0;
+};
+
+// Empty when expr parses; otherwise why it does not (syntax, length, nesting).
+// References to other derived ids are not resolved here.
+QString fly_derived_expr_error(const QString &expr);
@@ -2,12 +2,26 @@
 
 #include <QWidget>
 #include <QString>
+#include <QHash>
 #include <QList>
+#include <QVector>
 #include <QKeySequence>
 #include <QToolButton>
 
-#include "fly_score_state.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
 
+#include "fly_score_state.hpp"
+#include "fly_score_boards.hpp"
+#include "fly_score_field_rows.hpp"
+#include "fly_score_history.hpp"
+#include "fly_score_hotkeys.hpp"
+#include "fly_score_presets.hpp"
+#include "fly_score_shm_publisher.hpp"
+
+class QAction;
 class QPushButton;
 class QSpinBox;
 class QLineEdit;
@@ -18,18 +32,13 @@ class QLabel;
 class QShortcut;
 class QJsonObject;
 class FlyScoreWebSocketServer;
-
-struct FlyCustomFieldUi {
-	QWidget *row = nullptr;
-	QCheckBox *visibleCheck = nullptr;
-	QLabel *labelLbl = nullptr;
-	QSpinBox *homeSpin = nullptr;
-	QSpinBox *awaySpin = nullptr;
-	QToolButton *minusHome = nullptr;
-	QToolButton *plusHome = nullptr;
-	QToolButton *minusAway = nullptr;
-	QToolButton *plusAway = nullptr;
-};
+class FlyClientSession;
+class FlyThemeIndex;
+class FlyTemplateWatcher;
+class FlyIngestManager;
+struct FlyTemplateChange;
+struct FlyHttpRequest;
+struct FlyHttpResponse;
 
 struct FlySingleStatUi {
 	QWidget *row = nullptr;
@@ -49,18 +58,27 @@ struct FlyTimerUi {
 	QCheckBox *visibleCheck = nullptr;
 };
 
-struct FlyHotkeyBinding;
+// One bound action: a libobs frontend hotkey, or a QShortcut when the
+// sequence has no libobs key.
+struct FlyHotkeyRegistration {
+	FlyHotkeyBinding binding;
+	size_t obsId = ~size_t(0);
+	QShortcut *shortcut = nullptr;
+};
 
 class FlyScoreDock : public QWidget {
 	Q_OBJECT
 public:
 	explicit FlyScoreDock(QWidget *parent = nullptr);
 	~FlyScoreDock() override;
+	// Critical path during obs_module_load: state, UI shell and the servers.
 	bool init();
+	// The rest of startup, once OBS has finished loading; idempotent.
+	void finishStartup();
 
 	void refreshBrowserSourceCombo(bool preserveSelection = true);
 	QString selectedBrowserSourceName() const;
-	void updateBrowserSourceToCurrentResources();
+	void updateBrowserSourceToCurrentResources(bool forceReload = false);
 
 public slots:
 	void bumpCustomFieldHome(int index, int delta);
@@ -82,11 +100,31 @@ private slots:
 	void onOpenTeamsDialog();
 
 	void onSetTemplatesRoot();
+	void onForkBuiltInTemplate();
+	void onThemeIndexScanFinished();
+
+	void onAddBoard();
+	void onRemoveBoard();
+
+	void onToggleTracing(bool enabled);
+	void onDumpTrace();
+
+	void onAddIngestSource();
+	void rebuildIngestMenu();
+
+	void onSavePreset();
+	void rebuildPresetsMenu();
 
 private:
+	void runNextStartupStage();
+	void startThemeIndex();
+	void connectSourceSignals();
 	void loadState();
-	void saveState();
+	// undoable is false for feeds (ingest, set_timer keep_running): saved, but no history step.
+	void saveState(bool undoable = true);
 	void refreshUiFromState(bool onlyTimeIfRunning = false);
+	// In-place counterpart for value-only changes; rebuilds when the row counts differ.
+	void updateControlsFromState();
 	void clearAllCustomFieldRows();
 	void loadCustomFieldControlsFromState();
 	void syncCustomFieldControlsToState();
@@ -95,25 +133,66 @@ private:
 	void syncSingleStatControlsToState();
 	void clearAllTimerRows();
 	void loadTimerControlsFromState();
-	QList<FlyHotkeyBinding> buildDefaultHotkeyBindings() const;
 	QList<FlyHotkeyBinding> buildMergedHotkeyBindings() const;
-	void applyHotkeyBindings(const QList<FlyHotkeyBinding> &bindings);
-	void clearAllShortcuts();
+	void loadHotkeyBindings();
+	// persist writes hotkeys.json, and only when a sequence actually changed.
+	void applyHotkeyBindings(const QList<FlyHotkeyBinding> &bindings, bool persist = false);
+	void registerHotkey(const FlyHotkeyBinding &binding);
+	void onObsHotkeyRebound(const QString &actionId, const QKeySequence &seq);
+	void unregisterHotkey(const QString &actionId);
+	void clearAllHotkeys();
+	void runHotkeyAction(const FlyHotkeyAction &action, uint64_t pressedUs);
 	void refreshTemplateCombo(bool preserveSelection = true);
 	QString selectedTemplateName() const;
 	QString selectedTemplatePath() const;
 	void loadTemplateByPath(const QString &path);
+	void loadSelectedThemeIfValid();
+	bool hotSwapTemplate(const QString &path, const QString &name);
+	void onTemplateFilesChanged(const FlyTemplateChange &change);
 	void broadcastCurrentState();
 	void updateWebSocketStatus();
-	void handleRemoteCommand(const QJsonObject &command);
+	void updateIngestStatus();
+	void handleIngestBatch(const QString &boardId, const QList<QJsonObject> &commands);
+	void handleRemoteCommand(FlyClientSession *session, const QJsonObject &command);
+	void handleBoardCommand(FlyClientSession *session, const FlyBoard &board, const QString &action,
+				const QJsonObject &command);
+	void sendBoardState(FlyClientSession *session, const FlyBoard &board);
+	void collectUnusedLogos();
+	// /overlay/ serves the main board's template, /board/<id>/overlay/ the board's own.
+	void serveOverlayHttp(const FlyHttpRequest &req, FlyHttpResponse &res);
+	bool handlePresetCommand(const FlyBoard &board, const QString &action, const QJsonObject &command);
+	QVector<FlyPreset> &boardPresets(const FlyBoard &board);
+	void applyPreset(const FlyBoard &board, const QString &key);
+	void storePreset(const FlyBoard &board, FlyPreset preset);
+	void removePreset(const FlyBoard &board, const QString &key);
+	QString resolveTemplatePath(const QJsonObject &command) const;
+	const FlyBoard *findBoard(const QString &id) const;
+	bool isDefaultBoardActive() const;
+	FlyState &boardState(const FlyBoard &board);
+	// Commits, saves and broadcasts a board other than the active one.
+	void saveBoardState(const FlyBoard &board, bool undoable = true);
+	void broadcastBoardState(const QString &boardId);
+	void stepHistory(const FlyBoard &board, bool redo);
+	void updateHistoryButtons();
+	void refreshBoardCombo();
+	void switchBoard(const QString &boardId);
 	QWidget *widgetCarousel_ = nullptr;
 	QPushButton *toggleCarouselBtn_ = nullptr;
+	QAction *traceEnableAct_ = nullptr;
 	void toggleWidgetCarouselVisible();
 	void refreshWidgetCarouselToggleUi();
 
 private:
 	QString dataDir_;
+	QString stateDir_;
 	FlyState st_;
+	QString activeBoardId_;
+	QVector<FlyBoard> boards_;
+	QHash<QString, FlyState> boardStates_;
+	QHash<QString, QVector<FlyPreset>> boardPresets_;
+	QHash<QString, FlyHistory> histories_;
+	QComboBox *boardCombo_ = nullptr;
+	QToolButton *removeBoardBtn_ = nullptr;
 	QCheckBox *swapSides_ = nullptr;
 	QCheckBox *showScoreboard_ = nullptr;
 	QPushButton *teamsBtn_ = nullptr;
@@ -131,9 +210,26 @@ private:
 	QComboBox *templateCombo_ = nullptr;
 	QLabel *webSocketStatus_ = nullptr;
 	QPushButton *setTemplatesRootBtn_ = nullptr;
+	QPushButton *forkTemplateBtn_ = nullptr;
 	FlyScoreWebSocketServer *webSocketServer_ = nullptr;
+	FlyThemeIndex *themeIndex_ = nullptr;
+	FlyTemplateWatcher *templateWatcher_ = nullptr;
+	FlyIngestManager *ingest_ = nullptr;
+	FlyShmPublisher shm_;
+	QToolButton *ingestBtn_ = nullptr;
+	QToolButton *presetsBtn_ = nullptr;
+	QToolButton *undoBtn_ = nullptr;
+	QToolButton *redoBtn_ = nullptr;
+	quint64 assetRevision_ = 0;
+	bool selectFirstThemeAfterScan_ = false;
+	QString shellIndexPath_;
+	QString liveRuntimeHash_;
+	bool templateHotSwapped_ = false;
 	QList<FlyHotkeyBinding> hotkeyBindings_;
-	QList<QShortcut *> shortcuts_;
+	QHash<QString, FlyHotkeyRegistration> hotkeyRegs_;
+	bool startupStarted_ = false;
+	QList<std::pair<const char *, std::function<void()>>> startupStages_;
+	qint64 startupDeferredUs_ = 0;
 };
 
 void fly_create_dock();
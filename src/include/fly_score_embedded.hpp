@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+struct FlyHttpRequest;
+struct FlyHttpResponse;
+
+// The default template compiled into the plugin (EMBED_DEFAULT_ASSETS), kept
+// gzip-compressed with its original size and SHA-256.
+struct FlyEmbeddedAsset {
+	QString name;
+	// Points into the binary; no copy.
+	QByteArray gzip;
+	qsizetype size = 0;
+	QByteArray sha256;
+};
+
+bool fly_embedded_available();
+bool fly_embedded_find(const QString &name, FlyEmbeddedAsset &out);
+// Empty on a corrupt stream.
+QByteArray fly_embedded_inflate(const FlyEmbeddedAsset &asset);
+
+// Files of the built-in template; the locales stay embedded but are not part of it.
+QStringList fly_embedded_template_files();
+// Writes the built-in template files missing from dir; false when one could not be written.
+bool fly_embedded_extract_template(const QString &dir);
+
+// Answers GET /overlay/<file>: a file under root wins, otherwise the embedded
+// copy, passed through compressed when the client accepts gzip.
+void fly_overlay_http_serve(const QString &root, const FlyHttpRequest &req, FlyHttpResponse &res);
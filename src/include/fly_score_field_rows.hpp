@@ -0,0 +1,34 @@
+#pragma once
+
+#include <functional>
+
+#include <QList>
+
+#include "fly_score_state.hpp"
+
+class QWidget;
+class QBoxLayout;
+class QCheckBox;
+class QLabel;
+class QSpinBox;
+class QToolButton;
+
+struct FlyCustomFieldUi {
+	QWidget *row = nullptr;
+	QCheckBox *visibleCheck = nullptr;
+	QLabel *labelLbl = nullptr;
+	QSpinBox *homeSpin = nullptr;
+	QSpinBox *awaySpin = nullptr;
+	QToolButton *minusHome = nullptr;
+	QToolButton *plusHome = nullptr;
+	QToolButton *minusAway = nullptr;
+	QToolButton *plusAway = nullptr;
+};
+
+// Column captions shown above the custom field rows.
+QWidget *fly_custom_field_header_row(QWidget *parent);
+// One dock row for cf; onChanged runs after every edit made through it.
+FlyCustomFieldUi fly_custom_field_row(const FlyCustomField &cf, QWidget *parent, const std::function<void()> &onChanged);
+// Appends the header, one row per field and a trailing stretch to layout.
+QList<FlyCustomFieldUi> fly_custom_field_rows(QBoxLayout *layout, const QVector<FlyCustomField> &fields,
+					      QWidget *parent, const std::function<void()> &onChanged);
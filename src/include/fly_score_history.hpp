@@ -0,0 +1,44 @@
+#pragma once
+
+#include <QList>
+
+#include "fly_score_state.hpp"
+
+// Bounded undo/redo of committed board states. FlyState members are Qt
+// implicitly shared containers, so a snapshot only holds references: a step
+// owns a private copy of just the vectors and strings that changed in it
+// (one bumped field detaches custom_fields, the teams and timers stay shared).
+class FlyHistory {
+public:
+	static constexpr int kDefaultLimit = 1000;
+
+	explicit FlyHistory(int limit = kDefaultLimit) : limit_(limit) {}
+
+	bool hasBase() const { return hasBase_; }
+	// Sets the state later commits are compared against, once.
+	void begin(const FlyState &st);
+	// Drops every step and starts over from st, for a state reloaded from disk.
+	void reset(const FlyState &st);
+	// Records one step from the last committed state to st; false when nothing changed.
+	bool commit(const FlyState &st);
+	// Moves the base to st without a step, so changes that are not undoable
+	// (controller feeds) do not end up inside the next operator step.
+	void follow(const FlyState &st);
+
+	bool canUndo() const { return !undo_.isEmpty(); }
+	bool canRedo() const { return !redo_.isEmpty(); }
+	int undoCount() const { return int(undo_.size()); }
+	int redoCount() const { return int(redo_.size()); }
+
+	// Replace st with the previous / next committed state.
+	bool undo(FlyState &st);
+	bool redo(FlyState &st);
+	void clear();
+
+private:
+	int limit_;
+	bool hasBase_ = false;
+	FlyState current_;
+	QList<FlyState> undo_;
+	QList<FlyState> redo_;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QKeySequence>
+#include <QString>
+#include <QVector>
+
+#include "fly_score_presets.hpp"
+#include "fly_score_state.hpp"
+
+enum class FlyHotkeyKind {
+	None,
+	SwapSides,
+	ToggleScoreboard,
+	FieldToggle,
+	FieldHome,
+	FieldAway,
+	SingleToggle,
+	SingleBump,
+	TimerToggle,
+	Preset,
+	Undo,
+	Redo,
+};
+
+struct FlyHotkeyAction {
+	FlyHotkeyKind kind = FlyHotkeyKind::None;
+	int index = -1;
+	int delta = 0;
+	QString preset;
+
+	bool operator==(const FlyHotkeyAction &o) const
+	{
+		return kind == o.kind && index == o.index && delta == o.delta && preset == o.preset;
+	}
+	bool operator!=(const FlyHotkeyAction &o) const { return !(*this == o); }
+};
+
+struct FlyHotkeyBinding {
+	QString actionId;
+	QString label;
+	QKeySequence sequence;
+	// Filled by fly_hotkeys_default_bindings (and kept by fly_hotkeys_merge), so
+	// binding never has to parse actionId.
+	FlyHotkeyAction action;
+};
+
+// Every bindable action for st's rows and the board's presets, with empty sequences.
+QVector<FlyHotkeyBinding> fly_hotkeys_default_bindings(const FlyState &st,
+						       const QVector<FlyPreset> &presets = QVector<FlyPreset>());
+// defaults with the sequences of matching action ids taken from current.
+QVector<FlyHotkeyBinding> fly_hotkeys_merge(const QVector<FlyHotkeyBinding> &defaults,
+					    const QVector<FlyHotkeyBinding> &current);
+// Same action ids bound to the same sequences; unbound entries and order are ignored.
+bool fly_hotkeys_same_sequences(const QVector<FlyHotkeyBinding> &a, const QVector<FlyHotkeyBinding> &b);
+// Parses ids such as "field_2_home_inc", "timer_0_toggle" or "preset:halftime"; None when unknown.
+FlyHotkeyAction fly_hotkey_parse_action(const QString &actionId);
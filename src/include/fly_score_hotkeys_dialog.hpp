@@ -1,20 +1,15 @@
 #pragma once
 
 #include <QDialog>
-#include <QKeySequence>
 #include <QString>
 #include <QVector>
 
+#include "fly_score_hotkeys.hpp"
+
 class QKeySequenceEdit;
 class QPushButton;
 class QStackedWidget;
 
-struct FlyHotkeyBinding {
-	QString actionId;
-	QString label;
-	QKeySequence sequence;
-};
-
 class FlyHotkeysDialog : public QDialog {
 	Q_OBJECT
 public:
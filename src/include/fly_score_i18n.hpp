@@ -1,11 +1,30 @@
 #pragma once
 
-#include <obs-module.h>
-
 #include <QString>
 
+#ifdef FLY_SCORE_HEADLESS
+#include <QByteArray>
+#include <QHash>
+
+// No obs_module_text without libobs. Tools may fill this from a locale .ini;
+// otherwise the key doubles as the label.
+inline QHash<QByteArray, QString> &fly_i18n_headless_table()
+{
+	static QHash<QByteArray, QString> table;
+	return table;
+}
+
 inline QString fly_i18n(const char *key)
 {
-	return QString::fromUtf8(obs_module_text(key));
+	const auto &table = fly_i18n_headless_table();
+	const auto it = table.constFind(QByteArray(key));
+	return it != table.constEnd() ? it.value() : QString::fromUtf8(key);
 }
+#else
+#include <obs-module.h>
 
+inline QString fly_i18n(const char *key)
+{
+	return QString::fromUtf8(obs_module_text(key));
+}
+#endif
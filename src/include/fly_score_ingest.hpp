@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include <memory>
+#include <vector>
+
+class QTimer;
+class QUdpSocket;
+
+// Maps controller datagrams to ordinary remote commands (the objects the
+// WebSocket accepts), so hardware consoles reuse fly_apply_state_command().
+class FlyIngestAdapter {
+public:
+	virtual ~FlyIngestAdapter() = default;
+	virtual QString name() const = 0;
+	// Appends the commands carried by packet. Returns false when any part of it
+	// could not be understood; whatever did decode is still appended.
+	virtual bool decode(const QByteArray &packet, QList<QJsonObject> &commands) const = 0;
+};
+
+// "json": a command object or an array of them.
+// "text": key=value tokens separated by whitespace, ';' or ','. Keys take an
+//         optional index suffix (clock1, home2); without one they address index 0.
+//           home / away    set_score value
+//           clock          set_timer remaining_ms (keep_running); mm:ss[.t], h:mm:ss or plain ms
+//           running        1/0 -> timer_start / timer_pause, emitted after the clock
+//           single         set_single value
+QStringList fly_ingest_adapter_names();
+std::unique_ptr<FlyIngestAdapter> fly_ingest_make_adapter(const QString &name);
+
+// Collapses a burst of commands into the minimal ordered batch. Absolute
+// commands (set_*, timer_start/pause) for the same target merge into the first
+// slot, later keys winning; anything relative (bump_*, toggles, add/remove)
+// is kept and acts as a barrier so ordering semantics are preserved. A
+// set_timer without keep_running stops the clock, so it is a barrier too and
+// never moves across a start or pause.
+class FlyIngestCoalescer {
+public:
+	void add(const QJsonObject &command);
+	bool isEmpty() const { return batch_.isEmpty(); }
+	// Commands absorbed into an earlier slot since the last take().
+	int merged() const { return merged_; }
+	QList<QJsonObject> take();
+
+private:
+	QList<QJsonObject> batch_;
+	QHash<QString, int> slots_;
+	int merged_ = 0;
+};
+
+struct FlyIngestSourceConfig {
+	// Loopback unless the user opens the source to the network (e.g. 0.0.0.0).
+	QString address = QStringLiteral("127.0.0.1");
+	quint16 port = 0;
+	QString adapter;
+	QString board;
+
+	bool operator==(const FlyIngestSourceConfig &o) const
+	{
+		return address == o.address && port == o.port && adapter == o.adapter && board == o.board;
+	}
+};
+
+struct FlyIngestHealth {
+	FlyIngestSourceConfig config;
+	bool listening = false;
+	QString error;
+	quint64 packets = 0;
+	quint64 malformed = 0;
+	quint64 commands = 0;
+	qint64 lastPacketMs = 0;
+	QString lastSender;
+};
+
+// Owns one UDP socket per configured source and hands the dock at most one
+// coalesced batch per board every kIngestFlushMs, however fast controllers send.
+class FlyIngestManager : public QObject {
+	Q_OBJECT
+public:
+	explicit FlyIngestManager(QObject *parent = nullptr);
+	~FlyIngestManager() override;
+
+	// Rebinds only the sources that changed.
+	void setSources(const QVector<FlyIngestSourceConfig> &sources);
+	QVector<FlyIngestSourceConfig> sources() const;
+	QVector<FlyIngestHealth> health() const;
+
+signals:
+	void batchReady(const QString &board, const QList<QJsonObject> &commands);
+	void healthChanged();
+
+private:
+	struct Source {
+		FlyIngestHealth health;
+		std::unique_ptr<FlyIngestAdapter> adapter;
+		QUdpSocket *socket = nullptr;
+	};
+
+	void bind(Source &source);
+	void readPending(Source *source);
+	void flush();
+
+	std::vector<std::unique_ptr<Source>> sources_;
+	QHash<QString, FlyIngestCoalescer> pending_;
+	QTimer *flushTimer_ = nullptr;
+	QElapsedTimer sinceFlush_;
+};
@@ -1,11 +1,25 @@
 #pragma once
-#include <obs-module.h>
 #include "config.hpp"
 
 #ifndef LOG_TAG
 #define LOG_TAG "[" PLUGIN_NAME "]"
 #endif
 
+#ifdef FLY_SCORE_HEADLESS
+// Headless core (tools/benchmarks): no libobs, log to stderr.
+#include <cstdio>
+
+#define LOGI(fmt, ...) std::fprintf(stderr, "info: "    LOG_TAG " " fmt "\n", ##__VA_ARGS__)
+#define LOGW(fmt, ...) std::fprintf(stderr, "warning: " LOG_TAG " " fmt "\n", ##__VA_ARGS__)
+#define LOGE(fmt, ...) std::fprintf(stderr, "error: "   LOG_TAG " " fmt "\n", ##__VA_ARGS__)
+#define LOGD(...) do {} while (0)
+
+#define LOGI_T(tag, fmt, ...) std::fprintf(stderr, "info: [" tag "] " fmt "\n", ##__VA_ARGS__)
+#define LOGW_T(tag, fmt, ...) std::fprintf(stderr, "warning: [" tag "] " fmt "\n", ##__VA_ARGS__)
+#define LOGE_T(tag, fmt, ...) std::fprintf(stderr, "error: [" tag "] " fmt "\n", ##__VA_ARGS__)
+#else
+#include <obs-module.h>
+
 #define LOGI(fmt, ...) blog(LOG_INFO,    LOG_TAG " " fmt, ##__VA_ARGS__)
 #define LOGW(fmt, ...) blog(LOG_WARNING, LOG_TAG " " fmt, ##__VA_ARGS__)
 #define LOGE(fmt, ...) blog(LOG_ERROR,   LOG_TAG " " fmt, ##__VA_ARGS__)
@@ -19,3 +33,4 @@
 #define LOGI_T(tag, fmt, ...) blog(LOG_INFO,    "[" tag "] " fmt, ##__VA_ARGS__)
 #define LOGW_T(tag, fmt, ...) blog(LOG_WARNING, "[" tag "] " fmt, ##__VA_ARGS__)
 #define LOGE_T(tag, fmt, ...) blog(LOG_ERROR,   "[" tag "] " fmt, ##__VA_ARGS__)
+#endif
@@ -1,10 +1,41 @@
 #pragma once
+#include <QSize>
 #include <QString>
 
+#include <functional>
+
+struct FlyLogoIngestRequest {
+	QString source;
+	QString dataDir;
+	QString cacheDir;
+	QSize box;
+	bool keepOriginal = false;
+};
+
+struct FlyLogoIngestResult {
+	bool ok = false;
+	bool cached = false;
+	QString rel;
+	QString original;
+	QSize size;
+	QString error;
+};
+
 QString fly_normalized_ext_from_mime(const QString &path);
-QString fly_copy_logo_to_overlay(const QString &dataDir,
-                                 const QString &srcAbs,
-                                 const QString &baseName);
+
+QSize fly_logo_box_for_template(const QString &templatePath);
+QString fly_logo_cache_dir();
+
+// Decodes the source once, downsizes it to fit the template's logo box and stores
+// it in the template folder as logo-<content hash>.<webp|png>. Safe to run on the
+// thread pool; progress receives 0..100 from the worker thread.
+FlyLogoIngestResult fly_ingest_logo(const FlyLogoIngestRequest &request,
+				    const std::function<void(int)> &progress = {});
+
+// Removes logo-<hash> files in templateRoot that no state or preset file of
+// the template (plugin.json, presets.json, boards/<id>/...) mentions. Undo
+// history is not on disk, so run it before any board has history.
+int fly_logo_collect_garbage(const QString &templateRoot);
 
 bool fly_delete_logo_if_exists(const QString &dataDir,
                                const QString &relPath);
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Lock-free counters, gauges and log-linear latency histograms. All updates are
+// relaxed atomics so instrumentation can stay enabled in release builds.
+class FlyCounter {
+public:
+	void add(uint64_t n = 1) { v_.fetch_add(n, std::memory_order_relaxed); }
+	uint64_t value() const { return v_.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<uint64_t> v_{0};
+};
+
+class FlyGauge {
+public:
+	void set(int64_t v) { v_.store(v, std::memory_order_relaxed); }
+	void add(int64_t n) { v_.fetch_add(n, std::memory_order_relaxed); }
+	int64_t value() const { return v_.load(std::memory_order_relaxed); }
+
+private:
+	std::atomic<int64_t> v_{0};
+};
+
+// Microsecond histogram with 16 linear sub-buckets per power of two (~6%
+// relative error), covering 0 us to ~2^40 us.
+class FlyHistogram {
+public:
+	static constexpr int kSubBits = 4;
+	static constexpr int kSub = 1 << kSubBits;
+	static constexpr int kMaxExp = 40;
+	static constexpr int kBuckets = kSub + (kMaxExp - kSubBits) * kSub;
+
+	void record(uint64_t us);
+	uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+	// Approximate value at quantile q in [0, 1]; 0 when empty.
+	uint64_t percentile(double q) const;
+	QJsonObject toJson() const;
+
+private:
+	static int bucketFor(uint64_t us);
+	static uint64_t bucketMid(int idx);
+
+	std::array<std::atomic<uint64_t>, kBuckets> buckets_{};
+	std::atomic<uint64_t> count_{0};
+	std::atomic<uint64_t> sum_{0};
+	std::atomic<uint64_t> max_{0};
+};
+
+struct FlyMetrics {
+	FlyCounter stateSaves;
+	FlyCounter stateSaveFailures;
+	FlyCounter broadcasts;
+	FlyCounter broadcastsUnchanged;
+	FlyCounter clientsSkipped;
+	FlyCounter messagesSent;
+	FlyCounter bytesSent;
+	FlyCounter bytesReceived;
+	FlyCounter framesReceived;
+	FlyCounter commands;
+	FlyCounter commandsIgnored;
+	FlyCounter commandsRateLimited;
+	FlyCounter commandsCoalesced;
+	FlyCounter parseFailures;
+	FlyCounter templateScans;
+	FlyCounter derivedRecomputes;
+	FlyCounter ingestPackets;
+	FlyCounter ingestMalformed;
+	FlyCounter ingestCoalesced;
+	FlyGauge clients;
+	// Time spent inside obs_module_load, and in the stages deferred until OBS finished loading.
+	FlyGauge startupLoadUs;
+	FlyGauge startupDeferredUs;
+
+	FlyHistogram stateSaveUs;
+	FlyHistogram broadcastUs;
+	FlyHistogram processBufferUs;
+	FlyHistogram commandUs;
+	FlyHistogram refreshUiUs;
+	FlyHistogram templateScanUs;
+	// From an overlay's "rendered" echo: since the broadcast, and since the
+	// command/hotkey that caused it.
+	FlyHistogram broadcastToRenderUs;
+	FlyHistogram inputToRenderUs;
+};
+
+FlyMetrics &fly_metrics();
+QJsonObject fly_metrics_to_json();
+// Logs a one-line summary when anything happened since the previous call.
+void fly_metrics_log_summary();
+
+// Records the lifetime of the enclosing scope into a histogram.
+class FlyMetricsTimer {
+public:
+	explicit FlyMetricsTimer(FlyHistogram &h) : h_(h), start_(std::chrono::steady_clock::now()) {}
+	~FlyMetricsTimer()
+	{
+		const auto d = std::chrono::steady_clock::now() - start_;
+		h_.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(d).count()));
+	}
+	FlyMetricsTimer(const FlyMetricsTimer &) = delete;
+	FlyMetricsTimer &operator=(const FlyMetricsTimer &) = delete;
+
+private:
+	FlyHistogram &h_;
+	std::chrono::steady_clock::time_point start_;
+};
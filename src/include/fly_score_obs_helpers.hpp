@@ -8,3 +8,6 @@ bool fly_ensure_browser_source_in_current_scene(const QString &urlOrLocalIndex,
                                    const QString &browserSourceName = QString::fromUtf8(kBrowserSourceName));
 
 QStringList fly_list_browser_sources();
+QString fly_browser_source_local_file(const QString &browserSourceName);
+// Empty when the source shows a local file.
+QString fly_browser_source_url(const QString &browserSourceName);
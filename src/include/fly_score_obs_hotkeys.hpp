@@ -0,0 +1,28 @@
+#pragma once
+
+#include <QKeySequence>
+#include <QObject>
+#include <QString>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// libobs frontend hotkeys for the dock's bindings. They fire from OBS's
+// hotkey thread, so they work while OBS is unfocused; the press is handed to
+// receiver on its thread together with the time it was seen (trace clock, us).
+using FlyObsHotkeyHandler = std::function<void(uint64_t pressedUs)>;
+// A binding changed in OBS Settings > Hotkeys, delivered on receiver's thread;
+// empty when it was cleared there. Rebinding from the dock reports back too.
+using FlyObsHotkeyRebound = std::function<void(const QKeySequence &seq)>;
+
+inline constexpr size_t kFlyObsHotkeyInvalid = ~size_t(0);
+
+// True when the first chord of seq maps to a libobs key.
+bool fly_obs_hotkey_supported(const QKeySequence &seq);
+// Registers "fly_scoreboard.<actionId>" bound to seq; kFlyObsHotkeyInvalid on failure.
+size_t fly_obs_hotkey_register(const QString &actionId, const QString &label, const QKeySequence &seq,
+			       QObject *receiver, FlyObsHotkeyHandler handler, FlyObsHotkeyRebound rebound = {});
+bool fly_obs_hotkey_rebind(size_t id, const QKeySequence &seq);
+void fly_obs_hotkey_set_label(size_t id, const QString &label);
+void fly_obs_hotkey_unregister(size_t id);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "fly_score_state.hpp"
+
+// A named scene setup (halftime, overtime, intro) stored per board in
+// presets.json next to plugin.json:
+//   {"presets": [{"id": "halftime", "name": "Halftime",
+//                 "state": {...},          optional full snapshot
+//                 "commands": [{...}, ...] applied on top, in order}]}
+// Presets are validated and decoded when loaded; applying one builds the next
+// state off to the side and swaps it in, so the board is saved and broadcast once.
+struct FlyPresetCommand {
+	QString action;
+	QJsonObject command;
+};
+
+struct FlyPreset {
+	QString id;
+	QString name;
+	bool hasState = false;
+	FlyState state;
+	QVector<FlyPresetCommand> commands;
+};
+
+// Invalid presets are dropped; each gets an "id: reason" entry in errors.
+QVector<FlyPreset> fly_presets_load(const QString &stateDir, QStringList *errors = nullptr);
+bool fly_presets_save(const QString &stateDir, const QVector<FlyPreset> &presets);
+
+// Builds a preset from JSON (the file entry or a save_preset command).
+bool fly_preset_from_json(const QJsonObject &json, FlyPreset &preset, QString *error = nullptr);
+QJsonObject fly_preset_to_json(const FlyPreset &preset);
+// Snapshot of st with running timers paused, so re-applying it later does not
+// jump the clock by the time spent in between.
+FlyPreset fly_preset_capture(const QString &id, const QString &name, const FlyState &st, qint64 nowMs);
+
+// Matches the id, then the name case-insensitively.
+const FlyPreset *fly_preset_find(const QVector<FlyPreset> &presets, const QString &key);
+
+// Returns a FlyCommandEffect mask. st is replaced only when something applied.
+int fly_preset_apply(const FlyPreset &preset, FlyState &st, qint64 nowMs);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+// Players of both teams with per-player counters, stored column-wise: one int
+// column per stat instead of a struct (and a label string) per player. Stat
+// names are kept once in `stats`. Rows stay sorted by (team, number), and a
+// player is addressed by that pair.
+//
+// JSON: {"stats": [..], "team": [0|1, ..], "number": [..], "name": [..],
+//        "values": [[row values of stats[0]], [.. of stats[1]], ..]}
+struct FlyRoster {
+	QStringList stats;
+	QVector<int> team;
+	QVector<int> number;
+	QVector<QString> name;
+	// values[stat][row]
+	QVector<QVector<int>> values;
+
+	int rows() const { return int(number.size()); }
+	bool isEmpty() const { return stats.isEmpty() && number.isEmpty(); }
+
+	// -1 when absent. Stats match case-insensitively, or by numeric index.
+	int find(int team, int number) const;
+	int statIndex(const QString &stat) const;
+
+	// Inserts a zeroed row (or renames an existing player); returns the row.
+	int addPlayer(int team, int number, const QString &name);
+	bool removePlayer(int team, int number);
+	// Keeps the columns of stats that survive, zero-fills new ones.
+	void setStats(const QStringList &stats);
+	void resetValues();
+
+	// Same stats, players and names; only values may differ.
+	bool sameShape(const FlyRoster &other) const;
+	bool operator==(const FlyRoster &) const = default;
+};
+
+QJsonObject fly_roster_to_json(const FlyRoster &roster);
+FlyRoster fly_roster_from_json(const QJsonObject &json);
+
+// Up to n rows with the highest values of stat, ties broken by team and number.
+// team < 0 ranks both teams together.
+QVector<int> fly_roster_top(const FlyRoster &roster, int stat, int n, int team = -1);
+
+// Appends [row, stat, value] for every cell that differs. Returns false (and
+// appends nothing) when the shapes differ and a full roster must be sent.
+bool fly_roster_diff_cells(const FlyRoster &before, const FlyRoster &after, QJsonArray &cells);
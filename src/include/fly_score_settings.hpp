@@ -0,0 +1,56 @@
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QVariant>
+#include <QVariantMap>
+
+class QTimer;
+
+// The plugin settings (QSettings "MMLTech"/"fly-scoreboard"), read from disk
+// once and served from memory. Writes update memory immediately, notify
+// subscribers and reach the disk in batches on a background thread, so lookups
+// are cheap enough for source-signal handlers and other hot paths.
+// Use from the GUI thread only.
+class FlySettings : public QObject {
+	Q_OBJECT
+public:
+	// Writes within this window go out as one batch.
+	static constexpr int kFlushDelayMs = 500;
+
+	explicit FlySettings(QObject *parent = nullptr);
+	~FlySettings() override;
+
+	QVariant value(const QString &key, const QVariant &def = QVariant()) const;
+	QString string(const QString &key, const QString &def = QString()) const;
+	int integer(const QString &key, int def = 0) const;
+	// A QSettings array (beginReadArray); one map per row.
+	QList<QVariantMap> array(const QString &key) const;
+
+	void setValue(const QString &key, const QVariant &value);
+	// Removes key and everything below it.
+	void remove(const QString &key);
+	void setArray(const QString &key, const QList<QVariantMap> &rows);
+
+	// Writes pending changes and waits until they are on disk.
+	void sync();
+
+signals:
+	void changed(const QString &key);
+
+private:
+	void set(const QString &key, const QVariant &value);
+	bool erase(const QString &key);
+	void flush();
+
+	QHash<QString, QVariant> values_;
+	// Keys written since the last flush; an invalid QVariant removes the key.
+	QHash<QString, QVariant> pending_;
+	QTimer *flushTimer_ = nullptr;
+	QThreadPool writer_;
+};
+
+FlySettings &fly_settings();
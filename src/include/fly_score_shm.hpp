@@ -0,0 +1,120 @@
+#pragma once
+
+// Binary layout of the shared-memory state segment, for native consumers on
+// the same machine. Self-contained (no Qt, no plugin headers) so it can be
+// copied into another project as-is.
+//
+// The plugin is the only writer. It publishes under a seqlock: `seq` is odd
+// while a copy is in progress and bumped to the next even value once it is
+// done. Readers copy the state out and retry when `seq` was odd or moved; see
+// fly_shm_read_snapshot(). Strings are UTF-8, NUL-terminated and truncated to
+// fit. Timer times are epoch milliseconds: a running timer's current value is
+// remaining_ms -/+ (now - last_tick_ms) for countdown/countup.
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+static constexpr uint32_t kFlyShmMagic = 0x53594c46; // "FLYS"
+static constexpr uint32_t kFlyShmVersion = 1;
+static constexpr int kFlyShmText = 48;
+static constexpr int kFlyShmMaxFields = 32;
+static constexpr int kFlyShmMaxSingles = 16;
+static constexpr int kFlyShmMaxTimers = 8;
+
+struct FlyShmTeam {
+	char title[kFlyShmText];
+	char subtitle[kFlyShmText];
+	uint32_t color;
+	uint32_t reserved;
+};
+
+struct FlyShmField {
+	char label[kFlyShmText];
+	int32_t home;
+	int32_t away;
+	uint32_t visible;
+	uint32_t reserved;
+};
+
+struct FlyShmSingle {
+	char label[kFlyShmText];
+	int32_t value;
+	uint32_t visible;
+};
+
+struct FlyShmTimer {
+	char label[kFlyShmText];
+	uint32_t running;
+	uint32_t countup;
+	uint32_t visible;
+	uint32_t reserved;
+	int64_t initial_ms;
+	int64_t remaining_ms;
+	int64_t last_tick_ms;
+};
+
+struct FlyShmState {
+	// Bumped by the writer whenever the published content changes.
+	uint64_t rev;
+	char board[32];
+	uint32_t swap_sides;
+	uint32_t show_scoreboard;
+	FlyShmTeam home;
+	FlyShmTeam away;
+	// Rows past the limits are not published.
+	uint32_t field_count;
+	uint32_t single_count;
+	uint32_t timer_count;
+	uint32_t reserved;
+	FlyShmField fields[kFlyShmMaxFields];
+	FlyShmSingle singles[kFlyShmMaxSingles];
+	FlyShmTimer timers[kFlyShmMaxTimers];
+};
+
+struct FlyShmSegment {
+	uint32_t magic;
+	uint32_t version;
+	// sizeof(FlyShmSegment) as written; readers refuse a mismatch.
+	uint32_t size;
+	uint32_t reserved;
+	std::atomic<uint64_t> seq;
+	FlyShmState state;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "the seqlock needs a lock-free 64-bit atomic");
+
+inline bool fly_shm_segment_valid(const FlyShmSegment *seg)
+{
+	return seg && seg->magic == kFlyShmMagic && seg->version == kFlyShmVersion &&
+	       seg->size == sizeof(FlyShmSegment);
+}
+
+// Consistent copy of the published state. False when the segment is not valid
+// or the writer kept it busy for maxTries attempts (retry on the next frame).
+inline bool fly_shm_read_snapshot(const FlyShmSegment *seg, FlyShmState &out, int maxTries = 64)
+{
+	if (!fly_shm_segment_valid(seg))
+		return false;
+
+	for (int i = 0; i < maxTries; ++i) {
+		const uint64_t before = seg->seq.load(std::memory_order_acquire);
+		if (before & 1)
+			continue;
+		std::memcpy(&out, &seg->state, sizeof(FlyShmState));
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (seg->seq.load(std::memory_order_relaxed) == before)
+			return true;
+	}
+	return false;
+}
+
+// Writer side, used by the plugin.
+inline void fly_shm_write_snapshot(FlyShmSegment *seg, const FlyShmState &in)
+{
+	const uint64_t seq = seg->seq.load(std::memory_order_relaxed);
+	seg->seq.store(seq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(&seg->state, &in, sizeof(FlyShmState));
+	seg->seq.store(seq + 2, std::memory_order_release);
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QSharedMemory>
+#include <QString>
+
+#include "fly_score_shm.hpp"
+#include "fly_score_state.hpp"
+
+// Writes the active board into a named QSharedMemory segment laid out as
+// FlyShmSegment (fly_score_shm.hpp). Readers attach with QSharedMemory and the
+// same key; a publish that changes nothing leaves the segment untouched.
+class FlyShmPublisher {
+public:
+	FlyShmPublisher() = default;
+	FlyShmPublisher(const FlyShmPublisher &) = delete;
+	FlyShmPublisher &operator=(const FlyShmPublisher &) = delete;
+
+	// Creates the segment, or takes over one left behind by a previous run.
+	// An empty name just closes.
+	bool open(const QString &name);
+	void close();
+	bool isOpen() const { return segment_ != nullptr; }
+	QString name() const { return isOpen() ? mem_.key() : QString(); }
+	QString errorString() const { return error_; }
+
+	// One memcpy under the seqlock; false when closed or unchanged.
+	bool publish(const FlyState &st, const QString &board);
+
+private:
+	QSharedMemory mem_;
+	FlyShmSegment *segment_ = nullptr;
+	FlyShmState scratch_{};
+	FlyShmState last_{};
+	uint64_t rev_ = 0;
+	QString error_;
+};
+
+// Fills out from st; rows past the segment limits are dropped. out.rev is left alone.
+void fly_shm_fill_state(const FlyState &st, const QString &board, FlyShmState &out);
@@ -6,11 +6,15 @@
 #include <QByteArray>
 #include <string>
 
+#include "fly_score_roster.hpp"
+
 struct FlyTeam {
 	QString title;
 	QString subtitle;
 	QString logo;
 	uint32_t color = 0xFFFFFF;
+
+	bool operator==(const FlyTeam &) const = default;
 };
 
 struct FlyTimer {
@@ -21,6 +25,8 @@ struct FlyTimer {
 	long long remaining_ms = 0;
 	long long last_tick_ms = 0;
 	bool visible = true;
+
+	bool operator==(const FlyTimer &) const = default;
 };
 
 struct FlyCustomField {
@@ -28,12 +34,24 @@ struct FlyCustomField {
 	int  home    = 0;
 	int  away    = 0;
 	bool visible = true;
+
+	bool operator==(const FlyCustomField &) const = default;
 };
 
 struct FlySingleStat {
 	QString label;
 	int  value   = 0;
 	bool visible = true;
+
+	bool operator==(const FlySingleStat &) const = default;
+};
+
+// A computed value; see fly_score_derived.hpp for the expression syntax.
+struct FlyDerivedField {
+	QString id;
+	QString expr;
+
+	bool operator==(const FlyDerivedField &) const = default;
 };
 
 
@@ -47,6 +65,11 @@ struct FlyState {
 	QVector<FlyCustomField> custom_fields;
 	QVector<FlySingleStat> single_stats;
 	QVector<FlyTimer> timers;
+	QVector<FlyDerivedField> derived;
+	FlyRoster roster;
+
+	// Member-wise; unchanged implicitly shared vectors compare by pointer.
+	bool operator==(const FlyState &) const = default;
 };
 
 bool     fly_state_read_json(const std::string &base_dir, std::string &out_json);
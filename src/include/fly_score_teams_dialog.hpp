@@ -4,19 +4,27 @@
 #include <QString>
 
 #include "fly_score_state.hpp"
+#include "fly_score_logo_helpers.hpp"
 
+class QCheckBox;
 class QLineEdit;
+class QProgressBar;
 class QToolButton;
 class QPushButton;
+template<typename T> class QFutureWatcher;
 
 class FlyTeamsDialog : public QDialog {
     Q_OBJECT
 public:
-    explicit FlyTeamsDialog(const QString &dataDir,
-                            FlyState &state,
-                            QWidget *parent = nullptr);
+    FlyTeamsDialog(const QString &dataDir,
+                   const QString &stateDir,
+                   FlyState &state,
+                   QWidget *parent = nullptr);
     ~FlyTeamsDialog() override;
 
+public slots:
+    void reject() override;
+
 private slots:
     void onBrowseHomeLogo();
     void onBrowseAwayLogo();
@@ -28,9 +36,13 @@ private:
     void syncUiFromState();
     void syncStateFromUi();
     void updateColorButton(QToolButton *btn, uint32_t color);
+    void startLogoIngest(const QString &source, bool home);
+    void onLogoIngestFinished();
+    void setLogoBusy(bool busy);
 
 private:
     QString  dataDir_;
+    QString  stateDir_;
     FlyState &state_;
     QLineEdit   *homeTitle_  = nullptr;
     QLineEdit   *homeSub_    = nullptr;
@@ -43,4 +55,9 @@ private:
     QToolButton *awayBrowse_ = nullptr;
     QToolButton *awayColor_ = nullptr;
     QPushButton *applyBtn_   = nullptr;
+    QPushButton *closeBtn_   = nullptr;
+    QCheckBox   *keepOriginal_ = nullptr;
+    QProgressBar *logoProgress_ = nullptr;
+    QFutureWatcher<FlyLogoIngestResult> *logoWatcher_ = nullptr;
+    bool ingestHome_ = true;
 };
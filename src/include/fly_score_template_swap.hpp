@@ -0,0 +1,10 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+QString fly_template_runtime_hash(const QString &templatePath);
+QJsonObject fly_template_swap_message(const QString &templatePath, const QString &templateName);
+QJsonObject fly_template_asset_message(const QString &templatePath, const QStringList &styles,
+				       const QStringList &images, quint64 revision);
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+struct FlyTemplateChange {
+	QStringList styles;
+	QStringList images;
+	QStringList markup;
+	QStringList scripts;
+	QStringList other;
+
+	bool isEmpty() const
+	{
+		return styles.isEmpty() && images.isEmpty() && markup.isEmpty() && scripts.isEmpty() &&
+		       other.isEmpty();
+	}
+};
+
+// Watches the active template folder and reports debounced, classified file
+// changes. Files written by the plugin itself (plugin.json, hotkeys.json, presets.json, boards/) are ignored.
+class FlyTemplateWatcher : public QObject {
+	Q_OBJECT
+public:
+	explicit FlyTemplateWatcher(QObject *parent = nullptr);
+
+	void setPath(const QString &templatePath);
+	QString path() const { return path_; }
+
+signals:
+	void templateChanged(const FlyTemplateChange &change);
+
+private:
+	struct FileStamp {
+		qint64 mtime = -1;
+		qint64 size = -1;
+	};
+
+	void snapshot(QHash<QString, FileStamp> &files, QStringList &dirs) const;
+	void updateWatches(const QHash<QString, FileStamp> &files, const QStringList &dirs);
+	void flush();
+
+	QString path_;
+	QHash<QString, FileStamp> files_;
+	QFileSystemWatcher *watcher_ = nullptr;
+	QTimer *debounce_ = nullptr;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <QFuture>
+#include <QObject>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class QFileSystemWatcher;
+class QTimer;
+
+struct FlyThemeManifest {
+	QString title;
+	QString author;
+	QString authorUrl;
+	QString description;
+	QString version;
+	int logoWidth = 0;
+	int logoHeight = 0;
+};
+
+struct FlyThemeInfo {
+	FlyThemeManifest manifest;
+	QString path;
+	QString folderName;
+	bool hasIndex = false;
+	bool hasManifest = false;
+	bool manifestOk = false;
+	bool valid = false;
+	qint64 indexMtime = -1;
+	qint64 manifestMtime = -1;
+};
+
+FlyThemeInfo fly_read_theme_info(const QString &themePath);
+QString fly_theme_info_error(const FlyThemeInfo &info);
+QString fly_theme_tooltip(const FlyThemeManifest &manifest);
+
+// Persistent path -> mtime -> manifest cache of theme folders. Scans run on the
+// thread pool and a QFileSystemWatcher schedules rescans when folders change.
+class FlyThemeIndex : public QObject {
+	Q_OBJECT
+public:
+	explicit FlyThemeIndex(const QString &cacheFile, QObject *parent = nullptr);
+	~FlyThemeIndex() override;
+
+	void setRoots(const QStringList &roots);
+	QStringList roots() const;
+
+	QVector<FlyThemeInfo> themes() const;
+	FlyThemeInfo info(const QString &themePath) const;
+
+	void rescan();
+	bool isScanning() const;
+
+signals:
+	void themesChanged();
+	void scanFinished();
+
+private:
+	struct ScanResult {
+		quint64 generation = 0;
+		QHash<QString, FlyThemeInfo> cache;
+		QStringList watchDirs;
+		QStringList watchFiles;
+		bool changed = false;
+	};
+
+	static ScanResult scan(quint64 generation, const QStringList &roots, QHash<QString, FlyThemeInfo> cache,
+			       const QString &cacheFile);
+	void onScanFinished(const ScanResult &result);
+	void loadCache();
+	void updateWatches(const QStringList &dirs, const QStringList &files);
+
+	QString cacheFile_;
+	QStringList roots_;
+	QHash<QString, FlyThemeInfo> cache_;
+	QFileSystemWatcher *watcher_ = nullptr;
+	QTimer *rescanTimer_ = nullptr;
+	QFuture<ScanResult> scanFuture_;
+	quint64 generation_ = 0;
+	bool scanning_ = false;
+	bool rescanPending_ = false;
+};
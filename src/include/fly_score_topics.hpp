@@ -0,0 +1,20 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QJsonValue>
+#include <QString>
+#include <QStringList>
+
+// State topics a WebSocket client can subscribe to in its hello message. Each
+// topic expands to JSON pointers into the serialized state; a raw pointer such
+// as "/home/title" is accepted as-is. Returns an empty list for unknown topics.
+QStringList fly_topic_pointers(const QString &topic);
+QStringList fly_topic_pointers(const QStringList &topics);
+
+QJsonValue fly_json_pointer_value(const QJsonObject &root, const QString &pointer);
+bool fly_json_pointer_changed(const QJsonObject &before, const QJsonObject &after, const QString &pointer);
+
+// Copies only the top-level members addressed by pointers. Deeper pointers narrow
+// when a client is sent an update, not what it is sent: partial states are merged
+// member by member on the client, so a member is always sent whole.
+QJsonObject fly_state_slice(const QJsonObject &state, const QStringList &pointers);
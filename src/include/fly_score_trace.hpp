@@ -0,0 +1,63 @@
+#pragma once
+
+#include "config.hpp"
+
+#include <QString>
+
+#include <atomic>
+#include <cstdint>
+
+// Runtime-toggled span tracing into a bounded ring buffer, dumped as Chrome
+// trace-event JSON (loadable in Perfetto / chrome://tracing). Timestamps use
+// the libobs clock so spans line up with OBS's own profiler. When disabled a
+// span costs one relaxed atomic load.
+
+extern std::atomic<bool> g_fly_trace_enabled;
+
+inline bool fly_trace_enabled()
+{
+	return g_fly_trace_enabled.load(std::memory_order_relaxed);
+}
+
+// Monotonic libobs clock (os_gettime_ns) in microseconds.
+uint64_t fly_trace_now_us();
+
+void fly_trace_set_enabled(bool enabled);
+int fly_trace_event_count();
+void fly_trace_clear();
+// Writes the buffered spans to path, or to <config>/traces/ when empty.
+// Returns the written file, or an empty string on failure.
+QString fly_trace_dump(const QString &path = QString());
+
+// name and category must be string literals (or otherwise outlive the trace).
+class FlyTraceScope {
+public:
+	FlyTraceScope(const char *category, const char *name)
+	{
+		if (fly_trace_enabled()) {
+			category_ = category;
+			name_ = name;
+			startUs_ = fly_trace_now_us();
+		}
+	}
+	~FlyTraceScope()
+	{
+		if (name_)
+			finish();
+	}
+	FlyTraceScope(const FlyTraceScope &) = delete;
+	FlyTraceScope &operator=(const FlyTraceScope &) = delete;
+
+private:
+	void finish();
+
+	const char *category_ = nullptr;
+	const char *name_ = nullptr;
+	uint64_t startUs_ = 0;
+};
+
+#define FLY_TRACE_CONCAT_INNER(a, b) a##b
+#define FLY_TRACE_CONCAT(a, b) FLY_TRACE_CONCAT_INNER(a, b)
+#define FLY_TRACE_SCOPE_CAT(category, name) \
+	FlyTraceScope FLY_TRACE_CONCAT(fly_trace_scope_, __LINE__)(category, name)
+#define FLY_TRACE_SCOPE(name) FLY_TRACE_SCOPE_CAT(PLUGIN_NAME, name)
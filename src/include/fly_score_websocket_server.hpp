@@ -1,15 +1,93 @@
 #pragma once
 
 #include <QObject>
+#include <QHostAddress>
 #include <QJsonObject>
 #include <QHash>
 #include <QList>
+#include <QSet>
 #include <QString>
+#include <QStringList>
 
+#include <functional>
+
+#include "fly_score_derived.hpp"
 #include "fly_score_state.hpp"
 
+class QIODevice;
+class QLocalServer;
 class QTcpServer;
-class QTcpSocket;
+
+// One client connection and what its hello announced. Owned by the server
+// and handed out with every command, so request/response actions (get_state,
+// get_metrics, errors) reply to the sender instead of every client.
+class FlyClientSession : public QObject {
+	Q_OBJECT
+public:
+	enum class Transport {
+		WebSocket,
+		// QLocalSocket: each message is a 4-byte big-endian length + UTF-8 JSON.
+		Local,
+	};
+
+	FlyClientSession(QIODevice *socket, Transport transport, quint64 id, QObject *parent = nullptr);
+
+	quint64 id() const { return id_; }
+	Transport transport() const { return transport_; }
+	QString board() const { return board_; }
+	bool isObsOverlay() const { return obs_; }
+	bool hasCapability(const QString &capability) const { return capabilities_.contains(capability); }
+	// JSON pointers the client subscribed to; empty means the full state.
+	const QStringList &topics() const { return topics_; }
+	bool isOpen() const;
+
+	void sendText(const QString &message);
+	void sendJson(const QJsonObject &message);
+	void close();
+
+private:
+	friend class FlyScoreWebSocketServer;
+
+	// While corked, replies are collected and written in one go on uncork().
+	void cork() { ++corked_; }
+	void uncork();
+
+	QIODevice *socket_ = nullptr;
+	Transport transport_ = Transport::WebSocket;
+	quint64 id_ = 0;
+	QByteArray buffer_;
+	int corked_ = 0;
+	QByteArray pending_;
+	bool handshaken_ = false;
+	// Command token bucket; filled to the burst on first use.
+	double tokens_ = -1.0;
+	uint64_t tokensUs_ = 0;
+	quint64 rejectedStreak_ = 0;
+	bool obs_ = false;
+	QString board_;
+	QSet<QString> capabilities_;
+	QStringList topics_;
+};
+
+// Plain HTTP GET/HEAD on the WebSocket port (no Upgrade header), answered once
+// and closed. The dock uses it to serve the overlay from memory.
+struct FlyHttpRequest {
+	QByteArray method;
+	QString path;
+	bool acceptGzip = false;
+	QByteArray ifNoneMatch;
+};
+
+struct FlyHttpResponse {
+	int status = 404;
+	QByteArray contentType;
+	QByteArray body;
+	// body is already gzip-compressed; sent with Content-Encoding: gzip.
+	bool gzip = false;
+	QByteArray etag;
+};
+
+using FlyHttpHandler = std::function<void(const FlyHttpRequest &, FlyHttpResponse &)>;
 
 class FlyScoreWebSocketServer : public QObject {
 	Q_OBJECT
@@ -17,34 +95,128 @@ public:
 	explicit FlyScoreWebSocketServer(QObject *parent = nullptr);
 	~FlyScoreWebSocketServer() override;
 
-	bool start(quint16 port);
+	// The plugin only listens on loopback; the relay passes an external address.
+	bool start(quint16 port, const QHostAddress &address = QHostAddress(QHostAddress::LocalHost));
+	// Local control channel (Unix socket / named pipe) sharing the sessions and
+	// the command path. Call after start(); stop() closes both listeners.
+	bool listenLocal(const QString &name);
 	void stop();
+	// Either transport is accepting clients.
 	bool isListening() const;
+	bool isWebSocketListening() const;
+	QString localServerName() const;
 	quint16 port() const;
 	QString url() const;
 	int clientCount() const;
+	bool hasOverlayWithCapability(const QString &capability, const QString &board = QString()) const;
 
-	void broadcastState(const FlyState &state, const QString &templateName, const QString &templatePath);
-	void sendState(QTcpSocket *client, const FlyState &state, const QString &templateName,
-		       const QString &templatePath);
+	void broadcastState(const FlyState &state, const QString &templateName, const QString &templatePath,
+			    const QString &board);
+	// Reply to one client only, sliced to its topics; does not bump the revision.
+	void sendState(FlyClientSession *session, const FlyState &state, const QString &templateName,
+		       const QString &templatePath, const QString &board);
+	// Fans out a state that was serialized (and revisioned) elsewhere, as the
+	// relay does with its upstream; rev replaces this server's counter.
+	void relayState(const QJsonObject &state, quint64 rev, const QString &templateName,
+			const QString &templatePath, const QString &board);
+	// Replies with the last broadcast for board, sliced to the client's topics.
+	bool sendLastState(FlyClientSession *session, const QString &board);
+	// An empty board sends to every client; a capability limits it to clients
+	// that advertised it in their hello.
+	void broadcastMessage(const QJsonObject &message, const QString &board = QString(),
+			      const QString &capability = QString());
+	void setHttpHandler(FlyHttpHandler handler) { httpHandler_ = std::move(handler); }
+	// Per-session command limit: burst commands at once, refilled at perSecond.
+	// perSecond <= 0 turns limiting off.
+	void setRateLimit(int burst, double perSecond);
+	// When off, get_metrics, trace_enable and dump_trace are not answered here
+	// and reach commandReceived like any other command.
+	void setAdminActions(bool enabled) { adminActions_ = enabled; }
+	// Stamps a local input (hotkey) so the broadcast it causes gets an input time;
+	// 0 means now.
+	void markInput(uint64_t us = 0);
 
 signals:
-	void commandReceived(const QJsonObject &command);
+	// session is valid for the duration of the handler only.
+	void commandReceived(FlyClientSession *session, const QJsonObject &command);
 	void statusChanged();
+	void tracingChanged();
 
 private:
 	void onNewConnection();
-	void onReadyRead();
-	void removeClient(QObject *client);
-	void processBuffer(QTcpSocket *client);
-	void handleTextMessage(const QString &message);
-	void sendText(QTcpSocket *client, const QString &message);
-	QJsonObject makeStateEnvelope(const FlyState &state, const QString &templateName,
-				      const QString &templatePath) const;
+	void onNewLocalConnection();
+	void addSession(FlyClientSession *session);
+	void onReadyRead(FlyClientSession *session);
+	void removeSession(FlyClientSession *session);
+	void processBuffer(FlyClientSession *session);
+	void handleHttp(FlyClientSession *session, const QByteArray &header);
+	// One read's worth of text messages; consecutive set_* commands for the
+	// same target are folded into the last one.
+	void handleTextMessages(FlyClientSession *session, const QList<QByteArray> &messages);
+	// Returns the command's ack (sent only when it has an id), or empty for
+	// messages that are not state commands.
+	QJsonObject handleMessage(FlyClientSession *session, QJsonObject obj);
+	bool takeCommandToken(FlyClientSession *session, uint64_t nowUs, qint64 &retryAfterMs);
+	QJsonObject rejectRateLimited(FlyClientSession *session, const QJsonObject &obj, qint64 retryAfterMs);
+	void handleHello(FlyClientSession *session, const QJsonObject &hello);
+	void handleRendered(FlyClientSession *session, const QJsonObject &rendered);
+	void setClientTopics(FlyClientSession *session, const QJsonValue &topics);
+	bool clientOnBoard(const FlyClientSession *session, const QString &board) const;
+	QString targetBoard(const FlyClientSession *session, const QJsonObject &message) const;
+	QJsonObject makeStateEnvelope(const QJsonObject &state, const QString &templateName,
+				      const QString &templatePath, const QString &board = QString()) const;
+	quint64 revision(const QString &board) const;
+	// Reply to get_leaders: top-N players of a roster stat on the client's board.
+	QJsonObject leaders(FlyClientSession *session, const QJsonObject &request) const;
+	void insertDerivedValues(QJsonObject &json, const FlyState &state, const QString &boardKey);
+	// Shared tail of broadcastState/relayState; rev 0 bumps the board's own revision.
+	void publishState(const QJsonObject &json, const FlyRoster &roster, const QString &templateName,
+			  const QString &templatePath, const QString &board, quint64 rev, uint64_t appliedUs);
+
+	struct BoardSnapshot {
+		QJsonObject state;
+		QString templateName;
+		QString templatePath;
+		FlyRoster roster;
+	};
 
 	QTcpServer *server_ = nullptr;
-	QList<QTcpSocket *> clients_;
-	QHash<QTcpSocket *, QByteArray> buffers_;
-	QHash<QTcpSocket *, bool> handshaken_;
+	QLocalServer *localServer_ = nullptr;
+	QList<FlyClientSession *> sessions_;
+	quint64 nextSessionId_ = 0;
+	QHash<QString, BoardSnapshot> lastStates_;
+	// Derived-field DAG per board, kept so updates recompute incrementally.
+	QHash<QString, FlyDerivedEngine> derived_;
+
+	// Per-board state revision, bumped whenever a broadcast carries a change.
+	// Recent revisions keep their command receive / broadcast times (libobs
+	// clock, us) so "rendered" echoes can be turned into latency samples.
+	struct RevisionStamp {
+		quint64 rev = 0;
+		uint64_t receivedUs = 0;
+		uint64_t broadcastUs = 0;
+		bool rendered = false;
+	};
+	QHash<QString, quint64> revisions_;
+	QHash<QString, QList<RevisionStamp>> revisionStamps_;
+
+	// Pushed while commandReceived is being handled, so the broadcast it causes
+	// can be attributed to the command (and its ack). A stack, because handlers
+	// may run nested event loops that handle further commands.
+	struct CommandContext {
+		uint64_t receivedUs = 0;
+		uint64_t appliedUs = 0;
+		uint64_t broadcastUs = 0;
+		QString board;
+		quint64 rev = 0;
+		bool changed = false;
+	};
+	QList<CommandContext> commands_;
+	uint64_t inputUs_ = 0;
 	quint16 port_ = 4457;
+	QHostAddress address_ = QHostAddress(QHostAddress::LocalHost);
+	FlyHttpHandler httpHandler_;
+	int rateBurst_ = 0;
+	double ratePerSec_ = 0.0;
+	bool adminActions_ = true;
 };
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// RFC 6455 framing shared by the server, the load generator and the benchmarks.
+// Only single-fragment frames are produced; the server never fragments and
+// ignores continuation frames. The local control channel uses a plain 4-byte
+// big-endian length prefix instead.
+
+enum class FlyWsDecode {
+	Frame,
+	Incomplete,
+	TooLarge,
+};
+
+struct FlyWsFrame {
+	quint8 opcode = 0;
+	QByteArray payload;
+};
+
+// Builds a final frame. Clients must pass a 4-byte mask; servers pass nullptr.
+QByteArray fly_ws_encode_frame(const QByteArray &payload, quint8 opcode = 0x1, const quint8 *mask = nullptr);
+
+// Decodes the frame starting at buffer[pos]. On Frame, pos is advanced past it
+// and the payload is unmasked; otherwise pos is left untouched. Callers drop
+// the consumed prefix once, after draining every complete frame.
+FlyWsDecode fly_ws_decode_frame(const QByteArray &buffer, qsizetype &pos, FlyWsFrame &frame, quint64 maxPayload);
+
+// Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key.
+QByteArray fly_ws_accept_key(const QByteArray &clientKey);
+
+// Local channel: same draining contract as fly_ws_decode_frame.
+QByteArray fly_local_encode_frame(const QByteArray &payload);
+FlyWsDecode fly_local_decode_frame(const QByteArray &buffer, qsizetype &pos, QByteArray &payload, quint64 maxPayload);
@@ -0,0 +1,743 @@
+// fly-score-bench: microbenchmarks for the plugin's hot functions.
+//
+// Covers the state codec, the WebSocket frame codec, command dispatch, derived
+// values, controller ingest, rosters, presets, undo history, shared-memory
+// publishing, hotkey binding merges and the dock's custom-field row rebuild (on
+// the offscreen QPA).
+// Each case grows a batch until it fills one sample slot, then times a fixed
+// number of batches; medians are reported per operation. --json writes the
+// results for diffing between releases, --baseline compares against such a
+// file and --fail-regression turns a slowdown into a non-zero exit code.
+
+#include "config.hpp"
+#include "fly_score_commands.hpp"
+#include "fly_score_derived.hpp"
+#include "fly_score_field_rows.hpp"
+#include "fly_score_history.hpp"
+#include "fly_score_hotkeys.hpp"
+#include "fly_score_i18n.hpp"
+#include "fly_score_ingest.hpp"
+#include "fly_score_presets.hpp"
+#include "fly_score_roster.hpp"
+#include "fly_score_shm_publisher.hpp"
+#include "fly_score_state.hpp"
+#include "fly_score_ws_frame.hpp"
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QLayoutItem>
+#include <QRegularExpression>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QVBoxLayout>
+#include <QVector>
+#include <QWidget>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+static volatile uint64_t g_sink = 0;
+
+struct FlyBenchOptions {
+	int minTimeMs = 300;
+	int samples = 15;
+	QRegularExpression filter;
+	QString jsonPath;
+	QString baselinePath;
+	double failRegressionPct = 0.0;
+};
+
+struct FlyBenchResult {
+	QString name;
+	QJsonObject params;
+	quint64 iterations = 0;
+	double medianNs = 0;
+	double minNs = 0;
+	double meanNs = 0;
+	double madNs = 0;
+	double bytesPerOp = 0;
+};
+
+class FlyBench {
+public:
+	explicit FlyBench(const FlyBenchOptions &opt) : opt_(opt) {}
+
+	const QVector<FlyBenchResult> &results() const { return results_; }
+
+	// op returns something derived from its work so it cannot be elided.
+	template<class Op> void run(const QString &name, const QJsonObject &params, Op &&op, double bytesPerOp = 0)
+	{
+		const QString id = fly_bench_id(name, params);
+		if (opt_.filter.isValid() && !opt_.filter.pattern().isEmpty() && !opt_.filter.match(id).hasMatch())
+			return;
+
+		const qint64 slotNs = qint64(opt_.minTimeMs) * 1000000 / qMax(1, opt_.samples);
+		quint64 batch = 1;
+		for (;;) {
+			const qint64 ns = timeBatch(op, batch);
+			if (ns >= slotNs || batch >= (quint64(1) << 40))
+				break;
+			// Aim straight for the slot instead of doubling blindly.
+			const double scale = ns > 0 ? double(slotNs) / double(ns) : 16.0;
+			batch = std::max<quint64>(batch + 1, quint64(double(batch) * std::min(16.0, scale * 1.1)));
+		}
+
+		std::vector<double> perOp;
+		perOp.reserve(size_t(opt_.samples));
+		for (int i = 0; i < opt_.samples; ++i)
+			perOp.push_back(double(timeBatch(op, batch)) / double(batch));
+
+		std::sort(perOp.begin(), perOp.end());
+		FlyBenchResult r;
+		r.name = id;
+		r.params = params;
+		r.iterations = batch * quint64(opt_.samples);
+		r.medianNs = fly_bench_median(perOp);
+		r.minNs = perOp.front();
+		double sum = 0;
+		for (double v : perOp)
+			sum += v;
+		r.meanNs = sum / double(perOp.size());
+		std::vector<double> dev;
+		dev.reserve(perOp.size());
+		for (double v : perOp)
+			dev.push_back(std::fabs(v - r.medianNs));
+		std::sort(dev.begin(), dev.end());
+		r.madNs = fly_bench_median(dev);
+		r.bytesPerOp = bytesPerOp;
+
+		std::printf("%-48s %12s/op  (min %s, mad %4.1f%%, %llu iters)\n", id.toUtf8().constData(),
+			    fly_bench_time(r.medianNs).toUtf8().constData(), fly_bench_time(r.minNs).toUtf8().constData(),
+			    r.medianNs > 0 ? 100.0 * r.madNs / r.medianNs : 0.0, (unsigned long long)r.iterations);
+		std::fflush(stdout);
+		results_.push_back(r);
+	}
+
+	static QString fly_bench_id(const QString &name, const QJsonObject &params)
+	{
+		QStringList parts;
+		for (auto it = params.constBegin(); it != params.constEnd(); ++it)
+			parts << QStringLiteral("%1=%2").arg(it.key(), it.value().isString()
+										 ? it.value().toString()
+										 : QString::number(it.value().toDouble()));
+		return parts.isEmpty() ? name : name + QLatin1Char('/') + parts.join(QLatin1Char(','));
+	}
+
+	static QString fly_bench_time(double ns)
+	{
+		if (ns < 1e3)
+			return QStringLiteral("%1 ns").arg(ns, 0, 'f', 1);
+		if (ns < 1e6)
+			return QStringLiteral("%1 us").arg(ns / 1e3, 0, 'f', 2);
+		return QStringLiteral("%1 ms").arg(ns / 1e6, 0, 'f', 2);
+	}
+
+private:
+	template<class Op> static qint64 timeBatch(Op &op, quint64 batch)
+	{
+		uint64_t acc = 0;
+		QElapsedTimer t;
+		t.start();
+		for (quint64 i = 0; i < batch; ++i)
+			acc += static_cast<uint64_t>(op());
+		const qint64 ns = t.nsecsElapsed();
+		g_sink = g_sink + acc;
+		return ns;
+	}
+
+	static double fly_bench_median(const std::vector<double> &sorted)
+	{
+		const size_t n = sorted.size();
+		if (n == 0)
+			return 0;
+		return n % 2 ? sorted[n / 2] : 0.5 * (sorted[n / 2 - 1] + sorted[n / 2]);
+	}
+
+	FlyBenchOptions opt_;
+	QVector<FlyBenchResult> results_;
+};
+
+// ---------------------------------------------------------------------------
+// Fixtures
+// ---------------------------------------------------------------------------
+static FlyState fly_bench_state(int fields)
+{
+	FlyState st = fly_state_make_defaults();
+	st.home.title = QStringLiteral("Home Team");
+	st.home.subtitle = QStringLiteral("City");
+	st.away.title = QStringLiteral("Guests Team");
+	st.away.subtitle = QStringLiteral("Town");
+
+	st.custom_fields.clear();
+	st.custom_fields.reserve(fields);
+	for (int i = 0; i < fields; ++i)
+		st.custom_fields.push_back({QStringLiteral("Field %1").arg(i + 1), i, 2 * i, i % 3 != 0});
+
+	st.single_stats.clear();
+	for (int i = 0; i < 4; ++i)
+		st.single_stats.push_back({QStringLiteral("Stat %1").arg(i + 1), i * 7, true});
+
+	st.timers.clear();
+	for (int i = 0; i < 2; ++i) {
+		FlyTimer t;
+		t.label = QStringLiteral("Timer %1").arg(i + 1);
+		t.mode = i == 0 ? QStringLiteral("countdown") : QStringLiteral("countup");
+		t.initial_ms = 20 * 60 * 1000;
+		t.remaining_ms = t.initial_ms;
+		st.timers.push_back(t);
+	}
+	return st;
+}
+
+// Both teams with `players` each and basketball-style counters.
+static FlyRoster fly_bench_roster(int players)
+{
+	FlyRoster roster;
+	roster.setStats({QStringLiteral("points"), QStringLiteral("rebounds"), QStringLiteral("assists"),
+			 QStringLiteral("fouls")});
+	for (int team = 0; team < 2; ++team) {
+		for (int i = 0; i < players; ++i) {
+			const int row = roster.addPlayer(team, 4 + i, QStringLiteral("Player %1").arg(i + 1));
+			for (int s = 0; s < roster.stats.size(); ++s)
+				roster.values[s][row] = (i * 7 + s * 3 + team) % 31;
+		}
+	}
+	return roster;
+}
+
+static QByteArray fly_bench_payload(int size)
+{
+	QByteArray p(size, 'x');
+	for (int i = 0; i < size; ++i)
+		p[i] = char('a' + i % 26);
+	return p;
+}
+
+static QVector<FlyHotkeyBinding> fly_bench_bound_hotkeys(const FlyState &st)
+{
+	QVector<FlyHotkeyBinding> b = fly_hotkeys_default_bindings(st);
+	for (int i = 0; i < b.size(); ++i)
+		b[i].sequence = QKeySequence(QStringLiteral("Ctrl+Alt+Shift+F%1").arg(1 + i % 12));
+	return b;
+}
+
+// The dock's rebuild minus its deferred deletion of the old rows.
+static int fly_bench_rebuild_field_rows(QWidget *host, QVBoxLayout *layout, const FlyState &st)
+{
+	while (QLayoutItem *item = layout->takeAt(0)) {
+		delete item->widget();
+		delete item;
+	}
+
+	return int(fly_custom_field_rows(layout, st.custom_fields, host, []() { g_sink = g_sink + 1; }).size());
+}
+
+static void fly_bench_load_locale()
+{
+	QFile f(QStringLiteral(FLY_SCORE_LOCALE_DIR "/en-US.ini"));
+	if (!f.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		std::fprintf(stderr, "warning: %s not found, labels fall back to keys\n",
+			     f.fileName().toUtf8().constData());
+		return;
+	}
+
+	auto &table = fly_i18n_headless_table();
+	QTextStream in(&f);
+	while (!in.atEnd()) {
+		const QString line = in.readLine().trimmed();
+		const int eq = line.indexOf(QLatin1Char('='));
+		if (line.isEmpty() || line.startsWith(QLatin1Char(';')) || eq <= 0)
+			continue;
+		QString value = line.mid(eq + 1).trimmed();
+		if (value.size() >= 2 && value.startsWith(QLatin1Char('"')) && value.endsWith(QLatin1Char('"')))
+			value = value.mid(1, value.size() - 2);
+		table.insert(line.left(eq).trimmed().toUtf8(), value.replace(QLatin1String("\\n"), QLatin1String("\n")));
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Cases
+// ---------------------------------------------------------------------------
+static void fly_bench_state_codec(FlyBench &bench)
+{
+	for (int fields : {1, 10, 100, 1000}) {
+		const QJsonObject params{{QStringLiteral("fields"), fields}};
+		const FlyState st = fly_bench_state(fields);
+		const QJsonObject obj = fly_state_to_json_object(st);
+		const QByteArray text = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+
+		bench.run(QStringLiteral("state.to_json"), params, [&]() { return fly_state_to_json_object(st).size(); });
+		bench.run(QStringLiteral("state.from_json"), params, [&]() {
+			FlyState out;
+			fly_state_from_json_object(obj, out);
+			return out.custom_fields.size();
+		});
+		// What a broadcast pays before framing.
+		bench.run(
+			QStringLiteral("state.encode"), params,
+			[&]() { return QJsonDocument(fly_state_to_json_object(st)).toJson(QJsonDocument::Compact).size(); },
+			double(text.size()));
+		bench.run(
+			QStringLiteral("state.decode"), params,
+			[&]() {
+				FlyState out;
+				fly_state_from_json_object(QJsonDocument::fromJson(text).object(), out);
+				return out.custom_fields.size();
+			},
+			double(text.size()));
+	}
+}
+
+static void fly_bench_frame_codec(FlyBench &bench)
+{
+	const quint8 mask[4] = {0x12, 0x34, 0x56, 0x78};
+
+	for (int size : {16, 125, 1024, 16384, 262144}) {
+		const QJsonObject params{{QStringLiteral("payload"), size}};
+		const QByteArray payload = fly_bench_payload(size);
+		const QByteArray masked = fly_ws_encode_frame(payload, 0x1, mask);
+
+		bench.run(
+			QStringLiteral("frame.encode"), params, [&]() { return fly_ws_encode_frame(payload).size(); },
+			double(size));
+		bench.run(
+			QStringLiteral("frame.encode_masked"), params,
+			[&]() { return fly_ws_encode_frame(payload, 0x1, mask).size(); }, double(size));
+		bench.run(
+			QStringLiteral("frame.decode_masked"), params,
+			[&]() {
+				qsizetype pos = 0;
+				FlyWsFrame frame;
+				fly_ws_decode_frame(masked, pos, frame, quint64(1) << 30);
+				return frame.payload.size();
+			},
+			double(size));
+	}
+
+	// processBuffer's loop: many small client frames arriving in one read.
+	for (int frames : {1, 16, 256}) {
+		const QJsonObject params{{QStringLiteral("frames"), frames}, {QStringLiteral("payload"), 96}};
+		const QByteArray one = fly_ws_encode_frame(fly_bench_payload(96), 0x1, mask);
+		const QByteArray oneLocal = fly_local_encode_frame(fly_bench_payload(96));
+		QByteArray buffer;
+		QByteArray localBuffer;
+		for (int i = 0; i < frames; ++i) {
+			buffer.append(one);
+			localBuffer.append(oneLocal);
+		}
+
+		bench.run(
+			QStringLiteral("frame.decode_pipelined"), params,
+			[&]() {
+				qsizetype pos = 0;
+				FlyWsFrame frame;
+				int n = 0;
+				while (fly_ws_decode_frame(buffer, pos, frame, 1024 * 1024) == FlyWsDecode::Frame)
+					++n;
+				return n;
+			},
+			double(buffer.size()));
+		// The same requests over the local channel: no mask to undo.
+		bench.run(
+			QStringLiteral("frame.decode_local_pipelined"), params,
+			[&]() {
+				qsizetype pos = 0;
+				QByteArray payload;
+				int n = 0;
+				while (fly_local_decode_frame(localBuffer, pos, payload, 1024 * 1024) == FlyWsDecode::Frame)
+					++n;
+				return n;
+			},
+			double(localBuffer.size()));
+	}
+}
+
+static void fly_bench_dispatch(FlyBench &bench)
+{
+	// The headless half of FlyScoreDock::handleRemoteCommand: parse the frame
+	// text, resolve the action and apply it to the state.
+	const QVector<QPair<QString, QJsonObject>> commands = {
+		{QStringLiteral("swap"), {{QStringLiteral("action"), QStringLiteral("swap")}}},
+		{QStringLiteral("bump_score"),
+		 {{QStringLiteral("action"), QStringLiteral("bump_score")},
+		  {QStringLiteral("index"), 3},
+		  {QStringLiteral("side"), QStringLiteral("home")},
+		  {QStringLiteral("delta"), 1}}},
+		{QStringLiteral("set_team"),
+		 {{QStringLiteral("action"), QStringLiteral("set_team")},
+		  {QStringLiteral("side"), QStringLiteral("away")},
+		  {QStringLiteral("title"), QStringLiteral("Visitors")}}},
+		{QStringLiteral("timer_reset"),
+		 {{QStringLiteral("action"), QStringLiteral("timer_reset")}, {QStringLiteral("index"), 1}}},
+		{QStringLiteral("unknown"), {{QStringLiteral("action"), QStringLiteral("no_such_action")}}},
+	};
+
+	for (const auto &c : commands) {
+		const QByteArray text = QJsonDocument(c.second).toJson(QJsonDocument::Compact);
+		FlyState st = fly_bench_state(10);
+		qint64 now = 0;
+		bench.run(QStringLiteral("command.dispatch"), QJsonObject{{QStringLiteral("action"), c.first}}, [&]() {
+			const QJsonObject cmd = QJsonDocument::fromJson(text).object();
+			return fly_apply_state_command(st, fly_command_action(cmd), cmd, ++now);
+		});
+	}
+}
+
+static void fly_bench_derived(FlyBench &bench)
+{
+	const QVector<FlyDerivedField> defs = {
+		{QStringLiteral("lead"), QStringLiteral("field[0].home - field[0].away")},
+		{QStringLiteral("total"), QStringLiteral("sum_home() + sum_away()")},
+		{QStringLiteral("share"), QStringLiteral("pct(sum_home(), total)")},
+		{QStringLiteral("fouls_left"), QStringLiteral("max(0, 5 - single[\"Stat 2\"])")},
+		{QStringLiteral("leader"), QStringLiteral("lead > 0 ? 1 : lead < 0 ? 2 : 0")},
+	};
+
+	for (int fields : {10, 100}) {
+		const QJsonObject params{{QStringLiteral("fields"), fields}};
+		FlyState st = fly_bench_state(fields);
+		FlyDerivedEngine engine;
+		engine.setDefinitions(defs);
+
+		// Only a single stat moves: the field sums are re-read but not re-evaluated.
+		int tick = 0;
+		bench.run(QStringLiteral("derived.update_single"), params, [&]() {
+			st.single_stats[1].value = (++tick) & 7;
+			return engine.update(fly_state_to_json_object(st)).size() + engine.lastRecomputed();
+		});
+		bench.run(QStringLiteral("derived.update_field"), params, [&]() {
+			st.custom_fields[0].home = (++tick) & 63;
+			return engine.update(fly_state_to_json_object(st)).size() + engine.lastRecomputed();
+		});
+	}
+}
+
+static void fly_bench_ingest(FlyBench &bench)
+{
+	// A console streaming its clock: decode each packet, fold a 100 ms window
+	// of them and apply the surviving batch once.
+	const auto text = fly_ingest_make_adapter(QStringLiteral("text"));
+	const QByteArray packet("home=3 away=2 clock=11:42.5 running=1 single1=2");
+	QList<QJsonObject> commands;
+	bench.run(QStringLiteral("ingest.decode_text"), QJsonObject(), [&]() {
+		commands.clear();
+		text->decode(packet, commands);
+		return commands.size();
+	});
+
+	for (int packets : {1, 10, 100}) {
+		QVector<QByteArray> window;
+		for (int i = 0; i < packets; ++i)
+			window.push_back("home=3 away=2 running=1 clock=" + QByteArray::number(700000 - i * 10));
+
+		const QJsonObject params{{QStringLiteral("packets"), packets}};
+		FlyState st = fly_bench_state(10);
+		qint64 now = 0;
+		bench.run(QStringLiteral("ingest.coalesce_apply"), params, [&]() {
+			FlyIngestCoalescer coalescer;
+			for (const QByteArray &p : window) {
+				commands.clear();
+				text->decode(p, commands);
+				for (const QJsonObject &c : commands)
+					coalescer.add(c);
+			}
+			int effects = 0;
+			for (const QJsonObject &c : coalescer.take())
+				effects |= fly_apply_state_command(st, fly_command_action(c), c, ++now);
+			return effects;
+		});
+	}
+}
+
+static void fly_bench_roster(FlyBench &bench)
+{
+	for (int players : {15, 25}) {
+		const QJsonObject params{{QStringLiteral("players"), players}};
+		FlyState st = fly_bench_state(10);
+		st.roster = fly_bench_roster(players);
+
+		const QJsonObject cmd{{QStringLiteral("action"), QStringLiteral("player_stat")},
+				      {QStringLiteral("team"), QStringLiteral("away")},
+				      {QStringLiteral("number"), 4 + players / 2},
+				      {QStringLiteral("stat"), QStringLiteral("points")},
+				      {QStringLiteral("delta"), 2}};
+		bench.run(QStringLiteral("roster.player_stat"), params, [&]() {
+			return fly_apply_state_command(st, fly_command_action(cmd), cmd, 0);
+		});
+
+		bench.run(QStringLiteral("roster.top5"), params,
+			  [&]() { return fly_roster_top(st.roster, 0, 5, -1).size(); });
+
+		// What broadcastState does per change: diff against the previous
+		// snapshot, versus serializing the whole table.
+		const FlyRoster before = st.roster;
+		st.roster.values[0][3] += 1;
+		bench.run(QStringLiteral("roster.diff_cells"), params, [&]() {
+			QJsonArray cells;
+			fly_roster_diff_cells(before, st.roster, cells);
+			return cells.size();
+		});
+		bench.run(QStringLiteral("roster.to_json"), params,
+			  [&]() { return fly_roster_to_json(st.roster).size(); });
+	}
+}
+
+static void fly_bench_presets(FlyBench &bench)
+{
+	for (int fields : {10, 100}) {
+		const QJsonObject params{{QStringLiteral("fields"), fields}};
+		FlyState st = fly_bench_state(fields);
+		const FlyPreset snapshot = fly_preset_capture(QString(), QStringLiteral("Intro"), st, 0);
+
+		FlyPreset halftime;
+		halftime.id = QStringLiteral("halftime");
+		for (int i = 0; i < 3; ++i) {
+			const QJsonObject cmd{{QStringLiteral("action"), QStringLiteral("set_field")},
+					      {QStringLiteral("index"), i},
+					      {QStringLiteral("visible"), false}};
+			halftime.commands.push_back({fly_command_action(cmd), cmd});
+		}
+
+		bench.run(QStringLiteral("preset.apply_state"), params,
+			  [&]() { return fly_preset_apply(snapshot, st, 0); });
+		bench.run(QStringLiteral("preset.apply_commands"), params,
+			  [&]() { return fly_preset_apply(halftime, st, 0); });
+	}
+}
+
+static void fly_bench_history(FlyBench &bench)
+{
+	for (int fields : {10, 100}) {
+		const QJsonObject params{{QStringLiteral("fields"), fields}};
+		FlyState st = fly_bench_state(fields);
+		FlyHistory history;
+		history.begin(st);
+
+		// One dock edit: the field vector detaches, everything else stays shared.
+		int tick = 0;
+		bench.run(QStringLiteral("history.commit"), params, [&]() {
+			st.custom_fields[0].home = ++tick;
+			return history.commit(st);
+		});
+		bench.run(QStringLiteral("history.undo_redo"), params, [&]() {
+			history.undo(st);
+			return history.redo(st);
+		});
+		bench.run(QStringLiteral("history.commit_unchanged"), params, [&]() { return history.commit(st); });
+	}
+}
+
+static void fly_bench_shm(FlyBench &bench)
+{
+	// A heap segment: the same copies as the QSharedMemory one, minus the OS mapping.
+	auto seg = std::make_unique<FlyShmSegment>();
+	seg->magic = kFlyShmMagic;
+	seg->version = kFlyShmVersion;
+	seg->size = uint32_t(sizeof(FlyShmSegment));
+
+	for (int fields : {10, 32}) {
+		const QJsonObject params{{QStringLiteral("fields"), fields}};
+		FlyState st = fly_bench_state(fields);
+		FlyShmState scratch{};
+		FlyShmState out{};
+
+		int tick = 0;
+		bench.run(QStringLiteral("shm.publish"), params, [&]() {
+			st.custom_fields[0].home = ++tick;
+			fly_shm_fill_state(st, QStringLiteral("main"), scratch);
+			++scratch.rev;
+			fly_shm_write_snapshot(seg.get(), scratch);
+			return scratch.rev;
+		});
+		bench.run(QStringLiteral("shm.read"), params, [&]() {
+			return fly_shm_read_snapshot(seg.get(), out) ? out.rev : 0;
+		});
+	}
+}
+
+static void fly_bench_hotkeys(FlyBench &bench)
+{
+	for (int fields : {10, 100, 1000}) {
+		const QJsonObject params{{QStringLiteral("fields"), fields}};
+		const FlyState st = fly_bench_state(fields);
+		const QVector<FlyHotkeyBinding> current = fly_bench_bound_hotkeys(st);
+
+		bench.run(QStringLiteral("hotkeys.build_merged"), params, [&]() {
+			return fly_hotkeys_merge(fly_hotkeys_default_bindings(st), current).size();
+		});
+		bench.run(QStringLiteral("hotkeys.parse_actions"), params, [&]() {
+			int n = 0;
+			for (const auto &b : current)
+				n += int(fly_hotkey_parse_action(b.actionId).kind);
+			return n;
+		});
+	}
+}
+
+static void fly_bench_field_rows(FlyBench &bench)
+{
+	for (int fields : {1, 10, 100}) {
+		QWidget host;
+		auto *layout = new QVBoxLayout(&host);
+		const FlyState st = fly_bench_state(fields);
+
+		bench.run(QStringLiteral("ui.custom_field_rows"), QJsonObject{{QStringLiteral("fields"), fields}},
+			  [&]() { return fly_bench_rebuild_field_rows(&host, layout, st); });
+	}
+}
+
+// ---------------------------------------------------------------------------
+// Reporting
+// ---------------------------------------------------------------------------
+static QJsonObject fly_bench_to_json(const FlyBench &bench, const FlyBenchOptions &opt)
+{
+	QJsonArray arr;
+	for (const auto &r : bench.results()) {
+		QJsonObject o;
+		o.insert(QStringLiteral("name"), r.name);
+		o.insert(QStringLiteral("params"), r.params);
+		o.insert(QStringLiteral("iterations"), static_cast<qint64>(r.iterations));
+		o.insert(QStringLiteral("median_ns"), r.medianNs);
+		o.insert(QStringLiteral("min_ns"), r.minNs);
+		o.insert(QStringLiteral("mean_ns"), r.meanNs);
+		o.insert(QStringLiteral("mad_ns"), r.madNs);
+		if (r.bytesPerOp > 0)
+			o.insert(QStringLiteral("mb_per_s"), r.bytesPerOp / r.medianNs * 1e3);
+		arr.append(o);
+	}
+
+	QJsonObject out;
+	out.insert(QStringLiteral("tool"), QStringLiteral("fly-score-bench"));
+	out.insert(QStringLiteral("plugin_version"), QStringLiteral(PLUGIN_VERSION));
+	out.insert(QStringLiteral("qt_version"), QString::fromLatin1(qVersion()));
+	out.insert(QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture());
+	out.insert(QStringLiteral("os"), QSysInfo::prettyProductName());
+	out.insert(QStringLiteral("timestamp"), QDateTime::currentDateTimeUtc().toString(Qt::ISODate));
+	out.insert(QStringLiteral("min_time_ms"), opt.minTimeMs);
+	out.insert(QStringLiteral("samples"), opt.samples);
+	out.insert(QStringLiteral("results"), arr);
+	return out;
+}
+
+// Prints median deltas against an earlier --json run. Returns the number of
+// cases slower than failPct (when failPct > 0).
+static int fly_bench_compare(const FlyBench &bench, const QString &path, double failPct)
+{
+	QFile f(path);
+	if (!f.open(QIODevice::ReadOnly)) {
+		std::fprintf(stderr, "cannot read baseline %s\n", path.toUtf8().constData());
+		return -1;
+	}
+
+	QHash<QString, double> base;
+	const QJsonArray arr = QJsonDocument::fromJson(f.readAll()).object().value(QStringLiteral("results")).toArray();
+	for (const QJsonValue &v : arr) {
+		const QJsonObject o = v.toObject();
+		base.insert(o.value(QStringLiteral("name")).toString(), o.value(QStringLiteral("median_ns")).toDouble());
+	}
+
+	int regressions = 0;
+	std::printf("\nvs baseline %s\n", path.toUtf8().constData());
+	for (const auto &r : bench.results()) {
+		const auto it = base.constFind(r.name);
+		if (it == base.constEnd() || it.value() <= 0) {
+			std::printf("%-48s %12s  (new)\n", r.name.toUtf8().constData(),
+				    FlyBench::fly_bench_time(r.medianNs).toUtf8().constData());
+			continue;
+		}
+		const double pct = 100.0 * (r.medianNs - it.value()) / it.value();
+		const bool bad = failPct > 0 && pct > failPct;
+		regressions += bad ? 1 : 0;
+		std::printf("%-48s %12s -> %12s  %+6.1f%%%s\n", r.name.toUtf8().constData(),
+			    FlyBench::fly_bench_time(it.value()).toUtf8().constData(),
+			    FlyBench::fly_bench_time(r.medianNs).toUtf8().constData(), pct, bad ? "  REGRESSION" : "");
+	}
+	return regressions;
+}
+
+int main(int argc, char **argv)
+{
+	// The widget cases need a QApplication but never a display.
+	if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	QApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("fly-score-bench"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Microbenchmarks for fly-scoreboard hot paths."));
+	parser.addHelpOption();
+	const QCommandLineOption filterOpt(QStringLiteral("filter"),
+					   QStringLiteral("Only run cases whose id matches this regular expression."),
+					   QStringLiteral("regex"));
+	const QCommandLineOption timeOpt(QStringLiteral("min-time-ms"), QStringLiteral("Time budget per case."),
+					 QStringLiteral("ms"), QStringLiteral("300"));
+	const QCommandLineOption samplesOpt(QStringLiteral("samples"), QStringLiteral("Timed batches per case."),
+					    QStringLiteral("n"), QStringLiteral("15"));
+	const QCommandLineOption jsonOpt(QStringLiteral("json"), QStringLiteral("Write results to this JSON file."),
+					 QStringLiteral("file"));
+	const QCommandLineOption baselineOpt(QStringLiteral("baseline"),
+					     QStringLiteral("Compare against a previous --json file."),
+					     QStringLiteral("file"));
+	const QCommandLineOption failOpt(QStringLiteral("fail-regression"),
+					 QStringLiteral("Exit 1 when a median is this many percent slower than the baseline."),
+					 QStringLiteral("pct"));
+	parser.addOptions({filterOpt, timeOpt, samplesOpt, jsonOpt, baselineOpt, failOpt});
+	parser.process(app);
+
+	FlyBenchOptions opt;
+	opt.minTimeMs = qMax(10, parser.value(timeOpt).toInt());
+	opt.samples = qBound(3, parser.value(samplesOpt).toInt(), 1000);
+	opt.filter = QRegularExpression(parser.value(filterOpt));
+	opt.jsonPath = parser.value(jsonOpt);
+	opt.baselinePath = parser.value(baselineOpt);
+	opt.failRegressionPct = parser.value(failOpt).toDouble();
+	if (!opt.filter.isValid()) {
+		std::fprintf(stderr, "invalid --filter: %s\n", opt.filter.errorString().toUtf8().constData());
+		return 3;
+	}
+
+	fly_bench_load_locale();
+
+	FlyBench bench(opt);
+	fly_bench_state_codec(bench);
+	fly_bench_frame_codec(bench);
+	fly_bench_dispatch(bench);
+	fly_bench_derived(bench);
+	fly_bench_ingest(bench);
+	fly_bench_roster(bench);
+	fly_bench_presets(bench);
+	fly_bench_history(bench);
+	fly_bench_shm(bench);
+	fly_bench_hotkeys(bench);
+	fly_bench_field_rows(bench);
+
+	if (!opt.jsonPath.isEmpty()) {
+		QFile out(opt.jsonPath);
+		if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate) ||
+		    out.write(QJsonDocument(fly_bench_to_json(bench, opt)).toJson(QJsonDocument::Indented)) < 0) {
+			std::fprintf(stderr, "cannot write %s\n", opt.jsonPath.toUtf8().constData());
+			return 3;
+		}
+	}
+
+	if (!opt.baselinePath.isEmpty()) {
+		const int regressions = fly_bench_compare(bench, opt.baselinePath, opt.failRegressionPct);
+		if (regressions < 0)
+			return 3;
+		if (regressions > 0)
+			return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,755 @@
+// fly-score-loadgen: WebSocket load generator and latency benchmark.
+//
+// Opens simulated overlay and controller clients against a running plugin
+// (--url) or an in-process server built from the headless core (--embedded),
+// optionally with the overlays behind a relay (--overlay-url), replays a
+// weighted command mix and reports throughput, latency percentiles, memory
+// growth and dropped state revisions.
+
+#include "fly_score_commands.hpp"
+#include "fly_score_metrics.hpp"
+#include "fly_score_state.hpp"
+#include "fly_score_websocket_server.hpp"
+#include "fly_score_ws_frame.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QTcpSocket>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QVector>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+static constexpr int kTickMs = 1;
+static constexpr int kConnectTimeoutMs = 10000;
+static constexpr int kMetricsTimeoutMs = 1000;
+
+static QElapsedTimer g_clock;
+
+static uint64_t fly_loadgen_now_us()
+{
+	return static_cast<uint64_t>(g_clock.nsecsElapsed() / 1000);
+}
+
+static qint64 fly_loadgen_rss_bytes()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return static_cast<qint64>(pmc.WorkingSetSize);
+	return -1;
+#elif defined(__APPLE__)
+	mach_task_basic_info info;
+	mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+	if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) ==
+	    KERN_SUCCESS)
+		return static_cast<qint64>(info.resident_size);
+	return -1;
+#else
+	QFile f(QStringLiteral("/proc/self/statm"));
+	if (!f.open(QIODevice::ReadOnly))
+		return -1;
+	const QList<QByteArray> parts = f.readAll().split(' ');
+	if (parts.size() < 2)
+		return -1;
+	return parts[1].toLongLong() * static_cast<qint64>(sysconf(_SC_PAGESIZE));
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// Minimal RFC 6455 client (text frames only, masked as clients must).
+// ---------------------------------------------------------------------------
+class FlyLoadClient : public QObject {
+public:
+	std::function<void()> onOpen;
+	std::function<void(const QJsonObject &, uint64_t)> onMessage;
+	std::function<void()> onClosed;
+
+	explicit FlyLoadClient(QObject *parent = nullptr) : QObject(parent), socket_(new QTcpSocket(this))
+	{
+		socket_->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(socket_, &QTcpSocket::connected, this, [this]() { sendHandshake(); });
+		connect(socket_, &QTcpSocket::readyRead, this, [this]() { onReadyRead(); });
+		connect(socket_, &QTcpSocket::disconnected, this, [this]() {
+			open_ = false;
+			if (onClosed)
+				onClosed();
+		});
+	}
+
+	void open(const QUrl &url)
+	{
+		url_ = url;
+		socket_->connectToHost(url.host(), static_cast<quint16>(url.port(4457)));
+	}
+
+	bool isOpen() const { return open_; }
+	quint64 framesReceived() const { return frames_; }
+	quint64 bytesReceived() const { return bytes_; }
+
+	void send(const QJsonObject &obj)
+	{
+		const QByteArray payload = QJsonDocument(obj).toJson(QJsonDocument::Compact);
+		const quint32 maskWord = QRandomGenerator::global()->generate();
+		quint8 mask[4];
+		for (int i = 0; i < 4; ++i)
+			mask[i] = quint8((maskWord >> (8 * i)) & 0xff);
+		const QByteArray frame = fly_ws_encode_frame(payload, 0x1, mask);
+		socket_->write(frame);
+	}
+
+private:
+	void sendHandshake()
+	{
+		QByteArray nonce(16, '\0');
+		for (char &c : nonce)
+			c = char(QRandomGenerator::global()->bounded(256));
+
+		const QByteArray path = url_.path().isEmpty() ? QByteArray("/") : url_.path().toUtf8();
+		QByteArray req;
+		req += "GET " + path + " HTTP/1.1\r\n";
+		req += "Host: " + url_.host().toUtf8() + ":" + QByteArray::number(url_.port(4457)) + "\r\n";
+		req += "Upgrade: websocket\r\nConnection: Upgrade\r\n";
+		req += "Sec-WebSocket-Key: " + nonce.toBase64() + "\r\n";
+		req += "Sec-WebSocket-Version: 13\r\n\r\n";
+		socket_->write(req);
+	}
+
+	void onReadyRead()
+	{
+		const uint64_t now = fly_loadgen_now_us();
+		const QByteArray data = socket_->readAll();
+		bytes_ += static_cast<quint64>(data.size());
+		buffer_.append(data);
+
+		if (!open_) {
+			const int end = buffer_.indexOf("\r\n\r\n");
+			if (end < 0)
+				return;
+			const bool upgraded = buffer_.startsWith("HTTP/1.1 101");
+			buffer_.remove(0, end + 4);
+			if (!upgraded) {
+				socket_->disconnectFromHost();
+				return;
+			}
+			open_ = true;
+			if (onOpen)
+				onOpen();
+		}
+
+		qsizetype pos = 0;
+		FlyWsFrame frame;
+		while (fly_ws_decode_frame(buffer_, pos, frame, std::numeric_limits<quint64>::max()) == FlyWsDecode::Frame) {
+			++frames_;
+			if (frame.opcode != 0x1 || !onMessage)
+				continue;
+			const QJsonDocument doc = QJsonDocument::fromJson(frame.payload);
+			if (doc.isObject())
+				onMessage(doc.object(), now);
+		}
+		buffer_.remove(0, pos);
+	}
+
+	QTcpSocket *socket_ = nullptr;
+	QUrl url_;
+	QByteArray buffer_;
+	bool open_ = false;
+	quint64 frames_ = 0;
+	quint64 bytes_ = 0;
+};
+
+// ---------------------------------------------------------------------------
+// In-process server: the headless core standing in for the dock.
+// ---------------------------------------------------------------------------
+class FlyLoadHost : public QObject {
+public:
+	explicit FlyLoadHost(const QString &saveDir) : saveDir_(saveDir) {}
+
+	bool start(quint16 port)
+	{
+		server_ = new FlyScoreWebSocketServer(this);
+		connect(server_, &FlyScoreWebSocketServer::commandReceived, this,
+			[this](FlyClientSession *session, const QJsonObject &command) { handle(session, command); });
+		return server_->start(port);
+	}
+
+private:
+	void handle(FlyClientSession *session, const QJsonObject &command)
+	{
+		const QString board = command.value(QStringLiteral("board")).toString();
+		auto it = states_.find(board);
+		if (it == states_.end())
+			it = states_.insert(board, fly_state_make_defaults());
+
+		const QString action = fly_command_action(command);
+		if (action == QLatin1String("get_state")) {
+			server_->sendState(session, *it, QStringLiteral("loadgen"), QString(), board);
+			return;
+		}
+		const qint64 now = QDateTime::currentMSecsSinceEpoch();
+		if (fly_apply_state_command(*it, action, command, now) == FlyCommandIgnored)
+			return;
+
+		if (!saveDir_.isEmpty())
+			fly_state_save(QDir(saveDir_).filePath(board), *it);
+		server_->broadcastState(*it, QStringLiteral("loadgen"), QString(), board);
+	}
+
+	FlyScoreWebSocketServer *server_ = nullptr;
+	QHash<QString, FlyState> states_;
+	QString saveDir_;
+};
+
+// ---------------------------------------------------------------------------
+// Driver
+// ---------------------------------------------------------------------------
+struct FlyLoadOptions {
+	QUrl url;
+	// Overlays connect here when set (a fly-score-relay in front of url).
+	QUrl overlayUrl;
+	bool embedded = false;
+	QString saveDir;
+	int overlays = 10;
+	int controllers = 2;
+	double rate = 50.0;
+	double seconds = 10.0;
+	int drainMs = 1000;
+	QStringList topics;
+	QString board;
+	bool renderEcho = true;
+	QVector<QPair<QString, int>> mix;
+	quint32 seed = 1;
+	QString jsonOut;
+	double failP99Ms = 0.0;
+};
+
+struct FlyPendingCommand {
+	uint64_t sentUs = 0;
+};
+
+class FlyLoadRun {
+public:
+	explicit FlyLoadRun(const FlyLoadOptions &opt) : opt_(opt), rng_(opt.seed)
+	{
+		baseState_ = fly_state_to_json_object(fly_state_make_defaults());
+		for (const auto &m : opt_.mix)
+			mixTotal_ += m.second;
+	}
+
+	~FlyLoadRun()
+	{
+		// Sockets emit disconnected while being destroyed; detach first.
+		for (auto *list : {&overlays_, &controllers_}) {
+			for (auto &c : *list) {
+				c->onClosed = nullptr;
+				c->onMessage = nullptr;
+			}
+		}
+	}
+
+	int exec();
+
+private:
+	QString pickAction()
+	{
+		int r = static_cast<int>(rng_.bounded(quint32(qMax(1, mixTotal_))));
+		for (const auto &m : opt_.mix) {
+			if (r < m.second)
+				return m.first;
+			r -= m.second;
+		}
+		return QStringLiteral("bump");
+	}
+
+	QJsonObject makeCommand(const QString &kind)
+	{
+		QJsonObject cmd;
+		if (kind == QLatin1String("timer")) {
+			cmd.insert(QStringLiteral("action"), QStringLiteral("timer_toggle"));
+			cmd.insert(QStringLiteral("index"), 0);
+		} else if (kind == QLatin1String("single")) {
+			cmd.insert(QStringLiteral("action"), QStringLiteral("bump_single"));
+			cmd.insert(QStringLiteral("index"), 0);
+			cmd.insert(QStringLiteral("delta"), 1);
+		} else if (kind == QLatin1String("swap")) {
+			cmd.insert(QStringLiteral("action"), QStringLiteral("swap"));
+		} else if (kind == QLatin1String("set_state")) {
+			QJsonObject st = baseState_;
+			QJsonObject home = st.value(QStringLiteral("home")).toObject();
+			home.insert(QStringLiteral("title"), QStringLiteral("Home %1").arg(++setStateSeq_));
+			st.insert(QStringLiteral("home"), home);
+			cmd.insert(QStringLiteral("action"), QStringLiteral("set_state"));
+			cmd.insert(QStringLiteral("state"), st);
+		} else {
+			cmd.insert(QStringLiteral("action"), QStringLiteral("bump_score"));
+			cmd.insert(QStringLiteral("index"), 0);
+			cmd.insert(QStringLiteral("side"), rng_.bounded(2) ? QStringLiteral("home") : QStringLiteral("away"));
+			cmd.insert(QStringLiteral("delta"), 1);
+		}
+		return cmd;
+	}
+
+	void onOverlayMessage(FlyLoadClient *client, const QJsonObject &msg, uint64_t now);
+	void onControllerMessage(const QJsonObject &msg, uint64_t now);
+	void tick();
+	bool waitFor(const std::function<bool()> &done, int timeoutMs);
+	int report();
+
+	FlyLoadOptions opt_;
+	QRandomGenerator rng_;
+	QJsonObject baseState_;
+	int mixTotal_ = 0;
+	int setStateSeq_ = 0;
+
+	std::vector<std::unique_ptr<FlyLoadClient>> overlays_;
+	std::vector<std::unique_ptr<FlyLoadClient>> controllers_;
+	QHash<FlyLoadClient *, quint64> lastRev_;
+
+	bool sending_ = false;
+	uint64_t startUs_ = 0;
+	uint64_t stopUs_ = 0;
+	uint64_t lastTickUs_ = 0;
+	double credit_ = 0.0;
+	qint64 nextId_ = 0;
+	quint64 sent_ = 0;
+	quint64 acked_ = 0;
+	quint64 unchanged_ = 0;
+	// Acks carrying an error; rate_limited ones are also counted on their own.
+	quint64 rejected_ = 0;
+	quint64 rateLimited_ = 0;
+	quint64 stateFrames_ = 0;
+	quint64 dropped_ = 0;
+	quint64 disconnects_ = 0;
+	QHash<qint64, FlyPendingCommand> pending_;
+	QHash<quint64, uint64_t> revSentUs_;
+	QHash<quint64, QVector<uint64_t>> revArrivals_;
+	QJsonObject serverMetrics_;
+
+	FlyHistogram ackUs_;
+	FlyHistogram deliveryUs_;
+	FlyHistogram spreadUs_;
+};
+
+void FlyLoadRun::onOverlayMessage(FlyLoadClient *client, const QJsonObject &msg, uint64_t now)
+{
+	if (msg.value(QStringLiteral("type")).toString() != QLatin1String("state"))
+		return;
+
+	++stateFrames_;
+	const quint64 rev = static_cast<quint64>(msg.value(QStringLiteral("rev")).toDouble(0));
+	if (!rev)
+		return;
+
+	// Revisions only grow; a gap means a state change never reached this client.
+	// Without topics every change is sent, so any gap is a dropped broadcast.
+	const quint64 last = lastRev_.value(client, 0);
+	if (last && rev > last + 1 && opt_.topics.isEmpty())
+		dropped_ += rev - last - 1;
+	if (rev > last)
+		lastRev_.insert(client, rev);
+
+	if (startUs_)
+		revArrivals_[rev].append(now);
+
+	if (opt_.renderEcho) {
+		QJsonObject echo;
+		echo.insert(QStringLiteral("type"), QStringLiteral("rendered"));
+		echo.insert(QStringLiteral("rev"), static_cast<qint64>(rev));
+		client->send(echo);
+	}
+}
+
+void FlyLoadRun::onControllerMessage(const QJsonObject &msg, uint64_t now)
+{
+	const QString type = msg.value(QStringLiteral("type")).toString();
+	if (type == QLatin1String("metrics")) {
+		serverMetrics_ = msg.value(QStringLiteral("metrics")).toObject();
+		return;
+	}
+	if (type != QLatin1String("ack"))
+		return;
+
+	const qint64 id = static_cast<qint64>(msg.value(QStringLiteral("id")).toDouble(-1));
+	const auto it = pending_.find(id);
+	if (it == pending_.end())
+		return;
+
+	++acked_;
+	ackUs_.record(now - it->sentUs);
+	if (msg.contains(QStringLiteral("error"))) {
+		++rejected_;
+		if (msg.value(QStringLiteral("error")).toString() == QLatin1String("rate_limited"))
+			++rateLimited_;
+	} else if (msg.value(QStringLiteral("changed")).toBool())
+		revSentUs_.insert(static_cast<quint64>(msg.value(QStringLiteral("rev")).toDouble(0)), it->sentUs);
+	else
+		++unchanged_;
+	pending_.erase(it);
+}
+
+void FlyLoadRun::tick()
+{
+	if (!sending_)
+		return;
+
+	const uint64_t now = fly_loadgen_now_us();
+	if (now >= stopUs_) {
+		sending_ = false;
+		return;
+	}
+
+	credit_ += opt_.rate * double(now - lastTickUs_) / 1e6;
+	lastTickUs_ = now;
+
+	while (credit_ >= 1.0) {
+		credit_ -= 1.0;
+		for (auto &c : controllers_) {
+			if (!c->isOpen())
+				continue;
+			QJsonObject cmd = makeCommand(pickAction());
+			const qint64 id = ++nextId_;
+			cmd.insert(QStringLiteral("id"), id);
+			if (!opt_.board.isEmpty())
+				cmd.insert(QStringLiteral("board"), opt_.board);
+			pending_.insert(id, FlyPendingCommand{fly_loadgen_now_us()});
+			c->send(cmd);
+			++sent_;
+		}
+	}
+}
+
+bool FlyLoadRun::waitFor(const std::function<bool()> &done, int timeoutMs)
+{
+	QElapsedTimer t;
+	t.start();
+	while (!done() && t.elapsed() < timeoutMs)
+		QCoreApplication::processEvents(QEventLoop::AllEvents, 5);
+	return done();
+}
+
+int FlyLoadRun::exec()
+{
+	QUrl url = opt_.url;
+	QUrl overlayUrl = opt_.overlayUrl.isEmpty() ? opt_.url : opt_.overlayUrl;
+	if (!opt_.board.isEmpty()) {
+		url.setPath(QStringLiteral("/board/") + opt_.board);
+		overlayUrl.setPath(QStringLiteral("/board/") + opt_.board);
+	}
+
+	for (int i = 0; i < opt_.overlays; ++i) {
+		auto client = std::make_unique<FlyLoadClient>();
+		FlyLoadClient *raw = client.get();
+		raw->onOpen = [this, raw]() {
+			QJsonObject hello;
+			hello.insert(QStringLiteral("type"), QStringLiteral("hello"));
+			hello.insert(QStringLiteral("capabilities"), QJsonArray());
+			if (!opt_.topics.isEmpty())
+				hello.insert(QStringLiteral("topics"), QJsonArray::fromStringList(opt_.topics));
+			raw->send(hello);
+			QJsonObject get;
+			get.insert(QStringLiteral("type"), QStringLiteral("get_state"));
+			raw->send(get);
+		};
+		raw->onMessage = [this, raw](const QJsonObject &msg, uint64_t now) { onOverlayMessage(raw, msg, now); };
+		raw->onClosed = [this]() { ++disconnects_; };
+		raw->open(overlayUrl);
+		overlays_.push_back(std::move(client));
+	}
+
+	for (int i = 0; i < opt_.controllers; ++i) {
+		auto client = std::make_unique<FlyLoadClient>();
+		client->onMessage = [this](const QJsonObject &msg, uint64_t now) { onControllerMessage(msg, now); };
+		client->onClosed = [this]() { ++disconnects_; };
+		client->open(url);
+		controllers_.push_back(std::move(client));
+	}
+
+	const bool connected = waitFor(
+		[this]() {
+			for (const auto &c : overlays_)
+				if (!c->isOpen())
+					return false;
+			for (const auto &c : controllers_)
+				if (!c->isOpen())
+					return false;
+			return true;
+		},
+		kConnectTimeoutMs);
+	if (!connected) {
+		std::fprintf(stderr, "fly-score-loadgen: could not connect all clients to %s / %s\n",
+			     url.toString().toUtf8().constData(), overlayUrl.toString().toUtf8().constData());
+		return 3;
+	}
+
+	// Let initial get_state replies settle before measuring.
+	waitFor([]() { return false; }, 200);
+	const qint64 rssStart = fly_loadgen_rss_bytes();
+
+	QTimer ticker;
+	ticker.setTimerType(Qt::PreciseTimer);
+	ticker.setInterval(kTickMs);
+	QObject::connect(&ticker, &QTimer::timeout, [this]() { tick(); });
+
+	startUs_ = fly_loadgen_now_us();
+	stopUs_ = startUs_ + static_cast<uint64_t>(opt_.seconds * 1e6);
+	lastTickUs_ = startUs_;
+	sending_ = true;
+	ticker.start();
+	waitFor([this]() { return !sending_; }, static_cast<int>(opt_.seconds * 1000) + 5000);
+	ticker.stop();
+
+	waitFor([this]() { return pending_.isEmpty(); }, opt_.drainMs);
+
+	if (!controllers_.empty() && controllers_.front()->isOpen()) {
+		QJsonObject get;
+		get.insert(QStringLiteral("type"), QStringLiteral("get_metrics"));
+		controllers_.front()->send(get);
+		waitFor([this]() { return !serverMetrics_.isEmpty(); }, kMetricsTimeoutMs);
+	}
+
+	const qint64 rssEnd = fly_loadgen_rss_bytes();
+
+	for (auto it = revArrivals_.cbegin(); it != revArrivals_.cend(); ++it) {
+		const auto sent = revSentUs_.constFind(it.key());
+		uint64_t first = UINT64_MAX;
+		uint64_t last = 0;
+		for (uint64_t at : it.value()) {
+			first = qMin(first, at);
+			last = qMax(last, at);
+			if (sent != revSentUs_.cend() && at >= sent.value())
+				deliveryUs_.record(at - sent.value());
+		}
+		if (it.value().size() > 1)
+			spreadUs_.record(last - first);
+	}
+
+	const double elapsed = double(stopUs_ - startUs_) / 1e6;
+	auto ms = [](uint64_t us) { return double(us) / 1000.0; };
+	auto mb = [](qint64 b) { return b < 0 ? -1.0 : double(b) / (1024.0 * 1024.0); };
+	auto line = [&](const char *label, const FlyHistogram &h) {
+		std::printf("%-22s p50 %8.3f ms  p90 %8.3f ms  p99 %8.3f ms  (%llu samples)\n", label,
+			    ms(h.percentile(0.50)), ms(h.percentile(0.90)), ms(h.percentile(0.99)),
+			    (unsigned long long)h.count());
+	};
+
+	quint64 overlayBytes = 0;
+	for (const auto &c : overlays_)
+		overlayBytes += c->bytesReceived();
+
+	std::printf("fly-score-loadgen: %d overlays, %d controllers, %.1f s at %.1f cmd/s per controller (%s)\n",
+		    opt_.overlays, opt_.controllers, elapsed, opt_.rate, opt_.embedded ? "embedded" : "remote");
+	std::printf("%-22s %llu (%.1f/s)\n", "commands sent", (unsigned long long)sent_, double(sent_) / elapsed);
+	std::printf("%-22s %llu (lost %llu, no-op %llu, rejected %llu, rate limited %llu)\n", "acks",
+		    (unsigned long long)acked_, (unsigned long long)pending_.size(), (unsigned long long)unchanged_,
+		    (unsigned long long)rejected_, (unsigned long long)rateLimited_);
+	if (rateLimited_)
+		std::fprintf(stderr,
+			     "fly-score-loadgen: warning: %llu commands were rate limited and not applied; "
+			     "lower --rate or raise the server's websocket/rate_per_sec\n",
+			     (unsigned long long)rateLimited_);
+	line("ack round trip", ackUs_);
+	line("command -> overlay", deliveryUs_);
+	line("fan-out spread", spreadUs_);
+	std::printf("%-22s %llu (%.1f/s, %.2f MB)\n", "state frames", (unsigned long long)stateFrames_,
+		    double(stateFrames_) / elapsed, mb(static_cast<qint64>(overlayBytes)));
+	std::printf("%-22s %llu revisions, %llu disconnects\n", "dropped", (unsigned long long)dropped_,
+		    (unsigned long long)disconnects_);
+	std::printf("%-22s %.1f MB -> %.1f MB (%+.1f MB)%s\n", "memory (RSS)", mb(rssStart), mb(rssEnd),
+		    mb(rssEnd) - mb(rssStart), opt_.embedded ? "" : " client only");
+
+	const QJsonObject histograms = serverMetrics_.value(QStringLiteral("histograms")).toObject();
+	for (const char *name : {"broadcast", "command", "input_to_render"}) {
+		const QJsonObject h = histograms.value(QLatin1String(name)).toObject();
+		if (h.isEmpty())
+			continue;
+		std::printf("server %-15s p50 %8.3f ms  p99 %8.3f ms  max %8.3f ms\n", name,
+			    h.value(QStringLiteral("p50_us")).toDouble() / 1000.0,
+			    h.value(QStringLiteral("p99_us")).toDouble() / 1000.0,
+			    h.value(QStringLiteral("max_us")).toDouble() / 1000.0);
+	}
+
+	if (!opt_.jsonOut.isEmpty()) {
+		auto hist = [](const FlyHistogram &h) { return h.toJson(); };
+		QJsonObject out;
+		out.insert(QStringLiteral("overlays"), opt_.overlays);
+		out.insert(QStringLiteral("controllers"), opt_.controllers);
+		out.insert(QStringLiteral("seconds"), elapsed);
+		out.insert(QStringLiteral("rate"), opt_.rate);
+		out.insert(QStringLiteral("embedded"), opt_.embedded);
+		out.insert(QStringLiteral("commands_sent"), static_cast<qint64>(sent_));
+		out.insert(QStringLiteral("acks"), static_cast<qint64>(acked_));
+		out.insert(QStringLiteral("lost_acks"), static_cast<qint64>(pending_.size()));
+		out.insert(QStringLiteral("rejected"), static_cast<qint64>(rejected_));
+		out.insert(QStringLiteral("rate_limited"), static_cast<qint64>(rateLimited_));
+		out.insert(QStringLiteral("state_frames"), static_cast<qint64>(stateFrames_));
+		out.insert(QStringLiteral("state_bytes"), static_cast<qint64>(overlayBytes));
+		out.insert(QStringLiteral("dropped_revisions"), static_cast<qint64>(dropped_));
+		out.insert(QStringLiteral("disconnects"), static_cast<qint64>(disconnects_));
+		out.insert(QStringLiteral("rss_start"), rssStart);
+		out.insert(QStringLiteral("rss_end"), rssEnd);
+		out.insert(QStringLiteral("ack_round_trip"), hist(ackUs_));
+		out.insert(QStringLiteral("command_to_overlay"), hist(deliveryUs_));
+		out.insert(QStringLiteral("fanout_spread"), hist(spreadUs_));
+		out.insert(QStringLiteral("server"), serverMetrics_);
+
+		QFile f(opt_.jsonOut);
+		if (f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+			f.write(QJsonDocument(out).toJson(QJsonDocument::Indented));
+		else
+			std::fprintf(stderr, "fly-score-loadgen: cannot write %s\n", opt_.jsonOut.toUtf8().constData());
+	}
+
+	if (dropped_ || !pending_.isEmpty() || disconnects_)
+		return 2;
+	if (opt_.failP99Ms > 0.0 && ms(deliveryUs_.percentile(0.99)) > opt_.failP99Ms)
+		return 1;
+	return 0;
+}
+
+static bool fly_loadgen_parse_mix(const QString &spec, QVector<QPair<QString, int>> &mix)
+{
+	static const QStringList known = {QStringLiteral("bump"), QStringLiteral("timer"), QStringLiteral("single"),
+					  QStringLiteral("swap"), QStringLiteral("set_state")};
+	for (const QString &part : spec.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+		const QStringList kv = part.split(QLatin1Char('='));
+		bool ok = false;
+		const int weight = kv.value(1, QStringLiteral("1")).toInt(&ok);
+		const QString name = kv.value(0).trimmed();
+		if (!ok || weight < 0 || !known.contains(name))
+			return false;
+		mix.append({name, weight});
+	}
+	return !mix.isEmpty();
+}
+
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("fly-score-loadgen"));
+	g_clock.start();
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("WebSocket load generator for the fly-scoreboard plugin."));
+	parser.addHelpOption();
+	const QCommandLineOption urlOpt(QStringLiteral("url"), QStringLiteral("Server to connect to."),
+					QStringLiteral("url"), QStringLiteral("ws://127.0.0.1:4457"));
+	const QCommandLineOption overlayUrlOpt(QStringLiteral("overlay-url"),
+					       QStringLiteral("Connect the overlays here instead, e.g. a relay."),
+					       QStringLiteral("url"));
+	const QCommandLineOption embeddedOpt(QStringLiteral("embedded"),
+					     QStringLiteral("Run an in-process server on --port instead of --url."));
+	const QCommandLineOption portOpt(QStringLiteral("port"), QStringLiteral("Port for --embedded."),
+					 QStringLiteral("port"), QStringLiteral("14457"));
+	const QCommandLineOption saveOpt(QStringLiteral("save-dir"),
+					 QStringLiteral("With --embedded, also write plugin.json per board here."),
+					 QStringLiteral("dir"));
+	const QCommandLineOption overlaysOpt(QStringLiteral("overlays"), QStringLiteral("Overlay clients."),
+					     QStringLiteral("n"), QStringLiteral("10"));
+	const QCommandLineOption controllersOpt(QStringLiteral("controllers"), QStringLiteral("Controller clients."),
+						QStringLiteral("n"), QStringLiteral("2"));
+	// Below the plugin's default limit of 20 commands per second per client.
+	const QCommandLineOption rateOpt(QStringLiteral("rate"), QStringLiteral("Commands per second per controller."),
+					 QStringLiteral("n"), QStringLiteral("15"));
+	const QCommandLineOption secondsOpt(QStringLiteral("seconds"), QStringLiteral("Duration of the run."),
+					    QStringLiteral("s"), QStringLiteral("10"));
+	const QCommandLineOption mixOpt(QStringLiteral("mix"),
+					QStringLiteral("Weighted command mix: bump, timer, single, swap, set_state."),
+					QStringLiteral("spec"), QStringLiteral("bump=70,timer=20,set_state=10"));
+	const QCommandLineOption topicsOpt(QStringLiteral("topics"),
+					   QStringLiteral("Comma-separated topics overlays subscribe to."),
+					   QStringLiteral("list"));
+	const QCommandLineOption boardOpt(QStringLiteral("board"), QStringLiteral("Board to drive."),
+					  QStringLiteral("id"));
+	const QCommandLineOption noEchoOpt(QStringLiteral("no-render-echo"),
+					   QStringLiteral("Do not send rendered echoes from overlays."));
+	const QCommandLineOption seedOpt(QStringLiteral("seed"), QStringLiteral("Random seed."), QStringLiteral("n"),
+					 QStringLiteral("1"));
+	const QCommandLineOption jsonOpt(QStringLiteral("json"), QStringLiteral("Write results as JSON."),
+					 QStringLiteral("file"));
+	const QCommandLineOption failOpt(QStringLiteral("fail-p99-ms"),
+					 QStringLiteral("Exit 1 if command -> overlay p99 exceeds this."),
+					 QStringLiteral("ms"));
+	parser.addOptions({urlOpt, overlayUrlOpt, embeddedOpt, portOpt, saveOpt, overlaysOpt, controllersOpt, rateOpt,
+			   secondsOpt, mixOpt, topicsOpt, boardOpt, noEchoOpt, seedOpt, jsonOpt, failOpt});
+	parser.process(app);
+
+	FlyLoadOptions opt;
+	opt.embedded = parser.isSet(embeddedOpt);
+	opt.url = QUrl(parser.value(urlOpt));
+	opt.overlayUrl = QUrl(parser.value(overlayUrlOpt));
+	opt.saveDir = parser.value(saveOpt);
+	opt.overlays = qMax(0, parser.value(overlaysOpt).toInt());
+	opt.controllers = qMax(1, parser.value(controllersOpt).toInt());
+	opt.rate = qMax(0.1, parser.value(rateOpt).toDouble());
+	opt.seconds = qMax(0.1, parser.value(secondsOpt).toDouble());
+	opt.topics = parser.value(topicsOpt).split(QLatin1Char(','), Qt::SkipEmptyParts);
+	opt.board = parser.value(boardOpt);
+	opt.renderEcho = !parser.isSet(noEchoOpt);
+	opt.seed = parser.value(seedOpt).toUInt();
+	opt.jsonOut = parser.value(jsonOpt);
+	opt.failP99Ms = parser.value(failOpt).toDouble();
+	if (!fly_loadgen_parse_mix(parser.value(mixOpt), opt.mix)) {
+		std::fprintf(stderr, "fly-score-loadgen: invalid --mix '%s'\n", parser.value(mixOpt).toUtf8().constData());
+		return 3;
+	}
+
+	QThread serverThread;
+	FlyLoadHost *host = nullptr;
+	if (opt.embedded) {
+		const quint16 port = static_cast<quint16>(parser.value(portOpt).toUInt());
+		opt.url = QUrl(QStringLiteral("ws://127.0.0.1:%1").arg(port));
+
+		host = new FlyLoadHost(opt.saveDir);
+		host->moveToThread(&serverThread);
+		serverThread.start();
+		bool ok = false;
+		QMetaObject::invokeMethod(host, [host, port, &ok]() { ok = host->start(port); },
+					  Qt::BlockingQueuedConnection);
+		if (!ok) {
+			std::fprintf(stderr, "fly-score-loadgen: cannot listen on port %u\n", unsigned(port));
+			QMetaObject::invokeMethod(host, [host]() { delete host; }, Qt::BlockingQueuedConnection);
+			serverThread.quit();
+			serverThread.wait();
+			return 3;
+		}
+	}
+
+	int rc = 0;
+	{
+		FlyLoadRun run(opt);
+		rc = run.exec();
+	}
+
+	if (host) {
+		QMetaObject::invokeMethod(host, [host]() { delete host; }, Qt::BlockingQueuedConnection);
+		serverThread.quit();
+		serverThread.wait();
+	}
+	return rc;
+}
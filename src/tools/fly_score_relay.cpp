@@ -0,0 +1,367 @@
+// fly-score-relay: headless fan-out relay for large audiences.
+//
+// Subscribes to the plugin (or another relay) once per board, keeps the last
+// revisioned state and serves it to any number of downstream WebSocket and
+// HTTP clients from this process, so OBS only ever sees one consumer per
+// board. Downstream clients speak the plugin's protocol, which is what lets
+// relays chain. The relay is read-only: commands other than get_state are
+// refused, scoring stays with the operators connected to OBS.
+
+#include "fly_score_boards.hpp"
+#include "fly_score_commands.hpp"
+#include "fly_score_embedded.hpp"
+#include "fly_score_metrics.hpp"
+#include "fly_score_websocket_server.hpp"
+#include "fly_score_ws_frame.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTcpSocket>
+#include <QTimer>
+#include <QUrl>
+
+#include <cstdio>
+#include <functional>
+
+static constexpr int kReconnectMinMs = 250;
+static constexpr int kReconnectMaxMs = 5000;
+static constexpr quint64 kMaxUpstreamPayload = 16 * 1024 * 1024;
+
+// ---------------------------------------------------------------------------
+// Upstream subscriber: one masked RFC 6455 client per board, reconnecting
+// with backoff. Asks for the full state (no topics, no roster_delta) so every
+// envelope it receives is a complete snapshot.
+// ---------------------------------------------------------------------------
+class FlyRelayUpstream : public QObject {
+public:
+	std::function<void(const QJsonObject &)> onMessage;
+	QString board;
+
+	explicit FlyRelayUpstream(const QUrl &url, QObject *parent = nullptr)
+		: QObject(parent),
+		  url_(url),
+		  socket_(new QTcpSocket(this))
+	{
+		socket_->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+		connect(socket_, &QTcpSocket::connected, this, [this]() { sendHandshake(); });
+		connect(socket_, &QTcpSocket::readyRead, this, [this]() { onReadyRead(); });
+		connect(socket_, &QTcpSocket::disconnected, this, [this]() { onDropped(); });
+		connect(socket_, &QAbstractSocket::errorOccurred, this, [this](QAbstractSocket::SocketError) {
+			if (socket_->state() == QAbstractSocket::UnconnectedState)
+				onDropped();
+		});
+		retry_.setSingleShot(true);
+		connect(&retry_, &QTimer::timeout, this, [this]() { open(); });
+	}
+
+	void open()
+	{
+		buffer_.clear();
+		open_ = false;
+		socket_->connectToHost(url_.host(), static_cast<quint16>(url_.port(4457)));
+	}
+
+	bool isOpen() const { return open_; }
+	QString url() const { return url_.toString(); }
+
+private:
+	void send(const QByteArray &payload, quint8 opcode)
+	{
+		const quint32 maskWord = QRandomGenerator::global()->generate();
+		quint8 mask[4];
+		for (int i = 0; i < 4; ++i)
+			mask[i] = quint8((maskWord >> (8 * i)) & 0xff);
+		socket_->write(fly_ws_encode_frame(payload, opcode, mask));
+	}
+
+	void sendJson(const QJsonObject &obj) { send(QJsonDocument(obj).toJson(QJsonDocument::Compact), 0x1); }
+
+	void sendHandshake()
+	{
+		QByteArray nonce(16, '\0');
+		for (char &c : nonce)
+			c = char(QRandomGenerator::global()->bounded(256));
+
+		const QByteArray path = url_.path().isEmpty() ? QByteArray("/") : url_.path().toUtf8();
+		QByteArray req;
+		req += "GET " + path + " HTTP/1.1\r\n";
+		req += "Host: " + url_.host().toUtf8() + ":" + QByteArray::number(url_.port(4457)) + "\r\n";
+		req += "Upgrade: websocket\r\nConnection: Upgrade\r\n";
+		req += "Sec-WebSocket-Key: " + nonce.toBase64() + "\r\n";
+		req += "Sec-WebSocket-Version: 13\r\n\r\n";
+		socket_->write(req);
+	}
+
+	void onReadyRead()
+	{
+		buffer_.append(socket_->readAll());
+
+		if (!open_) {
+			const int end = buffer_.indexOf("\r\n\r\n");
+			if (end < 0)
+				return;
+			const bool upgraded = buffer_.startsWith("HTTP/1.1 101");
+			buffer_.remove(0, end + 4);
+			if (!upgraded) {
+				std::fprintf(stderr, "fly-score-relay: %s refused the WebSocket upgrade\n",
+					     url().toUtf8().constData());
+				socket_->abort();
+				return;
+			}
+			open_ = true;
+			backoffMs_ = kReconnectMinMs;
+			std::printf("fly-score-relay: subscribed to %s\n", url().toUtf8().constData());
+			std::fflush(stdout);
+
+			QJsonObject hello;
+			hello.insert(QStringLiteral("type"), QStringLiteral("hello"));
+			// Pushes the plugin only sends to clients that can apply them; the relay forwards them.
+			hello.insert(QStringLiteral("capabilities"),
+				     QJsonArray{QStringLiteral("template_swap"), QStringLiteral("asset_reload")});
+			sendJson(hello);
+			QJsonObject get;
+			get.insert(QStringLiteral("type"), QStringLiteral("get_state"));
+			get.insert(QStringLiteral("board"), board);
+			sendJson(get);
+		}
+
+		qsizetype pos = 0;
+		FlyWsFrame frame;
+		FlyWsDecode result;
+		while ((result = fly_ws_decode_frame(buffer_, pos, frame, kMaxUpstreamPayload)) == FlyWsDecode::Frame) {
+			if (frame.opcode == 0x8) {
+				socket_->disconnectFromHost();
+				return;
+			}
+			if (frame.opcode == 0x9) {
+				send(frame.payload, 0xA);
+				continue;
+			}
+			if (frame.opcode != 0x1 || !onMessage)
+				continue;
+			const QJsonDocument doc = QJsonDocument::fromJson(frame.payload);
+			if (doc.isObject())
+				onMessage(doc.object());
+		}
+		if (result == FlyWsDecode::TooLarge) {
+			socket_->abort();
+			return;
+		}
+		buffer_.remove(0, pos);
+	}
+
+	void onDropped()
+	{
+		if (retry_.isActive())
+			return;
+		if (open_)
+			std::fprintf(stderr, "fly-score-relay: lost %s, reconnecting\n", url().toUtf8().constData());
+		open_ = false;
+		retry_.start(backoffMs_);
+		backoffMs_ = qMin(backoffMs_ * 2, kReconnectMaxMs);
+	}
+
+	QUrl url_;
+	QTcpSocket *socket_ = nullptr;
+	QTimer retry_;
+	QByteArray buffer_;
+	bool open_ = false;
+	int backoffMs_ = kReconnectMinMs;
+};
+
+// ---------------------------------------------------------------------------
+// Relay: upstream envelopes in, the headless server's fan-out out.
+// ---------------------------------------------------------------------------
+class FlyRelay : public QObject {
+public:
+	explicit FlyRelay(const QString &wwwDir, QObject *parent = nullptr) : QObject(parent), wwwDir_(wwwDir)
+	{
+		server_ = new FlyScoreWebSocketServer(this);
+		// Viewers are anonymous: no tracing to the relay's disk, no metrics.
+		server_->setAdminActions(false);
+		connect(server_, &FlyScoreWebSocketServer::commandReceived, this,
+			[this](FlyClientSession *session, const QJsonObject &command) { handle(session, command); });
+		server_->setHttpHandler(
+			[this](const FlyHttpRequest &req, FlyHttpResponse &res) { serveHttp(req, res); });
+	}
+
+	FlyScoreWebSocketServer *server() const { return server_; }
+
+	void subscribe(const QUrl &upstream, const QString &board)
+	{
+		QUrl url = upstream;
+		if (!board.isEmpty())
+			url.setPath(QStringLiteral("/board/") + board);
+		const QString boardKey = board.isEmpty() ? fly_default_board_id() : fly_board_normalize_id(board);
+
+		// Parented to the relay, which outlives the event loop.
+		auto *client = new FlyRelayUpstream(url, this);
+		client->onMessage = [this, boardKey](const QJsonObject &msg) { onUpstream(boardKey, msg); };
+		client->board = boardKey;
+		client->open();
+	}
+
+private:
+	void onUpstream(const QString &boardKey, const QJsonObject &msg)
+	{
+		const QString type = msg.value(QStringLiteral("type")).toString();
+		const QString board = fly_board_normalize_id(msg.value(QStringLiteral("board")).toString(boardKey));
+		// The upstream picks the board from our URL; anything else is not ours to cache.
+		if (board != boardKey)
+			return;
+
+		if (type == QLatin1String("state")) {
+			if (msg.value(QStringLiteral("partial")).toBool())
+				return;
+			const quint64 rev = static_cast<quint64>(msg.value(QStringLiteral("rev")).toDouble(0));
+			envelopes_.insert(board, msg);
+			server_->relayState(msg.value(QStringLiteral("state")).toObject(), rev,
+					    msg.value(QStringLiteral("template")).toString(),
+					    msg.value(QStringLiteral("template_path")).toString(), board);
+			return;
+		}
+		// Replies to our own requests stay here; pushes (template swaps, asset
+		// reloads) go to the viewers on the board that advertised support.
+		static const QStringList kReplies = {QStringLiteral("ack"), QStringLiteral("error"),
+						     QStringLiteral("metrics"), QStringLiteral("trace"),
+						     QStringLiteral("leaders")};
+		if (kReplies.contains(type))
+			return;
+		QString capability;
+		if (type == QLatin1String("template"))
+			capability = QStringLiteral("template_swap");
+		else if (type == QLatin1String("asset_update"))
+			capability = QStringLiteral("asset_reload");
+		server_->broadcastMessage(msg, board, capability);
+	}
+
+	void handle(FlyClientSession *session, const QJsonObject &command)
+	{
+		const QString action = fly_command_action(command);
+		// Same resolution as the server: the command's board, else the session's.
+		const QString requested = command.value(QStringLiteral("board")).toString();
+		const QString board = requested.isEmpty() ? session->board() : fly_board_normalize_id(requested);
+		if (action == QLatin1String("get_state") && server_->sendLastState(session, board))
+			return;
+
+		QJsonObject reply;
+		reply.insert(QStringLiteral("type"), QStringLiteral("error"));
+		reply.insert(QStringLiteral("error"), action == QLatin1String("get_state") ? QStringLiteral("no_state")
+											 : QStringLiteral("read_only"));
+		reply.insert(QStringLiteral("action"), action);
+		reply.insert(QStringLiteral("board"), board);
+		session->sendJson(reply);
+	}
+
+	// GET /state or /board/<id>/state returns the last envelope; /overlay/ is
+	// served from --www so viewers can load the overlay from the relay itself.
+	void serveHttp(const FlyHttpRequest &req, FlyHttpResponse &res)
+	{
+		const QStringList parts = req.path.split(QLatin1Char('/'));
+		QString board;
+		if (req.path == QLatin1String("/state")) {
+			board = fly_default_board_id();
+		} else if (parts.size() == 4 && parts[1] == QLatin1String("board") &&
+			   parts[3] == QLatin1String("state")) {
+			board = fly_board_normalize_id(parts[2]);
+		} else {
+			if (!wwwDir_.isEmpty())
+				fly_overlay_http_serve(wwwDir_, req, res);
+			return;
+		}
+
+		const auto it = envelopes_.constFind(board);
+		if (it == envelopes_.cend())
+			return;
+		res.status = 200;
+		res.contentType = "application/json";
+		res.body = QJsonDocument(*it).toJson(QJsonDocument::Compact);
+		const qint64 rev = static_cast<qint64>(it->value(QStringLiteral("rev")).toDouble(0));
+		res.etag = '"' + board.toUtf8() + '-' + QByteArray::number(rev) + '"';
+	}
+
+	FlyScoreWebSocketServer *server_ = nullptr;
+	QHash<QString, QJsonObject> envelopes_;
+	QString wwwDir_;
+};
+
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("fly-score-relay"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Relays fly-scoreboard state from one upstream subscription "
+							"to many WebSocket and HTTP viewers."));
+	parser.addHelpOption();
+	const QCommandLineOption upstreamOpt(QStringLiteral("upstream"),
+					     QStringLiteral("Plugin or relay to subscribe to."), QStringLiteral("url"),
+					     QStringLiteral("ws://127.0.0.1:4457"));
+	const QCommandLineOption boardOpt(QStringLiteral("board"),
+					  QStringLiteral("Board to relay; repeat for several (default: main)."),
+					  QStringLiteral("id"));
+	const QCommandLineOption listenOpt(QStringLiteral("listen"), QStringLiteral("Address to accept viewers on."),
+					   QStringLiteral("address"), QStringLiteral("0.0.0.0"));
+	const QCommandLineOption portOpt(QStringLiteral("port"), QStringLiteral("Port to accept viewers on."),
+					 QStringLiteral("port"), QStringLiteral("4460"));
+	const QCommandLineOption wwwOpt(QStringLiteral("www"),
+					QStringLiteral("Template folder to serve under /overlay/."),
+					QStringLiteral("dir"));
+	const QCommandLineOption burstOpt(QStringLiteral("rate-burst"),
+					  QStringLiteral("Requests a viewer may send at once."), QStringLiteral("n"),
+					  QStringLiteral("40"));
+	const QCommandLineOption rateOpt(QStringLiteral("rate-per-sec"),
+					 QStringLiteral("Viewer request refill rate; 0 disables limiting."),
+					 QStringLiteral("n"), QStringLiteral("20"));
+	const QCommandLineOption metricsOpt(QStringLiteral("metrics-interval"),
+					    QStringLiteral("Seconds between metrics summaries; 0 disables them."),
+					    QStringLiteral("s"), QStringLiteral("60"));
+	parser.addOptions({upstreamOpt, boardOpt, listenOpt, portOpt, wwwOpt, burstOpt, rateOpt, metricsOpt});
+	parser.process(app);
+
+	const QUrl upstream(parser.value(upstreamOpt));
+	if (!upstream.isValid() || upstream.scheme() != QLatin1String("ws") || upstream.host().isEmpty()) {
+		std::fprintf(stderr, "fly-score-relay: --upstream must be a ws:// URL\n");
+		return 1;
+	}
+	QHostAddress address;
+	if (!address.setAddress(parser.value(listenOpt))) {
+		std::fprintf(stderr, "fly-score-relay: invalid --listen address '%s'\n",
+			     parser.value(listenOpt).toUtf8().constData());
+		return 1;
+	}
+	const quint16 port = static_cast<quint16>(parser.value(portOpt).toUInt());
+
+	FlyRelay relay(parser.value(wwwOpt));
+	relay.server()->setRateLimit(parser.value(burstOpt).toInt(), parser.value(rateOpt).toDouble());
+	if (!relay.server()->start(port, address)) {
+		std::fprintf(stderr, "fly-score-relay: cannot listen on %s:%u\n",
+			     address.toString().toUtf8().constData(), unsigned(port));
+		return 3;
+	}
+	std::printf("fly-score-relay: serving %s\n", relay.server()->url().toUtf8().constData());
+	std::fflush(stdout);
+
+	QStringList boards = parser.values(boardOpt);
+	if (boards.isEmpty())
+		boards << QString();
+	boards.removeDuplicates();
+	for (const QString &board : boards)
+		relay.subscribe(upstream, board.isEmpty() ? QString() : fly_board_normalize_id(board));
+
+	QTimer metrics;
+	const int metricsSec = parser.value(metricsOpt).toInt();
+	if (metricsSec > 0) {
+		QObject::connect(&metrics, &QTimer::timeout, []() { fly_metrics_log_summary(); });
+		metrics.start(metricsSec * 1000);
+	}
+
+	return app.exec();
+}
@@ -0,0 +1,99 @@
+// fly-score-shm-reader: example consumer of the shared-memory state segment.
+//
+// Attaches read-only to the segment the plugin publishes when "ipc/shm_name"
+// is set, polls it and prints every new revision. Only fly_score_shm.hpp and
+// QSharedMemory are needed, so this doubles as a template for native readers.
+
+#include "fly_score_shm.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QSharedMemory>
+#include <QTimer>
+
+#include <cstdint>
+#include <cstdio>
+
+static long long fly_shm_timer_now_ms(const FlyShmTimer &t, qint64 nowMs)
+{
+	if (!t.running || t.last_tick_ms <= 0)
+		return t.remaining_ms;
+	const long long elapsed = nowMs - t.last_tick_ms;
+	return t.countup ? t.remaining_ms + elapsed : (t.remaining_ms > elapsed ? t.remaining_ms - elapsed : 0);
+}
+
+static void fly_shm_print(const FlyShmState &st)
+{
+	std::printf("rev %llu  board '%s'%s%s\n", (unsigned long long)st.rev, st.board,
+		    st.swap_sides ? "  [swapped]" : "", st.show_scoreboard ? "" : "  [hidden]");
+	std::printf("  %-24s %06x  vs  %-24s %06x\n", st.home.title, unsigned(st.home.color & 0xFFFFFF), st.away.title,
+		    unsigned(st.away.color & 0xFFFFFF));
+	for (uint32_t i = 0; i < st.field_count; ++i) {
+		const FlyShmField &f = st.fields[i];
+		std::printf("  %-24s %5d : %-5d%s\n", f.label, f.home, f.away, f.visible ? "" : "  (hidden)");
+	}
+	for (uint32_t i = 0; i < st.single_count; ++i) {
+		const FlyShmSingle &s = st.singles[i];
+		std::printf("  %-24s %5d%s\n", s.label, s.value, s.visible ? "" : "  (hidden)");
+	}
+	const qint64 now = QDateTime::currentMSecsSinceEpoch();
+	for (uint32_t i = 0; i < st.timer_count; ++i) {
+		const FlyShmTimer &t = st.timers[i];
+		const long long ms = fly_shm_timer_now_ms(t, now);
+		std::printf("  %-24s %02lld:%02lld.%lld %s%s\n", t.label, ms / 60000, (ms / 1000) % 60, (ms / 100) % 10,
+			    t.running ? "running" : "paused", t.visible ? "" : "  (hidden)");
+	}
+	std::fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName(QStringLiteral("fly-score-shm-reader"));
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription(QStringLiteral("Prints the state the fly-scoreboard plugin publishes to "
+							"shared memory."));
+	parser.addHelpOption();
+	const QCommandLineOption nameOpt(QStringLiteral("name"), QStringLiteral("Segment key (ipc/shm_name)."),
+					 QStringLiteral("key"), QStringLiteral("fly-scoreboard"));
+	const QCommandLineOption intervalOpt(QStringLiteral("interval"), QStringLiteral("Poll interval."),
+					     QStringLiteral("ms"), QStringLiteral("16"));
+	const QCommandLineOption onceOpt(QStringLiteral("once"), QStringLiteral("Print one snapshot and exit."));
+	parser.addOptions({nameOpt, intervalOpt, onceOpt});
+	parser.process(app);
+
+	QSharedMemory mem(parser.value(nameOpt));
+	if (!mem.attach(QSharedMemory::ReadOnly)) {
+		std::fprintf(stderr, "fly-score-shm-reader: cannot attach to '%s': %s\n",
+			     parser.value(nameOpt).toUtf8().constData(), mem.errorString().toUtf8().constData());
+		return 1;
+	}
+	const auto *seg = static_cast<const FlyShmSegment *>(mem.constData());
+	if (mem.size() < int(sizeof(FlyShmSegment)) || !fly_shm_segment_valid(seg)) {
+		std::fprintf(stderr, "fly-score-shm-reader: '%s' is not a version %u state segment\n",
+			     parser.value(nameOpt).toUtf8().constData(), kFlyShmVersion);
+		return 1;
+	}
+
+	FlyShmState st{};
+	if (parser.isSet(onceOpt)) {
+		if (!fly_shm_read_snapshot(seg, st))
+			return 1;
+		fly_shm_print(st);
+		return 0;
+	}
+
+	uint64_t lastRev = 0;
+	QTimer poll;
+	poll.setInterval(qMax(1, parser.value(intervalOpt).toInt()));
+	QObject::connect(&poll, &QTimer::timeout, [&]() {
+		if (fly_shm_read_snapshot(seg, st) && st.rev != lastRev) {
+			lastRev = st.rev;
+			fly_shm_print(st);
+		}
+	});
+	poll.start();
+	return app.exec();
+}